@@ -49,6 +49,7 @@ It handles initialization and termination by subclassing wxApp.
 #include <wx/dir.h>
 #include <wx/file.h>
 #include <wx/filename.h>
+#include <wx/thread.h>
 
 #ifdef __WXGTK__
 #include <unistd.h>
@@ -69,6 +70,7 @@ It handles initialization and termination by subclassing wxApp.
 #include "AboutDialog.h"
 #include "AColor.h"
 #include "AudioIO.h"
+#include "BatchRunner.h"
 #include "Benchmark.h"
 #include "Clipboard.h"
 #include "CrashReport.h"
@@ -82,6 +84,7 @@ It handles initialization and termination by subclassing wxApp.
 #include "Menus.h"
 #include "MissingAliasFileDialog.h"
 #include "PluginManager.h"
+#include "PluginScanner.h"
 #include "Project.h"
 #include "ProjectAudioIO.h"
 #include "ProjectAudioManager.h"
@@ -108,6 +111,7 @@ It handles initialization and termination by subclassing wxApp.
 #include "prefs/GUIPrefs.h"
 #include "tracks/ui/Scrubbing.h"
 #include "widgets/FileHistory.h"
+#include "widgets/ProgressDialog.h"
 
 #ifdef EXPERIMENTAL_EASY_CHANGE_KEY_BINDINGS
 #include "prefs/KeyConfigPrefs.h"
@@ -489,7 +493,7 @@ static void QuitAudacity(bool bForce)
    else
 /*end+*/
    {
-      if (AllProjects{}.size())
+      if (AllProjects{}.size() && !wxGetApp().IsBatch())
          // PRL:  Always did at least once before close might be vetoed
          // though I don't know why that is important
          ProjectManager::SaveWindowSize();
@@ -1357,9 +1361,25 @@ bool AudacityApp::OnInit()
    }
 #endif
 
+   // Batch processing leaves the preferences, which the others share, alone,
+   // so it must be known before they are read, and so before the language
+   // and the full parsing of the command line
+   for (int i = 1; i < argc; i++)
+   {
+      const wxString arg = argv[i];
+      if (arg == wxT("--"))
+         break;
+      if (arg.StartsWith(wxT("-m")) || arg.StartsWith(wxT("--macro")))
+      {
+         mBatch = true;
+         ProgressDialog::SetHeadless(true);
+         break;
+      }
+   }
+
    // Initialize preferences and language
    wxFileName configFileName(FileNames::DataDir(), wxT("audacity.cfg"));
-   InitPreferences( configFileName );
+   InitPreferences( configFileName, mBatch );
    PopulatePreferences();
    // This test must follow PopulatePreferences, because if an error message
    // must be shown, we need internationalization to have been initialized
@@ -1379,6 +1399,59 @@ bool AudacityApp::OnInit()
    // AColor depends on theTheme.
    AColor::Init();
 
+   // Parse command line and handle options that might require
+   // immediate exit...no need to initialize all of the audio
+   // stuff to display the version string.
+   std::shared_ptr< wxCmdLineParser > parser{ ParseCommandLine().release() };
+   if (!parser)
+   {
+      // Either user requested help or a parsing error occured
+      exit(1);
+   }
+
+   if (parser->Found(wxT("v")))
+   {
+      wxPrintf("Audacity v%s\n", AUDACITY_VERSION_STRING);
+      exit(0);
+   }
+
+   // Started by PluginScanner, to check new plug-ins and quit; the
+   // parameters are pairs of provider and path
+   if (parser->Found(wxT("scan-plugins")))
+   {
+      PluginIDs providers;
+      PluginPaths paths;
+      for (size_t i = 0, cnt = parser->GetParamCount(); i + 1 < cnt; i += 2)
+      {
+         providers.push_back(parser->GetParam(i));
+         paths.push_back(parser->GetParam(i + 1));
+      }
+      exit(parser->GetParamCount() % 2 == 0
+         ? PluginScanner::RunHelper(providers, paths)
+         : 1);
+   }
+
+   FilePaths batchFiles;
+   if (parser->Found(wxT("m"), &mBatchMacro))
+   {
+      for (size_t i = 0, cnt = parser->GetParamCount(); i < cnt; i++)
+         batchFiles.push_back(parser->GetParam(i));
+
+      long jobs = wxThread::GetCPUCount();
+      if (parser->Found(wxT("j"), &jobs) && jobs < 1)
+      {
+         wxPrintf(_("The number of jobs must be at least 1\n"));
+         exit(1);
+      }
+
+      // Several files at once are done by other processes, so this one
+      // needs nothing more
+      if (batchFiles.size() > 1 && jobs > 1)
+         exit(BatchRunner::RunInProcesses(
+            mBatchMacro, batchFiles, jobs) > 0 ? 1 : 0);
+   }
+   const bool batch = mBatch;
+
    // Init DirManager, which initializes the temp directory
    // If this fails, we must exit the program.
    if (!InitTempDir()) {
@@ -1400,22 +1473,6 @@ bool AudacityApp::OnInit()
    // Initialize the ModuleManager, including loading found modules
    ModuleManager::Get().Initialize(*mCmdHandler);
 
-   // Parse command line and handle options that might require
-   // immediate exit...no need to initialize all of the audio
-   // stuff to display the version string.
-   std::shared_ptr< wxCmdLineParser > parser{ ParseCommandLine().release() };
-   if (!parser)
-   {
-      // Either user requested help or a parsing error occured
-      exit(1);
-   }
-
-   if (parser->Found(wxT("v")))
-   {
-      wxPrintf("Audacity v%s\n", AUDACITY_VERSION_STRING);
-      exit(0);
-   }
-
    long lval;
    if (parser->Found(wxT("b"), &lval))
    {
@@ -1459,29 +1516,33 @@ bool AudacityApp::OnInit()
       bool bIconized = false;
       GetNextWindowPlacement(&wndRect, &bMaximized, &bIconized);
 
-      wxSplashScreen temporarywindow(
-         logo,
-         wxSPLASH_CENTRE_ON_SCREEN | wxSPLASH_NO_TIMEOUT,
-         0,
-         NULL,
-         wxID_ANY,
-         wndRect.GetTopLeft(),
-         wxDefaultSize,
-         wxSTAY_ON_TOP);
-
-      // Unfortunately with the Windows 10 Creators update, the splash screen 
-      // now appears before setting its position.
-      // On a dual monitor screen it will appear on one screen and then 
-      // possibly jump to the second.
-      // We could fix this by writing our own splash screen and using Hide() 
-      // until the splash scren was correctly positioned, then Show()
-
-      // Possibly move it on to the second screen...
-      temporarywindow.SetPosition( wndRect.GetTopLeft() );
-      // Centered on whichever screen it is on.
-      temporarywindow.Center();
-      temporarywindow.SetTitle(_("Audacity is starting up..."));
-      SetTopWindow(&temporarywindow);
+      // No windows for batch processing
+      Maybe<wxSplashScreen> temporarywindow;
+      if (!batch) {
+         temporarywindow.create(
+            logo,
+            wxSPLASH_CENTRE_ON_SCREEN | wxSPLASH_NO_TIMEOUT,
+            0,
+            nullptr,
+            wxID_ANY,
+            wndRect.GetTopLeft(),
+            wxDefaultSize,
+            wxSTAY_ON_TOP);
+
+         // Unfortunately with the Windows 10 Creators update, the splash screen 
+         // now appears before setting its position.
+         // On a dual monitor screen it will appear on one screen and then 
+         // possibly jump to the second.
+         // We could fix this by writing our own splash screen and using Hide() 
+         // until the splash scren was correctly positioned, then Show()
+
+         // Possibly move it on to the second screen...
+         temporarywindow->SetPosition( wndRect.GetTopLeft() );
+         // Centered on whichever screen it is on.
+         temporarywindow->Center();
+         temporarywindow->SetTitle(_("Audacity is starting up..."));
+         SetTopWindow(temporarywindow.get());
+      }
 
       // ANSWER-ME: Why is YieldFor needed at all?
       //wxEventLoopBase::GetActive()->YieldFor(wxEVT_CATEGORY_UI|wxEVT_CATEGORY_USER_INPUT|wxEVT_CATEGORY_UNKNOWN);
@@ -1524,7 +1585,8 @@ bool AudacityApp::OnInit()
       SetExitOnFrameDelete(false);
 
 #endif //__WXMAC__
-      temporarywindow.Show(false);
+      if (temporarywindow)
+         temporarywindow->Show(false);
    }
 
    // Workaround Bug 1377 - Crash after Audacity starts and low disk space warning appears
@@ -1536,9 +1598,9 @@ bool AudacityApp::OnInit()
    // Root cause is problem with wxSplashScreen and other dialogs co-existing, that
    // seemed to arrive with wx3.
    {
-      project = ProjectManager::New();
+      project = ProjectManager::New( !batch );
       mCmdHandler->SetProject(project);
-      wxWindow * pWnd = MakeHijackPanel();
+      wxWindow * pWnd = batch ? nullptr : MakeHijackPanel();
       if (pWnd)
       {
          auto &window = GetProjectFrame( *project );
@@ -1549,7 +1611,7 @@ bool AudacityApp::OnInit()
       }
    }
 
-   if( ProjectSettings::Get( *project ).GetShowSplashScreen() ){
+   if( !batch && ProjectSettings::Get( *project ).GetShowSplashScreen() ){
       // This may do a check-for-updates at every start up.
       // Mainly this is to tell users of ALPHAS who don't know that they have an ALPHA.
       // Disabled for now, after discussion.
@@ -1565,6 +1627,13 @@ bool AudacityApp::OnInit()
 
    // Bug1561: delay the recovery dialog, to avoid crashes.
    CallAfter( [=] () mutable {
+      if (batch) {
+         // Apply the macro, instead of recovering and opening the files
+         mBatchFailures = BatchRunner::Run(*project, mBatchMacro, batchFiles);
+         QuitAudacity(true);
+         return;
+      }
+
       //
       // Auto-recovery
       //
@@ -1744,7 +1813,20 @@ bool AudacityApp::InitTempDir()
    chmod(OSFILENAME(temp), 0755);
    #endif
 
+   if (mBatch) {
+      // A batch process keeps its files apart, so that it may run alongside
+      // other batch processes, or Audacity itself.  So it needs no lock,
+      // nor takes files from other copies of Audacity; and it leaves the
+      // preferences, which the others share, alone.  On Windows the single
+      // instance check would not even look at the directory.
+      mBatchTempDir = FileNames::MkDir( wxFileName( temp,
+         wxString::Format( wxT("batch-%lu"), wxGetProcessId() ) ).GetFullPath() );
+      DirManager::SetTempDir(mBatchTempDir);
+      return true;
+   }
+
    bool bSuccess = gPrefs->Write(wxT("/Directories/TempDir"), temp) && gPrefs->Flush();
+
    DirManager::SetTempDir(temp);
 
    // Make sure the temp dir isn't locked by another process.
@@ -1988,6 +2070,19 @@ std::unique_ptr<wxCmdLineParser> AudacityApp::ParseCommandLine()
    parser->AddSwitch(wxT("h"), wxT("help"), _("this help message"),
                      wxCMD_LINE_OPTION_HELP);
 
+   /*i18n-hint: This applies a macro to the files, without showing any
+    *           windows, and then quits */
+   parser->AddOption(wxT("m"), wxT("macro"), _("apply a macro to the files and quit"),
+                     wxCMD_LINE_VAL_STRING);
+
+   /*i18n-hint: This sets how many files are processed at once with --macro */
+   parser->AddOption(wxT("j"), wxT("jobs"), _("number of files to process at once with --macro"),
+                     wxCMD_LINE_VAL_NUMBER);
+
+   // For PluginScanner only, so not in the help
+   parser->AddLongSwitch(wxT("scan-plugins"), wxT("check plug-ins and quit"),
+                         wxCMD_LINE_HIDDEN);
+
    /*i18n-hint: This runs a set of automatic tests on Audacity itself */
    parser->AddSwitch(wxT("t"), wxT("test"), _("run self diagnostics"));
 
@@ -2028,7 +2123,7 @@ void AudacityApp::OnEndSession(wxCloseEvent & event)
    // Try to close each open window.  If the user hits Cancel
    // in a Save Changes dialog, don't continue.
    gIsQuitting = true;
-   if (AllProjects{}.size())
+   if (AllProjects{}.size() && !mBatch)
       // PRL:  Always did at least once before close might be vetoed
       // though I don't know why that is important
       ProjectManager::SaveWindowSize();
@@ -2040,6 +2135,15 @@ void AudacityApp::OnEndSession(wxCloseEvent & event)
    }
 }
 
+int AudacityApp::OnRun()
+{
+   auto result = wxApp::OnRun();
+   // Batch processing fails if any file failed
+   if (mBatchFailures > 0)
+      result = 1;
+   return result;
+}
+
 int AudacityApp::OnExit()
 {
    gIsQuitting = true;
@@ -2088,6 +2192,12 @@ int AudacityApp::OnExit()
 #endif
    }
 
+   if (!mBatchTempDir.empty())
+   {
+      // Nothing else uses the temporary directory of a batch process
+      wxFileName::Rmdir(mBatchTempDir, wxPATH_RMDIR_RECURSIVE);
+   }
+
    return 0;
 }
 
@@ -45,6 +45,7 @@ class AudacityApp final : public wxApp {
    AudacityApp();
    ~AudacityApp();
    bool OnInit(void) override;
+   int OnRun(void) override;
    int OnExit(void) override;
    void OnFatalException() override;
    bool OnExceptionInMainLoop() override;
@@ -98,12 +99,21 @@ class AudacityApp final : public wxApp {
 
 #endif
 
+   // Whether --macro was given, for unattended batch processing
+   bool IsBatch() const { return mBatch; }
+
 
  private:
    std::unique_ptr<CommandHandler> mCmdHandler;
 
    std::unique_ptr<wxSingleInstanceChecker> mChecker;
 
+   // Given by --macro, for unattended batch processing
+   bool mBatch{ false };
+   wxString mBatchMacro;
+   FilePath mBatchTempDir;
+   unsigned mBatchFailures{ 0 };
+
    wxTimer mTimer;
 
    void InitCommandHandler();
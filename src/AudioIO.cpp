@@ -427,6 +427,7 @@ time warp info and AudioIOListener and whether the playback is looped.
 #include <math.h>
 #include <stdlib.h>
 #include <algorithm>
+#include <chrono>
 
 #ifdef __WXMSW__
 #include <malloc.h>
@@ -453,6 +454,7 @@ time warp info and AudioIOListener and whether the playback is looped.
 #include "Mix.h"
 #include "Resample.h"
 #include "RingBuffer.h"
+#include "ThreadPool.h"
 #include "prefs/GUISettings.h"
 #include "Prefs.h"
 #include "Project.h"
@@ -1556,6 +1558,7 @@ int AudioIO::StartStream(const TransportTracks &tracks,
 
    mPlaybackBuffers.reset();
    mPlaybackMixers.reset();
+   mPlaybackScratch.reset();
    mCaptureBuffers.reset();
    mResample.reset();
    mTimeQueue.mData.reset();
@@ -1850,14 +1853,25 @@ bool AudioIO::AllocateBuffers(
       try
       {
          if( mNumPlaybackChannels > 0 ) {
-            // Allocate output buffers.  For every output track we allocate
-            // a ring buffer of ten seconds
+            // Allocate output buffers.  We allocate one ring buffer of ten
+            // seconds, with a channel for every output track
             auto playbackBufferSize =
                (size_t)lrint(mRate * mPlaybackRingBufferSecs);
 
-            mPlaybackBuffers.reinit(mPlaybackTracks.size());
+            mPlaybackBuffers = std::make_unique<PlanarRingBuffer>(
+               floatSample, playbackBufferSize, mPlaybackTracks.size());
             mPlaybackMixers.reinit(mPlaybackTracks.size());
 
+            // The callback needs a buffer for each track.  PortAudio chooses
+            // how many frames each callback asks for, but not more than its
+            // latency in practice; allow for several times that.
+            mPlaybackScratchFrames = 16384;
+            if (const auto info = Pa_GetStreamInfo(mPortStreamV19))
+               mPlaybackScratchFrames = std::max(mPlaybackScratchFrames,
+                  (size_t)lrint(4 * info->outputLatency * mRate));
+            mPlaybackScratch.reinit(
+               mPlaybackTracks.size(), mPlaybackScratchFrames);
+
             const Mixer::WarpOptions &warpOptions =
 #ifdef EXPERIMENTAL_SCRUBBING_SUPPORT
                scrubbing
@@ -1885,8 +1899,6 @@ bool AudioIO::AllocateBuffers(
                mPlaybackTracks[i]->SetOldChannelGain(0, 0.0);
                mPlaybackTracks[i]->SetOldChannelGain(1, 0.0);
 
-               mPlaybackBuffers[i] =
-                  std::make_unique<RingBuffer>(floatSample, playbackBufferSize);
                const auto timeQueueSize =
                   (playbackBufferSize + TimeQueueGrainSize - 1)
                      / TimeQueueGrainSize;
@@ -1925,8 +1937,10 @@ bool AudioIO::AllocateBuffers(
 
          if( mNumCaptureChannels > 0 )
          {
-            // Allocate input buffers.  For every input track we allocate
-            // a ring buffer of five seconds
+            // Allocate input buffers.  We allocate one ring buffer of five
+            // seconds, with a channel for every input track.  It holds
+            // samples in the format of the stream, so that the callback
+            // need not convert them
             auto captureBufferSize =
                (size_t)(mRate * mCaptureRingBufferSecs + 0.5);
 
@@ -1938,14 +1952,13 @@ bool AudioIO::AllocateBuffers(
                return false;
             }
 
-            mCaptureBuffers.reinit(mCaptureTracks.size());
+            mCaptureBuffers = std::make_unique<PlanarRingBuffer>(
+               mCaptureFormat, captureBufferSize, mCaptureTracks.size());
             mResample.reinit(mCaptureTracks.size());
             mFactor = sampleRate / mRate;
 
             for( unsigned int i = 0; i < mCaptureTracks.size(); i++ )
             {
-               mCaptureBuffers[i] = std::make_unique<RingBuffer>(
-                  mCaptureTracks[i]->GetSampleFormat(), captureBufferSize );
                mResample[i] =
                   std::make_unique<Resample>(true, mFactor, mFactor);
                   // constant rate resampling
@@ -1974,11 +1987,43 @@ bool AudioIO::AllocateBuffers(
          }
       }
    } while(!bDone);
-   
+
+   AllocateFillBuffersPool();
+
    success = true;
    return true;
 }
 
+void AudioIO::AllocateFillBuffersPool()
+{
+   // The number of threads, counting the audio thread, that may share the
+   // work of FillBuffers(), or zero to use all processors
+   long nThreads = 0;
+   gPrefs->Read(wxT("/AudioIO/FillBuffersThreads"), &nThreads, 0L);
+   if (nThreads <= 0)
+      nThreads = std::max(1u, std::thread::hardware_concurrency());
+
+   // No use for more threads than channels
+   const size_t nChannels =
+      std::max(mPlaybackTracks.size(), mCaptureTracks.size());
+   const size_t nWorkers =
+      std::min<size_t>(nThreads, std::max<size_t>(nChannels, 1)) - 1;
+
+   if (nWorkers == 0)
+      mFillBuffersPool.reset();
+   else if (!mFillBuffersPool ||
+            mFillBuffersPool->GetConcurrency() != nWorkers + 1)
+      mFillBuffersPool = std::make_unique<ThreadPool>(nWorkers);
+
+   mMixerCosts.assign(mPlaybackTracks.size(), -1.0);
+   mMixerOrder.resize(mPlaybackTracks.size());
+   for (size_t i = 0; i < mMixerOrder.size(); ++i)
+      mMixerOrder[i] = i;
+
+   std::lock_guard<std::mutex> lock{ mFillStatisticsMutex };
+   mFillStatistics = {};
+}
+
 void AudioIO::StartStreamCleanup(bool bOnlyBuffers)
 {
    if (mNumPlaybackChannels > 0)
@@ -1988,6 +2033,7 @@ void AudioIO::StartStreamCleanup(bool bOnlyBuffers)
 
    mPlaybackBuffers.reset();
    mPlaybackMixers.reset();
+   mPlaybackScratch.reset();
    mCaptureBuffers.reset();
    mResample.reset();
    mTimeQueue.mData.reset();
@@ -2285,6 +2331,17 @@ void AudioIO::StopStream()
          wxMilliSleep( 50 );
       }
 
+      {
+         const auto stats = GetFillStatistics();
+         if (stats.fills > 0)
+            wxLogDebug(
+               wxT("FillBuffers: %lu fills, mean %.3f ms, max %.3f ms, %lu late"),
+               (unsigned long)stats.fills,
+               1000 * stats.totalSeconds / stats.fills,
+               1000 * stats.maxSeconds,
+               (unsigned long)stats.lateFills);
+      }
+
       //
       // Everything is taken care of.  Now, just free all the resources
       // we allocated in StartStream()
@@ -2294,6 +2351,7 @@ void AudioIO::StopStream()
       {
          mPlaybackBuffers.reset();
          mPlaybackMixers.reset();
+         mPlaybackScratch.reset();
          mTimeQueue.mData.reset();
       }
 
@@ -2593,10 +2651,7 @@ MidiThread::ExitCode MidiThread::Entry()
 
 size_t AudioIO::GetCommonlyFreePlayback()
 {
-   auto commonlyAvail = mPlaybackBuffers[0]->AvailForPut();
-   for (unsigned i = 1; i < mPlaybackTracks.size(); ++i)
-      commonlyAvail = std::min(commonlyAvail,
-         mPlaybackBuffers[i]->AvailForPut());
+   auto commonlyAvail = mPlaybackBuffers->AvailForPut();
    // MB: subtract a few samples because the code in FillBuffers has rounding
    // errors
    return commonlyAvail - std::min(size_t(10), commonlyAvail);
@@ -2607,20 +2662,93 @@ size_t AudioIoCallback::GetCommonlyReadyPlayback()
    if (mPlaybackTracks.empty())
       return 0;
 
-   auto commonlyAvail = mPlaybackBuffers[0]->AvailForGet();
-   for (unsigned i = 1; i < mPlaybackTracks.size(); ++i)
-      commonlyAvail = std::min(commonlyAvail,
-         mPlaybackBuffers[i]->AvailForGet());
-   return commonlyAvail;
+   return mPlaybackBuffers->AvailForGet();
 }
 
 size_t AudioIO::GetCommonlyAvailCapture()
 {
-   auto commonlyAvail = mCaptureBuffers[0]->AvailForGet();
-   for (unsigned i = 1; i < mCaptureTracks.size(); ++i)
-      commonlyAvail = std::min(commonlyAvail,
-         mCaptureBuffers[i]->AvailForGet());
-   return commonlyAvail;
+   return mCaptureBuffers->AvailForGet();
+}
+
+void AudioIO::ProcessPlaybackMixers(size_t toProcess, size_t frames)
+{
+   // Fill the same region of all channels, then publish them together
+   const auto region = mPlaybackBuffers->GetWriteRegion(frames);
+   // wxASSERT(region.Length() == frames);
+   // but we can't assert in this thread
+
+   auto mix = [&](size_t i) {
+      using Clock = std::chrono::steady_clock;
+      const auto start = Clock::now();
+
+      // The mixer here isn't actually mixing: it's just doing
+      // resampling, format conversion, and possibly time track
+      // warping
+      size_t processed = 0;
+      if ( toProcess )
+         processed = mPlaybackMixers[i]->Process( toProcess );
+      //wxASSERT(processed <= toProcess);
+      samplePtr warpedSamples = mPlaybackMixers[i]->GetBuffer();
+      mPlaybackBuffers->WriteChannel(
+         i, region, warpedSamples, floatSample, processed);
+
+      if ( toProcess )
+         mMixerCosts[i] = std::chrono::duration<double>(
+            Clock::now() - start ).count() / toProcess;
+   };
+
+   // Below this estimated time, waking the workers costs more than it saves
+   static const double MinParallelSeconds = 0.001;
+
+   const auto numTracks = mPlaybackTracks.size();
+   bool parallel = false;
+   if (mFillBuffersPool && numTracks > 1 && toProcess > 0) {
+      // Start the costliest mixers first, so that the last to finish is
+      // likely a short one; unmeasured mixers count as costly
+      std::sort(mMixerOrder.begin(), mMixerOrder.end(),
+         [this](size_t a, size_t b){
+            const auto costA = mMixerCosts[a], costB = mMixerCosts[b];
+            if ((costA < 0) != (costB < 0))
+               return costA < 0;
+            return costA > costB;
+         });
+      double estimate = 0;
+      for (auto cost : mMixerCosts) {
+         if (cost < 0) {
+            parallel = true;
+            break;
+         }
+         estimate += cost * toProcess;
+      }
+      parallel = parallel || estimate >= MinParallelSeconds;
+   }
+
+   if (parallel)
+      mFillBuffersPool->ParallelFor(numTracks,
+         [&](size_t j){ mix(mMixerOrder[j]); });
+   else
+      for (size_t i = 0; i < numTracks; ++i)
+         mix(i);
+
+   mPlaybackBuffers->CommitWrite(region.Length());
+}
+
+void AudioIO::RecordFill(double seconds, double deadline)
+{
+   std::lock_guard<std::mutex> lock{ mFillStatisticsMutex };
+   auto &stats = mFillStatistics;
+   ++stats.fills;
+   if (deadline > 0 && seconds > deadline)
+      ++stats.lateFills;
+   stats.totalSeconds += seconds;
+   stats.maxSeconds = std::max(stats.maxSeconds, seconds);
+   stats.lastSeconds = seconds;
+}
+
+auto AudioIO::GetFillStatistics() const -> FillStatistics
+{
+   std::lock_guard<std::mutex> lock{ mFillStatisticsMutex };
+   return mFillStatistics;
 }
 
 // This method is the data gateway between the audio thread (which
@@ -2649,6 +2777,19 @@ void AudioIO::FillBuffers()
       DefaultDelayedHandlerAction{}( pException );
    };
 
+   // Measure the fill against the playback already queued for the callback,
+   // which is the time it has before it runs dry
+   using Clock = std::chrono::steady_clock;
+   const auto fillStart = Clock::now();
+   const double deadline =
+      mPlaybackTracks.empty() ? 0.0 : GetCommonlyReadyPlayback() / mRate;
+   bool filled = false;
+   auto recordFill = finally( [&] {
+      if (filled)
+         RecordFill( std::chrono::duration<double>(
+            Clock::now() - fillStart ).count(), deadline );
+   } );
+
    if (mPlaybackTracks.size() > 0)
    {
       // Though extremely unlikely, it is possible that some buffers
@@ -2739,26 +2880,10 @@ void AudioIO::FillBuffers()
                (mPlaybackSchedule.Interactive() ? mScrubSpeed : 1.0),
                frames);
 
-            for (i = 0; i < mPlaybackTracks.size(); i++)
+            if (frames > 0)
             {
-               // The mixer here isn't actually mixing: it's just doing
-               // resampling, format conversion, and possibly time track
-               // warping
-               samplePtr warpedSamples;
-
-               if (frames > 0)
-               {
-                  size_t processed = 0;
-                  if ( toProcess )
-                     processed = mPlaybackMixers[i]->Process( toProcess );
-                  //wxASSERT(processed <= toProcess);
-                  warpedSamples = mPlaybackMixers[i]->GetBuffer();
-                  const auto put = mPlaybackBuffers[i]->Put(
-                     warpedSamples, floatSample, processed, frames - processed);
-                  // wxASSERT(put == frames);
-                  // but we can't assert in this thread
-                  wxUnusedVar(put);
-               }               
+               ProcessPlaybackMixers(toProcess, frames);
+               filled = true;
             }
 
             available -= frames;
@@ -2851,43 +2976,40 @@ void AudioIO::FillBuffers()
             // The WaveTracks have their own buffering for efficiency.
             AutoSaveFile blockFileLog;
             auto numChannels = mCaptureTracks.size();
+            size_t discarded = 0;
+
+            if (!mRecordingSchedule.mLatencyCorrected &&
+                mRecordingSchedule.TotalCorrection() < 0) {
+               // Leftward shift
+               // discard some samples from the ring buffers.
+               size_t size = floor(
+                  mRecordingSchedule.ToDiscard() * mRate );
+
+               // The ring buffer might have grown concurrently -- don't discard more
+               // than the "avail" value noted above.
+               discarded = mCaptureBuffers->Discard(std::min(avail, size));
+
+               if (discarded < size)
+                  // We need to visit this again to complete the
+                  // discarding.
+                  latencyCorrected = false;
+            }
 
-            for( i = 0; i < numChannels; i++ )
-            {
+            // The same region of every channel is consumed, in place, and
+            // released after the loop
+            wxASSERT(discarded <= avail);
+            const auto region = mCaptureBuffers->GetReadRegion(avail - discarded);
+
+            // Convert the samples of each channel, on the fill pool if
+            // resampling makes that worthwhile.  Appending stays on this
+            // thread, because making block files is not thread safe.
+            ArrayOf<SampleBuffer> buffers{ numChannels };
+            std::vector<size_t> sizes( numChannels );
+            std::vector<sampleFormat> formats( numChannels );
+            const bool flush = !IsStreamActive();
+            auto convert = [&]( size_t i ) {
                sampleFormat trackFormat = mCaptureTracks[i]->GetSampleFormat();
 
-               AutoSaveFile appendLog;
-               size_t discarded = 0;
-
-               if (!mRecordingSchedule.mLatencyCorrected) {
-                  const auto correction = mRecordingSchedule.TotalCorrection();
-                  if (correction >= 0) {
-                     // Rightward shift
-                     // Once only (per track per recording), insert some initial
-                     // silence.
-                     size_t size = floor( correction * mRate * mFactor);
-                     SampleBuffer temp(size, trackFormat);
-                     ClearSamples(temp.ptr(), trackFormat, 0, size);
-                     mCaptureTracks[i]->Append(temp.ptr(), trackFormat,
-                                               size, 1, &appendLog);
-                  }
-                  else {
-                     // Leftward shift
-                     // discard some samples from the ring buffers.
-                     size_t size = floor(
-                        mRecordingSchedule.ToDiscard() * mRate );
-
-                     // The ring buffer might have grown concurrently -- don't discard more
-                     // than the "avail" value noted above.
-                     discarded = mCaptureBuffers[i]->Discard(std::min(avail, size));
-
-                     if (discarded < size)
-                        // We need to visit this again to complete the
-                        // discarding.
-                        latencyCorrected = false;
-                  }
-               }
-
                const float *pCrossfadeSrc = nullptr;
                size_t crossfadeStart = 0, totalCrossfadeLength = 0;
                if (i < mRecordingSchedule.mCrossfadeData.size())
@@ -2904,11 +3026,10 @@ void AudioIO::FillBuffers()
                   }
                }
 
-               wxASSERT(discarded <= avail);
-               size_t toGet = avail - discarded;
-               SampleBuffer temp;
-               size_t size;
-               sampleFormat format;
+               size_t toGet = region.Length();
+               SampleBuffer &temp = buffers[i];
+               size_t &size = sizes[i];
+               sampleFormat &format = formats[i];
                if( mFactor == 1.0 )
                {
                   // Take captured samples directly
@@ -2919,11 +3040,7 @@ void AudioIO::FillBuffers()
                   else
                      format = trackFormat;
                   temp.Allocate(size, format);
-                  const auto got =
-                     mCaptureBuffers[i]->Get(temp.ptr(), format, toGet);
-                  // wxASSERT(got == toGet);
-                  // but we can't assert in this thread
-                  wxUnusedVar(got);
+                  mCaptureBuffers->ReadChannel(i, region, temp.ptr(), format);
                   if (double(size) > remainingSamples)
                      size = floor(remainingSamples);
                }
@@ -2933,11 +3050,8 @@ void AudioIO::FillBuffers()
                   format = floatSample;
                   SampleBuffer temp1(toGet, floatSample);
                   temp.Allocate(size, format);
-                  const auto got =
-                     mCaptureBuffers[i]->Get(temp1.ptr(), floatSample, toGet);
-                  // wxASSERT(got == toGet);
-                  // but we can't assert in this thread
-                  wxUnusedVar(got);
+                  mCaptureBuffers->ReadChannel(
+                     i, region, temp1.ptr(), floatSample);
                   /* we are re-sampling on the fly. The last resampling call
                    * must flush any samples left in the rate conversion buffer
                    * so that they get recorded
@@ -2947,7 +3061,7 @@ void AudioIO::FillBuffers()
                         toGet = floor(remainingSamples);
                      const auto results =
                      mResample[i]->Process(mFactor, (float *)temp1.ptr(), toGet,
-                                           !IsStreamActive(), (float *)temp.ptr(), size);
+                                           flush, (float *)temp.ptr(), size);
                      size = results.second;
                   }
                }
@@ -2968,11 +3082,40 @@ void AudioIO::FillBuffers()
                      }
                   }
                }
+            };
+
+            // Only conversions to float are done concurrently, because
+            // dithering to narrower formats keeps state
+            if (mFillBuffersPool && mFactor != 1.0 && numChannels > 1)
+               mFillBuffersPool->ParallelFor(numChannels, convert);
+            else
+               for( i = 0; i < numChannels; i++ )
+                  convert(i);
+
+            for( i = 0; i < numChannels; i++ )
+            {
+               sampleFormat trackFormat = mCaptureTracks[i]->GetSampleFormat();
+
+               AutoSaveFile appendLog;
+
+               if (!mRecordingSchedule.mLatencyCorrected) {
+                  const auto correction = mRecordingSchedule.TotalCorrection();
+                  if (correction >= 0) {
+                     // Rightward shift
+                     // Once only (per track per recording), insert some initial
+                     // silence.
+                     size_t size = floor( correction * mRate * mFactor);
+                     SampleBuffer temp(size, trackFormat);
+                     ClearSamples(temp.ptr(), trackFormat, 0, size);
+                     mCaptureTracks[i]->Append(temp.ptr(), trackFormat,
+                                               size, 1, &appendLog);
+                  }
+               }
 
                // Now append
                // see comment in second handler about guarantee
-               mCaptureTracks[i]->Append(temp.ptr(), format,
-                  size, 1,
+               mCaptureTracks[i]->Append(buffers[i].ptr(), formats[i],
+                  sizes[i], 1,
                   &appendLog);
 
                if (!appendLog.IsEmpty())
@@ -2986,6 +3129,9 @@ void AudioIO::FillBuffers()
                }
             } // end loop over capture channels
 
+            mCaptureBuffers->Release(region.Length());
+            filled = true;
+
             // Now update the recording shedule position
             mRecordingSchedule.mPosition += avail / mRate;
             mRecordingSchedule.mLatencyCorrected = latencyCorrected;
@@ -3788,26 +3934,53 @@ bool AudioIoCallback::FillOutputBuffers(
       return true;
    }
 
+   // All channels are read first, then realtime effects process all groups
+   // of channels together, then all are mixed.  So each channel needs a
+   // buffer of its own.
+   struct GroupInfo
+   {
+      unsigned first;   // index of the group's first buffer
+      int chanCnt;
+      bool drop;
+      bool dropQuickly;
+      int rtGroup;      // index in rtGroups, or -1 if not processed
+      decltype(framesPerBuffer) len;
+   };
+
    // ------ MEMORY ALLOCATION ----------------------
    // These are small structures.
-   WaveTrack **chans = (WaveTrack **) alloca(numPlaybackChannels * sizeof(WaveTrack *));
-   float **tempBufs = (float **) alloca(numPlaybackChannels * sizeof(float *));
-
-   // And these are larger structures....
-   for (unsigned int c = 0; c < numPlaybackChannels; c++)
-      tempBufs[c] = (float *) alloca(framesPerBuffer * sizeof(float));
+   WaveTrack **chans = (WaveTrack **) alloca(numPlaybackTracks * sizeof(WaveTrack *));
+   float **tempBufs = (float **) alloca(numPlaybackTracks * sizeof(float *));
+   GroupInfo *groups = (GroupInfo *) alloca(numPlaybackTracks * sizeof(GroupInfo));
+   auto rtGroups = (RealtimeEffectManager::Group *)
+      alloca(numPlaybackTracks * sizeof(RealtimeEffectManager::Group));
+
+   // The larger ones, for samples, were allocated in StartStream(), because
+   // there may be hundreds of them
+   for (unsigned int c = 0; c < numPlaybackTracks; c++)
+      tempBufs[c] = mPlaybackScratch[c].get();
    // ------ End of MEMORY ALLOCATION ---------------
 
+   // If ever PortAudio asks for more than that, supply what fits, and leave
+   // the rest of the output silent as for an underrun
+   const auto frames = numPlaybackTracks > 0
+      ? std::min<unsigned long>(framesPerBuffer, mPlaybackScratchFrames)
+      : framesPerBuffer;
+
    auto & em = RealtimeEffectManager::Get();
    em.RealtimeProcessStart();
 
    bool selected = false;
    int group = 0;
+   int nRtGroups = 0;
+   unsigned first = 0;
    int chanCnt = 0;
 
-   // Choose a common size to take from all ring buffers
-   const auto toGet =
-      std::min<size_t>(framesPerBuffer, GetCommonlyReadyPlayback());
+   // Choose a common size to take from all channels of the ring buffer
+   PlanarRingBuffer::Region region{};
+   if (numPlaybackTracks > 0)
+      region = mPlaybackBuffers->GetReadRegion(frames);
+   const auto toGet = region.Length();
 
    // The drop and dropQuickly booleans are so named for historical reasons.
    // JKC: The original code attempted to be faster by doing nothing on silenced audio.
@@ -3827,7 +4000,7 @@ bool AudioIoCallback::FillOutputBuffers(
    for (unsigned t = 0; t < numPlaybackTracks; t++)
    {
       WaveTrack *vt = mPlaybackTracks[t].get();
-      chans[chanCnt] = vt;
+      chans[first + chanCnt] = vt;
 
       // TODO: more-than-two-channels
       auto nextTrack =
@@ -3843,11 +4016,6 @@ bool AudioIoCallback::FillOutputBuffers(
       if ( firstChannel )
       {
          selected = vt->GetSelected();
-         // IF mono THEN clear 'the other' channel.
-         if ( lastChannel && (numPlaybackChannels>1)) {
-            // TODO: more-than-two-channels
-            memset(tempBufs[1], 0, framesPerBuffer * sizeof(float));
-         }
          drop = TrackShouldBeSilent( *vt );
          dropQuickly = drop;
       }
@@ -3859,25 +4027,25 @@ bool AudioIoCallback::FillOutputBuffers(
 
       if (dropQuickly)
       {
-         len = mPlaybackBuffers[t]->Discard(framesPerBuffer);
+         // The samples are discarded with the others, after the loop
+         len = toGet;
          // keep going here.  
          // we may still need to issue a paComplete.
       }
       else
       {
-         len = mPlaybackBuffers[t]->Get((samplePtr)tempBufs[chanCnt],
-                                                   floatSample,
-                                                   toGet);
-         // wxASSERT( len == toGet );
-         if (len < framesPerBuffer)
+         mPlaybackBuffers->ReadChannel(t, region,
+            (samplePtr)tempBufs[first + chanCnt], floatSample);
+         len = toGet;
+         if (len < frames)
             // This used to happen normally at the end of non-looping
             // plays, but it can also be an anomalous case where the
             // supply from FillBuffers fails to keep up with the
             // real-time demand in this thread (see bug 1932).  We
             // must supply something to the sound card, so pad it with
             // zeroes and not random garbage.
-            memset((void*)&tempBufs[chanCnt][len], 0,
-               (framesPerBuffer - len) * sizeof(float));
+            memset((void*)&tempBufs[first + chanCnt][len], 0,
+               (frames - len) * sizeof(float));
          chanCnt++;
       }
 
@@ -3896,12 +4064,32 @@ bool AudioIoCallback::FillOutputBuffers(
       // Last channel of a track seen now
       len = mMaxFramesOutput;
 
-      if( !dropQuickly && selected )
-         len = em.RealtimeProcess(group, chanCnt, tempBufs, len);
+      auto &info = groups[group];
+      info = { first, chanCnt, drop, dropQuickly, -1, len };
+      if( !dropQuickly && selected ) {
+         info.rtGroup = nRtGroups;
+         rtGroups[nRtGroups++] =
+            { group, (unsigned)chanCnt, &tempBufs[first], len, len };
+      }
       group++;
 
+      first = t + 1;
+      chanCnt = 0;
+   }
+
+   // Let realtime effects process all groups, perhaps concurrently
+   if (nRtGroups > 0)
+      em.RealtimeProcess(rtGroups, nRtGroups);
+
+   for (int g = 0; g < group; g++)
+   {
+      const auto &info = groups[g];
+      auto len = info.len;
+      if (info.rtGroup >= 0)
+         len = rtGroups[info.rtGroup].processed;
+
       CallbackCheckCompletion(mCallbackReturn, len);
-      if (dropQuickly) // no samples to process, they've been discarded
+      if (info.dropQuickly) // no samples to process, they've been discarded
          continue;
 
       // Our channels aren't silent.  We need to pass their data on.
@@ -3914,22 +4102,25 @@ bool AudioIoCallback::FillOutputBuffers(
       //
       // Each channel in the tracks can output to more than one channel on the device.
       // For example mono channels output to both left and right output channels.
-      if (len > 0) for (int c = 0; c < chanCnt; c++)
+      if (len > 0) for (int c = 0; c < info.chanCnt; c++)
       {
-         vt = chans[c];
+         const auto vt = chans[info.first + c];
+         const auto buffer = tempBufs[info.first + c];
 
          if (vt->GetChannelIgnoringPan() == Track::LeftChannel ||
                vt->GetChannelIgnoringPan() == Track::MonoChannel )
-            AddToOutputChannel( 0, outputMeterFloats, outputFloats, tempFloats, tempBufs[c], drop, len, vt);
+            AddToOutputChannel( 0, outputMeterFloats, outputFloats, tempFloats, buffer, info.drop, len, vt);
 
          if (vt->GetChannelIgnoringPan() == Track::RightChannel ||
                vt->GetChannelIgnoringPan() == Track::MonoChannel  )
-            AddToOutputChannel( 1, outputMeterFloats, outputFloats, tempFloats, tempBufs[c], drop, len, vt);
+            AddToOutputChannel( 1, outputMeterFloats, outputFloats, tempFloats, buffer, info.drop, len, vt);
       }
-
-      chanCnt = 0;
    }
 
+   // Consume the samples of all channels together
+   if (numPlaybackTracks > 0)
+      mPlaybackBuffers->Release(toGet);
+
    // Poke: If there are no playback tracks, then the earlier check
    // about the time indicator being past the end won't happen;
    // do it here instead (but not if looping or scrubbing)
@@ -4001,9 +4192,8 @@ void AudioIoCallback::FillInputBuffers(
    // So we have not decided to enable this extra detection yet in
    // production
 
-   size_t len = framesPerBuffer;
-   for(unsigned t = 0; t < numCaptureChannels; t++)
-      len = std::min( len, mCaptureBuffers[t]->AvailForPut() );
+   size_t len = std::min<size_t>(
+      framesPerBuffer, mCaptureBuffers->AvailForPut() );
 
    if (mSimulateRecordingErrors && 100LL * rand() < RAND_MAX)
       // Make spurious errors for purposes of testing the error
@@ -4035,9 +4225,9 @@ void AudioIoCallback::FillInputBuffers(
    if (len <= 0) 
       return;
 
-   // We have an ASSERT in the AudioIO constructor to alert us to 
-   // possible issues with the (short*) cast.  We'd have a problem if
-   // sizeof(short) > sizeof(float) since our buffers are sized for floats.
+   // Un-interleave directly into the ring buffer, which holds samples in the
+   // format of the stream, then publish all channels at once
+   const auto region = mCaptureBuffers->GetWriteRegion(len);
    for(unsigned t = 0; t < numCaptureChannels; t++) {
 
       // dmazzoni:
@@ -4046,41 +4236,40 @@ void AudioIoCallback::FillInputBuffers(
       // it'd be nice to be able to call CopySamples, but it can't
       // handle multiplying by the gain and then clipping.  Bummer.
 
-      switch(mCaptureFormat) {
-         case floatSample: {
-            float *inputFloats = (float *)inputBuffer;
-            for(unsigned i = 0; i < len; i++)
-               tempFloats[i] =
-                  inputFloats[numCaptureChannels*i+t];
-         } break;
-         case int24Sample:
-            // We should never get here. Audacity's int24Sample format
-            // is different from PortAudio's sample format and so we
-            // make PortAudio return float samples when recording in
-            // 24-bit samples.
-            wxASSERT(false);
-            break;
-         case int16Sample: {
-            short *inputShorts = (short *)inputBuffer;
-            short *tempShorts = (short *)tempFloats;
-            for( unsigned i = 0; i < len; i++) {
-               float tmp = inputShorts[numCaptureChannels*i+t];
-               tmp = wxClip( -32768, tmp, 32767 );
-               tempShorts[i] = (short)(tmp);
-            }
-         } break;
-      } // switch
-
-      // JKC: mCaptureFormat must be for samples with sizeof(float) or
-      // fewer bytes (because tempFloats is sized for floats).  All 
-      // formats are 2 or 4 bytes, so we are OK.
-      const auto put =
-         mCaptureBuffers[t]->Put(
-            (samplePtr)tempFloats, mCaptureFormat, len);
-      // wxASSERT(put == len);
-      // but we can't assert in this thread
-      wxUnusedVar(put);
+      const auto dest = mCaptureBuffers->GetChannel(t);
+      const size_t starts[] = { region.start, 0 };
+      const size_t lengths[] = { region.first, region.second };
+      size_t frame = 0;
+      for (int segment = 0; segment < 2; ++segment) {
+         switch(mCaptureFormat) {
+            case floatSample: {
+               float *inputFloats = (float *)inputBuffer;
+               float *destFloats = (float *)dest + starts[segment];
+               for(unsigned i = 0; i < lengths[segment]; i++)
+                  destFloats[i] =
+                     inputFloats[numCaptureChannels*(frame + i)+t];
+            } break;
+            case int24Sample:
+               // We should never get here. Audacity's int24Sample format
+               // is different from PortAudio's sample format and so we
+               // make PortAudio return float samples when recording in
+               // 24-bit samples.
+               wxASSERT(false);
+               break;
+            case int16Sample: {
+               short *inputShorts = (short *)inputBuffer;
+               short *destShorts = (short *)dest + starts[segment];
+               for( unsigned i = 0; i < lengths[segment]; i++) {
+                  float tmp = inputShorts[numCaptureChannels*(frame + i)+t];
+                  tmp = wxClip( -32768, tmp, 32767 );
+                  destShorts[i] = (short)(tmp);
+               }
+            } break;
+         } // switch
+         frame += lengths[segment];
+      }
    }
+   mCaptureBuffers->CommitWrite(region.Length());
 }
 
 
@@ -4430,15 +4619,20 @@ PaStreamCallbackResult AudioIoCallback::CallbackDoSeek()
 
    mPlaybackSchedule.RealTimeInit( time );
 
-   // Reset mixer positions and flush buffers for all tracks
+   // Reset mixer positions for all tracks
    for (size_t i = 0; i < numPlaybackTracks; i++)
    {
       const bool skipping = true;
       mPlaybackMixers[i]->Reposition( time, skipping );
+   }
+
+   // Flush the ring buffer for all tracks
+   if (numPlaybackTracks > 0)
+   {
       const auto toDiscard =
-         mPlaybackBuffers[i]->AvailForGet();
+         mPlaybackBuffers->AvailForGet();
       const auto discarded =
-         mPlaybackBuffers[i]->Discard( toDiscard );
+         mPlaybackBuffers->Discard( toDiscard );
       // wxASSERT( discarded == toDiscard );
       // but we can't assert in this thread
       wxUnusedVar(discarded);
@@ -20,6 +20,7 @@
 #include "Experimental.h"
 
 #include <memory>
+#include <mutex>
 #include <utility>
 #include <wx/atomic.h> // member variable
 
@@ -48,10 +49,11 @@ using NoteTrackConstArray = std::vector < std::shared_ptr< const NoteTrack > >;
 class wxArrayString;
 class AudioIOBase;
 class AudioIO;
-class RingBuffer;
+class PlanarRingBuffer;
 class Mixer;
 class Resample;
 class AudioThread;
+class ThreadPool;
 class SelectedRegion;
 
 class AudacityProject;
@@ -419,12 +421,16 @@ public:
 #endif
 #endif
    ArrayOf<std::unique_ptr<Resample>> mResample;
-   ArrayOf<std::unique_ptr<RingBuffer>> mCaptureBuffers;
+   std::unique_ptr<PlanarRingBuffer> mCaptureBuffers;
    WaveTrackArray      mCaptureTracks;
-   ArrayOf<std::unique_ptr<RingBuffer>> mPlaybackBuffers;
+   std::unique_ptr<PlanarRingBuffer> mPlaybackBuffers;
    WaveTrackArray      mPlaybackTracks;
 
    ArrayOf<std::unique_ptr<Mixer>> mPlaybackMixers;
+   /// Scratch buffers for the callback, one for each playback track, each of
+   /// mPlaybackScratchFrames; kept off the callback thread's small stack
+   FloatBuffers        mPlaybackScratch;
+   size_t              mPlaybackScratchFrames{ 0 };
    static int          mNextStreamToken;
    double              mFactor;
    unsigned long       mMaxFramesOutput; // The actual number of frames output.
@@ -609,6 +615,18 @@ public:
    wxLongLong GetLastPlaybackTime() const { return mLastPlaybackTimeMillis; }
    AudacityProject *GetOwningProject() const { return mOwningProject; }
 
+   // Timing of the audio thread's fills of the ring buffers, since the start
+   // of the last stream.  A fill is late if it took longer than the playback
+   // that was queued when it began, so that the callback may have run dry.
+   struct FillStatistics {
+      size_t fills{};
+      size_t lateFills{};
+      double totalSeconds{};
+      double maxSeconds{};
+      double lastSeconds{};
+   };
+   FillStatistics GetFillStatistics() const;
+
 #ifdef EXPERIMENTAL_MIDI_OUT
    /** \brief Compute the current PortMidi timestamp time.
     *
@@ -782,6 +800,29 @@ private:
      *
      * If bOnlyBuffers is specified, it only cleans up the buffers. */
    void StartStreamCleanup(bool bOnlyBuffers = false);
+
+   /** \brief Make the pool of threads that help the audio thread in
+     * FillBuffers(), sized by preferences and the number of tracks */
+   void AllocateFillBuffersPool();
+
+   /** \brief Mix toProcess samples of every playback track into the ring
+     * buffer, padded with silence to frames.
+     *
+     * The mixers run on the fill pool when their recent cost makes that
+     * worthwhile, costliest first. */
+   void ProcessPlaybackMixers(size_t toProcess, size_t frames);
+
+   void RecordFill(double seconds, double deadline);
+
+   // Null when FillBuffers() works on the audio thread only
+   std::unique_ptr<ThreadPool> mFillBuffersPool;
+   // Seconds per sample of the last Process() of each playback mixer,
+   // negative if not yet measured
+   std::vector<double> mMixerCosts;
+   std::vector<size_t> mMixerOrder;
+
+   mutable std::mutex mFillStatisticsMutex;
+   FillStatistics mFillStatistics;
 };
 
 static constexpr unsigned ScrubPollInterval_ms = 50;
@@ -24,7 +24,10 @@ text or binary format to a file.
 #include "blockfile/SimpleBlockFile.h"
 #include "Sequence.h"
 
+#include <unordered_set>
+
 #include <wx/wxprec.h>
+#include <wx/ffile.h>
 #include <wx/filefn.h>
 #include <wx/dir.h>
 #include <wx/dialog.h>
@@ -226,6 +229,16 @@ XMLTagHandler* RecordingRecoveryHandler::HandleXMLChild(const wxChar *tag)
 // All strings are in native unicode format, 2-byte or 4-byte.
 //
 // All "lengths" are 2-byte signed, so are limited to 32767 bytes long.
+//
+// Autosave does not rewrite the file each time, but appends a journal of
+// records.  Each record, after FT_Record and its length, replaces the whole
+// document before it, but may repeat a fragment (a subtree, such as one
+// track) of an earlier record by its key, instead of writing it again.
+// Data appended after a record, such as recording logs, continue it.  A
+// record cut short by a crash is ignored, and the one before it recovered.
+//
+// Compact() rewrites the file as only the fragments that the last record
+// repeats, followed by that record.
 
 enum FieldTypes
 {
@@ -243,9 +256,310 @@ enum FieldTypes
    FT_Raw,           // type, string length, string
    FT_Push,          // type only
    FT_Pop,           // type only
-   FT_Name           // type, ID, name length, name
+   FT_Name,          // type, ID, name length, name
+   FT_Record,        // type, record length
+   FT_Fragment,      // type, key, subtree
+   FT_FragmentRef    // type, key
 };
 
+namespace {
+
+// Reads the fields of the data of an autosave file after the ident
+class AutoSaveDecoder
+{
+public:
+   AutoSaveDecoder(const char *data, size_t len)
+      : mData{ data }, end{ len }
+   {}
+
+   // Find the last whole record and the fragments; false if the data are
+   // not well formed
+   bool Scan()
+   {
+      try {
+         Fields(0, end, nullptr);
+      }
+      catch (const Truncated &) {
+         // Ignore what a crash cut short
+         end = mTruncatedAt;
+      }
+      catch (const Error &) {
+         return false;
+      }
+      return true;
+   }
+
+   // Decode the last record; false if it is not well formed.  Call after
+   // Scan().
+   bool Emit(XMLWriter &out)
+   {
+      mIds.clear();
+      mIdStack.clear();
+      mOpen.clear();
+      try {
+         Fields(lastRecord, end, &out);
+      }
+      catch (const Truncated &) {
+      }
+      catch (const Error &) {
+         return false;
+      }
+      return true;
+   }
+
+   // Offsets in the data of the subtrees of fragments, by key
+   std::unordered_map< int, std::pair< size_t, size_t > > fragments;
+   // Keys repeated by the last record
+   std::vector< int > refs;
+   // Offsets of the last record's FT_Record, or 0 if there is none, and of
+   // what follows its header
+   size_t lastRecordHeader{ 0 };
+   size_t lastRecord{ 0 };
+   // Offset of the end of all whole fields
+   size_t end;
+
+private:
+   struct Error{};
+   struct Truncated{};
+
+   template< typename T > void Read(wxInputStream &in, T &value)
+   {
+      if (in.Read(&value, sizeof(value)).LastRead() != sizeof(value))
+         throw Truncated{};
+   }
+
+   wxString ReadString(wxInputStream &in, size_t len, bool skip)
+   {
+      if (len % sizeof(wxChar))
+         throw Error{};
+      if (skip) {
+         if (in.GetLength() - in.TellI() < (wxFileOffset)len)
+            throw Truncated{};
+         in.SeekI(len, wxFromCurrent);
+         return {};
+      }
+      using WxChars = ArrayOf < wxChar >;
+      WxChars val{ len / sizeof(wxChar) };
+      if (in.Read(val.get(), len).LastRead() != len)
+         throw Truncated{};
+      return wxString(val.get(), len / sizeof(wxChar));
+   }
+
+   const wxString &Lookup(short id) const
+   {
+      auto iter = mIds.find( id );
+      if ( iter == mIds.end() )
+         throw Error{};
+      return iter->second;
+   }
+
+   void Tag(wxInputStream &in, XMLWriter *out,
+            void (XMLWriter::*fn)(const wxString &))
+   {
+      short id;
+      Read(in, id);
+      if (out)
+         (out->*fn)(Lookup(id));
+   }
+
+   template< typename T > void Value(wxInputStream &in, XMLWriter *out)
+   {
+      short id;
+      T val;
+      Read(in, id);
+      Read(in, val);
+      if (out)
+         out->WriteAttr(Lookup(id), val);
+   }
+
+   template< typename T > void ValueWithDigits(wxInputStream &in, XMLWriter *out)
+   {
+      short id;
+      T val;
+      int dig;
+      Read(in, id);
+      Read(in, val);
+      Read(in, dig);
+      if (out)
+         out->WriteAttr(Lookup(id), val, dig);
+   }
+
+   // Decode fields in [begin, finish), or only scan them if out is null
+   void Fields(size_t begin, size_t finish, XMLWriter *out)
+   {
+      wxMemoryInputStream in(mData + begin, finish - begin);
+      const bool scan = (out == nullptr);
+      size_t fieldStart = begin;
+
+      try { while ( ( fieldStart = begin + in.TellI() ) < finish ) {
+         short id;
+         const auto type = in.GetC();
+
+         switch (type)
+         {
+            case FT_Push:
+            {
+               mIdStack.push_back(mIds);
+               mIds.clear();
+            }
+            break;
+
+            case FT_Pop:
+            {
+               if (mIdStack.empty())
+                  throw Error{};
+               mIds = mIdStack.back();
+               mIdStack.pop_back();
+               if (!mOpen.empty() && mOpen.back().depth == mIdStack.size()) {
+                  fragments[mOpen.back().key] =
+                     { mOpen.back().start, begin + in.TellI() };
+                  mOpen.pop_back();
+               }
+            }
+            break;
+
+            case FT_Name:
+            {
+               short len;
+
+               Read(in, id);
+               Read(in, len);
+               mIds[id] = ReadString(in, len, false);
+            }
+            break;
+
+            case FT_StartTag:
+               Tag(in, out, &XMLWriter::StartTag);
+            break;
+
+            case FT_EndTag:
+               Tag(in, out, &XMLWriter::EndTag);
+            break;
+
+            case FT_String:
+            {
+               int len;
+
+               Read(in, id);
+               Read(in, len);
+               auto val = ReadString(in, len, scan);
+               if (!scan)
+                  out->WriteAttr(Lookup(id), val);
+            }
+            break;
+
+            case FT_Float:
+               ValueWithDigits<float>(in, out);
+            break;
+
+            case FT_Double:
+               ValueWithDigits<double>(in, out);
+            break;
+
+            case FT_Int:
+               Value<int>(in, out);
+            break;
+
+            case FT_Bool:
+               Value<bool>(in, out);
+            break;
+
+            case FT_Long:
+               Value<long>(in, out);
+            break;
+
+            case FT_LongLong:
+               Value<long long>(in, out);
+            break;
+
+            case FT_SizeT:
+               Value<size_t>(in, out);
+            break;
+
+            case FT_Data:
+            case FT_Raw:
+            {
+               int len;
+
+               Read(in, len);
+               auto val = ReadString(in, len, scan);
+               if (!scan) {
+                  if (type == FT_Data)
+                     out->WriteData(val);
+                  else
+                     out->Write(val);
+               }
+            }
+            break;
+
+            case FT_Record:
+            {
+               // Only scanning comes here, and a new document begins
+               size_t len;
+               Read(in, len);
+               const size_t start = begin + in.TellI();
+               if (finish - start < len)
+                  throw Truncated{};
+               lastRecordHeader = fieldStart;
+               lastRecord = start;
+               refs.clear();
+               mIds.clear();
+               mIdStack.clear();
+               mOpen.clear();
+            }
+            break;
+
+            case FT_Fragment:
+            {
+               // The subtree that follows is the fragment
+               int key;
+               Read(in, key);
+               mOpen.push_back({ key, mIdStack.size(), begin + in.TellI() });
+            }
+            break;
+
+            case FT_FragmentRef:
+            {
+               int key;
+               Read(in, key);
+               if (scan)
+                  refs.push_back(key);
+               else {
+                  auto iter = fragments.find(key);
+                  if (iter == fragments.end())
+                     throw Error{};
+                  Fields(iter->second.first, iter->second.second, out);
+               }
+            }
+            break;
+
+            default:
+               if (in.Eof())
+                  throw Truncated{};
+               throw Error{};
+         }
+      } }
+      catch (const Truncated &) {
+         mTruncatedAt = fieldStart;
+         throw;
+      }
+   }
+
+   struct OpenFragment {
+      int key;
+      size_t depth;
+      size_t start;
+   };
+
+   const char *mData;
+   IdMap mIds;
+   std::vector<IdMap> mIdStack;
+   std::vector<OpenFragment> mOpen;
+   size_t mTruncatedAt{ 0 };
+};
+
+}
+
 wxString AutoSaveFile::FailureMessage( const FilePath &/*filePath*/ )
 {
    return 
@@ -450,6 +764,54 @@ bool AutoSaveFile::IsEmpty() const
    return mBuffer.GetLength() == 0;
 }
 
+void AutoSaveFile::WriteFragment(int key, const AutoSaveFile & value)
+{
+   mBuffer.PutC(FT_Fragment);
+   mBuffer.Write(&key, sizeof(key));
+   WriteSubTree(value);
+}
+
+void AutoSaveFile::WriteFragmentRef(int key)
+{
+   mBuffer.PutC(FT_FragmentRef);
+   mBuffer.Write(&key, sizeof(key));
+}
+
+namespace {
+   void AppendStream(std::vector<char> &bytes, const wxMemoryOutputStream &os)
+   {
+      const wxStreamBuffer *buf = os.GetOutputStreamBuffer();
+      const char *start = static_cast<const char*>(buf->GetBufferStart());
+      bytes.insert(bytes.end(), start, start + buf->GetIntPosition());
+   }
+}
+
+std::vector<char> AutoSaveFile::GetRecord(bool first) const
+{
+   std::vector<char> bytes;
+   if (first)
+      bytes.insert(bytes.end(), AutoSaveIdent, AutoSaveIdent + strlen(AutoSaveIdent));
+   else
+   {
+      size_t len = mDict.GetOutputStreamBuffer()->GetIntPosition() +
+         mBuffer.GetOutputStreamBuffer()->GetIntPosition();
+      bytes.push_back(FT_Record);
+      const char *pLen = reinterpret_cast<const char*>(&len);
+      bytes.insert(bytes.end(), pLen, pLen + sizeof(len));
+   }
+   AppendStream(bytes, mDict);
+   AppendStream(bytes, mBuffer);
+   return bytes;
+}
+
+std::vector<char> AutoSaveFile::GetContinuation() const
+{
+   std::vector<char> bytes;
+   AppendStream(bytes, mDict);
+   AppendStream(bytes, mBuffer);
+   return bytes;
+}
+
 bool AutoSaveFile::Decode(const FilePath & fileName)
 {
    char ident[sizeof(AutoSaveIdent)];
@@ -512,17 +874,18 @@ bool AutoSaveFile::Decode(const FilePath & fileName)
 
    len = file.Length() - len;
    using Chars = ArrayOf < char >;
-   using WxChars = ArrayOf < wxChar >;
    Chars buf{ len };
    if (file.Read(buf.get(), len) != len)
    {
       return false;
    }
 
-   wxMemoryInputStream in(buf.get(), len);
-
    file.Close();
 
+   AutoSaveDecoder decoder{ buf.get(), len };
+   if (!decoder.Scan())
+      return false;
+
    // JKC: ANSWER-ME: Is the try catch actually doing anything?
    // If it is useful, why are we not using it everywhere?
    // If it isn't useful, why are we doing it here?
@@ -531,198 +894,72 @@ bool AutoSaveFile::Decode(const FilePath & fileName)
    return GuardedCall< bool >( [&] {
       XMLFileWriter out{ fileName, _("Error Decoding File") };
 
-      IdMap mIds;
-      std::vector<IdMap> mIdStack;
-
-      mIds.clear();
-   
-      struct Error{};
-      auto Lookup = [&mIds]( short id ) -> const wxString & {
-         auto iter = mIds.find( id );
-         if ( iter == mIds.end() )
-            throw Error{};
-         return iter->second;
-      };
-
-      try { while ( !in.Eof() ) {
-         short id;
-
-         switch (in.GetC())
-         {
-            case FT_Push:
-            {
-               mIdStack.push_back(mIds);
-               mIds.clear();
-            }
-            break;
-
-            case FT_Pop:
-            {
-               mIds = mIdStack.back();
-               mIdStack.pop_back();
-            }
-            break;
-
-            case FT_Name:
-            {
-               short len;
-
-               in.Read(&id, sizeof(id));
-               in.Read(&len, sizeof(len));
-               WxChars name{ len / sizeof(wxChar) };
-               in.Read(name.get(), len);
-
-               mIds[id] = wxString(name.get(), len / sizeof(wxChar));
-            }
-            break;
-
-            case FT_StartTag:
-            {
-               in.Read(&id, sizeof(id));
-
-               out.StartTag(Lookup(id));
-            }
-            break;
-
-            case FT_EndTag:
-            {
-               in.Read(&id, sizeof(id));
-
-               out.EndTag(Lookup(id));
-            }
-            break;
-
-            case FT_String:
-            {
-               int len;
-
-               in.Read(&id, sizeof(id));
-               in.Read(&len, sizeof(len));
-               WxChars val{ len / sizeof(wxChar) };
-               in.Read(val.get(), len);
-
-               out.WriteAttr(Lookup(id), wxString(val.get(), len / sizeof(wxChar)));
-            }
-            break;
-
-            case FT_Float:
-            {
-               float val;
-               int dig;
-
-               in.Read(&id, sizeof(id));
-               in.Read(&val, sizeof(val));
-               in.Read(&dig, sizeof(dig));
-
-               out.WriteAttr(Lookup(id), val, dig);
-            }
-            break;
-
-            case FT_Double:
-            {
-               double val;
-               int dig;
-
-               in.Read(&id, sizeof(id));
-               in.Read(&val, sizeof(val));
-               in.Read(&dig, sizeof(dig));
-
-               out.WriteAttr(Lookup(id), val, dig);
-            }
-            break;
-
-            case FT_Int:
-            {
-               int val;
-
-               in.Read(&id, sizeof(id));
-               in.Read(&val, sizeof(val));
-
-               out.WriteAttr(Lookup(id), val);
-            }
-            break;
-
-            case FT_Bool:
-            {
-               bool val;
-
-               in.Read(&id, sizeof(id));
-               in.Read(&val, sizeof(val));
-
-               out.WriteAttr(Lookup(id), val);
-            }
-            break;
-
-            case FT_Long:
-            {
-               long val;
-
-               in.Read(&id, sizeof(id));
-               in.Read(&val, sizeof(val));
-
-               out.WriteAttr(Lookup(id), val);
-            }
-            break;
-
-            case FT_LongLong:
-            {
-               long long val;
-
-               in.Read(&id, sizeof(id));
-               in.Read(&val, sizeof(val));
-
-               out.WriteAttr(Lookup(id), val);
-            }
-            break;
-
-            case FT_SizeT:
-            {
-               size_t val;
-
-               in.Read(&id, sizeof(id));
-               in.Read(&val, sizeof(val));
+      if (!decoder.Emit(out))
+         // return before committing, so we do not overwrite the recovery file!
+         return false;
 
-               out.WriteAttr(Lookup(id), val);
-            }
-            break;
+      out.Commit();
 
-            case FT_Data:
-            {
-               int len;
+      return true;
+   } );
+}
 
-               in.Read(&len, sizeof(len));
-               WxChars val{ len / sizeof(wxChar) };
-               in.Read(val.get(), len);
+bool AutoSaveFile::Compact(const FilePath & fileName)
+{
+   wxFFile file;
+   if (!file.Open(fileName, wxT("rb")))
+      return false;
 
-               out.WriteData(wxString(val.get(), len / sizeof(wxChar)));
-            }
-            break;
+   const size_t identLen = strlen(AutoSaveIdent);
+   const size_t len = file.Length();
+   using Chars = ArrayOf < char >;
+   Chars buf{ len };
+   if (len < identLen || file.Read(buf.get(), len) != len ||
+       strncmp(buf.get(), AutoSaveIdent, identLen) != 0)
+      return false;
+   file.Close();
 
-            case FT_Raw:
-            {
-               int len;
+   AutoSaveDecoder decoder{ buf.get() + identLen, len - identLen };
+   if (!decoder.Scan())
+      return false;
+   if (decoder.lastRecordHeader == 0)
+      // Nothing to drop
+      return true;
 
-               in.Read(&len, sizeof(len));
-               WxChars val{ len / sizeof(wxChar) };
-               in.Read(val.get(), len);
+   const wxString tempName = fileName + wxT(".tmp");
+   if (!file.Open(tempName, wxT("wb")))
+      return false;
 
-               out.Write(wxString(val.get(), len / sizeof(wxChar)));
-            }
-            break;
+   bool success = file.Write(AutoSaveIdent, identLen) == identLen;
 
-            default:
-               wxASSERT(true);
-            break;
-         }
-      } }
-      catch( const Error & )
-      {
-         // return before committing, so we do not overwrite the recovery file!
-         return false;
-      }
+   // The fragments that the last record repeats from before it
+   std::unordered_set<int> written;
+   for (auto key : decoder.refs)
+   {
+      auto iter = decoder.fragments.find(key);
+      if (!success || iter == decoder.fragments.end() ||
+          iter->second.first >= decoder.lastRecordHeader ||
+          !written.insert(key).second)
+         continue;
+      const char type = FT_Fragment;
+      const auto &range = iter->second;
+      const size_t size = range.second - range.first;
+      success =
+         file.Write(&type, 1) == 1 &&
+         file.Write(&key, sizeof(key)) == sizeof(key) &&
+         file.Write(buf.get() + identLen + range.first, size) == size;
+   }
 
-      out.Commit();
+   // Then the last record, and whatever continues it
+   const size_t size = decoder.end - decoder.lastRecordHeader;
+   success = success &&
+      file.Write(buf.get() + identLen + decoder.lastRecordHeader, size) == size;
+   success = file.Close() && success;
 
-      return true;
-   } );
+   if (!success || !wxRenameFile(tempName, fileName))
+   {
+      wxRemoveFile(tempName);
+      return false;
+   }
+   return true;
 }
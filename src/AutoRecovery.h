@@ -16,6 +16,7 @@
 #include <wx/mstream.h> // member variables
 
 #include <unordered_map>
+#include <vector>
 #include "audacity/Types.h"
 
 class wxFFile;
@@ -89,6 +90,17 @@ public:
 
    bool IsEmpty() const;
 
+   // For the journal that autosave appends to: each record replaces the
+   // document before it, but may repeat fragments of earlier records by key
+   void WriteFragment(int key, const AutoSaveFile & value);
+   void WriteFragmentRef(int key);
+   // The bytes to append for a new record; the first also makes the file's ident
+   std::vector<char> GetRecord(bool first) const;
+   // The bytes to append that continue the last record
+   std::vector<char> GetContinuation() const;
+   // Rewrite the file as its last record, and only the fragments that it repeats
+   static bool Compact(const FilePath & fileName);
+
    bool Decode(const FilePath & fileName);
 
 private:
@@ -0,0 +1,140 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  AutoSaveJournal.cpp
+
+*******************************************************************//**
+
+\class AutoSaveJournal
+\brief Appends the records of a project's autosave file on a thread of
+its own, so that autosave never waits for the disk.
+
+  Records are written in the order they were appended.  Compaction happens
+  on the same thread, between records, so it never sees half a record.
+
+*//*******************************************************************/
+
+#include "Audacity.h"
+#include "AutoSaveJournal.h"
+
+#include <algorithm>
+
+#include <wx/ffile.h>
+#include <wx/filefn.h>
+
+#include "AutoRecovery.h"
+
+namespace {
+   // Don't compact a file smaller than this
+   const unsigned long long MinCompactedSize = 1024 * 1024;
+}
+
+AutoSaveJournal::AutoSaveJournal( const FilePath &fileName )
+   : mFileName{ fileName }
+{
+   mThread = std::thread( [this]{ Run(); } );
+}
+
+AutoSaveJournal::~AutoSaveJournal()
+{
+   {
+      std::lock_guard< std::mutex > lock{ mMutex };
+      mStopping = true;
+   }
+   mCondition.notify_one();
+   mThread.join();
+}
+
+void AutoSaveJournal::AppendRecord( const AutoSaveFile &record )
+{
+   const bool first = !mStarted;
+   mStarted = true;
+   Push( record.GetRecord( first ), first );
+}
+
+void AutoSaveJournal::AppendContinuation( const AutoSaveFile &data )
+{
+   // There is nothing to continue before the first record
+   if ( mStarted )
+      Push( data.GetContinuation(), false );
+}
+
+bool AutoSaveJournal::Flush()
+{
+   std::unique_lock< std::mutex > lock{ mMutex };
+   mFlushed.wait( lock, [this]{ return mItems.empty() && !mWriting; } );
+   return !mFailed;
+}
+
+void AutoSaveJournal::Push( std::vector< char > &&bytes, bool first )
+{
+   {
+      std::lock_guard< std::mutex > lock{ mMutex };
+      mItems.push_back( { std::move( bytes ), first } );
+   }
+   mCondition.notify_one();
+}
+
+void AutoSaveJournal::Run()
+{
+   std::unique_lock< std::mutex > lock{ mMutex };
+   while ( true ) {
+      mCondition.wait( lock, [this]{ return mStopping || !mItems.empty(); } );
+      if ( mItems.empty() )
+         // Stopping, and all is written
+         return;
+
+      auto item = std::move( mItems.front() );
+      mItems.pop_front();
+      mWriting = true;
+      lock.unlock();
+
+      if ( !mFailed && !Write( item.bytes, item.first ) )
+         mFailed = true;
+
+      lock.lock();
+      mWriting = false;
+      mFlushed.notify_all();
+   }
+}
+
+bool AutoSaveJournal::Write( const std::vector< char > &bytes, bool first )
+{
+   const auto size = bytes.size();
+   if ( first ) {
+      const wxString tempName = mFileName + wxT(".tmp");
+      wxFFile file;
+      if ( !file.Open( tempName, wxT("wb") ) )
+         return false;
+      const bool success = file.Write( bytes.data(), size ) == size;
+      if ( !( file.Close() && success ) ||
+           !wxRenameFile( tempName, mFileName ) ) {
+         wxRemoveFile( tempName );
+         return false;
+      }
+      mSize = mCompactedSize = size;
+      return true;
+   }
+
+   {
+      wxFFile file;
+      if ( !file.Open( mFileName, wxT("ab") ) ||
+           file.Write( bytes.data(), size ) != size ||
+           !file.Close() )
+         return false;
+   }
+   mSize += size;
+
+   if ( mSize > 2 * std::max( mCompactedSize, MinCompactedSize ) ) {
+      // A failure leaves the file as it was, which is still good
+      if ( AutoSaveFile::Compact( mFileName ) ) {
+         wxFFile file{ mFileName, wxT("rb") };
+         if ( file.IsOpened() )
+            mSize = file.Length();
+      }
+      mCompactedSize = mSize;
+   }
+
+   return true;
+}
@@ -0,0 +1,80 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  AutoSaveJournal.h
+
+**********************************************************************/
+
+#ifndef __AUDACITY_AUTOSAVE_JOURNAL__
+#define __AUDACITY_AUTOSAVE_JOURNAL__
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "audacity/Types.h"
+
+class AutoSaveFile;
+
+/// \brief Appends the records of a project's autosave file on a thread of
+/// its own, so that autosave never waits for the disk.
+///
+/// The first record is written to a temporary file, which is then renamed,
+/// so that recovery never finds a partial file.  The others are appended.
+/// When the file has grown to twice its size after the last compaction,
+/// it is compacted to only what its last record needs.
+class AutoSaveJournal final
+{
+public:
+   /// The file is created by the first record
+   explicit AutoSaveJournal( const FilePath &fileName );
+   AutoSaveJournal( const AutoSaveJournal& ) = delete;
+   AutoSaveJournal &operator= ( const AutoSaveJournal& ) = delete;
+   /// Writes all that was appended before returning
+   ~AutoSaveJournal();
+
+   const FilePath &GetFileName() const { return mFileName; }
+
+   /// Queue a record that replaces the whole document
+   void AppendRecord( const AutoSaveFile &record );
+   /// Queue data that continue the last record, such as recording logs; may
+   /// be called from another thread than AppendRecord
+   void AppendContinuation( const AutoSaveFile &data );
+
+   /// Wait until all that was appended is written; returns !Failed()
+   bool Flush();
+
+   /// Whether some write failed, after which nothing more is written
+   bool Failed() const { return mFailed; }
+
+private:
+   void Push( std::vector< char > &&bytes, bool first );
+   void Run();
+   bool Write( const std::vector< char > &bytes, bool first );
+
+   const FilePath mFileName;
+   std::atomic< bool > mStarted{ false };
+
+   std::thread mThread;
+   std::mutex mMutex;
+   std::condition_variable mCondition;
+   std::condition_variable mFlushed;
+   struct Item {
+      std::vector< char > bytes;
+      bool first;
+   };
+   std::deque< Item > mItems;
+   bool mStopping{ false };
+   bool mWriting{ false };
+   std::atomic< bool > mFailed{ false };
+
+   // Used only by the thread
+   unsigned long long mSize{ 0 };
+   unsigned long long mCompactedSize{ 0 };
+};
+
+#endif
@@ -0,0 +1,150 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  BatchRunner.cpp
+
+*******************************************************************//**
+
+\namespace BatchRunner
+\brief Applies a macro to files named on the command line, with no
+project window, for unattended processing of many files.
+
+*//*******************************************************************/
+
+#include "Audacity.h"
+#include "BatchRunner.h"
+
+#include <algorithm>
+#include <vector>
+
+#include <wx/app.h>
+#include <wx/intl.h>
+#include <wx/process.h>
+#include <wx/utils.h>
+
+#include "AudacityException.h"
+#include "BatchCommands.h"
+#include "MemoryX.h"
+#include "PlatformCompatibility.h"
+#include "ProjectFileManager.h"
+#include "ProjectManager.h"
+#include "SelectUtilities.h"
+
+namespace {
+
+/// One child process, which processes one file
+class BatchProcess final : public wxProcess
+{
+public:
+   explicit BatchProcess( const FilePath &file )
+      : mFile{ file }
+   {}
+
+   bool IsActive() const { return mActive; }
+   int GetStatus() const { return mStatus; }
+   const FilePath &GetFile() const { return mFile; }
+
+   void OnTerminate(int WXUNUSED( pid ), int status) override
+   {
+      mStatus = status;
+      mActive = false;
+   }
+
+private:
+   const FilePath mFile;
+   bool mActive{ true };
+   int mStatus{ -1 };
+};
+
+}
+
+unsigned BatchRunner::Run( AudacityProject &project,
+   const wxString &macro, const FilePaths &files )
+{
+   MacroCommands commands;
+   if ( !commands.ReadMacro( macro ) ) {
+      wxPrintf( _("Macro not found: %s\n"), macro.wx_str() );
+      return files.size();
+   }
+   MacroCommandsCatalog catalog( &project );
+
+   unsigned nFailed = 0;
+   for ( const auto &file : files ) {
+      auto success = GuardedCall< bool >( [&] {
+         if ( !ProjectFileManager::Get( project ).Import( file ) )
+            return false;
+         SelectUtilities::DoSelectAll( project );
+         return commands.ApplyMacro( catalog );
+      } );
+
+      if ( success )
+         wxPrintf( _("Processed %s\n"), file.wx_str() );
+      else {
+         wxPrintf( _("Failed to process %s\n"), file.wx_str() );
+         ++nFailed;
+      }
+
+      ProjectManager::Get( project ).ResetProjectToEmpty();
+   }
+
+   return nFailed;
+}
+
+unsigned BatchRunner::RunInProcesses(
+   const wxString &macro, const FilePaths &files, unsigned jobs )
+{
+   const auto &cmdpath = PlatformCompatibility::GetExecutablePath();
+   jobs = std::max( 1u, jobs );
+
+   std::vector< std::unique_ptr< BatchProcess > > running;
+   unsigned nFailed = 0;
+   size_t next = 0;
+
+   // Reap the finished processes
+   auto reap = [&] {
+      auto end = std::remove_if( running.begin(), running.end(),
+         [&]( const std::unique_ptr< BatchProcess > &pProcess ) {
+            if ( pProcess->IsActive() )
+               return false;
+            if ( pProcess->GetStatus() != 0 ) {
+               wxPrintf( _("Failed to process %s\n"),
+                  pProcess->GetFile().wx_str() );
+               ++nFailed;
+            }
+            return true;
+         } );
+      running.erase( end, running.end() );
+   };
+
+   while ( next < files.size() || !running.empty() ) {
+      // Start processes while there are files and free jobs
+      while ( next < files.size() && running.size() < jobs ) {
+         const auto &file = files[ next++ ];
+
+         // One file and one job for the child, so that it does the work
+         // itself.  The arguments go separately, not quoted in one string,
+         // so that no file name can be taken for more than one argument
+         const wxChar *const cmd[] = {
+            cmdpath.wx_str(), wxT("--macro"), macro.wx_str(),
+            wxT("--jobs"), wxT("1"), file.wx_str(), nullptr
+         };
+
+         auto pProcess = std::make_unique< BatchProcess >( file );
+         if ( wxExecute( cmd, wxEXEC_ASYNC, pProcess.get() ) <= 0 ) {
+            wxPrintf( _("Failed to process %s\n"), file.wx_str() );
+            ++nFailed;
+            pProcess->Detach();
+            continue;
+         }
+         running.push_back( std::move( pProcess ) );
+      }
+
+      // Wait for processes to terminate
+      wxMilliSleep( 10 );
+      wxTheApp->Yield();
+      reap();
+   }
+
+   return nFailed;
+}
@@ -0,0 +1,36 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  BatchRunner.h
+
+**********************************************************************/
+
+#ifndef __AUDACITY_BATCH_RUNNER__
+#define __AUDACITY_BATCH_RUNNER__
+
+#include "audacity/Types.h"
+
+class AudacityProject;
+
+/// \brief Applies a macro to files named on the command line, with no
+/// project window, for unattended processing of many files.
+///
+/// With more than one file and more than one job, the files are given to
+/// child Audacity processes, one file each, so that every file gets a
+/// project and a temporary directory of its own.  As many run at once as
+/// there are jobs.
+namespace BatchRunner
+{
+   /// Import each file into the empty project, apply the macro, and empty
+   /// the project again; returns the number of files that failed
+   unsigned Run( AudacityProject &project,
+      const wxString &macro, const FilePaths &files );
+
+   /// Run this program again for each file, in at most jobs processes at
+   /// once; returns the number of files that failed
+   unsigned RunInProcesses(
+      const wxString &macro, const FilePaths &files, unsigned jobs );
+}
+
+#endif
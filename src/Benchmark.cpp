@@ -18,6 +18,8 @@ of the BlockFile system.
 #include "Audacity.h"
 #include "Benchmark.h"
 
+#include <cmath>
+
 #include <wx/app.h>
 #include <wx/log.h>
 #include <wx/textctrl.h>
@@ -34,14 +36,22 @@ of the BlockFile system.
 #include <wx/valtext.h>
 #include <wx/intl.h>
 
+#include "BlockFileCache.h"
 #include "DirManager.h"
+#include "Dither.h"
+#include "Mix.h"
+#include "MixKernels.h"
+#include "Resample.h"
+#include "SampleFormatKernels.h"
 #include "ShuttleGui.h"
+#include "ThreadPool.h"
 #include "Project.h"
 #include "WaveClip.h"
 #include "WaveTrack.h"
 #include "Sequence.h"
 #include "Prefs.h"
 #include "ViewInfo.h"
+#include "prefs/SpectrogramSettings.h"
 
 #include "FileNames.h"
 #include "widgets/AudacityMessageBox.h"
@@ -62,6 +72,11 @@ private:
    void OnClear( wxCommandEvent &event );
    void OnClose( wxCommandEvent &event );
 
+   void ConversionBenchmark(long dataSize);
+   void SpectrogramBenchmark(long dataSize);
+   void MixBenchmark(long dataSize);
+   void ResampleBenchmark(long dataSize);
+
    void Printf(const wxChar *format, ...);
    void HoldPrint(bool hold);
    void FlushPrint();
@@ -76,6 +91,10 @@ private:
 
    bool      mBlockDetail;
    bool      mEditDetail;
+   bool      mConversions;
+   bool      mSpectrograms;
+   bool      mMixing;
+   bool      mResampling;
 
    wxTextCtrl  *mText;
 
@@ -144,6 +163,10 @@ BenchmarkDialog::BenchmarkDialog(wxWindow *parent):
 
    mBlockDetail = false;
    mEditDetail = false;
+   mConversions = false;
+   mSpectrograms = false;
+   mMixing = false;
+   mResampling = false;
 
    HoldPrint(false);
 
@@ -213,6 +236,26 @@ void BenchmarkDialog::MakeBenchmarkDialog()
                            false);
       item->SetValidator(wxGenericValidator(&mEditDetail));
 
+      //
+      item = S.AddCheckBox(_("Also time sample format conversions"),
+                           false);
+      item->SetValidator(wxGenericValidator(&mConversions));
+
+      //
+      item = S.AddCheckBox(_("Also time spectrogram computation"),
+                           false);
+      item->SetValidator(wxGenericValidator(&mSpectrograms));
+
+      //
+      item = S.AddCheckBox(_("Also time mixing of many tracks"),
+                           false);
+      item->SetValidator(wxGenericValidator(&mMixing));
+
+      //
+      item = S.AddCheckBox(_("Also time resampling of many channels"),
+                           false);
+      item->SetValidator(wxGenericValidator(&mResampling));
+
       //
       mText = S.Id(StaticTextID).AddTextWindow(wxT(""));
       /* i18n-hint noun */
@@ -361,6 +404,18 @@ void BenchmarkDialog::OnRun( wxCommandEvent & WXUNUSED(event))
 
    HoldPrint(true);
 
+   if (mConversions)
+      ConversionBenchmark(dataSize);
+
+   if (mSpectrograms)
+      SpectrogramBenchmark(dataSize);
+
+   if (mMixing)
+      MixBenchmark(dataSize);
+
+   if (mResampling)
+      ResampleBenchmark(dataSize);
+
    ZoomInfo zoomInfo(0.0, ZoomInfo::GetDefaultZoom());
    auto dd = DirManager::Create();
    const auto t = TrackFactory{ dd, &zoomInfo }.NewWaveTrack(int16Sample);
@@ -505,6 +560,9 @@ void BenchmarkDialog::OnRun( wxCommandEvent & WXUNUSED(event))
    FlushPrint();
    wxTheApp->Yield();
 
+   // Count how the reads below use the cache of sample data
+   BlockFileCache::Get().ResetStatistics();
+
    bad = 0;
    timer.Start();
    for (size_t i = 0; i < nChunks; i++) {
@@ -545,6 +603,13 @@ void BenchmarkDialog::OnRun( wxCommandEvent & WXUNUSED(event))
 
    Printf(_("Time to check all data (2): %ld ms\n"), elapsed);
 
+   {
+      const auto stats = BlockFileCache::Get().GetStatistics();
+      Printf(_("Sample cache: %llu hits, %llu misses, %d blocks (%.1f MB) cached\n"),
+         stats.hits, stats.misses, (int)stats.entries,
+         stats.bytes / (1024.0 * 1024.0));
+   }
+
    Printf(_("At 44100 Hz, 16-bits per sample, the estimated number of\n simultaneous tracks that could be played at once: %.1f\n"),
           (nChunks*chunkSize/44100.0)/(elapsed/1000.0));
 
@@ -560,3 +625,401 @@ void BenchmarkDialog::OnRun( wxCommandEvent & WXUNUSED(event))
    Printf(_("Benchmark completed successfully.\n"));
    HoldPrint(false);
 }
+
+// Times Dither::Apply for each pair of formats and each dither, with each
+// instruction set that the processor supports, converting the test data
+// size of samples in buffers of a typical size for block files.  Results
+// without dither must agree exactly with the scalar loops.
+void BenchmarkDialog::ConversionBenchmark(long dataSize)
+{
+   using namespace SampleFormatKernels;
+
+   const auto oldSet = Get();
+   const auto cleanup = finally( [&] { Set(oldSet); } );
+
+   struct Case {
+      sampleFormat from, to;
+      DitherType dither;
+      unsigned stride;
+   };
+   static const Case cases[] = {
+      { int16Sample, floatSample, DitherType::none, 1 },
+      { int24Sample, floatSample, DitherType::none, 1 },
+      { int16Sample, int24Sample, DitherType::none, 1 },
+      { floatSample, int16Sample, DitherType::none, 1 },
+      { floatSample, int16Sample, DitherType::rectangle, 1 },
+      { floatSample, int16Sample, DitherType::triangle, 1 },
+      { floatSample, int16Sample, DitherType::shaped, 1 },
+      { floatSample, int24Sample, DitherType::none, 1 },
+      { floatSample, int24Sample, DitherType::triangle, 1 },
+      { floatSample, int24Sample, DitherType::shaped, 1 },
+      { int24Sample, int16Sample, DitherType::none, 1 },
+      { int24Sample, int16Sample, DitherType::triangle, 1 },
+      // Interleaved stereo, as for recording and exporting
+      { floatSample, int16Sample, DitherType::none, 2 },
+      { floatSample, int16Sample, DitherType::shaped, 2 },
+   };
+   static const wxChar *ditherNames[] = {
+      wxT("no"), wxT("rectangle"), wxT("triangle"), wxT("shaped") };
+
+   const size_t bufferSize = 65536;
+   const size_t nBuffers =
+      std::max<size_t>(1, dataSize * 1048576 / (bufferSize * sizeof(float)));
+
+   // Random samples, a tenth of them out of range for float
+   Floats floats{ bufferSize };
+   ArrayOf<int> ints{ bufferSize };
+   ArrayOf<short> shorts{ bufferSize };
+   for (size_t i = 0; i < bufferSize; i++) {
+      floats[i] = 2.2f * (rand() / (float)RAND_MAX - 0.5f);
+      ints[i] = (rand() % (1 << 24)) - (1 << 23);
+      shorts[i] = short(rand());
+   }
+   const auto Source = [&](sampleFormat format) {
+      return format == floatSample ? (samplePtr)floats.get()
+         : format == int24Sample ? (samplePtr)ints.get()
+         : (samplePtr)shorts.get();
+   };
+
+   Printf(_("Converting %d buffers of %d samples...\n"),
+      (int)nBuffers, (int)bufferSize);
+   wxTheApp->Yield();
+   FlushPrint();
+
+   ArrayOf<int> result{ bufferSize }, scalarResult{ bufferSize };
+   for (const auto &c : cases) {
+      Printf(wxT("%s to %s, %s dither%s:"),
+         GetSampleFormatStr(c.from), GetSampleFormatStr(c.to),
+         ditherNames[c.dither],
+         c.stride > 1 ? wxT(", interleaved") : wxT(""));
+      const auto len = bufferSize / c.stride;
+      long scalarElapsed = 0;
+      for (int set = (int)InstructionSet::Scalar;
+           set <= (int)GetBest(); set++) {
+         Set((InstructionSet)set);
+         Dither dither;
+         wxStopWatch timer;
+         for (size_t i = 0; i < nBuffers; i++)
+            dither.Apply(c.dither, Source(c.from), c.from,
+               (samplePtr)result.get(), c.to, len, c.stride, c.stride);
+         const long elapsed = timer.Time();
+
+         Printf(wxT("  %s %ld ms"),
+            wxString::FromAscii(GetName((InstructionSet)set)).wx_str(),
+            elapsed);
+         if (set == (int)InstructionSet::Scalar) {
+            scalarElapsed = elapsed;
+            memcpy(scalarResult.get(), result.get(), bufferSize * sizeof(int));
+         }
+         else {
+            if (elapsed > 0)
+               Printf(wxT(" (%.1fx)"), scalarElapsed / (double)elapsed);
+            if (c.dither == DitherType::none &&
+                memcmp(scalarResult.get(), result.get(),
+                       len * c.stride * SAMPLE_SIZE(c.to)))
+               Printf(_(" DIFFERENT RESULT!"));
+         }
+      }
+      Printf(wxT("\n"));
+      wxTheApp->Yield();
+      FlushPrint();
+   }
+}
+
+// Times the spectrograms of a clip of the test data size of noise at
+// 96 kHz, for each algorithm and window size, on one thread and on all
+// threads of the pool.  Results of the short time Fourier transform must
+// agree exactly.
+void BenchmarkDialog::SpectrogramBenchmark(long dataSize)
+{
+   // The window size is private to the settings, which load it from
+   // preferences
+   const wxString fftSizeKey{ wxT("/Spectrum/FFTSize") };
+   const bool hadFFTSize = gPrefs->HasEntry(fftSizeKey);
+   const long oldFFTSize = gPrefs->Read(fftSizeKey, 1024L);
+   const auto cleanup = finally( [&] {
+      SpecCache::SetMaxConcurrency(0);
+      if (hadFFTSize)
+         gPrefs->Write(fftSizeKey, oldFFTSize);
+      else
+         gPrefs->DeleteEntry(fftSizeKey);
+      gPrefs->Flush();
+   } );
+
+   ZoomInfo zoomInfo(0.0, ZoomInfo::GetDefaultZoom());
+   auto dd = DirManager::Create();
+   const auto t =
+      TrackFactory{ dd, &zoomInfo }.NewWaveTrack(floatSample, 96000);
+
+   const size_t bufferSize = 65536;
+   const size_t nBuffers =
+      std::max<size_t>(1, dataSize * 1048576 / (bufferSize * sizeof(float)));
+   Floats noise{ bufferSize };
+   for (size_t i = 0; i < nBuffers; i++) {
+      for (size_t j = 0; j < bufferSize; j++)
+         noise[j] = rand() / (float)RAND_MAX - 0.5f;
+      t->Append((samplePtr)noise.get(), floatSample, bufferSize);
+   }
+   t->Flush();
+
+   const auto clip = t->GetClipByIndex(0);
+   WaveTrackCache cache{ t };
+   auto &settings = t->GetIndependentSpectrogramSettings();
+
+   const size_t numPixels = 2000;
+   const double pixelsPerSecond = numPixels / t->GetEndTime();
+   const size_t nThreads = ThreadPool::Get().GetConcurrency();
+
+   Printf(_("Computing spectrograms of %d columns, %.1f seconds each...\n"),
+      (int)numPixels, t->GetEndTime() / numPixels);
+   wxTheApp->Yield();
+   FlushPrint();
+
+   static const int algorithms[] = {
+      SpectrogramSettings::algSTFT, SpectrogramSettings::algReassignment };
+   static const long windowSizes[] = { 256, 1024, 4096, 16384 };
+   std::vector<float> serialResult;
+   for (auto algorithm : algorithms) {
+      for (auto windowSize : windowSizes) {
+         gPrefs->Write(fftSizeKey, windowSize);
+         settings.LoadPrefs();
+         settings.algorithm = algorithm;
+
+         Printf(wxT("%s, window %ld:"),
+            SpectrogramSettings::GetAlgorithmNames()[algorithm].wx_str(),
+            windowSize);
+         for (auto concurrency : { size_t(1), nThreads }) {
+            SpecCache::SetMaxConcurrency(concurrency);
+            const float *spectrogram = nullptr;
+            const sampleCount *where = nullptr;
+            long columns = 0, elapsed;
+            wxStopWatch timer;
+            do {
+               clip->MarkChanged();
+               clip->GetSpectrogram(cache, spectrogram, where,
+                  numPixels, t->GetStartTime(), pixelsPerSecond);
+               columns += numPixels;
+            } while ((elapsed = timer.Time()) < 1000);
+
+            Printf(wxT("  %d threads %.0f columns/s"), (int)concurrency,
+               columns * 1000.0 / std::max(1L, elapsed));
+
+            const size_t size = numPixels * settings.NBins();
+            if (concurrency == 1)
+               serialResult.assign(spectrogram, spectrogram + size);
+            else if (algorithm == SpectrogramSettings::algSTFT &&
+                     !std::equal(serialResult.begin(), serialResult.end(),
+                                 spectrogram))
+               Printf(_(" DIFFERENT RESULT!"));
+         }
+         Printf(wxT("\n"));
+         wxTheApp->Yield();
+         FlushPrint();
+      }
+   }
+}
+
+// Times the mixing of many tracks, as Mixer does it: each track's samples
+// are multiplied by its envelope values, then added with its channel gains
+// into mono, interleaved stereo, and non-interleaved stereo buffers.  Uses
+// each instruction set that the processor supports, on the test data size
+// of samples in all.  Results must agree exactly with the scalar loops.
+void BenchmarkDialog::MixBenchmark(long dataSize)
+{
+   using namespace SampleFormatKernels;
+
+   const auto oldSet = Get();
+   const auto cleanup = finally( [&] { Set(oldSet); } );
+
+   struct Case {
+      unsigned numChannels;
+      bool interleaved;
+   };
+   static const Case cases[] = {
+      { 1, false },
+      { 2, true },
+      { 2, false },
+   };
+
+   const size_t nTracks = 128;
+   const size_t bufferSize = 4096;
+   const size_t nBuffers = std::max<size_t>(1,
+      dataSize * 1048576 / (nTracks * bufferSize * sizeof(float)));
+
+   // Random samples, envelope values, and gains for each track
+   Floats samples{ nTracks * bufferSize };
+   Floats envelopes{ nTracks * bufferSize };
+   Floats gains{ nTracks * 2 };
+   for (size_t i = 0; i < nTracks * bufferSize; i++) {
+      samples[i] = rand() / (float)RAND_MAX - 0.5f;
+      envelopes[i] = rand() / (float)RAND_MAX;
+   }
+   for (size_t i = 0; i < nTracks * 2; i++)
+      gains[i] = rand() / (float)RAND_MAX;
+   int channelFlags[2] = { 1, 1 };
+
+   Printf(_("Mixing %d tracks, %d buffers of %d samples each...\n"),
+      (int)nTracks, (int)nBuffers, (int)bufferSize);
+   wxTheApp->Yield();
+   FlushPrint();
+
+   Floats temp{ bufferSize };
+   for (const auto &c : cases) {
+      Printf(c.numChannels == 1 ? _("Mono:")
+         : c.interleaved ? _("Interleaved stereo:")
+         : _("Stereo:"));
+
+      ArrayOf<SampleBuffer> dests{ c.numChannels };
+      const auto destSize = c.interleaved ? bufferSize * 2 : bufferSize;
+      for (unsigned ch = 0; ch < c.numChannels; ch++)
+         dests[ch].Allocate(destSize, floatSample);
+      std::vector<float> scalarResult;
+
+      double scalarRate = 0;
+      for (int set = (int)InstructionSet::Scalar;
+           set <= (int)GetBest(); set++) {
+         Set((InstructionSet)set);
+         wxStopWatch timer;
+         for (size_t i = 0; i < nBuffers; i++) {
+            for (unsigned ch = 0; ch < c.numChannels; ch++)
+               memset(dests[ch].ptr(), 0, destSize * sizeof(float));
+            for (size_t t = 0; t < nTracks; t++) {
+               const auto src = samples.get() + t * bufferSize;
+               const auto env = envelopes.get() + t * bufferSize;
+               for (auto j = MixKernels::Multiply(
+                       src, env, temp.get(), bufferSize);
+                    j < bufferSize; j++)
+                  temp[j] = src[j] * env[j];
+               MixBuffers(c.numChannels, channelFlags, gains.get() + t * 2,
+                  (samplePtr)temp.get(), dests.get(), bufferSize,
+                  c.interleaved);
+            }
+         }
+         const long elapsed = std::max(1L, timer.Time());
+         const double rate = nTracks * nBuffers * bufferSize * 1000.0 /
+            elapsed / 1e6;
+
+         Printf(wxT("  %s %.0f M samples/s"),
+            wxString::FromAscii(GetName((InstructionSet)set)).wx_str(),
+            rate);
+
+         std::vector<float> result;
+         for (unsigned ch = 0; ch < c.numChannels; ch++) {
+            const auto p = (const float *)dests[ch].ptr();
+            result.insert(result.end(), p, p + destSize);
+         }
+         if (set == (int)InstructionSet::Scalar) {
+            scalarRate = rate;
+            scalarResult = std::move(result);
+         }
+         else {
+            Printf(wxT(" (%.1fx)"), rate / scalarRate);
+            if (result != scalarResult)
+               Printf(_(" DIFFERENT RESULT!"));
+         }
+      }
+      Printf(wxT("\n"));
+      wxTheApp->Yield();
+      FlushPrint();
+   }
+}
+
+// Times the resampling of many channels from 44100 Hz to 48000 Hz, in blocks
+// as Mixer does it, with a Resample for each channel, and then with one
+// Resample for all of them.  Does constant and variable rates, on the test
+// data size of samples in all.  Results must agree exactly.
+void BenchmarkDialog::ResampleBenchmark(long dataSize)
+{
+   static const unsigned channelCounts[] = { 2, 8, 64 };
+
+   // As Mixer resamples
+   const size_t blockSize = 1024;
+   const double factor = 48000.0 / 44100.0;
+
+   const size_t nSamples = std::max<size_t>(blockSize * 64,
+      dataSize * 1048576 / sizeof(float));
+   Floats samples{ nSamples };
+   for (size_t i = 0; i < nSamples; i++)
+      samples[i] = rand() / (float)RAND_MAX - 0.5f;
+
+   Printf(_("Resampling %d samples in blocks of %d...\n"),
+      (int)nSamples, (int)blockSize);
+   wxTheApp->Yield();
+   FlushPrint();
+
+   for (int variable = 0; variable < 2; variable++) {
+      // Speeds change from block to block for variable rate
+      const double minFactor = variable ? factor * 0.9 : factor;
+      const double maxFactor = variable ? factor * 1.1 : factor;
+      const auto blockFactor = [&](size_t block) {
+         return variable ? factor * (1.0 + 0.1 * sin(block * 0.01)) : factor;
+      };
+
+      for (const auto nChannels : channelCounts) {
+         const size_t len = nSamples / nChannels;
+         const size_t outLen = len * maxFactor + 4 * blockSize;
+
+         // One or more channels, beginning at first, with one Resample
+         struct Stream {
+            std::unique_ptr<Resample> resample;
+            unsigned first;
+            size_t pos, out;
+            bool done;
+         };
+
+         const auto run = [&](unsigned channelsPerStream,
+                              std::vector<float> &results, size_t &out) {
+            results.assign(nChannels * outLen, 0.0f);
+
+            std::vector<Stream> streams;
+            for (unsigned first = 0; first < nChannels;
+                 first += channelsPerStream)
+               streams.push_back({ std::make_unique<Resample>(
+                  true, minFactor, maxFactor, channelsPerStream),
+                  first, 0, 0, false });
+            std::vector<float *> ins(channelsPerStream),
+               outs(channelsPerStream);
+
+            wxStopWatch timer;
+            for (size_t block = 0; !streams[0].done; block++) {
+               for (auto &stream : streams) {
+                  const auto remaining = len - stream.pos;
+                  const bool last = remaining <= blockSize;
+                  for (unsigned c = 0; c < channelsPerStream; c++) {
+                     const auto channel = stream.first + c;
+                     ins[c] = &samples[channel * len + stream.pos];
+                     outs[c] = &results[channel * outLen + stream.out];
+                  }
+                  const auto done = stream.resample->Process(
+                     blockFactor(block), ins.data(),
+                     std::min(remaining, blockSize), last,
+                     outs.data(), outLen - stream.out);
+                  stream.pos += done.first;
+                  stream.out += done.second;
+                  stream.done = last;
+               }
+            }
+            out = streams[0].out;
+            const long elapsed = std::max(1L, timer.Time());
+            return nChannels * len * 1000.0 / elapsed / 1e6;
+         };
+
+         Printf(variable
+            ? _("%d channels, variable rate:")
+            : _("%d channels, constant rate:"), (int)nChannels);
+
+         std::vector<float> separate, together;
+         size_t separateOut, togetherOut;
+         const auto separateRate = run(1, separate, separateOut);
+         const auto togetherRate = run(nChannels, together, togetherOut);
+         Printf(_("  each alone %.1f M samples/s, all together %.1f M samples/s (%.1fx)"),
+            separateRate, togetherRate, togetherRate / separateRate);
+         if (separateOut != togetherOut || separate != together)
+            Printf(_(" DIFFERENT RESULT!"));
+
+         Printf(wxT("\n"));
+         wxTheApp->Yield();
+         FlushPrint();
+      }
+   }
+}
@@ -44,6 +44,7 @@ out.
 
 #include <float.h>
 #include <cmath>
+#include <mutex>
 
 #include <wx/utils.h>
 #include <wx/filefn.h>
@@ -51,8 +52,10 @@ out.
 #include <wx/log.h>
 
 #include "sndfile.h"
+#include "BlockFileCache.h"
 #include "FileException.h"
 #include "FileFormats.h"
+#include "MappedSampleFile.h"
 
 // msmeyer: Define this to add debug output via wxPrintf()
 //#define DEBUG_BLOCKFILE
@@ -110,6 +113,10 @@ unsigned long BlockFile::gBlockFileDestructionCount { 0 };
 
 BlockFile::~BlockFile()
 {
+   BlockFileCache::Get().Invalidate(this);
+   // Unmap before removing the file, which Windows would not allow
+   MappedSampleFileCache::Get().Invalidate(this);
+
    if (!IsLocked() && mFileName.HasName())
       // PRL: what should be done if this fails?
       wxRemoveFile(mFileName.GetFullPath());
@@ -130,6 +137,7 @@ auto BlockFile::GetFileName() const -> GetFileNameResult
 ///sets the file name the summary info will be saved in.  threadsafe.
 void BlockFile::SetFileName(wxFileNameWrapper &&name)
 {
+   MappedSampleFileCache::Get().Invalidate(this);
    mFileName=std::move(name);
 }
 
@@ -303,6 +311,29 @@ void BlockFile::CalcSummaryFromBuffer(const float *fbuffer, size_t len,
 
    mMin = min;
    mMax = max;
+
+   // Not in the summary, but cheap to find while we have the data
+   double sum = 0.0;
+   size_t clipped = 0;
+   for (decltype(len) i = 0; i < len; i++) {
+      sum += fbuffer[i];
+      if (fabs(fbuffer[i]) >= MAX_AUDIO)
+         clipped++;
+   }
+   SetSums(sum, clipped);
+}
+
+namespace {
+   // Guards the sums of all block files, which may be found on any thread
+   std::mutex sSumsMutex;
+}
+
+void BlockFile::SetSums(double sum, size_t clipped) const
+{
+   std::lock_guard<std::mutex> lock{ sSumsMutex };
+   mSum = sum;
+   mClipped = clipped;
+   mHaveSums = true;
 }
 
 static void ComputeMinMax256(float *summary256,
@@ -409,6 +440,49 @@ auto BlockFile::GetMinMaxRMS(bool)
    return { mMin, mMax, mRMS };
 }
 
+SampleStatistics BlockFile::GetStatistics(size_t start, size_t len,
+                                          bool mayThrow) const
+{
+   SampleStatistics result;
+   if (len == 0)
+      return result;
+
+   SampleBuffer blockData(len, floatSample);
+   this->ReadData(blockData.ptr(), floatSample, start, len, mayThrow);
+   result.Accumulate((const float *)blockData.ptr(), len);
+   return result;
+}
+
+SampleStatistics BlockFile::GetStatistics(bool mayThrow) const
+{
+   if (!IsSummaryAvailable())
+      // mMin, mMax and mRMS are not computed yet
+      return GetStatistics(0, mLen, mayThrow);
+
+   SampleStatistics result;
+   bool haveSums;
+   {
+      std::lock_guard<std::mutex> lock{ sSumsMutex };
+      haveSums = mHaveSums;
+      result.sum = mSum;
+      result.clipped = mClipped;
+   }
+
+   if (!haveSums) {
+      result = GetStatistics(0, mLen, mayThrow);
+      // Don't remember the zeroes of data that are still being decoded
+      if (IsDataAvailable())
+         SetSums(result.sum, result.clipped.as_size_t());
+      return result;
+   }
+
+   result.min = mMin;
+   result.max = mMax;
+   result.sumOfSquares = double(mRMS) * mRMS * mLen;
+   result.count = mLen;
+   return result;
+}
+
 /// Retrieves a portion of the 256-byte summary buffer from this BlockFile.  This
 /// data provides information about the minimum value, the maximum
 /// value, and the maximum RMS value for every group of 256 samples in the
@@ -793,6 +867,8 @@ bool AliasBlockFile::ReadSummary(ArrayOf<char> &data)
 void AliasBlockFile::ChangeAliasedFileName(wxFileNameWrapper &&newAliasedFile)
 {
    mAliasedFileName = std::move(newAliasedFile);
+   BlockFileCache::Get().Invalidate(this);
+   MappedSampleFileCache::Get().Invalidate(this);
 }
 
 auto AliasBlockFile::GetSpaceUsage() const -> DiskByteCount
@@ -137,6 +137,14 @@ class PROFILE_DLL_API BlockFile /* not final, abstract */ {
                           bool mayThrow = true) const;
    /// Gets extreme values for the entire block
    virtual MinMaxRMS GetMinMaxRMS(bool mayThrow = true) const;
+   /// Gets extremes, sums and clipping for the specified region, from the
+   /// data
+   SampleStatistics GetStatistics(size_t start, size_t len,
+                                  bool mayThrow = true) const;
+   /// Gets extremes, sums and clipping for the entire block.  The sum and
+   /// clipping, which the summary does not hold, are found from the data
+   /// the first time and remembered, since the data never change
+   SampleStatistics GetStatistics(bool mayThrow = true) const;
    /// Returns the 256 byte summary data block
    virtual bool Read256(float *buffer, size_t start, size_t len);
    /// Returns the 64K summary data block
@@ -151,6 +159,10 @@ class PROFILE_DLL_API BlockFile /* not final, abstract */ {
    /// Returns TRUE if this block's complete data is ready to be accessed by Read()
    virtual bool IsDataAvailable() const {return true;}
 
+   /// Returns TRUE if reads of this block's data are worth keeping in
+   /// BlockFileCache
+   virtual bool IsDataCacheable() const {return IsDataAvailable();}
+
    /// Returns TRUE if the summary has not yet been written, but is actively being computed and written to disk
    virtual bool IsSummaryBeingComputed(){return false;}
 
@@ -221,6 +233,9 @@ class PROFILE_DLL_API BlockFile /* not final, abstract */ {
    void CalcSummaryFromBuffer(const float *fbuffer, size_t len,
                               float *summary256, float *summary64K);
 
+   /// Remember what GetStatistics() needs besides the summary; thread-safe
+   void SetSums(double sum, size_t clipped) const;
+
    /// Read the summary section of the file.  Derived classes implement.
    virtual bool ReadSummary(ArrayOf<char> &data) = 0;
 
@@ -246,6 +261,12 @@ class PROFILE_DLL_API BlockFile /* not final, abstract */ {
    SummaryInfo mSummaryInfo;
    float mMin, mMax, mRMS;
    mutable bool mSilentLog;
+
+ private:
+   // Sum and number of clipped samples, once known
+   mutable bool mHaveSums{ false };
+   mutable double mSum{ 0.0 };
+   mutable size_t mClipped{ 0 };
 };
 
 /// A BlockFile that refers to data in an existing file
@@ -0,0 +1,170 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  BlockFileCache.cpp
+
+*******************************************************************//**
+
+\class BlockFileCache
+\brief Keeps the sample data of recently read BlockFiles in memory.
+
+  Sequence reads go through the one cache of the application, so repeated
+  playback, export, and effect processing of the same regions avoid the
+  disk.  A miss reads the whole block, which is the unit of replacement.
+
+  BlockFiles never change their data once it is available, except when an
+  alias file is moved or replaced, so entries only need invalidation when
+  that happens or when the BlockFile is destroyed.
+
+*//*******************************************************************/
+
+#include "Audacity.h"
+#include "BlockFileCache.h"
+
+#include <algorithm>
+#include <string.h>
+
+#include "BlockFile.h"
+#include "Prefs.h"
+
+namespace {
+   // In megabytes
+   const wxChar *CacheSizeKey = wxT("/Directories/SampleCacheSize");
+   const long DefaultCacheSize = 256;
+}
+
+BlockFileCache &BlockFileCache::Get()
+{
+   static BlockFileCache cache;
+   return cache;
+}
+
+BlockFileCache::BlockFileCache()
+{
+   UpdatePrefs();
+}
+
+BlockFileCache::~BlockFileCache()
+{
+}
+
+size_t BlockFileCache::ReadData( const BlockFile &file, samplePtr data,
+   sampleFormat format, size_t start, size_t len, bool mayThrow )
+{
+   const auto blockLen = file.GetLength();
+   const auto bytes = blockLen * SAMPLE_SIZE(format);
+   if ( GetCapacity() < bytes || !file.IsDataCacheable() || start + len > blockLen )
+      return file.ReadData( data, format, start, len, mayThrow );
+
+   const Key key{ &file, format };
+   auto found = Find( key );
+   if ( !found ) {
+      auto buffer = std::make_shared< ArrayOf< char > >( bytes );
+      const auto read =
+         file.ReadData( buffer->get(), format, 0, blockLen, false );
+      if ( read != blockLen )
+         // Don't keep an incomplete block; let the file report the problem
+         // in its own way, for just the range that was asked for
+         return file.ReadData( data, format, start, len, mayThrow );
+      Insert( key, buffer, bytes );
+      found = buffer;
+   }
+
+   const auto size = SAMPLE_SIZE(format);
+   memcpy( data, found->get() + start * size, len * size );
+   return len;
+}
+
+auto BlockFileCache::Find( const Key &key ) -> Data
+{
+   std::lock_guard< std::mutex > lock{ mMutex };
+   auto iter = mIndex.find( key );
+   if ( iter == mIndex.end() ) {
+      ++mStatistics.misses;
+      return {};
+   }
+   ++mStatistics.hits;
+   // Move to the front
+   mEntries.splice( mEntries.begin(), mEntries, iter->second );
+   return iter->second->data;
+}
+
+void BlockFileCache::Insert( const Key &key, const Data &data, size_t bytes )
+{
+   std::lock_guard< std::mutex > lock{ mMutex };
+   if ( mIndex.count( key ) )
+      // Another thread read the same block meanwhile
+      return;
+   Trim( mCapacity - std::min( mCapacity, bytes ) );
+   mEntries.push_front( { key, data, bytes } );
+   mIndex[ key ] = mEntries.begin();
+   mBytes += bytes;
+}
+
+void BlockFileCache::Trim( size_t capacity )
+{
+   while ( mBytes > capacity && !mEntries.empty() ) {
+      auto &entry = mEntries.back();
+      mBytes -= entry.bytes;
+      mIndex.erase( entry.key );
+      mEntries.pop_back();
+   }
+}
+
+void BlockFileCache::Invalidate( const BlockFile *file )
+{
+   std::lock_guard< std::mutex > lock{ mMutex };
+   if ( mEntries.empty() )
+      return;
+   for ( auto format : { int16Sample, int24Sample, floatSample } ) {
+      auto iter = mIndex.find( { file, format } );
+      if ( iter != mIndex.end() ) {
+         mBytes -= iter->second->bytes;
+         mEntries.erase( iter->second );
+         mIndex.erase( iter );
+      }
+   }
+}
+
+void BlockFileCache::Clear()
+{
+   std::lock_guard< std::mutex > lock{ mMutex };
+   Trim( 0 );
+}
+
+void BlockFileCache::SetCapacity( size_t bytes )
+{
+   std::lock_guard< std::mutex > lock{ mMutex };
+   mCapacity = bytes;
+   Trim( mCapacity );
+}
+
+size_t BlockFileCache::GetCapacity() const
+{
+   std::lock_guard< std::mutex > lock{ mMutex };
+   return mCapacity;
+}
+
+void BlockFileCache::UpdatePrefs()
+{
+   long megabytes = gPrefs
+      ? gPrefs->Read( CacheSizeKey, DefaultCacheSize )
+      : DefaultCacheSize;
+   SetCapacity( std::max( 0L, megabytes ) * 1024 * 1024 );
+}
+
+auto BlockFileCache::GetStatistics() const -> Statistics
+{
+   std::lock_guard< std::mutex > lock{ mMutex };
+   auto result = mStatistics;
+   result.entries = mEntries.size();
+   result.bytes = mBytes;
+   return result;
+}
+
+void BlockFileCache::ResetStatistics()
+{
+   std::lock_guard< std::mutex > lock{ mMutex };
+   mStatistics.hits = mStatistics.misses = 0;
+}
@@ -0,0 +1,95 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  BlockFileCache.h
+
+**********************************************************************/
+
+#ifndef __AUDACITY_BLOCKFILE_CACHE__
+#define __AUDACITY_BLOCKFILE_CACHE__
+
+#include "SampleFormat.h"
+
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+class BlockFile;
+
+/// \brief Keeps the sample data of recently read BlockFiles in memory,
+/// within a bounded number of bytes, discarding the least recently used.
+///
+/// Whole blocks are cached, in the format in which they were requested, so
+/// that a cached read gives exactly what BlockFile::ReadData() would.  All
+/// methods may be called from any thread.
+class BlockFileCache final
+{
+public:
+   static BlockFileCache &Get();
+
+   BlockFileCache();
+   BlockFileCache( const BlockFileCache & ) = delete;
+   BlockFileCache &operator= ( const BlockFileCache & ) = delete;
+   ~BlockFileCache();
+
+   /// Same contract as BlockFile::ReadData()
+   size_t ReadData( const BlockFile &file, samplePtr data,
+      sampleFormat format, size_t start, size_t len, bool mayThrow = true );
+
+   /// Forget any data of the file, which is changing or being destroyed
+   void Invalidate( const BlockFile *file );
+   void Clear();
+
+   /// Bytes of sample data to keep; zero disables the cache
+   void SetCapacity( size_t bytes );
+   size_t GetCapacity() const;
+   /// Reread the capacity from preferences
+   void UpdatePrefs();
+
+   struct Statistics {
+      unsigned long long hits{};
+      unsigned long long misses{};
+      size_t entries{};
+      size_t bytes{};
+   };
+   Statistics GetStatistics() const;
+   void ResetStatistics();
+
+private:
+   using Data = std::shared_ptr< const ArrayOf< char > >;
+
+   struct Key {
+      const BlockFile *file;
+      sampleFormat format;
+      bool operator == ( const Key &other ) const
+      { return file == other.file && format == other.format; }
+   };
+   struct KeyHash {
+      size_t operator () ( const Key &key ) const
+      { return std::hash< const void* >{}( key.file ) ^ key.format; }
+   };
+   struct Entry {
+      Key key;
+      Data data;
+      size_t bytes;
+   };
+   using List = std::list< Entry >;
+
+   Data Find( const Key &key );
+   void Insert( const Key &key, const Data &data, size_t bytes );
+   // Requires the lock
+   void Trim( size_t capacity );
+
+   mutable std::mutex mMutex;
+   // Most recently used first
+   List mEntries;
+   std::unordered_map< Key, List::iterator, KeyHash > mIndex;
+   size_t mCapacity{ 0 };
+   size_t mBytes{ 0 };
+   Statistics mStatistics;
+};
+
+#endif
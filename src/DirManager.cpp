@@ -46,7 +46,7 @@
   The blockfile/directory scheme is rather complicated with two different schemes.
   The current scheme uses two levels of subdirectories - up to 256 'eXX' and up to
   256 'dYY' directories within each of the 'eXX' dirs, where XX and YY are hex chars.
-  In each of the dXX directories there are up to 256 audio files (e.g. .au or .auf).
+  In each of the dXX directories there are up to 256 audio files (e.g. .au, .auf, or .flac).
   They have a filename scheme of 'eXXYYZZZZ', where XX and YY refers to the
   subdirectories as above.  The 'ZZZZ' component is generated randomly for some reason.
   The XX and YY components are sequential.
@@ -88,6 +88,7 @@
 #include "BlockFile.h"
 #include "FileNames.h"
 #include "InconsistencyException.h"
+#include "MappedSampleFile.h"
 #include "Prefs.h"
 #include "Project.h"
 #include "widgets/Warning.h"
@@ -752,6 +753,8 @@ void DirManager::ProjectSetter::Impl::Commit()
          if (moving || !b->IsLocked()) {
             auto result = b->GetFileName();
             auto oldPath = result.name.GetFullPath();
+            // Windows does not remove a file while it is mapped
+            MappedSampleFileCache::Get().Invalidate( b.get() );
             if (!oldPath.empty())
                wxRemoveFile( oldPath );
          }
@@ -1212,6 +1215,11 @@ BlockFilePtr DirManager::NewBlockFile( const BlockFileFactory &factory )
    wxFileNameWrapper filePath{ MakeBlockFileName() };
    const wxString fileName{ filePath.GetName() };
    auto newBlockFile = factory( std::move(filePath) );
+   if ( !newBlockFile ) {
+      // The factory declined; give the name back
+      BalanceInfoDel( fileName );
+      return {};
+   }
    mBlockFileHash[fileName] = newBlockFile;
    auto &aliasName = newBlockFile->GetExternalFileName();
    if ( aliasName.IsOk() )
@@ -1324,6 +1332,25 @@ DirManager::RegisteredBlockFileDeserializer::RegisteredBlockFileDeserializer(
    GetDeserializers()[tag] = function;
 }
 
+namespace {
+DirManager::SampleBlockFileFactory &SampleBlockFileFactoryInstance()
+{
+   static DirManager::SampleBlockFileFactory sFactory;
+   return sFactory;
+}
+}
+
+DirManager::RegisteredSampleBlockFileFactory::RegisteredSampleBlockFileFactory(
+   SampleBlockFileFactory function )
+{
+   SampleBlockFileFactoryInstance() = function;
+}
+
+auto DirManager::GetSampleBlockFileFactory() -> const SampleBlockFileFactory &
+{
+   return SampleBlockFileFactoryInstance();
+}
+
 bool DirManager::HandleXMLTag(const wxChar *tag, const wxChar **attrs)
 {
    if( !mLoadingTarget )
@@ -1537,6 +1564,9 @@ bool DirManager::EnsureSafeFilename(const wxFileName &fName)
    }
 
    if (needToRename) {
+      // Windows does not rename a file while it is mapped
+      MappedSampleFileCache::Get().Clear();
+
       if (!wxRenameFile(fullPath,
                         renamedFullPath))
       {
@@ -1666,7 +1696,8 @@ void DirManager::FindMissingAUs(
          {
             wxFileNameWrapper fileName{ MakeBlockFilePath(key) };
             fileName.SetName(key);
-            fileName.SetExt(wxT("au"));
+            const wxString ext{ b->GetFileName().name.GetExt() };
+            fileName.SetExt(ext.empty() ? wxString{ wxT("au") } : ext);
             const auto path = fileName.GetFullPath();
             if (!fileName.FileExists() ||
                 wxFile{ path }.Length() == 0)
@@ -1680,7 +1711,7 @@ void DirManager::FindMissingAUs(
    }
 }
 
-// Find .au and .auf files that are not in the project.
+// Find .au, .auf, and .flac files that are not in the project.
 void DirManager::FindOrphanBlockFiles(
       const FilePaths &filePathArray,       // input: all files in project directory
       FilePaths &orphanFilePathArray)       // output: orphan files
@@ -1701,7 +1732,8 @@ void DirManager::FindOrphanBlockFiles(
             // Consider only Audacity data files.
             // Specifically, ignore <branding> JPG and <import> OGG ("Save Compressed Copy").
             (ext.IsSameAs(wxT("au"), false) ||
-               ext.IsSameAs(wxT("auf"), false)))
+               ext.IsSameAs(wxT("auf"), false) ||
+               ext.IsSameAs(wxT("flac"), false)))
       {
          // Ignore it if it exists in the clipboard (from a previously closed project)
          if ( std::any_of( otherDirManagers.begin(), otherDirManagers.end(),
@@ -91,6 +91,19 @@ class PROFILE_DLL_API DirManager final
          const wxString &tag, BlockFileDeserializer function );
    };
 
+   // Type of a function that may build a block file for NEW sample data,
+   // in place of a SimpleBlockFile.  It returns null to decline, and then
+   // leaves the file name unchanged.
+   using SampleBlockFileFactory = std::function< BlockFilePtr(
+      wxFileNameWrapper &, samplePtr, size_t, sampleFormat ) >;
+   // Typically a statically declared object,
+   // registers the one function that may replace SimpleBlockFile
+   struct RegisteredSampleBlockFileFactory {
+      RegisteredSampleBlockFileFactory( SampleBlockFileFactory function );
+   };
+   // The registered function, or an empty one
+   static const SampleBlockFileFactory &GetSampleBlockFileFactory();
+
  private:
    // MM: Construct DirManager
    // Don't call this directly but use Create() instead
@@ -140,6 +153,7 @@ class PROFILE_DLL_API DirManager final
    wxLongLong GetFreeDiskSpace();
 
    using BlockFileFactory = std::function< BlockFilePtr( wxFileNameWrapper ) >;
+   // Returns null if the factory does
    BlockFilePtr NewBlockFile( const BlockFileFactory &factory );
 
    /// Returns true if the blockfile pointed to by b is contained by the DirManager
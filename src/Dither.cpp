@@ -45,6 +45,7 @@ and get deterministic behaviour.
 // (Note: this file should be included first)
 #include "float_cast.h"
 
+#include <algorithm>
 #include <stdlib.h>
 #include <math.h>
 #include <string.h>
@@ -63,8 +64,11 @@ const int Dither::BUF_SIZE = 8;
 // Lipshitz's minimally audible FIR
 const float Dither::SHAPED_BS[] = { 2.033f, -2.165f, 1.959f, -1.590f, 0.6149f };
 
+// Samples at a time for which shaped dither makes its noise
+const unsigned Dither::NOISE_BLOCK_SIZE = 256;
+
 // This is supposed to produce white noise and no dc
-#define DITHER_NOISE (rand() / (float)RAND_MAX - 0.5f)
+#define DITHER_NOISE (SampleFormatKernels::NextNoise(mNoise))
 
 // The following is a rather ugly, but fast implementation
 // of a dither loop. The macro "DITHER" is expanded to an implementation
@@ -211,15 +215,65 @@ Dither::Dither()
 {
     // On startup, initialize dither by resetting values
     Reset();
+    mShapedNoiseIndex = 0;
 }
 
 void Dither::Reset()
 {
-    mTriangleState = 0;
+    mNoise.triangle = 0;
     mPhase = 0;
     memset(mBuffer, 0, sizeof(float) * BUF_SIZE);
 }
 
+namespace {
+
+// Interleaved samples are gathered into blocks, and scattered from them,
+// so that the vectorized loops apply to them too
+enum : size_t { StagingSize = 1024 };
+
+template<typename T>
+void Gather(const samplePtr source, unsigned int stride, void *block,
+            unsigned int len)
+{
+    const T* s = (const T*)source;
+    T* b = (T*)block;
+    for (unsigned int i = 0; i < len; i++, s += stride)
+        b[i] = *s;
+}
+
+template<typename T>
+void Scatter(const void *block, samplePtr dest, unsigned int stride,
+             unsigned int len)
+{
+    const T* b = (const T*)block;
+    T* d = (T*)dest;
+    for (unsigned int i = 0; i < len; i++, d += stride)
+        *d = b[i];
+}
+
+// Returns how many samples the vectorized loops dithered, none for shaped
+// dither
+size_t VectorDither(DitherType ditherType,
+                    const samplePtr source, sampleFormat sourceFormat,
+                    samplePtr dest, sampleFormat destFormat,
+                    unsigned int len,
+                    SampleFormatKernels::NoiseState &noise)
+{
+    using namespace SampleFormatKernels;
+    if (sourceFormat == int24Sample && destFormat == int16Sample)
+        return Int24ToInt16((const int*)source, (short*)dest, len,
+                            ditherType, noise);
+    else if (sourceFormat == floatSample && destFormat == int16Sample)
+        return FloatToInt16((const float*)source, (short*)dest, len,
+                            ditherType, noise);
+    else if (sourceFormat == floatSample && destFormat == int24Sample)
+        return FloatToInt24((const float*)source, (int*)dest, len,
+                            ditherType, noise);
+    return 0;
+}
+
+}
+
 // This only decides if we must dither at all, the dithers
 // are all implemented using macros.
 //
@@ -295,6 +349,52 @@ void Dither::Apply(enum DitherType ditherType,
             }
         }
     } else
+    {
+        // Dithering continues across the blocks of one conversion
+        if (ditherType == DitherType::triangle ||
+            ditherType == DitherType::shaped)
+            Reset(); // reset dither filter for this NEW conversion
+
+        if (destStride == 1 && sourceStride == 1)
+            Convert(ditherType, source, sourceFormat, dest, destFormat, len);
+        else
+        {
+            // Big enough, and aligned, for samples of any format
+            float sourceBlock[StagingSize], destBlock[StagingSize];
+            const auto sourceSize = SAMPLE_SIZE(sourceFormat);
+            const auto destSize = SAMPLE_SIZE(destFormat);
+            for (i = 0; i < len; )
+            {
+                const auto count =
+                    std::min<unsigned int>(StagingSize, len - i);
+                const auto s = source + i * sourceStride * sourceSize;
+                const auto d = dest + i * destStride * destSize;
+                if (sourceSize == sizeof(short))
+                    Gather<short>(s, sourceStride, sourceBlock, count);
+                else
+                    Gather<int>(s, sourceStride, sourceBlock, count);
+                Convert(ditherType, (samplePtr)sourceBlock, sourceFormat,
+                        (samplePtr)destBlock, destFormat, count);
+                if (destSize == sizeof(short))
+                    Scatter<short>(destBlock, d, destStride, count);
+                else
+                    Scatter<int>(destBlock, d, destStride, count);
+                i += count;
+            }
+        }
+    }
+}
+
+// Formats differ, and source and dest are not interleaved.  The vectorized
+// loops do what they can, and the scalar loops do the rest.
+void Dither::Convert(enum DitherType ditherType,
+                     const samplePtr source, sampleFormat sourceFormat,
+                     samplePtr dest, sampleFormat destFormat,
+                     unsigned int len)
+{
+    using namespace SampleFormatKernels;
+    unsigned int i;
+
     if (destFormat == floatSample)
     {
         // No need to dither, just convert samples to float.
@@ -304,14 +404,14 @@ void Dither::Apply(enum DitherType ditherType,
         if (sourceFormat == int16Sample)
         {
             short* s = (short*)source;
-            for (i = 0; i < len; i++, d += destStride, s += sourceStride)
-                *d = FROM_INT16(s);
+            for (i = Int16ToFloat(s, d, len); i < len; i++)
+                d[i] = FROM_INT16(s + i);
         } else
         if (sourceFormat == int24Sample)
         {
             int* s = (int*)source;
-            for (i = 0; i < len; i++, d += destStride, s += sourceStride)
-                *d = FROM_INT24(s);
+            for (i = Int24ToFloat(s, d, len); i < len; i++)
+                d[i] = FROM_INT24(s + i);
         } else {
             wxASSERT(false); // source format unknown
         }
@@ -321,26 +421,42 @@ void Dither::Apply(enum DitherType ditherType,
         // Special case when promoting 16 bit to 24 bit
         int* d = (int*)dest;
         short* s = (short*)source;
-        for (i = 0; i < len; i++, d += destStride, s += sourceStride)
-            *d = ((int)*s) << 8;
+        for (i = Int16ToInt24(s, d, len); i < len; i++)
+            d[i] = ((int)s[i]) << 8;
     } else
     {
         // We must do dithering
+        const unsigned int done = VectorDither(ditherType,
+            source, sourceFormat, dest, destFormat, len, mNoise);
+        const samplePtr src = source + done * SAMPLE_SIZE(sourceFormat);
+        const samplePtr dst = dest + done * SAMPLE_SIZE(destFormat);
+        len -= done;
+
         switch (ditherType)
         {
         case DitherType::none:
-            DITHER(NoDither, dest, destFormat, destStride, source, sourceFormat, sourceStride, len);
+            DITHER(NoDither, dst, destFormat, 1, src, sourceFormat, 1, len);
             break;
         case DitherType::rectangle:
-            DITHER(RectangleDither, dest, destFormat, destStride, source, sourceFormat, sourceStride, len);
+            DITHER(RectangleDither, dst, destFormat, 1, src, sourceFormat, 1, len);
             break;
         case DitherType::triangle:
-            Reset(); // reset dither filter for this NEW conversion
-            DITHER(TriangleDither, dest, destFormat, destStride, source, sourceFormat, sourceStride, len);
+            DITHER(TriangleDither, dst, destFormat, 1, src, sourceFormat, 1, len);
             break;
         case DitherType::shaped:
-            Reset(); // reset dither filter for this NEW conversion
-            DITHER(ShapedDither, dest, destFormat, destStride, source, sourceFormat, sourceStride, len);
+            // The noise shaping filter is recursive, so only the noise is
+            // made with vectors, a block at a time
+            for (i = 0; i < len; )
+            {
+                const auto count = std::min(NOISE_BLOCK_SIZE, len - i);
+                Noise(mShapedNoise, 2 * count, mNoise);
+                mShapedNoiseIndex = 0;
+                DITHER(ShapedDither,
+                       dst + i * SAMPLE_SIZE(destFormat), destFormat, 1,
+                       src + i * SAMPLE_SIZE(sourceFormat), sourceFormat, 1,
+                       count);
+                i += count;
+            }
             break;
         default:
             wxASSERT(false); // unknown dither algorithm
@@ -366,8 +482,8 @@ inline float Dither::RectangleDither(float sample)
 inline float Dither::TriangleDither(float sample)
 {
     float r = DITHER_NOISE;
-    float result = sample + r - mTriangleState;
-    mTriangleState = r;
+    float result = sample + r - mNoise.triangle;
+    mNoise.triangle = r;
 
     return result;
 }
@@ -376,7 +492,9 @@ inline float Dither::TriangleDither(float sample)
 inline float Dither::ShapedDither(float sample)
 {
     // Generate triangular dither, +-1 LSB, flat psd
-    float r = DITHER_NOISE + DITHER_NOISE;
+    float r = mShapedNoise[mShapedNoiseIndex] +
+              mShapedNoise[mShapedNoiseIndex + 1];
+    mShapedNoiseIndex += 2;
     if(sample != sample)  // test for NaN
        sample = 0; // and do the best we can with it
 
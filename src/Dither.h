@@ -11,6 +11,7 @@
 #define __AUDACITY_DITHER_H__
 
 #include "audacity/Types.h" // for samplePtr
+#include "SampleFormatKernels.h"
 
 class EnumSetting;
 
@@ -45,6 +46,12 @@ public:
                unsigned int destStride = 1);
 
 private:
+    // Convert samples that are not interleaved
+    void Convert(DitherType ditherType,
+                 const samplePtr source, sampleFormat sourceFormat,
+                 samplePtr dest, sampleFormat destFormat,
+                 unsigned int len);
+
     // Dither methods
     float NoDither(float sample);
     float RectangleDither(float sample);
@@ -55,11 +62,16 @@ private:
     static const int BUF_SIZE; /* = 8 */
     static const int BUF_MASK; /* = 7 */
     static const float SHAPED_BS[];
+    static const unsigned NOISE_BLOCK_SIZE; /* = 256 */
 
     // Dither state
     int mPhase;
-    float mTriangleState;
+    SampleFormatKernels::NoiseState mNoise;
     float mBuffer[8 /* = BUF_SIZE */];
+
+    // Pairs of noise values for shaped dither, made a block at a time
+    float mShapedNoise[2 * 256 /* = NOISE_BLOCK_SIZE */];
+    unsigned mShapedNoiseIndex;
 };
 
 #endif /* __AUDACITY_DITHER_H__ */
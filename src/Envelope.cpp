@@ -31,6 +31,7 @@ a draggable point type.
 
 #include "Experimental.h"
 
+#include <algorithm>
 #include <math.h>
 
 #include <wx/wxcrtvararg.h>
@@ -266,6 +267,20 @@ Envelope::Envelope(const Envelope &orig)
    CopyRange(orig, 0, orig.GetNumberOfPoints());
 }
 
+bool Envelope::SameStateAs(const Envelope &other) const
+{
+   return mDB == other.mDB &&
+      mMinValue == other.mMinValue &&
+      mMaxValue == other.mMaxValue &&
+      mDefaultValue == other.mDefaultValue &&
+      mOffset == other.mOffset &&
+      mTrackLen == other.mTrackLen &&
+      mEnv.size() == other.mEnv.size() &&
+      std::equal(mEnv.begin(), mEnv.end(), other.mEnv.begin(),
+         [](const EnvPoint &a, const EnvPoint &b){
+            return a.GetT() == b.GetT() && a.GetVal() == b.GetVal(); });
+}
+
 void Envelope::CopyRange(const Envelope &orig, size_t begin, size_t end)
 {
    size_t len = orig.mEnv.size();
@@ -182,6 +182,9 @@ public:
 
    bool IsDirty() const;
 
+   // Whether the other has the same points and parameters, as a copy does
+   bool SameStateAs(const Envelope &other) const;
+
    void Clear() { mEnv.clear(); }
 
    /** \brief Add a point at a particular absolute time coordinate */
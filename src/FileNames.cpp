@@ -243,6 +243,11 @@ FilePath FileNames::PluginRegistry()
    return wxFileName( DataDir(), wxT("pluginregistry.cfg") ).GetFullPath();
 }
 
+FilePath FileNames::PluginRegistryCache()
+{
+   return wxFileName( DataDir(), wxT("pluginregistry.cache") ).GetFullPath();
+}
+
 FilePath FileNames::PluginSettings()
 {
    return wxFileName( DataDir(), wxT("pluginsettings.cfg") ).GetFullPath();
@@ -74,6 +74,7 @@ public:
    static FilePath NRPDir();
    static FilePath NRPFile();
    static FilePath PluginRegistry();
+   static FilePath PluginRegistryCache();
    static FilePath PluginSettings();
 
    static FilePath BaseDir();
@@ -0,0 +1,468 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  MappedSampleFile.cpp
+
+*******************************************************************//**
+
+\class MappedSampleFile
+\brief A read-only memory mapping of a file of uncompressed samples.
+
+  Reading a block through libsndfile opens, seeks, reads, and closes the
+  file each time, and serializes on the libsndfile mutex.  A mapping is
+  made once, and then reads are only conversions from the mapped pages,
+  in loops simple enough for the compiler to vectorize.
+
+  Conversions follow BlockFile::CommonReadData(), so that a mapped read
+  gives the same samples as libsndfile would.
+
+*//****************************************************************//**
+
+\class MappedSampleFileCache
+\brief Keeps mappings of the files of recently read BlockFiles.
+
+  A mapping of a block file lives until its BlockFile is destroyed or
+  renamed, or until it is the least recently used when the limit on the
+  number of mappings is reached.
+
+  Block files never change once written, but an aliased file might be
+  truncated by another program while mapped, and reading a page past its
+  new end would crash.  So mapping of aliased files is off by default.
+
+*//*******************************************************************/
+
+#include "Audacity.h"
+#include "MappedSampleFile.h"
+
+#include <algorithm>
+#include <limits>
+#include <string.h>
+
+#include <wx/file.h>
+#include <wx/filename.h>
+#include <wx/log.h>
+
+#ifdef __WXMSW__
+#include <windows.h>
+#include <io.h>
+#else
+#include <sys/mman.h>
+#endif
+
+#include <sndfile.h>
+
+#include "BlockFile.h"
+#include "FileFormats.h"
+#include "Prefs.h"
+#include "blockfile/SimpleBlockFile.h"
+
+namespace {
+   const wxChar *MapBlockFilesKey = wxT("/Directories/MapBlockFiles");
+   const wxChar *MapAliasedFilesKey = wxT("/Directories/MapAliasedFiles");
+
+   // Address space is plentiful only in 64 bit builds
+   const size_t MappingLimit = sizeof(void*) >= 8 ? 4096 : 128;
+
+   // How many frames of an aliased file to compare with libsndfile
+   const size_t CheckedFrames = 4096;
+
+   inline int UnpackInt24( const unsigned char *bytes )
+   {
+      // The sign comes from the most significant byte
+#if wxBYTE_ORDER == wxBIG_ENDIAN
+      return static_cast<signed char>(bytes[0]) * 65536 +
+         (bytes[1] << 8) + bytes[2];
+#else
+      return static_cast<signed char>(bytes[2]) * 65536 +
+         (bytes[1] << 8) + bytes[0];
+#endif
+   }
+}
+
+std::unique_ptr< MappedSampleFile >
+MappedSampleFile::OpenBlockFile( const wxString &fullPath )
+{
+   std::unique_ptr< MappedSampleFile > result;
+
+   wxLogNull silence;
+   wxFile file;
+   if ( !wxFile::Exists( fullPath ) || !file.Open( fullPath ) )
+      return result;
+   const auto length = file.Length();
+   if ( length < (wxFileOffset)sizeof(auHeader) ||
+        (unsigned long long)length > std::numeric_limits<size_t>::max() )
+      return result;
+   const size_t size = length;
+
+   result = Map( file, size );
+   if ( !result )
+      return result;
+   const auto address = result->mAddress;
+
+   // SimpleBlockFile writes the header in the byte order of the machine,
+   // and no other machine's files are mapped
+   auHeader header;
+   memcpy( &header, address, sizeof(header) );
+   if ( header.magic != 0x2e736e64 || header.channels != 1 ) {
+      result.reset();
+      return result;
+   }
+
+   Encoding encoding;
+   switch ( header.encoding ) {
+      case AU_SAMPLE_FORMAT_16:
+         encoding = Encoding::Int16; break;
+      case AU_SAMPLE_FORMAT_24:
+         encoding = Encoding::PackedInt24; break;
+      case AU_SAMPLE_FORMAT_FLOAT:
+         encoding = Encoding::Float; break;
+      default:
+         result.reset();
+         return result;
+   }
+
+   // The data size in the header is not meaningful; the data go to the end
+   const size_t offset = header.dataOffset;
+   if ( offset > size ||
+        !result->SetLayout( offset, encoding, 1, size - offset ) )
+      result.reset();
+
+   return result;
+}
+
+std::unique_ptr< MappedSampleFile >
+MappedSampleFile::OpenAliasedFile( const wxString &fullPath )
+{
+   std::unique_ptr< MappedSampleFile > result;
+
+   wxLogNull silence;
+   wxFile file;
+   if ( !wxFile::Exists( fullPath ) || !file.Open( fullPath ) )
+      return result;
+
+   SF_INFO info;
+   memset( &info, 0, sizeof(info) );
+   SFFile sf{
+      SFCall<SNDFILE*>( sf_open_fd, file.fd(), SFM_READ, &info, FALSE ) };
+   if ( !sf || info.channels < 1 || info.frames <= 0 )
+      return result;
+
+   Encoding encoding;
+   switch ( info.format & SF_FORMAT_SUBMASK ) {
+      case SF_FORMAT_PCM_16:
+         encoding = Encoding::Int16; break;
+      case SF_FORMAT_FLOAT:
+         encoding = Encoding::Float; break;
+      default:
+         return result;
+   }
+   if ( SFCall<int>( sf_command, sf.get(), SFC_RAW_DATA_NEEDS_ENDSWAP,
+         nullptr, 0 ) != SF_FALSE )
+      return result;
+
+   // libsndfile reads the descriptor without buffering, so after a seek to
+   // the first frame, the position of the descriptor is where the data begin
+   if ( SFCall<sf_count_t>( sf_seek, sf.get(), 0, SEEK_SET ) != 0 )
+      return result;
+   const auto offset = file.Tell();
+   const auto length = file.Length();
+   if ( offset < 0 || length <= offset ||
+        (unsigned long long)length > std::numeric_limits<size_t>::max() )
+      return result;
+   const size_t size = length;
+
+   result = Map( file, size );
+   if ( !result )
+      return result;
+
+   const auto frames = (size_t)std::min< sf_count_t >( info.frames,
+      ( size - offset ) /
+         ( info.channels * ( encoding == Encoding::Float ? 4 : 2 ) ) );
+   if ( !result->SetLayout( offset, encoding, info.channels, frames ) ) {
+      result.reset();
+      return result;
+   }
+
+   // Trust the mapping only if it gives what libsndfile gives
+   const auto checked = std::min( CheckedFrames, frames );
+   Floats expected{ checked * info.channels }, actual{ checked };
+   if ( SFCall<sf_count_t>( sf_seek, sf.get(), 0, SEEK_SET ) != 0 ||
+        SFCall<sf_count_t>( sf_readf_float, sf.get(), expected.get(),
+           (sf_count_t)checked ) != (sf_count_t)checked ) {
+      result.reset();
+      return result;
+   }
+   for ( unsigned channel = 0; channel < result->mChannels; ++channel ) {
+      result->Read( channel, 0, (samplePtr)actual.get(), floatSample,
+         0, checked );
+      for ( size_t ii = 0; ii < checked; ++ii )
+         if ( actual[ii] != expected[ ii * info.channels + channel ] ) {
+            result.reset();
+            return result;
+         }
+   }
+
+   return result;
+}
+
+std::unique_ptr< MappedSampleFile >
+MappedSampleFile::Map( wxFile &file, size_t size )
+{
+   std::unique_ptr< MappedSampleFile > result;
+#ifdef __WXMSW__
+   HANDLE handle = (HANDLE)_get_osfhandle( file.fd() );
+   HANDLE mapping =
+      CreateFileMapping( handle, NULL, PAGE_READONLY, 0, 0, NULL );
+   if ( !mapping )
+      return result;
+   void *address = MapViewOfFile( mapping, FILE_MAP_READ, 0, 0, 0 );
+   if ( !address ) {
+      CloseHandle( mapping );
+      return result;
+   }
+   result.reset( safenew MappedSampleFile{ address, size } );
+   result->mMapping = mapping;
+#else
+   // The mapping outlives the descriptor
+   void *address = mmap( nullptr, size, PROT_READ, MAP_SHARED, file.fd(), 0 );
+   if ( address == MAP_FAILED )
+      return result;
+   result.reset( safenew MappedSampleFile{ address, size } );
+#endif
+   return result;
+}
+
+MappedSampleFile::MappedSampleFile( void *address, size_t size )
+   : mAddress{ address }
+   , mSize{ size }
+{
+}
+
+MappedSampleFile::~MappedSampleFile()
+{
+#ifdef __WXMSW__
+   UnmapViewOfFile( mAddress );
+   CloseHandle( mMapping );
+#else
+   munmap( mAddress, mSize );
+#endif
+}
+
+bool MappedSampleFile::SetLayout( size_t offset, Encoding encoding,
+   unsigned channels, size_t frames )
+{
+   mEncoding = encoding;
+   mChannels = channels;
+   const auto frameSize = GetBytesPerSample() * channels;
+   frames = std::min( frames, ( mSize - std::min( mSize, offset ) ) / frameSize );
+   if ( frames == 0 )
+      return false;
+   mSamples = static_cast< const char* >( mAddress ) + offset;
+   mFrames = frames;
+   return true;
+}
+
+size_t MappedSampleFile::GetBytesPerSample() const
+{
+   switch ( mEncoding ) {
+      case Encoding::PackedInt24:
+         return 3;
+      case Encoding::Float:
+         return 4;
+      case Encoding::Int16:
+      default:
+         return 2;
+   }
+}
+
+size_t MappedSampleFile::Read( unsigned channel, sampleCount origin,
+   samplePtr data, sampleFormat format, size_t start, size_t len ) const
+{
+   const auto first = origin + start;
+   if ( channel >= mChannels || first >= mFrames )
+      return 0;
+   const auto frames = limitSampleBufferSize( len, mFrames - first );
+   const auto stride = mChannels;
+   const auto src = mSamples +
+      ( first.as_size_t() * stride + channel ) * GetBytesPerSample();
+
+   switch ( mEncoding ) {
+      case Encoding::Int16: {
+         if ( format == floatSample ) {
+            const auto s = reinterpret_cast< const short* >( src );
+            const auto d = reinterpret_cast< float* >( data );
+            if ( stride == 1 )
+               for ( size_t ii = 0; ii < frames; ++ii )
+                  d[ii] = s[ii] / float(1 << 15);
+            else
+               for ( size_t ii = 0; ii < frames; ++ii )
+                  d[ii] = s[ii * stride] / float(1 << 15);
+         }
+         else
+            CopySamples( const_cast< samplePtr >( src ), int16Sample,
+               data, format, frames, true, stride );
+         break;
+      }
+      case Encoding::Float: {
+         if ( format == floatSample ) {
+            const auto s = reinterpret_cast< const float* >( src );
+            const auto d = reinterpret_cast< float* >( data );
+            if ( stride == 1 )
+               memcpy( d, s, frames * sizeof(float) );
+            else
+               for ( size_t ii = 0; ii < frames; ++ii )
+                  d[ii] = s[ii * stride];
+         }
+         else
+            // Dithers, as reading through libsndfile did
+            CopySamples( const_cast< samplePtr >( src ), floatSample,
+               data, format, frames, true, stride );
+         break;
+      }
+      case Encoding::PackedInt24: {
+         // Only block files are packed, and they are mono
+         const auto s = reinterpret_cast< const unsigned char* >( src );
+         switch ( format ) {
+            case floatSample: {
+               const auto d = reinterpret_cast< float* >( data );
+               for ( size_t ii = 0; ii < frames; ++ii )
+                  d[ii] = UnpackInt24( s + 3 * ii ) / float(1 << 23);
+               break;
+            }
+            case int24Sample: {
+               const auto d = reinterpret_cast< int* >( data );
+               for ( size_t ii = 0; ii < frames; ++ii )
+                  d[ii] = UnpackInt24( s + 3 * ii );
+               break;
+            }
+            case int16Sample:
+            default: {
+               // libsndfile truncates, without dither
+               const auto d = reinterpret_cast< short* >( data );
+               for ( size_t ii = 0; ii < frames; ++ii )
+                  d[ii] = UnpackInt24( s + 3 * ii ) >> 8;
+               break;
+            }
+         }
+         break;
+      }
+   }
+
+   return frames;
+}
+
+MappedSampleFileCache &MappedSampleFileCache::Get()
+{
+   static MappedSampleFileCache cache;
+   return cache;
+}
+
+MappedSampleFileCache::MappedSampleFileCache()
+   : mLimit{ MappingLimit }
+{
+   UpdatePrefs();
+}
+
+MappedSampleFileCache::~MappedSampleFileCache()
+{
+}
+
+size_t MappedSampleFileCache::ReadData(
+   const BlockFile &owner, const wxFileName &fileName,
+   bool aliased, unsigned channel, sampleCount origin,
+   samplePtr data, sampleFormat format, size_t start, size_t len )
+{
+   auto mapping = Acquire( owner, fileName, aliased );
+   if ( !mapping )
+      return 0;
+   return mapping->Read( channel, origin, data, format, start, len );
+}
+
+auto MappedSampleFileCache::Acquire( const BlockFile &owner,
+   const wxFileName &fileName, bool aliased ) -> Mapping
+{
+   const auto fullPath = fileName.GetFullPath();
+   {
+      std::lock_guard< std::mutex > lock{ mMutex };
+      if ( !( aliased ? mMapAliasedFiles : mMapBlockFiles ) )
+         return {};
+      auto iter = mIndex.find( &owner );
+      if ( iter != mIndex.end() ) {
+         // Move to the front
+         mEntries.splice( mEntries.begin(), mEntries, iter->second );
+         return iter->second->mapping;
+      }
+      if ( aliased ) {
+         auto mapping = mAliased[ fullPath ].lock();
+         if ( mapping ) {
+            Trim( mLimit - 1 );
+            mEntries.push_front( { &owner, mapping } );
+            mIndex[ &owner ] = mEntries.begin();
+            return mapping;
+         }
+      }
+   }
+
+   // Map without the lock, so that other reads may proceed
+   Mapping mapping{ aliased
+      ? MappedSampleFile::OpenAliasedFile( fullPath )
+      : MappedSampleFile::OpenBlockFile( fullPath ) };
+
+   std::lock_guard< std::mutex > lock{ mMutex };
+   if ( mIndex.count( &owner ) )
+      // Another thread mapped the same file meanwhile
+      return mapping;
+   if ( aliased && mapping )
+      mAliased[ fullPath ] = mapping;
+   Trim( mLimit - 1 );
+   mEntries.push_front( { &owner, mapping } );
+   mIndex[ &owner ] = mEntries.begin();
+   return mapping;
+}
+
+void MappedSampleFileCache::Trim( size_t limit )
+{
+   if ( mEntries.size() <= limit )
+      return;
+   while ( mEntries.size() > limit ) {
+      mIndex.erase( mEntries.back().owner );
+      mEntries.pop_back();
+   }
+   // Forget aliased files no longer mapped
+   for ( auto iter = mAliased.begin(); iter != mAliased.end(); )
+         if ( iter->second.expired() )
+            iter = mAliased.erase( iter );
+         else
+            ++iter;
+}
+
+void MappedSampleFileCache::Invalidate( const BlockFile *owner )
+{
+   std::lock_guard< std::mutex > lock{ mMutex };
+   auto iter = mIndex.find( owner );
+   if ( iter != mIndex.end() ) {
+      mEntries.erase( iter->second );
+      mIndex.erase( iter );
+   }
+}
+
+void MappedSampleFileCache::Clear()
+{
+   std::lock_guard< std::mutex > lock{ mMutex };
+   Trim( 0 );
+}
+
+void MappedSampleFileCache::UpdatePrefs()
+{
+   bool mapBlockFiles = true, mapAliasedFiles = false;
+   if ( gPrefs ) {
+      gPrefs->Read( MapBlockFilesKey, &mapBlockFiles, true );
+      gPrefs->Read( MapAliasedFilesKey, &mapAliasedFiles, false );
+   }
+
+   std::lock_guard< std::mutex > lock{ mMutex };
+   mMapBlockFiles = mapBlockFiles;
+   mMapAliasedFiles = mapAliasedFiles;
+   Trim( 0 );
+}
@@ -0,0 +1,135 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  MappedSampleFile.h
+
+**********************************************************************/
+
+#ifndef __AUDACITY_MAPPED_SAMPLE_FILE__
+#define __AUDACITY_MAPPED_SAMPLE_FILE__
+
+#include "SampleFormat.h"
+
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+#include <wx/string.h>
+
+class BlockFile;
+class wxFile;
+class wxFileName;
+
+/// \brief A read-only memory mapping of a file of uncompressed samples.
+///
+/// Reads convert straight from the mapped pages, without any system call.
+/// Only layouts that can be read that way are accepted by the factory
+/// functions, which return null for anything else, leaving such files to
+/// libsndfile.
+class MappedSampleFile final
+{
+public:
+   /// Map the sample data of an .au file, as SimpleBlockFile writes them
+   static std::unique_ptr< MappedSampleFile >
+      OpenBlockFile( const wxString &fullPath );
+
+   /// Map a 16 bit or float PCM file in the byte order of this machine.
+   /// The mapping is checked against what libsndfile decodes.
+   static std::unique_ptr< MappedSampleFile >
+      OpenAliasedFile( const wxString &fullPath );
+
+   MappedSampleFile( const MappedSampleFile & ) = delete;
+   MappedSampleFile &operator= ( const MappedSampleFile & ) = delete;
+   ~MappedSampleFile();
+
+   unsigned GetChannels() const { return mChannels; }
+   sampleCount GetFrames() const { return mFrames; }
+
+   /// Converts samples of one channel, from frame origin + start, as
+   /// BlockFile::CommonReadData() would.  Returns the number of frames read,
+   /// which is less than len only at the end of the file.
+   size_t Read( unsigned channel, sampleCount origin,
+      samplePtr data, sampleFormat format, size_t start, size_t len ) const;
+
+private:
+   enum class Encoding { Int16, PackedInt24, Float };
+
+   static std::unique_ptr< MappedSampleFile > Map( wxFile &file, size_t size );
+   MappedSampleFile( void *address, size_t size );
+   bool SetLayout( size_t offset, Encoding encoding,
+      unsigned channels, size_t frames );
+   size_t GetBytesPerSample() const;
+
+   void *mAddress;
+   size_t mSize;
+#ifdef __WXMSW__
+   void *mMapping{};
+#endif
+
+   const char *mSamples{};
+   Encoding mEncoding{ Encoding::Int16 };
+   unsigned mChannels{ 1 };
+   sampleCount mFrames{ 0 };
+};
+
+/// \brief Keeps mappings of the files of recently read BlockFiles, so each
+/// file is opened once and not for every read.
+///
+/// Mappings are bounded in number, discarding the least recently used.
+/// Blocks aliasing the same file share one mapping.  All methods may be
+/// called from any thread.
+class MappedSampleFileCache final
+{
+public:
+   static MappedSampleFileCache &Get();
+
+   MappedSampleFileCache();
+   MappedSampleFileCache( const MappedSampleFileCache & ) = delete;
+   MappedSampleFileCache &operator= ( const MappedSampleFileCache & ) = delete;
+   ~MappedSampleFileCache();
+
+   /// Read from the file of the block, mapping it if not yet done.  A
+   /// result less than len means the caller must read in the usual way,
+   /// which also takes care of reporting errors.
+   size_t ReadData( const BlockFile &owner, const wxFileName &fileName,
+      bool aliased, unsigned channel, sampleCount origin,
+      samplePtr data, sampleFormat format, size_t start, size_t len );
+
+   /// Unmap the file of the block, which is moving or being destroyed
+   void Invalidate( const BlockFile *owner );
+   /// Unmap everything, as before renaming an aliased file
+   void Clear();
+
+   /// Reread from preferences whether to map block and aliased files
+   void UpdatePrefs();
+
+private:
+   using Mapping = std::shared_ptr< const MappedSampleFile >;
+
+   struct Entry {
+      const BlockFile *owner;
+      // Null if the file could not be mapped
+      Mapping mapping;
+   };
+   using List = std::list< Entry >;
+
+   Mapping Acquire( const BlockFile &owner,
+      const wxFileName &fileName, bool aliased );
+   // Requires the lock
+   void Trim( size_t limit );
+
+   std::mutex mMutex;
+   // Most recently used first
+   List mEntries;
+   std::unordered_map< const BlockFile*, List::iterator > mIndex;
+   // Aliased files, which many blocks may share
+   std::unordered_map< wxString, std::weak_ptr< const MappedSampleFile > >
+      mAliased;
+   size_t mLimit;
+   bool mMapBlockFiles{ true };
+   bool mMapAliasedFiles{ false };
+};
+
+#endif
@@ -32,6 +32,7 @@
 #include <wx/intl.h>
 
 #include "Envelope.h"
+#include "MixKernels.h"
 #include "WaveTrack.h"
 #include "Prefs.h"
 #include "Resample.h"
@@ -255,7 +256,8 @@ Mixer::Mixer(const WaveTrackConstArray &inputTracks,
       mInputTrack[i].SetTrack(inputTracks[i]);
       mSamplePos[i] = inputTracks[i]->TimeToLongSamples(startTime);
    }
-   mEnvelope = warpOptions.envelope;
+   if (warpOptions.envelope)
+      mEnvelope = std::make_unique<BoundedEnvelope>(*warpOptions.envelope);
    mT0 = startTime;
    mT1 = stopTime;
    mTime = startTime;
@@ -286,7 +288,6 @@ Mixer::Mixer(const WaveTrackConstArray &inputTracks,
       mBuffer[c].Allocate(mInterleavedBufferSize, mFormat);
       mTemp[c].Allocate(mInterleavedBufferSize, floatSample);
    }
-   mFloatBuffer = Floats{ mInterleavedBufferSize };
 
    // But cut the queue into blocks of this finer size
    // for variable rate resampling.  Each block is resampled at some
@@ -325,6 +326,30 @@ Mixer::Mixer(const WaveTrackConstArray &inputTracks,
       mQueueLen[i] = 0;
    }
 
+   // The channels of a track, when they come together at one rate, are
+   // resampled together.  Not at variable rates, where that measured slower
+   // than a resampler for each channel.
+   mGroupChannels.reinit(mNumInputTracks);
+   size_t maxGroupChannels = 1;
+   for (size_t i = 0; i < mNumInputTracks;) {
+      size_t nChannels = 1;
+      while (!mbVariableRates && i + nChannels < mNumInputTracks) {
+         const auto prev = mInputTrack[i + nChannels - 1].GetTrack();
+         const auto next = mInputTrack[i + nChannels].GetTrack();
+         if (!(prev->GetLinked() && prev->GetLink() == next.get() &&
+               prev->GetRate() == next->GetRate()))
+            break;
+         mGroupChannels[i + nChannels] = 0;
+         ++nChannels;
+      }
+      mGroupChannels[i] = nChannels;
+      maxGroupChannels = std::max(maxGroupChannels, nChannels);
+      i += nChannels;
+   }
+   mFloatBuffer = FloatBuffers{ maxGroupChannels, mInterleavedBufferSize };
+   mInBuffers.reinit(maxGroupChannels);
+   mOutBuffers.reinit(maxGroupChannels);
+
    MakeResamplers();
 
    const auto envLen = std::max(mQueueMaxLen, mInterleavedBufferSize);
@@ -338,7 +363,9 @@ Mixer::~Mixer()
 void Mixer::MakeResamplers()
 {
    for (size_t i = 0; i < mNumInputTracks; i++)
-      mResample[i] = std::make_unique<Resample>(mHighQuality, mMinFactor[i], mMaxFactor[i]);
+      if (mGroupChannels[i] > 0)
+         mResample[i] = std::make_unique<Resample>(mHighQuality, mMinFactor[i], mMaxFactor[i],
+                                                   mGroupChannels[i]);
 }
 
 void Mixer::ApplyTrackGains(bool apply)
@@ -357,6 +384,20 @@ void MixBuffers(unsigned numChannels, int *channelFlags, float *gains,
                 samplePtr src, SampleBuffer *dests,
                 int len, bool interleaved)
 {
+   float *temp = (float *)src;
+
+   // The common case of interleaved stereo mixes both channels at once
+   if (interleaved && numChannels == 2 && channelFlags[0] && channelFlags[1]) {
+      float *dest = (float *)dests[0].ptr();
+      const float gain0 = gains[0], gain1 = gains[1];
+      for (int j = MixKernels::MixStereo(temp, gain0, gain1, dest, len);
+           j < len; j++) {
+         dest[2 * j] += temp[j] * gain0;
+         dest[2 * j + 1] += temp[j] * gain1;
+      }
+      return;
+   }
+
    for (unsigned int c = 0; c < numChannels; c++) {
       if (!channelFlags[c])
          continue;
@@ -374,8 +415,12 @@ void MixBuffers(unsigned numChannels, int *channelFlags, float *gains,
 
       float gain = gains[c];
       float *dest = (float *)destPtr;
-      float *temp = (float *)src;
-      for (int j = 0; j < len; j++) {
+      int j = 0;
+      if (skip == 1) {
+         j = MixKernels::MixMono(temp, gain, dest, len);
+         dest += j;
+      }
+      for (; j < len; j++) {
          *dest += temp[j] * gain;   // the actual mixing process
          dest += skip;
       }
@@ -402,12 +447,17 @@ double ComputeWarpFactor(const Envelope &env, double t0, double t1)
 
 }
 
-size_t Mixer::MixVariableRates(int *channelFlags, WaveTrackCache &cache,
-                                    sampleCount *pos, float *queue,
-                                    int *queueStart, int *queueLen,
-                                    Resample * pResample)
+size_t Mixer::MixVariableRates(int *channelFlags,
+                                    size_t iTrack, size_t nChannels)
 {
-   const WaveTrack *const track = cache.GetTrack().get();
+   // The channels are read and resampled in step, so the position and the
+   // queue of the first stand for all of them
+   sampleCount *const pos = &mSamplePos[iTrack];
+   int *const queueStart = &mQueueStart[iTrack];
+   int *const queueLen = &mQueueLen[iTrack];
+   Resample *const pResample = mResample[iTrack].get();
+
+   const WaveTrack *const track = mInputTrack[iTrack].GetTrack().get();
    const double trackRate = track->GetRate();
    const double initialWarp = mRate / mSpeed / trackRate;
    const double tstep = 1.0 / trackRate;
@@ -426,9 +476,14 @@ size_t Mixer::MixVariableRates(int *channelFlags, WaveTrackCache &cache,
     *       to calculate the position.
     */
 
-   // Find the last sample
+   // Find the last sample, of the longest channel
    double endTime = track->GetEndTime();
    double startTime = track->GetStartTime();
+   for (size_t c = 1; c < nChannels; c++) {
+      const WaveTrack *const channel = mInputTrack[iTrack + c].GetTrack().get();
+      endTime = std::max(endTime, channel->GetEndTime());
+      startTime = std::min(startTime, channel->GetStartTime());
+   }
    const bool backwards = (mT1 < mT0);
    const double tEnd = backwards
       ? std::max(startTime, mT1)
@@ -440,17 +495,23 @@ size_t Mixer::MixVariableRates(int *channelFlags, WaveTrackCache &cache,
 
    while (out < mMaxOut) {
       if (*queueLen < (int)mProcessLen) {
-         // Shift pending portion to start of the buffer
-         memmove(queue, &queue[*queueStart], (*queueLen) * sampleSize);
-         *queueStart = 0;
-
          auto getLen = limitSampleBufferSize(
             mQueueMaxLen - *queueLen,
             backwards ? *pos - endPos : endPos - *pos
          );
 
-         // Nothing to do if past end of play interval
-         if (getLen > 0) {
+         for (size_t c = 0; c < nChannels; c++) {
+            WaveTrackCache &cache = mInputTrack[iTrack + c];
+            const WaveTrack *const channel = cache.GetTrack().get();
+            float *const queue = mSampleQueue[iTrack + c].get();
+
+            // Shift pending portion to start of the buffer
+            memmove(queue, &queue[*queueStart], (*queueLen) * sampleSize);
+
+            // Nothing to do if past end of play interval
+            if (getLen == 0)
+               continue;
+
             if (backwards) {
                auto results = cache.Get(floatSample, *pos - (getLen - 1), getLen, mMayThrow);
                if (results)
@@ -458,10 +519,9 @@ size_t Mixer::MixVariableRates(int *channelFlags, WaveTrackCache &cache,
                else
                   memset(&queue[*queueLen], 0, sizeof(float) * getLen);
 
-               track->GetEnvelopeValues(mEnvValues.get(),
-                                        getLen,
-                                        (*pos - (getLen- 1)).as_double() / trackRate);
-               *pos -= getLen;
+               channel->GetEnvelopeValues(mEnvValues.get(),
+                                          getLen,
+                                          (*pos - (getLen- 1)).as_double() / trackRate);
             }
             else {
                auto results = cache.Get(floatSample, *pos, getLen, mMayThrow);
@@ -470,21 +530,31 @@ size_t Mixer::MixVariableRates(int *channelFlags, WaveTrackCache &cache,
                else
                   memset(&queue[*queueLen], 0, sizeof(float) * getLen);
 
-               track->GetEnvelopeValues(mEnvValues.get(),
-                                        getLen,
-                                        (*pos).as_double() / trackRate);
-
-               *pos += getLen;
+               channel->GetEnvelopeValues(mEnvValues.get(),
+                                          getLen,
+                                          (*pos).as_double() / trackRate);
             }
 
-            for (decltype(getLen) i = 0; i < getLen; i++) {
-               queue[(*queueLen) + i] *= mEnvValues[i];
+            {
+               const auto pQueue = &queue[*queueLen];
+               for (auto i = MixKernels::Multiply(
+                       pQueue, mEnvValues.get(), pQueue, getLen);
+                    i < getLen; i++) {
+                  pQueue[i] *= mEnvValues[i];
+               }
             }
 
             if (backwards)
                ReverseSamples((samplePtr)&queue[0], floatSample,
                               *queueLen, getLen);
+         }
+         *queueStart = 0;
 
+         if (getLen > 0) {
+            if (backwards)
+               *pos -= getLen;
+            else
+               *pos += getLen;
             *queueLen += getLen;
          }
       }
@@ -511,11 +581,15 @@ size_t Mixer::MixVariableRates(int *channelFlags, WaveTrackCache &cache,
                t, t + (double)thisProcessLen / trackRate);
       }
 
+      for (size_t c = 0; c < nChannels; c++) {
+         mInBuffers[c] = &mSampleQueue[iTrack + c][*queueStart];
+         mOutBuffers[c] = &mFloatBuffer[c][out];
+      }
       auto results = pResample->Process(factor,
-                                      &queue[*queueStart],
+                                      mInBuffers.get(),
                                       thisProcessLen,
                                       last,
-                                      &mFloatBuffer[out],
+                                      mOutBuffers.get(),
                                       mMaxOut - out);
 
       const auto input_used = results.first;
@@ -529,22 +603,33 @@ size_t Mixer::MixVariableRates(int *channelFlags, WaveTrackCache &cache,
       }
    }
 
-   for (size_t c = 0; c < mNumChannels; c++) {
-      if (mApplyTrackGains) {
-         mGains[c] = track->GetChannelGain(c);
-      }
-      else {
-         mGains[c] = 1.0;
+   for (size_t c = 0; c < nChannels; c++) {
+      const WaveTrack *const channel = mInputTrack[iTrack + c].GetTrack().get();
+      for (size_t j = 0; j < mNumChannels; j++) {
+         if (mApplyTrackGains) {
+            mGains[j] = channel->GetChannelGain(j);
+         }
+         else {
+            mGains[j] = 1.0;
+         }
       }
+
+      MixBuffers(mNumChannels,
+                 channelFlags + c * mNumChannels,
+                 mGains.get(),
+                 (samplePtr)mFloatBuffer[c].get(),
+                 mTemp.get(),
+                 out,
+                 mInterleaved);
    }
 
-   MixBuffers(mNumChannels,
-              channelFlags,
-              mGains.get(),
-              (samplePtr)mFloatBuffer.get(),
-              mTemp.get(),
-              out,
-              mInterleaved);
+   // Keep the other channels in step, for the current time and for
+   // repositioning
+   for (size_t c = 1; c < nChannels; c++) {
+      mSamplePos[iTrack + c] = *pos;
+      mQueueStart[iTrack + c] = *queueStart;
+      mQueueLen[iTrack + c] = *queueLen;
+   }
 
    return out;
 }
@@ -576,25 +661,27 @@ size_t Mixer::MixSameRate(int *channelFlags, WaveTrackCache &cache,
    if (backwards) {
       auto results = cache.Get(floatSample, *pos - (slen - 1), slen, mMayThrow);
       if (results)
-         memcpy(mFloatBuffer.get(), results, sizeof(float) * slen);
+         memcpy(mFloatBuffer[0].get(), results, sizeof(float) * slen);
       else
-         memset(mFloatBuffer.get(), 0, sizeof(float) * slen);
+         memset(mFloatBuffer[0].get(), 0, sizeof(float) * slen);
       track->GetEnvelopeValues(mEnvValues.get(), slen, t - (slen - 1) / mRate);
-      for(decltype(slen) i = 0; i < slen; i++)
-         mFloatBuffer[i] *= mEnvValues[i]; // Track gain control will go here?
-      ReverseSamples((samplePtr)mFloatBuffer.get(), floatSample, 0, slen);
+      for(auto i = MixKernels::Multiply(mFloatBuffer[0].get(), mEnvValues.get(),
+             mFloatBuffer[0].get(), slen); i < slen; i++)
+         mFloatBuffer[0][i] *= mEnvValues[i]; // Track gain control will go here?
+      ReverseSamples((samplePtr)mFloatBuffer[0].get(), floatSample, 0, slen);
 
       *pos -= slen;
    }
    else {
       auto results = cache.Get(floatSample, *pos, slen, mMayThrow);
       if (results)
-         memcpy(mFloatBuffer.get(), results, sizeof(float) * slen);
+         memcpy(mFloatBuffer[0].get(), results, sizeof(float) * slen);
       else
-         memset(mFloatBuffer.get(), 0, sizeof(float) * slen);
+         memset(mFloatBuffer[0].get(), 0, sizeof(float) * slen);
       track->GetEnvelopeValues(mEnvValues.get(), slen, t);
-      for(decltype(slen) i = 0; i < slen; i++)
-         mFloatBuffer[i] *= mEnvValues[i]; // Track gain control will go here?
+      for(auto i = MixKernels::Multiply(mFloatBuffer[0].get(), mEnvValues.get(),
+             mFloatBuffer[0].get(), slen); i < slen; i++)
+         mFloatBuffer[0][i] *= mEnvValues[i]; // Track gain control will go here?
 
       *pos += slen;
    }
@@ -606,7 +693,7 @@ size_t Mixer::MixSameRate(int *channelFlags, WaveTrackCache &cache,
          mGains[c] = 1.0;
 
    MixBuffers(mNumChannels, channelFlags, mGains.get(),
-              (samplePtr)mFloatBuffer.get(), mTemp.get(), slen, mInterleaved);
+              (samplePtr)mFloatBuffer[0].get(), mTemp.get(), slen, mInterleaved);
 
    return slen;
 }
@@ -619,55 +706,65 @@ size_t Mixer::Process(size_t maxToProcess)
    //   return 0;
 
    decltype(Process(0)) maxOut = 0;
-   ArrayOf<int> channelFlags{ mNumChannels };
+   // mNumChannels flags for each input track
+   ArrayOf<int> channelFlags{ mNumChannels * mNumInputTracks };
 
    mMaxOut = maxToProcess;
 
    Clear();
    for(size_t i=0; i<mNumInputTracks; i++) {
       const WaveTrack *const track = mInputTrack[i].GetTrack().get();
+      int *const flags = &channelFlags[i * mNumChannels];
       for(size_t j=0; j<mNumChannels; j++)
-         channelFlags[j] = 0;
+         flags[j] = 0;
 
       if( mMixerSpec ) {
          //ignore left and right when downmixing is not required
          for(size_t j = 0; j < mNumChannels; j++ )
-            channelFlags[ j ] = mMixerSpec->mMap[ i ][ j ] ? 1 : 0;
+            flags[ j ] = mMixerSpec->mMap[ i ][ j ] ? 1 : 0;
       }
       else {
          switch(track->GetChannel()) {
          case Track::MonoChannel:
          default:
             for(size_t j=0; j<mNumChannels; j++)
-               channelFlags[j] = 1;
+               flags[j] = 1;
             break;
          case Track::LeftChannel:
-            channelFlags[0] = 1;
+            flags[0] = 1;
             break;
          case Track::RightChannel:
             if (mNumChannels >= 2)
-               channelFlags[1] = 1;
+               flags[1] = 1;
             else
-               channelFlags[0] = 1;
+               flags[0] = 1;
             break;
          }
       }
+   }
+
+   for(size_t i=0; i<mNumInputTracks; i += mGroupChannels[i]) {
+      const WaveTrack *const track = mInputTrack[i].GetTrack().get();
+      const auto nChannels = mGroupChannels[i];
       if (mbVariableRates || track->GetRate() != mRate)
          maxOut = std::max(maxOut,
-            MixVariableRates(channelFlags.get(), mInputTrack[i],
-               &mSamplePos[i], mSampleQueue[i].get(),
-               &mQueueStart[i], &mQueueLen[i], mResample[i].get()));
+            MixVariableRates(&channelFlags[i * mNumChannels], i, nChannels));
       else
-         maxOut = std::max(maxOut,
-            MixSameRate(channelFlags.get(), mInputTrack[i], &mSamplePos[i]));
-
-      double t = mSamplePos[i].as_double() / (double)track->GetRate();
-      if (mT0 > mT1)
-         // backwards (as possibly in scrubbing)
-         mTime = std::max(std::min(t, mTime), mT1);
-      else
-         // forwards (the usual)
-         mTime = std::min(std::max(t, mTime), mT1);
+         for(size_t j=i; j<i+nChannels; j++)
+            maxOut = std::max(maxOut,
+               MixSameRate(&channelFlags[j * mNumChannels], mInputTrack[j],
+                  &mSamplePos[j]));
+
+      for(size_t j=i; j<i+nChannels; j++) {
+         double t = mSamplePos[j].as_double() /
+            (double)mInputTrack[j].GetTrack()->GetRate();
+         if (mT0 > mT1)
+            // backwards (as possibly in scrubbing)
+            mTime = std::max(std::min(t, mTime), mT1);
+         else
+            // forwards (the usual)
+            mTime = std::min(std::max(t, mTime), mT1);
+      }
    }
    if(mInterleaved) {
       for(size_t c=0; c<mNumChannels; c++) {
@@ -21,6 +21,7 @@
 #define __AUDACITY_MIX__
 
 #include "SampleFormat.h"
+#include <memory>
 #include <vector>
 
 class Resample;
@@ -52,7 +53,7 @@ void MixAndRender(TrackList * tracks, TrackFactory *factory,
 
 void MixBuffers(unsigned numChannels, int *channelFlags, float *gains,
                 samplePtr src,
-                samplePtr *dests, int len, bool interleaved);
+                SampleBuffer *dests, int len, bool interleaved);
 
 class AUDACITY_DLL_API MixerSpec
 {
@@ -151,10 +152,10 @@ class AUDACITY_DLL_API Mixer {
    size_t MixSameRate(int *channelFlags, WaveTrackCache &cache,
                            sampleCount *pos);
 
-   size_t MixVariableRates(int *channelFlags, WaveTrackCache &cache,
-                                sampleCount *pos, float *queue,
-                                int *queueStart, int *queueLen,
-                                Resample * pResample);
+   // Resamples the channels of a group together; channelFlags has
+   // mNumChannels flags for each
+   size_t MixVariableRates(int *channelFlags,
+                                size_t iTrack, size_t nChannels);
 
    void MakeResamplers();
 
@@ -164,13 +165,18 @@ class AUDACITY_DLL_API Mixer {
    size_t           mNumInputTracks;
    ArrayOf<WaveTrackCache> mInputTrack;
    bool             mbVariableRates;
-   const BoundedEnvelope *mEnvelope;
+   // A copy of the time track's envelope, because lookups update its search
+   // hint, and mixers may run concurrently on other threads
+   std::unique_ptr<BoundedEnvelope> mEnvelope;
    ArrayOf<sampleCount> mSamplePos;
    bool             mApplyTrackGains;
    Doubles          mEnvValues;
    double           mT0; // Start time
    double           mT1; // Stop time (none if mT0==mT1)
    double           mTime;  // Current time (renamed from mT to mTime for consistency with AudioIO - mT represented warped time there)
+   // For the first of each group of channels, which are resampled
+   // together, the number in the group; else zero
+   ArrayOf<size_t>  mGroupChannels;
    ArrayOf<std::unique_ptr<Resample>> mResample;
    size_t           mQueueMaxLen;
    FloatBuffers     mSampleQueue;
@@ -189,7 +195,9 @@ class AUDACITY_DLL_API Mixer {
    sampleFormat     mFormat;
    bool             mInterleaved;
    ArrayOf<SampleBuffer> mBuffer, mTemp;
-   Floats           mFloatBuffer;
+   FloatBuffers     mFloatBuffer; // for each channel of the largest group
+   // Pointers into the queues and mFloatBuffer, for the channels of a group
+   ArrayOf<float *> mInBuffers, mOutBuffers;
    double           mRate;
    double           mSpeed;
    bool             mHighQuality;
@@ -0,0 +1,172 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  MixKernels.cpp
+
+*******************************************************************//**
+
+\file MixKernels.cpp
+\brief SSE2 and AVX2 loops for applying envelopes and gains while mixing,
+chosen at run time.
+
+  Like those of SampleFormatKernels, the AVX2 loops are built by a target
+  attribute on each function, with no special compiler option.  They use
+  separate multiplications and additions, never fused ones, so that they
+  round as the scalar loops do.
+
+*//*******************************************************************/
+
+#include "Audacity.h"
+#include "MixKernels.h"
+
+#include "SampleFormatKernels.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+   #define MIX_KERNELS_X86
+   #include <immintrin.h>
+   #if defined(_MSC_VER)
+      #define TARGET_SSE2
+      #define TARGET_AVX2
+   #else
+      #define TARGET_SSE2 __attribute__((target("sse2")))
+      #define TARGET_AVX2 __attribute__((target("avx2")))
+   #endif
+#endif
+
+namespace MixKernels {
+
+namespace {
+
+#ifdef MIX_KERNELS_X86
+
+////////////////////////////////////////////////////////////////////////
+// SSE2, four samples to a vector
+
+namespace SSE2 {
+
+TARGET_SSE2 size_t Multiply( const float *src, const float *factors,
+   float *dst, size_t len )
+{
+   size_t ii = 0;
+   for ( ; ii + 4 <= len; ii += 4 )
+      _mm_storeu_ps( dst + ii,
+         _mm_mul_ps( _mm_loadu_ps( src + ii ), _mm_loadu_ps( factors + ii ) ) );
+   return ii;
+}
+
+TARGET_SSE2 size_t MixMono( const float *src, float gain,
+   float *dst, size_t len )
+{
+   const auto g = _mm_set1_ps( gain );
+   size_t ii = 0;
+   for ( ; ii + 4 <= len; ii += 4 )
+      _mm_storeu_ps( dst + ii, _mm_add_ps( _mm_loadu_ps( dst + ii ),
+         _mm_mul_ps( _mm_loadu_ps( src + ii ), g ) ) );
+   return ii;
+}
+
+TARGET_SSE2 size_t MixStereo( const float *src, float gain0, float gain1,
+   float *dst, size_t len )
+{
+   const auto g = _mm_setr_ps( gain0, gain1, gain0, gain1 );
+   size_t ii = 0;
+   for ( ; ii + 4 <= len; ii += 4 ) {
+      // Each source sample goes to both channels
+      const auto s = _mm_loadu_ps( src + ii );
+      const auto lo = _mm_unpacklo_ps( s, s );
+      const auto hi = _mm_unpackhi_ps( s, s );
+      const auto p = dst + 2 * ii;
+      _mm_storeu_ps( p,
+         _mm_add_ps( _mm_loadu_ps( p ), _mm_mul_ps( lo, g ) ) );
+      _mm_storeu_ps( p + 4,
+         _mm_add_ps( _mm_loadu_ps( p + 4 ), _mm_mul_ps( hi, g ) ) );
+   }
+   return ii;
+}
+
+} // namespace SSE2
+
+////////////////////////////////////////////////////////////////////////
+// AVX2, eight samples to a vector
+
+namespace AVX2 {
+
+TARGET_AVX2 size_t Multiply( const float *src, const float *factors,
+   float *dst, size_t len )
+{
+   size_t ii = 0;
+   for ( ; ii + 8 <= len; ii += 8 )
+      _mm256_storeu_ps( dst + ii, _mm256_mul_ps(
+         _mm256_loadu_ps( src + ii ), _mm256_loadu_ps( factors + ii ) ) );
+   return ii;
+}
+
+TARGET_AVX2 size_t MixMono( const float *src, float gain,
+   float *dst, size_t len )
+{
+   const auto g = _mm256_set1_ps( gain );
+   size_t ii = 0;
+   for ( ; ii + 8 <= len; ii += 8 )
+      _mm256_storeu_ps( dst + ii, _mm256_add_ps( _mm256_loadu_ps( dst + ii ),
+         _mm256_mul_ps( _mm256_loadu_ps( src + ii ), g ) ) );
+   return ii;
+}
+
+TARGET_AVX2 size_t MixStereo( const float *src, float gain0, float gain1,
+   float *dst, size_t len )
+{
+   const auto g = _mm256_setr_ps(
+      gain0, gain1, gain0, gain1, gain0, gain1, gain0, gain1 );
+   size_t ii = 0;
+   for ( ; ii + 8 <= len; ii += 8 ) {
+      // Unpacking works within halves, so put the halves back in order
+      const auto s = _mm256_loadu_ps( src + ii );
+      const auto lo = _mm256_unpacklo_ps( s, s );
+      const auto hi = _mm256_unpackhi_ps( s, s );
+      const auto first = _mm256_permute2f128_ps( lo, hi, 0x20 );
+      const auto second = _mm256_permute2f128_ps( lo, hi, 0x31 );
+      const auto p = dst + 2 * ii;
+      _mm256_storeu_ps( p,
+         _mm256_add_ps( _mm256_loadu_ps( p ), _mm256_mul_ps( first, g ) ) );
+      _mm256_storeu_ps( p + 8,
+         _mm256_add_ps( _mm256_loadu_ps( p + 8 ), _mm256_mul_ps( second, g ) ) );
+   }
+   return ii;
+}
+
+} // namespace AVX2
+
+#endif // MIX_KERNELS_X86
+
+} // namespace
+
+#ifdef MIX_KERNELS_X86
+   #define DISPATCH( call ) \
+      switch ( SampleFormatKernels::Get() ) { \
+      case SampleFormatKernels::InstructionSet::AVX2: return AVX2::call; \
+      case SampleFormatKernels::InstructionSet::SSE2: return SSE2::call; \
+      default: return 0; \
+      }
+#else
+   #define DISPATCH( call ) return 0;
+#endif
+
+size_t Multiply( const float *src, const float *factors,
+   float *dst, size_t len )
+{
+   DISPATCH( Multiply( src, factors, dst, len ) )
+}
+
+size_t MixMono( const float *src, float gain, float *dst, size_t len )
+{
+   DISPATCH( MixMono( src, gain, dst, len ) )
+}
+
+size_t MixStereo( const float *src, float gain0, float gain1,
+   float *dst, size_t len )
+{
+   DISPATCH( MixStereo( src, gain0, gain1, dst, len ) )
+}
+
+}
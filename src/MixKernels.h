@@ -0,0 +1,37 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  MixKernels.h
+
+**********************************************************************/
+
+#ifndef __AUDACITY_MIX_KERNELS__
+#define __AUDACITY_MIX_KERNELS__
+
+#include <stddef.h>
+
+/// \brief Vectorized inner loops of Mixer and MixBuffers().
+///
+/// The instruction set is the one that SampleFormatKernels uses, so that
+/// SampleFormatKernels::Set() chooses it for both.  As there, each loop does
+/// the longest prefix of the source samples that is a whole number of
+/// vectors, and returns its length; the caller does the rest with the scalar
+/// loops.  Each sample has one multiplication and at most one addition, as in
+/// the scalar loops, so the results are exactly the same.
+namespace MixKernels {
+
+   /// dst[i] = src[i] * factors[i], as for envelope values; dst may be src
+   size_t Multiply( const float *src, const float *factors,
+      float *dst, size_t len );
+
+   /// dst[i] += src[i] * gain
+   size_t MixMono( const float *src, float gain, float *dst, size_t len );
+
+   /// dst[2 * i] += src[i] * gain0, and dst[2 * i + 1] += src[i] * gain1,
+   /// mixing one track into interleaved stereo
+   size_t MixStereo( const float *src, float gain0, float gain1,
+      float *dst, size_t len );
+}
+
+#endif
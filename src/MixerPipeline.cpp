@@ -0,0 +1,147 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  MixerPipeline.cpp
+
+*******************************************************************//**
+
+\class MixerPipeline
+\brief Runs a Mixer on a thread of its own, a few buffers ahead of the
+thread that consumes its output.
+
+*//*******************************************************************/
+
+#include "Audacity.h"
+#include "MixerPipeline.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include <wx/debug.h>
+
+#include "Mix.h"
+
+MixerPipeline::MixerPipeline( std::unique_ptr< Mixer > pMixer,
+   size_t bufferSize, unsigned numChannels, bool interleaved,
+   sampleFormat format, size_t depth )
+   : mpMixer{ std::move( pMixer ) }
+   , mBufferSize{ bufferSize }
+   , mNumChannels{ numChannels }
+   , mInterleaved{ interleaved }
+   , mFormat{ format }
+   , mDepth{ std::max< size_t >( 1, depth ) }
+   , mSlots{ mDepth }
+{
+   const auto nBuffers = mInterleaved ? 1 : mNumChannels;
+   const auto size = mInterleaved ? mBufferSize * mNumChannels : mBufferSize;
+   for ( size_t ii = 0; ii < mDepth; ++ii ) {
+      auto &slot = mSlots[ ii ];
+      slot.buffers.reinit( nBuffers );
+      for ( size_t cc = 0; cc < nBuffers; ++cc )
+         slot.buffers[ cc ].Allocate( size, mFormat );
+   }
+
+   mThread = std::thread( [this]{ Run(); } );
+}
+
+MixerPipeline::~MixerPipeline()
+{
+   {
+      std::lock_guard< std::mutex > lock{ mMutex };
+      mStopping = true;
+   }
+   mCondition.notify_all();
+   mThread.join();
+}
+
+void MixerPipeline::Run()
+{
+   while ( true ) {
+      Slot *pSlot;
+      {
+         std::unique_lock< std::mutex > lock{ mMutex };
+         mCondition.wait( lock,
+            [this]{ return mStopping || mFilled < mDepth; } );
+         if ( mStopping )
+            return;
+         pSlot = &mSlots[ ( mHead + mFilled ) % mDepth ];
+      }
+
+      // The slot is neither filled nor given out, so mix into it unlocked
+      auto &slot = *pSlot;
+      try {
+         slot.count = mpMixer->Process( mBufferSize );
+         slot.time = mpMixer->MixGetCurrentTime();
+         const auto nBuffers = mInterleaved ? 1 : mNumChannels;
+         // Copy whole buffers, as the Mixer leaves them
+         const auto bytes = mBufferSize * SAMPLE_SIZE( mFormat ) *
+            ( mInterleaved ? mNumChannels : 1 );
+         for ( size_t cc = 0; cc < nBuffers; ++cc )
+            memcpy( slot.buffers[ cc ].ptr(),
+               mInterleaved ? mpMixer->GetBuffer() : mpMixer->GetBuffer( cc ),
+               bytes );
+      }
+      catch ( ... ) {
+         {
+            std::lock_guard< std::mutex > lock{ mMutex };
+            mException = std::current_exception();
+            mDone = true;
+         }
+         mCondition.notify_all();
+         return;
+      }
+
+      const bool end = ( slot.count == 0 );
+      {
+         std::lock_guard< std::mutex > lock{ mMutex };
+         ++mFilled;
+         mDone = end;
+      }
+      mCondition.notify_all();
+      if ( end )
+         return;
+   }
+}
+
+size_t MixerPipeline::Process( size_t maxSamples )
+{
+   wxASSERT( maxSamples == mBufferSize );
+   wxUnusedVar( maxSamples );
+
+   std::unique_lock< std::mutex > lock{ mMutex };
+
+   // Give back the slot given out last time
+   if ( mHolding ) {
+      mHolding = false;
+      mHead = ( mHead + 1 ) % mDepth;
+      --mFilled;
+      mCondition.notify_all();
+   }
+
+   mCondition.wait( lock, [this]{ return mFilled > 0 || mDone; } );
+   if ( mFilled == 0 ) {
+      if ( mException )
+         std::rethrow_exception( mException );
+      return 0;
+   }
+
+   mHolding = true;
+   mpCurrent = &mSlots[ mHead ];
+   return mpCurrent->count;
+}
+
+double MixerPipeline::MixGetCurrentTime() const
+{
+   return mpCurrent ? mpCurrent->time : 0.0;
+}
+
+samplePtr MixerPipeline::GetBuffer()
+{
+   return mpCurrent ? mpCurrent->buffers[ 0 ].ptr() : nullptr;
+}
+
+samplePtr MixerPipeline::GetBuffer( int channel )
+{
+   return mpCurrent ? mpCurrent->buffers[ channel ].ptr() : nullptr;
+}
@@ -0,0 +1,93 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  MixerPipeline.h
+
+**********************************************************************/
+
+#ifndef __AUDACITY_MIXER_PIPELINE__
+#define __AUDACITY_MIXER_PIPELINE__
+
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <thread>
+
+#include "MemoryX.h"
+#include "SampleFormat.h"
+
+class Mixer;
+
+/// \brief Runs a Mixer on a thread of its own, a few buffers ahead of the
+/// thread that consumes its output.
+///
+/// An exporter mixes and encodes in turn; with the mixing done here, the
+/// encoder need wait for the mixer only when it is the faster of the two.
+/// The buffers are the same as the Mixer would give, in the same order.
+class AUDACITY_DLL_API MixerPipeline final
+{
+public:
+   /// Number of buffers mixed ahead
+   static const size_t DefaultDepth = 4;
+
+   /// Takes the mixer, which was made with the other arguments, and starts
+   /// to mix buffers of bufferSize samples
+   MixerPipeline( std::unique_ptr< Mixer > pMixer,
+      size_t bufferSize, unsigned numChannels, bool interleaved,
+      sampleFormat format, size_t depth = DefaultDepth );
+   MixerPipeline( const MixerPipeline& ) = delete;
+   MixerPipeline &operator= ( const MixerPipeline& ) = delete;
+   /// Stops the mixing thread
+   ~MixerPipeline();
+
+   /// Like Mixer::Process(), but maxSamples must be the buffer size given to
+   /// the constructor.  Waits for the next buffer, and rethrows any exception
+   /// that the mixer threw.
+   size_t Process( size_t maxSamples );
+
+   /// The current time of the mixer, as of the last buffer
+   double MixGetCurrentTime() const;
+
+   /// Retrieve the main buffer or the interleaved buffer
+   samplePtr GetBuffer();
+
+   /// Retrieve one of the non-interleaved buffers
+   samplePtr GetBuffer( int channel );
+
+private:
+   void Run();
+
+   struct Slot {
+      // One buffer if interleaved, else one per channel
+      ArrayOf< SampleBuffer > buffers;
+      size_t count{ 0 };
+      double time{ 0.0 };
+   };
+
+   const std::unique_ptr< Mixer > mpMixer;
+   const size_t mBufferSize;
+   const unsigned mNumChannels;
+   const bool mInterleaved;
+   const sampleFormat mFormat;
+   const size_t mDepth;
+
+   // A ring of mDepth slots, of which mFilled from mHead on are mixed
+   ArrayOf< Slot > mSlots;
+   // The slot that Process() last gave out, if any
+   Slot *mpCurrent{ nullptr };
+
+   std::mutex mMutex;
+   std::condition_variable mCondition;
+   // Guarded by mMutex
+   size_t mHead{ 0 };
+   size_t mFilled{ 0 };
+   bool mHolding{ false };
+   bool mDone{ false };
+   bool mStopping{ false };
+   std::exception_ptr mException;
+
+   std::thread mThread;
+};
+
+#endif
@@ -537,7 +537,8 @@ PluginPaths ModuleManager::FindPluginsForProvider(const PluginID & providerID,
    return mDynModules[providerID]->FindPluginPaths(PluginManager::Get());
 }
 
-bool ModuleManager::RegisterEffectPlugin(const PluginID & providerID, const PluginPath & path, wxString &errMsg)
+bool ModuleManager::RegisterEffectPlugin(const PluginID & providerID, const PluginPath & path, wxString &errMsg,
+   const ModuleInterface::RegistrationCallback &callback)
 {
    errMsg.clear();
    if (mDynModules.find(providerID) == mDynModules.end())
@@ -545,7 +546,7 @@ bool ModuleManager::RegisterEffectPlugin(const PluginID & providerID, const Plug
       return false;
    }
 
-   auto nFound = mDynModules[providerID]->DiscoverPluginsAtPath(path, errMsg, PluginManagerInterface::DefaultRegistrationCallback);
+   auto nFound = mDynModules[providerID]->DiscoverPluginsAtPath(path, errMsg, callback);
 
    return nFound > 0;
 }
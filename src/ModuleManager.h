@@ -17,6 +17,7 @@
 #include <vector>
 
 #include "audacity/ModuleInterface.h"
+#include "audacity/PluginInterface.h"
 
 class wxArrayString;
 class wxDynamicLibrary;
@@ -100,7 +101,9 @@ public:
 
    PluginPaths FindPluginsForProvider(const PluginID & provider, const PluginPath & path);
    bool RegisterEffectPlugin(const PluginID & provider, const PluginPath & path,
-                       wxString &errMsg);
+                       wxString &errMsg,
+                       const ModuleInterface::RegistrationCallback &callback =
+                          PluginManagerInterface::DefaultRegistrationCallback);
 
    ModuleInterface *CreateProviderInstance(const PluginID & provider, const PluginPath & path);
    ComponentInterface *CreateInstance(const PluginID & provider, const PluginPath & path);
@@ -44,13 +44,17 @@ for shared and private configs - which need to move out.
 #include "FileNames.h"
 #include "ModuleManager.h"
 #include "PlatformCompatibility.h"
+#include "PluginRegistryCache.h"
+#include "PluginScanner.h"
 #include "Prefs.h"
 #include "ShuttleGui.h"
+#include "ThreadPool.h"
 #include "wxFileNameWrapper.h"
 #include "widgets/AudacityMessageBox.h"
 #include "widgets/ProgressDialog.h"
 
 #include <unordered_map>
+#include <unordered_set>
 
 // ============================================================================
 //
@@ -984,13 +988,31 @@ void PluginRegistrationDialog::OnOK(wxCommandEvent & WXUNUSED(evt))
       ProgressDialog progress(GetTitle(), msg, pdlgHideStopButton);
       progress.CenterOnParent();
 
+      // Check the plug-ins in helper processes, so that one that crashes
+      // does not take Audacity with it, and several are checked at once
+      const bool inProcesses =
+         gPrefs->ReadBool(wxT("/Plugins/ScanInProcesses"), true);
+      std::vector<PluginScanner::Request> requests;
+      std::vector<ItemData *> requested;
+
       int i = 0;
       for (ItemDataMap::iterator iter = mItems.begin(); iter != mItems.end(); ++iter)
       {
          ItemData & item = iter->second;
          wxString path = item.path;
 
-         if (item.state == STATE_Enabled && item.plugs[0]->GetPluginType() == PluginTypeStub)
+         if (item.state == STATE_Enabled && item.plugs[0]->GetPluginType() == PluginTypeStub && inProcesses)
+         {
+            PluginScanner::Request request;
+            request.path = path;
+            for (size_t j = 0, cntj = item.plugs.size(); j < cntj; j++)
+            {
+               request.providers.push_back(item.plugs[j]->GetProviderID());
+            }
+            requests.push_back(request);
+            requested.push_back(&item);
+         }
+         else if (item.state == STATE_Enabled && item.plugs[0]->GetPluginType() == PluginTypeStub)
          {
             last3 = last3.AfterFirst(wxT('\n')) + item.path + wxT("\n");
             auto status = progress.Update(++i, enableCount, wxString::Format(_("Enabling effect or command:\n\n%s"), last3));
@@ -1047,6 +1069,41 @@ void PluginRegistrationDialog::OnOK(wxCommandEvent & WXUNUSED(evt))
          }
       }
 
+      if (!requests.empty())
+      {
+         auto results = PluginScanner::Scan(requests,
+            ThreadPool::Get().GetConcurrency(),
+            [&](size_t nDone, const PluginPath &path)
+            {
+               last3 = last3.AfterFirst(wxT('\n')) + path + wxT("\n");
+               auto status = progress.Update(i + (int)nDone, enableCount, wxString::Format(_("Enabling effect or command:\n\n%s"), last3));
+               return status != ProgressResult::Cancelled;
+            });
+
+         for (size_t r = 0, cntr = results.size(); r < cntr; r++)
+         {
+            auto &result = results[r];
+            ItemData & item = *requested[r];
+            if (result.registered)
+            {
+               for (size_t k = 0, cntk = item.plugs.size(); k < cntk; k++)
+               {
+                  pm.mPlugins.erase(item.plugs[k]->GetProviderID() + wxT("_") + item.path);
+               }
+               // Empty if the plug-in was registered here instead
+               for (auto &plug : result.plugins)
+               {
+                  pm.mPlugins[plug.GetID()] = std::move(plug);
+               }
+            }
+            else if (!result.errors.empty())
+               AudacityMessageBox( wxString::Format(
+                  _("Effect or Command at %s failed to register:\n%s"),
+                  item.path, wxT("\n") + result.errors
+               ) );
+         }
+      }
+
       pm.Save();
    }
 
@@ -1884,6 +1941,11 @@ bool PluginManager::DropFile(const wxString &fileName)
 
 void PluginManager::Load()
 {
+   // The binary cache is much faster to read, if it is up to date
+   if (PluginRegistryCache::Read(FileNames::PluginRegistryCache(),
+      FileNames::PluginRegistry(), mPlugins))
+      return;
+
    // Create/Open the registry
    wxFileConfig registry(wxEmptyString, wxEmptyString, FileNames::PluginRegistry());
 
@@ -1961,6 +2023,10 @@ void PluginManager::Load()
    LoadGroup(&registry, PluginTypeImporter);
 
    LoadGroup(&registry, PluginTypeStub);
+
+   // So that the next start is faster
+   PluginRegistryCache::Write(FileNames::PluginRegistryCache(),
+      FileNames::PluginRegistry(), mPlugins);
    return;
 }
 
@@ -2257,6 +2323,10 @@ void PluginManager::Save()
 
    // Just to be safe
    registry.Flush();
+
+   // Keep the cache in step with the registry
+   PluginRegistryCache::Write(FileNames::PluginRegistryCache(),
+      FileNames::PluginRegistry(), mPlugins);
 }
 
 void PluginManager::SaveGroup(wxFileConfig *pRegistry, PluginType type)
@@ -2350,7 +2420,8 @@ void PluginManager::CheckForUpdates(bool bFast)
    // Get ModuleManager reference
    ModuleManager & mm = ModuleManager::Get();
 
-   wxArrayString pathIndex;
+   // Hashed, because providers may report thousands of paths
+   std::unordered_set<wxString> pathIndex;
    for (PluginMap::iterator iter = mPlugins.begin(); iter != mPlugins.end(); ++iter)
    {
       PluginDescriptor & plug = iter->second;
@@ -2361,7 +2432,7 @@ void PluginManager::CheckForUpdates(bool bFast)
          continue;
       }
 
-      pathIndex.push_back(plug.GetPath().BeforeFirst(wxT(';')));
+      pathIndex.insert(plug.GetPath().BeforeFirst(wxT(';')));
    }
 
    // Check all known plugins to ensure they are still valid and scan for NEW ones.
@@ -2406,7 +2477,7 @@ void PluginManager::CheckForUpdates(bool bFast)
             for (size_t i = 0, cnt = paths.size(); i < cnt; i++)
             {
                wxString path = paths[i].BeforeFirst(wxT(';'));;
-               if ( ! make_iterator_range( pathIndex ).contains( path ) )
+               if ( pathIndex.count( path ) == 0 )
                {
                   PluginID ID = plugID + wxT("_") + path;
                   PluginDescriptor & plug2 = mPlugins[ID];  // This will create a NEW descriptor
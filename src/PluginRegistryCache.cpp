@@ -0,0 +1,335 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  PluginRegistryCache.cpp
+
+*******************************************************************//**
+
+\namespace PluginRegistryCache
+\brief A binary copy of the plug-in registry, which is much faster to
+load than the text registry when very many plug-ins are installed.
+
+  The file is one header and one record per plug-in, in the byte order of
+  the machine, read into memory at once.  Strings are UTF-8, preceded by
+  their lengths.
+
+*//*******************************************************************/
+
+#include "Audacity.h"
+#include "PluginRegistryCache.h"
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include <wx/ffile.h>
+#include <wx/filefn.h>
+#include <wx/filename.h>
+
+#include "PlatformCompatibility.h"
+
+namespace {
+
+// Also tells whether the file was written in another byte order
+const uint32_t Magic = 0x43525041; // "APRC"
+// Change this when the records change
+const uint32_t FormatVersion = 1;
+
+enum : uint32_t {
+   FlagEnabled = 1 << 0,
+   FlagValid = 1 << 1,
+   FlagEffectDefault = 1 << 2,
+   FlagEffectInteractive = 1 << 3,
+   FlagEffectRealtime = 1 << 4,
+   FlagEffectAutomatable = 1 << 5,
+};
+
+// The types that PluginManager::LoadGroup() accepts from the text registry;
+// others are saved there but not loaded again
+bool IsLoaded( PluginType type )
+{
+   switch ( type ) {
+      case PluginTypeModule:
+      case PluginTypeEffect:
+      case PluginTypeImporter:
+      case PluginTypeStub:
+         return true;
+      default:
+         return false;
+   }
+}
+
+// What makes the cache stale, if it differs
+struct Stamp
+{
+   int64_t modified;
+   uint64_t size;
+   wxString program;
+   wxString version;
+};
+
+bool GetStamp( const FilePath &registry, Stamp &stamp )
+{
+   wxFileName fn{ registry };
+   if ( !fn.FileExists() )
+      return false;
+   const auto modified = fn.GetModificationTime();
+   const auto size = fn.GetSize();
+   if ( !modified.IsValid() || size == wxInvalidSize )
+      return false;
+   stamp.modified = modified.GetValue().GetValue();
+   stamp.size = size.GetValue();
+   stamp.program = PlatformCompatibility::GetExecutablePath();
+   stamp.version = AUDACITY_VERSION_STRING;
+   return true;
+}
+
+class Writer
+{
+public:
+   template< typename T > void Put( T value )
+   {
+      const auto p = reinterpret_cast< const char * >( &value );
+      mBytes.insert( mBytes.end(), p, p + sizeof( T ) );
+   }
+
+   void Put( const wxString &str )
+   {
+      const auto utf8 = str.utf8_str();
+      const auto len = strlen( utf8.data() );
+      Put< uint32_t >( len );
+      mBytes.insert( mBytes.end(), utf8.data(), utf8.data() + len );
+   }
+
+   const std::vector< char > &GetBytes() const { return mBytes; }
+
+private:
+   std::vector< char > mBytes;
+};
+
+class Reader
+{
+public:
+   Reader( const char *begin, const char *end )
+      : mPos{ begin }, mEnd{ end }
+   {}
+
+   // Results are unspecified once this is false
+   bool Ok() const { return mOk; }
+   bool AtEnd() const { return mPos == mEnd; }
+
+   template< typename T > T Get()
+   {
+      T value{};
+      if ( Need( sizeof( T ) ) ) {
+         memcpy( &value, mPos, sizeof( T ) );
+         mPos += sizeof( T );
+      }
+      return value;
+   }
+
+   wxString GetString()
+   {
+      const auto len = Get< uint32_t >();
+      if ( !Need( len ) )
+         return {};
+      auto result = wxString::FromUTF8( mPos, len );
+      mPos += len;
+      return result;
+   }
+
+private:
+   bool Need( size_t len )
+   {
+      if ( mOk && size_t( mEnd - mPos ) >= len )
+         return true;
+      mOk = false;
+      return false;
+   }
+
+   const char *mPos;
+   const char *mEnd;
+   bool mOk{ true };
+};
+
+}
+
+bool PluginRegistryCache::Read( const FilePath &cache,
+   const FilePath &registry, PluginMap &plugins )
+{
+   Stamp stamp;
+   if ( !wxFileExists( cache ) || !GetStamp( registry, stamp ) )
+      return false;
+
+   // Read the whole file at once
+   std::vector< char > bytes;
+   {
+      wxFFile file{ cache, wxT("rb") };
+      if ( !file.IsOpened() )
+         return false;
+      const auto length = file.Length();
+      if ( length <= 0 )
+         return false;
+      bytes.resize( length );
+      if ( file.Read( bytes.data(), length ) != size_t( length ) )
+         return false;
+   }
+   Reader reader{ bytes.data(), bytes.data() + bytes.size() };
+
+   if ( reader.Get< uint32_t >() != Magic ||
+        reader.Get< uint32_t >() != FormatVersion ||
+        reader.Get< int64_t >() != stamp.modified ||
+        reader.Get< uint64_t >() != stamp.size ||
+        reader.GetString() != stamp.program ||
+        reader.GetString() != stamp.version ||
+        !reader.Ok() )
+      return false;
+
+   const auto count = reader.Get< uint32_t >();
+   std::vector< PluginDescriptor > descriptors;
+   for ( uint32_t ii = 0; ii < count && reader.Ok(); ++ii ) {
+      descriptors.emplace_back();
+      auto &plug = descriptors.back();
+
+      const auto type = PluginType( reader.Get< uint32_t >() );
+      const auto flags = reader.Get< uint32_t >();
+      if ( !IsLoaded( type ) )
+         return false;
+      plug.SetPluginType( type );
+      plug.SetID( reader.GetString() );
+      plug.SetProviderID( reader.GetString() );
+      plug.SetPath( reader.GetString() );
+      plug.SetSymbol( reader.GetString() );
+      plug.SetVersion( reader.GetString() );
+      plug.SetVendor( reader.GetString() );
+      plug.SetEnabled( ( flags & FlagEnabled ) != 0 );
+      plug.SetValid( ( flags & FlagValid ) != 0 );
+
+      if ( type == PluginTypeEffect ) {
+         plug.SetEffectType( EffectType( reader.Get< uint32_t >() ) );
+         plug.SetEffectFamily( reader.GetString() );
+         plug.SetEffectDefault( ( flags & FlagEffectDefault ) != 0 );
+         plug.SetEffectInteractive( ( flags & FlagEffectInteractive ) != 0 );
+         plug.SetEffectRealtime( ( flags & FlagEffectRealtime ) != 0 );
+         plug.SetEffectAutomatable( ( flags & FlagEffectAutomatable ) != 0 );
+      }
+      else if ( type == PluginTypeImporter ) {
+         plug.SetImporterIdentifier( reader.GetString() );
+         plug.SetImporterFilterDescription( reader.GetString() );
+         FileExtensions extensions;
+         const auto nExtensions = reader.Get< uint32_t >();
+         for ( uint32_t jj = 0; jj < nExtensions && reader.Ok(); ++jj )
+            extensions.push_back( reader.GetString() );
+         plug.SetImporterExtensions( extensions );
+      }
+   }
+   if ( !reader.Ok() || !reader.AtEnd() )
+      return false;
+
+   // All is well; keep the plug-ins whose IDs are not in use, as the text
+   // registry would
+   for ( auto &plug : descriptors ) {
+      auto &ID = plug.GetID();
+      if ( plugins.find( ID ) == plugins.end() )
+         plugins[ ID ] = plug;
+   }
+
+   return true;
+}
+
+bool PluginRegistryCache::Write( const FilePath &cache,
+   const FilePath &registry, const PluginMap &plugins )
+{
+   Stamp stamp;
+   if ( !GetStamp( registry, stamp ) ) {
+      // Don't leave a cache of some other registry
+      if ( wxFileExists( cache ) )
+         wxRemoveFile( cache );
+      return false;
+   }
+
+   uint32_t count = 0;
+   for ( const auto &pair : plugins )
+      if ( IsLoaded( pair.second.GetPluginType() ) )
+         ++count;
+
+   Writer writer;
+   writer.Put( Magic );
+   writer.Put( FormatVersion );
+   writer.Put( stamp.modified );
+   writer.Put( stamp.size );
+   writer.Put( stamp.program );
+   writer.Put( stamp.version );
+   writer.Put( count );
+
+   for ( const auto &pair : plugins ) {
+      const auto &plug = pair.second;
+      const auto type = plug.GetPluginType();
+      if ( !IsLoaded( type ) )
+         continue;
+
+      uint32_t flags = 0;
+      if ( plug.IsEnabled() )
+         flags |= FlagEnabled;
+      if ( plug.IsValid() )
+         flags |= FlagValid;
+      if ( type == PluginTypeEffect ) {
+         if ( plug.IsEffectDefault() )
+            flags |= FlagEffectDefault;
+         if ( plug.IsEffectInteractive() )
+            flags |= FlagEffectInteractive;
+         if ( plug.IsEffectRealtime() )
+            flags |= FlagEffectRealtime;
+         if ( plug.IsEffectAutomatable() )
+            flags |= FlagEffectAutomatable;
+      }
+
+      writer.Put< uint32_t >( type );
+      writer.Put( flags );
+      writer.Put( plug.GetID() );
+      writer.Put( plug.GetProviderID() );
+      writer.Put( plug.GetPath() );
+      // As the text registry has it
+      writer.Put( plug.GetSymbol().Internal() );
+      writer.Put( plug.GetUntranslatedVersion() );
+      writer.Put( plug.GetVendor() );
+
+      if ( type == PluginTypeEffect ) {
+         writer.Put< uint32_t >( plug.GetEffectType() );
+         writer.Put( plug.GetEffectFamily() );
+      }
+      else if ( type == PluginTypeImporter ) {
+         writer.Put( plug.GetImporterIdentifier() );
+         writer.Put( plug.GetImporterFilterDescription() );
+         // The text registry loses empty extensions
+         FileExtensions extensions;
+         for ( const auto &extension : plug.GetImporterExtensions() )
+            if ( !extension.empty() )
+               extensions.push_back( extension );
+         writer.Put< uint32_t >( extensions.size() );
+         for ( const auto &extension : extensions )
+            writer.Put( extension );
+      }
+   }
+
+   // Write a temporary file and then rename it, so that a reader never sees
+   // half a cache
+   const auto &bytes = writer.GetBytes();
+   const auto temp = cache + wxT(".tmp");
+   {
+      wxFFile file{ temp, wxT("wb") };
+      if ( !file.IsOpened() ||
+           file.Write( bytes.data(), bytes.size() ) != bytes.size() ||
+           !file.Close() ) {
+         wxRemoveFile( temp );
+         return false;
+      }
+   }
+   if ( !wxRenameFile( temp, cache, true ) ) {
+      wxRemoveFile( temp );
+      return false;
+   }
+
+   return true;
+}
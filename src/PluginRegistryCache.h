@@ -0,0 +1,35 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  PluginRegistryCache.h
+
+**********************************************************************/
+
+#ifndef __AUDACITY_PLUGIN_REGISTRY_CACHE__
+#define __AUDACITY_PLUGIN_REGISTRY_CACHE__
+
+#include "PluginManager.h"
+
+/// \brief A binary copy of the plug-in registry, which is much faster to
+/// load than the text registry when very many plug-ins are installed.
+///
+/// It holds what PluginManager would load from the text registry, with the
+/// modification time and size of that file, and the program's path and
+/// version.  If any of those differ, the cache is stale, and the text
+/// registry is loaded instead.
+namespace PluginRegistryCache
+{
+   /// Add the plug-ins of the cache to plugins, except those with IDs
+   /// already there; false, adding none, if the cache is missing, stale, or
+   /// damaged
+   bool Read( const FilePath &cache, const FilePath &registry,
+      PluginMap &plugins );
+
+   /// Write the plug-ins that PluginManager would load from the registry,
+   /// which must be saved already; false if it fails
+   bool Write( const FilePath &cache, const FilePath &registry,
+      const PluginMap &plugins );
+}
+
+#endif
@@ -0,0 +1,529 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  PluginScanner.cpp
+
+*******************************************************************//**
+
+\namespace PluginScanner
+\brief Registers new plug-ins in helper processes, several at once.
+
+  A helper writes each descriptor it made as lines of the form
+  "<prefix>Key=Value", in UTF-8, with newlines and backslashes in the values
+  escaped, and ends the report on each plug-in with an End line.  Other
+  output, perhaps from the plug-ins, is ignored.
+
+*//*******************************************************************/
+
+#include "Audacity.h"
+#include "PluginScanner.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <string>
+
+#include <wx/app.h>
+#include <wx/intl.h>
+#include <wx/process.h>
+#include <wx/stream.h>
+#include <wx/utils.h>
+
+#include "MemoryX.h"
+#include "ModuleManager.h"
+#include "PlatformCompatibility.h"
+
+namespace {
+
+// Begins each line of the output of a helper that is meant for the caller
+const char OutputPrefix[] = "<PLUGINSCAN>";
+
+// Keys of the output; Begin starts a descriptor, and End, with 1 if the
+// plug-in was registered, ends the report on one plug-in of the batch
+const wxString KeyBegin = wxT("Begin");
+const wxString KeyEnd = wxT("End");
+const wxString KeyType = wxT("Type");
+const wxString KeyID = wxT("ID");
+const wxString KeyProvider = wxT("Provider");
+const wxString KeyPath = wxT("Path");
+const wxString KeySymbol = wxT("Symbol");
+const wxString KeyName = wxT("Name");
+const wxString KeyVersion = wxT("Version");
+const wxString KeyVendor = wxT("Vendor");
+const wxString KeyEnabled = wxT("Enabled");
+const wxString KeyValid = wxT("Valid");
+const wxString KeyEffectType = wxT("EffectType");
+const wxString KeyEffectFamily = wxT("EffectFamily");
+const wxString KeyEffectDefault = wxT("EffectDefault");
+const wxString KeyEffectInteractive = wxT("EffectInteractive");
+const wxString KeyEffectRealtime = wxT("EffectRealtime");
+const wxString KeyEffectAutomatable = wxT("EffectAutomatable");
+const wxString KeyError = wxT("Error");
+
+// Most plug-ins given to one helper, and most characters of its command
+const size_t MaxBatch = 16;
+const size_t MaxCommandLength = 8000;
+
+wxString Escape( const wxString &value )
+{
+   wxString result;
+   for ( auto ch : value ) {
+      if ( ch == wxT('\\') )
+         result += wxT("\\\\");
+      else if ( ch == wxT('\n') )
+         result += wxT("\\n");
+      else if ( ch == wxT('\r') )
+         result += wxT("\\r");
+      else
+         result += ch;
+   }
+   return result;
+}
+
+wxString Unescape( const wxString &value )
+{
+   wxString result;
+   for ( auto iter = value.begin(), end = value.end(); iter != end; ++iter ) {
+      auto ch = *iter;
+      if ( ch == wxT('\\') && iter + 1 != end ) {
+         ch = *++iter;
+         if ( ch == wxT('n') )
+            ch = wxT('\n');
+         else if ( ch == wxT('r') )
+            ch = wxT('\r');
+      }
+      result += ch;
+   }
+   return result;
+}
+
+void AddLine( wxString &output, const wxString &key, const wxString &value )
+{
+   output += OutputPrefix + key + wxT("=") + Escape( value ) + wxT("\n");
+}
+
+void AddNumber( wxString &output, const wxString &key, long value )
+{
+   AddLine( output, key, wxString::Format( wxT("%ld"), value ) );
+}
+
+void Describe( const PluginDescriptor &plug, wxString &output )
+{
+   AddLine( output, KeyBegin, wxString{} );
+   AddNumber( output, KeyType, plug.GetPluginType() );
+   AddLine( output, KeyID, plug.GetID() );
+   AddLine( output, KeyProvider, plug.GetProviderID() );
+   AddLine( output, KeyPath, plug.GetPath() );
+   AddLine( output, KeySymbol, plug.GetSymbol().Internal() );
+   AddLine( output, KeyName, plug.GetSymbol().Msgid() );
+   AddLine( output, KeyVersion, plug.GetUntranslatedVersion() );
+   AddLine( output, KeyVendor, plug.GetVendor() );
+   AddNumber( output, KeyEnabled, plug.IsEnabled() );
+   AddNumber( output, KeyValid, plug.IsValid() );
+   if ( plug.GetPluginType() == PluginTypeEffect ) {
+      AddNumber( output, KeyEffectType, plug.GetEffectType() );
+      AddLine( output, KeyEffectFamily, plug.GetEffectFamily() );
+      AddNumber( output, KeyEffectDefault, plug.IsEffectDefault() );
+      AddNumber( output, KeyEffectInteractive, plug.IsEffectInteractive() );
+      AddNumber( output, KeyEffectRealtime, plug.IsEffectRealtime() );
+      AddNumber( output, KeyEffectAutomatable, plug.IsEffectAutomatable() );
+   }
+}
+
+void AddError( wxString &errors, const wxString &error )
+{
+   if ( error.empty() )
+      return;
+   if ( !errors.empty() )
+      errors += wxT("\n");
+   errors += error;
+}
+
+/// One attempt to register a plug-in: the request, and which of its
+/// providers to try
+struct Item
+{
+   size_t request;
+   size_t provider;
+};
+
+/// What a helper reported about one item of its batch
+struct Report
+{
+   bool registered{ false };
+   std::vector< PluginDescriptor > plugins;
+   wxString errors;
+};
+
+/// One helper process, which tries a batch of items in turn, and reports on
+/// each as it finishes
+class ScanProcess final : public wxProcess
+{
+public:
+   using ReportCallback = std::function< void( const Item &, Report && ) >;
+
+   explicit ScanProcess( std::vector< Item > items )
+      : mItems{ std::move( items ) }
+   {
+      Redirect();
+   }
+
+   bool IsActive() const { return mActive; }
+   int GetStatus() const { return mStatus; }
+   const std::vector< Item > &GetItems() const { return mItems; }
+   /// How many items were reported so far
+   size_t GetReported() const { return mReported; }
+
+   /// Read what is available, so that the helper never waits for a full
+   /// pipe; the error output is discarded
+   void Drain()
+   {
+      char buffer[ 4096 ];
+      while ( IsInputAvailable() ) {
+         auto stream = GetInputStream();
+         stream->Read( buffer, sizeof( buffer ) );
+         const auto count = stream->LastRead();
+         if ( count == 0 )
+            break;
+         mOutput.append( buffer, count );
+      }
+      while ( IsErrorAvailable() ) {
+         auto stream = GetErrorStream();
+         stream->Read( buffer, sizeof( buffer ) );
+         if ( stream->LastRead() == 0 )
+            break;
+      }
+   }
+
+   /// Parse the lines read so far, or all that was read if the helper is
+   /// finished, and give each report that ended to the callback
+   void Parse( const ReportCallback &callback )
+   {
+      size_t begin = 0;
+      while ( true ) {
+         auto end = mOutput.find( '\n', begin );
+         if ( end == std::string::npos ) {
+            if ( mActive || begin == mOutput.size() )
+               break;
+            end = mOutput.size();
+         }
+         ParseLine( mOutput.data() + begin, end - begin, callback );
+         begin = std::min( end + 1, mOutput.size() );
+      }
+      mOutput.erase( 0, begin );
+   }
+
+   void OnTerminate(int WXUNUSED( pid ), int status) override
+   {
+      mStatus = status;
+      mActive = false;
+   }
+
+private:
+   // Decode only the lines meant for us, because the plug-ins may write
+   // anything, not always valid UTF-8
+   void ParseLine( const char *data, size_t length,
+      const ReportCallback &callback )
+   {
+      const auto prefixLength = strlen( OutputPrefix );
+      if ( length > 0 && data[ length - 1 ] == '\r' )
+         --length;
+      if ( length < prefixLength ||
+          strncmp( data, OutputPrefix, prefixLength ) != 0 )
+         return;
+      const auto line = wxString::FromUTF8(
+         data + prefixLength, length - prefixLength );
+
+      const auto key = line.BeforeFirst( wxT('=') );
+      const auto value = Unescape( line.AfterFirst( wxT('=') ) );
+      long number = 0;
+      value.ToLong( &number );
+
+      auto &plugins = mReport.plugins;
+      if ( key == KeyEnd ) {
+         if ( mReported < mItems.size() ) {
+            mReport.registered = ( number != 0 );
+            DropIncomplete();
+            callback( mItems[ mReported++ ], std::move( mReport ) );
+         }
+         mReport = {};
+         return;
+      }
+      if ( key == KeyError ) {
+         AddError( mReport.errors, value );
+         return;
+      }
+      if ( key == KeyBegin ) {
+         plugins.emplace_back();
+         mSymbol.clear();
+         return;
+      }
+      if ( plugins.empty() )
+         return;
+
+      auto &plug = plugins.back();
+      if ( key == KeyType )
+         plug.SetPluginType( PluginType( number ) );
+      else if ( key == KeyID )
+         plug.SetID( value );
+      else if ( key == KeyProvider )
+         plug.SetProviderID( value );
+      else if ( key == KeyPath )
+         plug.SetPath( value );
+      else if ( key == KeySymbol ) {
+         // The internal part of the symbol comes first
+         mSymbol = value;
+         plug.SetSymbol( mSymbol );
+      }
+      else if ( key == KeyName )
+         plug.SetSymbol( { mSymbol, value } );
+      else if ( key == KeyVersion )
+         plug.SetVersion( value );
+      else if ( key == KeyVendor )
+         plug.SetVendor( value );
+      else if ( key == KeyEnabled )
+         plug.SetEnabled( number != 0 );
+      else if ( key == KeyValid )
+         plug.SetValid( number != 0 );
+      else if ( key == KeyEffectType )
+         plug.SetEffectType( EffectType( number ) );
+      else if ( key == KeyEffectFamily )
+         plug.SetEffectFamily( value );
+      else if ( key == KeyEffectDefault )
+         plug.SetEffectDefault( number != 0 );
+      else if ( key == KeyEffectInteractive )
+         plug.SetEffectInteractive( number != 0 );
+      else if ( key == KeyEffectRealtime )
+         plug.SetEffectRealtime( number != 0 );
+      else if ( key == KeyEffectAutomatable )
+         plug.SetEffectAutomatable( number != 0 );
+   }
+
+   // Drop descriptors that lines we could not read left incomplete
+   void DropIncomplete()
+   {
+      auto &plugins = mReport.plugins;
+      auto end = std::remove_if( plugins.begin(), plugins.end(),
+         []( const PluginDescriptor &plug ) {
+            return plug.GetID().empty() ||
+               plug.GetPluginType() == PluginTypeNone;
+         } );
+      plugins.erase( end, plugins.end() );
+   }
+
+   const std::vector< Item > mItems;
+   std::string mOutput;
+   size_t mReported{ 0 };
+   Report mReport;
+   wxString mSymbol;
+   bool mActive{ true };
+   int mStatus{ -1 };
+};
+
+// What happens with no helpers:  register in this process, trying the
+// providers from the given one on
+void RegisterHere( const PluginScanner::Request &request, size_t provider,
+   PluginScanner::Result &result )
+{
+   auto &mm = ModuleManager::Get();
+   for ( auto cnt = request.providers.size(); provider < cnt; ++provider ) {
+      wxString errMsg;
+      if ( mm.RegisterEffectPlugin(
+            request.providers[ provider ], request.path, errMsg ) ) {
+         result.registered = true;
+         result.errors.clear();
+         return;
+      }
+      AddError( result.errors, errMsg );
+   }
+}
+
+}
+
+std::vector< PluginScanner::Result > PluginScanner::Scan(
+   const std::vector< Request > &requests, unsigned jobs,
+   const ProgressCallback &progress )
+{
+   const auto &cmdpath = PlatformCompatibility::GetExecutablePath();
+   jobs = std::max( 1u, jobs );
+
+   std::vector< Result > results( requests.size() );
+   std::vector< std::unique_ptr< ScanProcess > > running;
+   // Attempts not yet given to a helper
+   std::deque< Item > pending;
+   for ( size_t request = 0; request < requests.size(); ++request )
+      pending.push_back( { request, 0 } );
+   size_t nDone = 0;
+   bool stopped = false;
+
+   auto done = [&]( size_t request ) {
+      ++nDone;
+      if ( !stopped && progress && !progress( nDone, requests[ request ].path ) )
+      {
+         // Start no more helpers, and stop those that are running
+         stopped = true;
+         pending.clear();
+         for ( auto &pProcess : running )
+            if ( pProcess )
+               wxProcess::Kill(
+                  pProcess->GetPid(), wxSIGKILL, wxKILL_CHILDREN );
+      }
+   };
+
+   // Try the next provider of a request that failed, if there is one
+   auto retry = [&]( const Item &item ) {
+      if ( item.provider + 1 < requests[ item.request ].providers.size() )
+         pending.push_front( { item.request, item.provider + 1 } );
+      else
+         done( item.request );
+   };
+
+   auto report = [&]( const Item &item, Report &&outcome ) {
+      auto &result = results[ item.request ];
+      if ( outcome.registered && !outcome.plugins.empty() ) {
+         // A provider that works; errors of others are no longer useful
+         result.registered = true;
+         result.plugins = std::move( outcome.plugins );
+         result.errors.clear();
+         done( item.request );
+         return;
+      }
+      if ( outcome.errors.empty() )
+         outcome.errors =
+            _("The check of the plug-in produced no descriptors");
+      AddError( result.errors, outcome.errors );
+      retry( item );
+   };
+
+   // Start a helper for a batch of the pending attempts, sharing them among
+   // the jobs, or else register them here
+   auto start = [&] {
+      const auto size = std::min( MaxBatch,
+         std::max< size_t >( 1, pending.size() / jobs ) );
+      // The arguments go separately, not quoted in one string, so that no
+      // path can be taken for more than one argument.  They point into
+      // requests, which outlives the call.
+      std::vector< const wxChar * > cmd{
+         cmdpath.wx_str(), wxT("--scan-plugins") };
+      // Where the system joins them into one command line, each may gain
+      // quotes and a space
+      size_t length = cmdpath.length() + 20;
+      std::vector< Item > items;
+      while ( !pending.empty() && items.size() < size ) {
+         const auto &item = pending.front();
+         const auto &req = requests[ item.request ];
+         const auto &provider = req.providers[ item.provider ];
+         const auto argLength = provider.length() + req.path.length() + 6;
+         if ( !items.empty() && length + argLength > MaxCommandLength )
+            break;
+         length += argLength;
+         cmd.push_back( provider.wx_str() );
+         cmd.push_back( req.path.wx_str() );
+         items.push_back( item );
+         pending.pop_front();
+      }
+      cmd.push_back( nullptr );
+
+      auto pProcess = std::make_unique< ScanProcess >( items );
+      if ( wxExecute( cmd.data(), wxEXEC_ASYNC, pProcess.get() ) <= 0 ) {
+         pProcess->Detach();
+         for ( const auto &item : items ) {
+            RegisterHere( requests[ item.request ], item.provider,
+               results[ item.request ] );
+            done( item.request );
+         }
+         return;
+      }
+      running.push_back( std::move( pProcess ) );
+   };
+
+   // Collect the reports of the helpers as they come.  When one finishes
+   // short of its batch, blame the item it was trying, and give the rest
+   // to another helper.
+   auto reap = [&] {
+      std::vector< std::unique_ptr< ScanProcess > > finished;
+      for ( auto &pProcess : running ) {
+         pProcess->Drain();
+         pProcess->Parse( report );
+         if ( !pProcess->IsActive() )
+            finished.push_back( std::move( pProcess ) );
+      }
+      running.erase( std::remove( running.begin(), running.end(), nullptr ),
+         running.end() );
+
+      for ( auto &pProcess : finished ) {
+         const auto &items = pProcess->GetItems();
+         auto reported = pProcess->GetReported();
+         if ( stopped || reported == items.size() )
+            continue;
+
+         for ( auto ii = items.size(); ii-- > reported + 1; )
+            pending.push_front( items[ ii ] );
+         const auto &item = items[ reported ];
+         AddError( results[ item.request ].errors, wxString::Format(
+            _("The check of the plug-in ended abnormally (status %d)"),
+            pProcess->GetStatus() ) );
+         retry( item );
+      }
+   };
+
+   while ( !pending.empty() || !running.empty() ) {
+      // Start helpers while there are plug-ins and free jobs
+      while ( !pending.empty() && running.size() < jobs )
+         start();
+
+      // Wait for helpers to report
+      wxMilliSleep( 10 );
+      wxTheApp->Yield();
+      reap();
+   }
+
+   return results;
+}
+
+int PluginScanner::RunHelper(
+   const PluginIDs &providers, const PluginPaths &paths )
+{
+   auto &mm = ModuleManager::Get();
+   auto &pm = PluginManager::Get();
+   mm.DiscoverProviders();
+
+   int status = 0;
+   for ( size_t ii = 0, cnt = std::min( providers.size(), paths.size() );
+        ii < cnt; ++ii ) {
+      PluginIDs ids;
+      wxString errMsg;
+      const auto registered = mm.RegisterEffectPlugin(
+         providers[ ii ], paths[ ii ], errMsg,
+         [&]( ModuleInterface *module, ComponentInterface *ident )
+            -> const PluginID & {
+            auto &id = PluginManagerInterface::DefaultRegistrationCallback(
+               module, ident );
+            if ( !id.empty() )
+               ids.push_back( id );
+            return id;
+         } );
+
+      // Begin on a line of its own, whatever the plug-in wrote
+      wxString output = wxT("\n");
+      for ( const auto &id : ids )
+         if ( auto plug = pm.GetPlugin( id ) )
+            Describe( *plug, output );
+      if ( !errMsg.empty() )
+         AddLine( output, KeyError, errMsg );
+      const bool ok = registered && !ids.empty();
+      AddNumber( output, KeyEnd, ok );
+      if ( !ok )
+         status = 1;
+
+      // All at once, so that output of the plug-ins is not mixed in, and
+      // now, so that the caller knows how far we got if a later one crashes
+      const auto utf8 = output.utf8_str();
+      fwrite( utf8.data(), strlen( utf8.data() ), 1, stdout );
+      fflush( stdout );
+   }
+
+   return status;
+}
@@ -0,0 +1,62 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  PluginScanner.h
+
+**********************************************************************/
+
+#ifndef __AUDACITY_PLUGIN_SCANNER__
+#define __AUDACITY_PLUGIN_SCANNER__
+
+#include <functional>
+#include <vector>
+
+#include "PluginManager.h"
+
+/// \brief Registers new plug-ins in helper processes, several at once, so
+/// that scanning a large collection is faster, and a plug-in that crashes
+/// takes down only its helper.
+///
+/// Each helper is this program again, started with --scan-plugins and a
+/// batch of plug-in paths, so that few pay the cost of starting up.  It
+/// registers each path through the provider given with it, as this process
+/// would, and writes the descriptors it made to its standard output as it
+/// goes, for the caller to add to the registry.  If a helper crashes, the
+/// rest of its batch goes to another.
+namespace PluginScanner
+{
+   /// A plug-in path, with the providers that reported it, to try in turn
+   /// until one succeeds
+   struct Request
+   {
+      PluginPath path;
+      PluginIDs providers;
+   };
+
+   struct Result
+   {
+      bool registered{ false };
+      /// To add to the registry; empty if the plug-in was registered in
+      /// this process instead, because no helper could be started
+      std::vector< PluginDescriptor > plugins;
+      /// From the providers that failed
+      wxString errors;
+   };
+
+   /// Given the number of requests done and the path of the last; returns
+   /// false to start no more helpers
+   using ProgressCallback =
+      std::function< bool( size_t nDone, const PluginPath &path ) >;
+
+   /// Register the plug-ins, in at most jobs helpers at once; results are in
+   /// the order of the requests, and those not attempted are not registered
+   std::vector< Result > Scan( const std::vector< Request > &requests,
+      unsigned jobs, const ProgressCallback &progress );
+
+   /// In a helper: register the plug-in at each path through the provider
+   /// at the same index, and write what was made; returns the exit status
+   int RunHelper( const PluginIDs &providers, const PluginPaths &paths );
+}
+
+#endif
@@ -204,7 +204,14 @@ bool AudacityPrefs::GetEditClipsCanMove()
    return editClipsCanMove;
 }
 
-void InitPreferences( const wxFileName &configFileName )
+bool AudacityPrefs::Flush(bool bCurrentOnly)
+{
+   if (mReadOnly)
+      return true;
+   return wxFileConfig::Flush(bCurrentOnly);
+}
+
+void InitPreferences( const wxFileName &configFileName, bool readOnly )
 {
    wxString appName = wxTheApp->GetAppName();
 
@@ -214,6 +221,12 @@ void InitPreferences( const wxFileName &configFileName )
        wxEmptyString, wxCONFIG_USE_LOCAL_FILE);
    gPrefs = ugPrefs.get();
 
+   if (readOnly) {
+      gPrefs->mReadOnly = true;
+      // Nor write the file on destruction
+      gPrefs->DisableAutoSave();
+   }
+
    wxConfigBase::Set(gPrefs);
 }
 
@@ -39,7 +39,7 @@
 
 class wxFileName;
 
-void InitPreferences( const wxFileName &configFileName );
+void InitPreferences( const wxFileName &configFileName, bool readOnly = false );
 bool CheckWritablePreferences();
 wxString UnwritablePreferencesErrorMessage( const wxFileName &configFileName );
 void FinishPreferences();
@@ -65,6 +65,9 @@ public:
                const wxMBConv& conv = wxConvAuto());
    bool GetEditClipsCanMove();
 
+   // Does nothing if read-only, so that changes stay in memory
+   bool Flush(bool bCurrentOnly = false) override;
+
    // Set and Get values of the version major/minor/micro keys in audacity.cfg when Audacity first opens
    void SetVersionKeysInit( int major, int minor, int micro)
    {
@@ -84,6 +87,10 @@ public:
    int mVersionMajorKeyInit{};
    int mVersionMinorKeyInit{};
    int mVersionMicroKeyInit{};
+
+   // Set by InitPreferences() for unattended processing, which must leave
+   // the file, shared with other copies of Audacity, as it was
+   bool mReadOnly{ false };
 };
 
 /// Packages a table of user-visible choices each with an internal code string,
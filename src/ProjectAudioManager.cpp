@@ -16,6 +16,7 @@ Paul Licameli split from ProjectManager.cpp
 #include <wx/frame.h>
 #include <wx/statusbr.h>
 
+#include "AudacityException.h"
 #include "AudioIO.h"
 #include "AutoRecovery.h"
 #include "CommonCommandFlags.h"
@@ -28,9 +29,11 @@ Paul Licameli split from ProjectManager.cpp
 #include "ProjectHistory.h"
 #include "ProjectSettings.h"
 #include "ProjectStatus.h"
+#include "Sequence.h"
 #include "TimeTrack.h"
 #include "TrackPanelAx.h"
 #include "ViewInfo.h"
+#include "WaveClip.h"
 #include "WaveTrack.h"
 #include "toolbars/ToolManager.h"
 #include "prefs/TracksPrefs.h"
@@ -864,9 +867,18 @@ You are saving directly to a slow external storage device\n\
          // Reset timer record
          ResetTimerRecordCancelled();
       }
-      else
+      else {
+         // Recording deferred the writing of its blocks, and did not wait
+         // to compress them; do that now, before the writing below
+         for (auto wt : tracks.Any< WaveTrack >())
+            for (auto clip : wt->GetAllClips())
+               GuardedCall( [&] {
+                  clip->GetSequence()->CompressDeferredBlocks();
+               } );
+
          // Add to history
          history.PushState(_("Recorded Audio"), _("Record"));
+      }
    }
 
    // Write all cached files to disk, if any
@@ -881,16 +893,9 @@ void ProjectAudioManager::OnAudioIONewBlockFiles(
 {
    auto &project = mProject;
    auto &projectFileIO = ProjectFileIO::Get( project );
-   // New blockfiles have been created, so add them to the auto-save file
-   const auto &autoSaveFileName = projectFileIO.GetAutoSaveFileName();
-   if ( !autoSaveFileName.empty() )
-   {
-      wxFFile f{ autoSaveFileName, wxT("ab") };
-      if (!f.IsOpened())
-         return; // Keep recording going, there's not much we can do here
-      blockFileLog.Append(f);
-      f.Close();
-   }
+   // New blockfiles have been created, so add them to the auto-save file;
+   // this is called from the audio thread, so only queue them for writing
+   projectFileIO.AppendToAutoSave( blockFileLog );
 }
 
 void ProjectAudioManager::OnCommitRecording()
@@ -10,15 +10,19 @@ Paul Licameli split from AudacityProject.cpp
 
 #include "ProjectFileIO.h"
 
+#include <algorithm>
+
 #include <wx/frame.h>
 
 #include "AutoRecovery.h"
+#include "AutoSaveJournal.h"
 #include "DirManager.h"
 #include "FileNames.h"
 #include "Project.h"
 #include "ProjectFileIORegistry.h"
 #include "ProjectSettings.h"
 #include "Tags.h"
+#include "UndoManager.h"
 #include "ViewInfo.h"
 #include "WaveTrack.h"
 #include "widgets/AudacityMessageBox.h"
@@ -510,11 +514,17 @@ void ProjectFileIO::WriteXML(
          }
          else {
             pWaveTrack->SetAutoSaveIdent(mAutoSaving ? ++ndx : 0);
-            pWaveTrack->WriteXML(xmlFile);
+            if (mpJournalRecord)
+               WriteJournaledTrack(*pWaveTrack, pWaveTrack->GetAutoSaveIdent());
+            else
+               pWaveTrack->WriteXML(xmlFile);
          }
       },
       [&](Track *t) {
-         t->WriteXML(xmlFile);
+         if (mpJournalRecord)
+            WriteJournaledTrack(*t, 0);
+         else
+            t->WriteXML(xmlFile);
       }
    );
 
@@ -561,68 +571,178 @@ private:
    T mValExit;
 };
 
+void ProjectFileIO::WriteJournaledTrack(const Track &track, int ident)
+{
+   auto &record = *mpJournalRecord;
+   const auto position = mJournalPosition++;
+
+   // Find the copy of the track in the current undo state.  Copies keep the
+   // ids of the tracks, but undo makes tracks with new ids, and then the copy
+   // in the same position is the likely one.
+   std::shared_ptr<const Track> pCopy;
+   const auto &copies = mUndoCopies;
+   const auto id = track.GetId();
+   if (position < copies.size() && copies[position]->GetId() == id)
+      pCopy = copies[position];
+   else {
+      const auto end = copies.end();
+      const auto iter = std::find_if(copies.begin(), end,
+         [&](const std::shared_ptr<const Track> &pTrack){
+            return pTrack->GetId() == id; });
+      if (iter != end)
+         pCopy = *iter;
+      else if (position < copies.size())
+         pCopy = copies[position];
+   }
+   if (pCopy && !track.SameStateAs(*pCopy))
+      pCopy.reset();
+
+   if (pCopy) {
+      // Copies never change, so if the last record wrote the track from the
+      // same copy, only refer to that
+      const auto sameCopy = [&](const JournalFragment &fragment){
+         return fragment.ident == ident &&
+            !fragment.copy.owner_before(pCopy) &&
+            !pCopy.owner_before(fragment.copy);
+      };
+      auto end = mFragments.end();
+      auto iter = position < mFragments.size() &&
+         sameCopy(mFragments[position])
+            ? mFragments.begin() + position
+            : std::find_if(mFragments.begin(), end, sameCopy);
+      if (iter != end) {
+         record.WriteFragmentRef(iter->key);
+         mNewFragments.push_back(*iter);
+         return;
+      }
+
+      AutoSaveFile fragment;
+      track.WriteXML(fragment);
+      const auto key = mNextFragmentKey++;
+      record.WriteFragment(key, fragment);
+      mNewFragments.push_back({ pCopy, key, ident });
+   }
+   else
+      // Not yet in the undo history, so it may still change, such as the
+      // tracks of a recording
+      track.WriteXML(record);
+}
+
 void ProjectFileIO::AutoSave()
 {
    auto &project = mProject;
    auto &window = GetProjectFrame( project );
    //    SonifyBeginAutoSave(); // part of RBD's r10680 stuff now backed out
 
-   // To minimize the possibility of race conditions, we first write to a
-   // file with the extension ".tmp", then rename the file to .autosave
-   wxString projName;
+   if (mJournal && mJournal->Failed())
+   {
+      AudacityMessageBox(
+         wxString::Format( _("Could not create autosave file: %s"),
+            mJournal->GetFileName() ),
+         _("Error"), wxICON_STOP, &window);
+      // Start over with a NEW file, and delete this one when that is written
+      std::lock_guard<std::mutex> lock{ mJournalMutex };
+      mJournal.reset();
+   }
 
-   auto fileName = project.GetFileName();
-   if (fileName.empty())
-      projName = wxT("New Project");
-   else
-      projName = wxFileName{ fileName }.GetName();
+   // The journal writes the first record to a file with the extension
+   // ".tmp", then renames the file to .autosave; later records, and
+   // recording logs, are appended
+   std::unique_ptr<AutoSaveJournal> pNewJournal;
+   if (!mJournal)
+   {
+      wxString projName;
+
+      auto fileName = project.GetFileName();
+      if (fileName.empty())
+         projName = wxT("New Project");
+      else
+         projName = wxFileName{ fileName }.GetName();
+
+      wxString fn = wxFileName(FileNames::AutoSaveDir(),
+         projName + wxString(wxT(" - ")) + CreateUniqueName()).GetFullPath();
+
+      pNewJournal =
+         std::make_unique<AutoSaveJournal>( fn + wxT(".autosave") );
+      mFragments.clear();
+      mNextFragmentKey = 0;
+   }
 
-   wxString fn = wxFileName(FileNames::AutoSaveDir(),
-      projName + wxString(wxT(" - ")) + CreateUniqueName()).GetFullPath();
+   // Each record replaces the whole project, but tracks that are unchanged
+   // since the last one are only references to what it wrote
+   if (const auto pCopies = UndoManager::Get( project ).GetCurrentTracks())
+      mUndoCopies = *pCopies;
+   mNewFragments.clear();
+   mJournalPosition = 0;
 
-   // PRL:  I found a try-catch and rewrote it,
-   // but this guard is unnecessary because AutoSaveFile does not throw
+   AutoSaveFile record;
    bool success = GuardedCall< bool >( [&]
    {
       VarSetter<bool> setter(&mAutoSaving, true, false);
+      VarSetter<AutoSaveFile*> recordSetter(&mpJournalRecord, &record, nullptr);
 
-      AutoSaveFile buffer;
-      WriteXMLHeader( buffer );
-      WriteXML( buffer, nullptr );
-
-      wxFFile saveFile;
-      saveFile.Open(fn + wxT(".tmp"), wxT("wb"));
-      return buffer.Write(saveFile);
+      WriteXMLHeader( record );
+      WriteXML( record, nullptr );
+      return true;
    } );
 
+   mUndoCopies.clear();
    if (!success)
       return;
 
-   // Now that we have a NEW auto-save file, DELETE the old one
-   DeleteCurrentAutoSaveFile();
+   if (pNewJournal)
+   {
+      pNewJournal->AppendRecord( record );
+      if (!pNewJournal->Flush())
+      {
+         AudacityMessageBox(
+            wxString::Format( _("Could not create autosave file: %s"),
+               pNewJournal->GetFileName() ),
+            _("Error"), wxICON_STOP, &window);
+         return;
+      }
 
-   if (!mAutoSaveFileName.empty())
-      return; // could not remove auto-save file
+      // Now that we have a NEW auto-save file, DELETE the old one
+      DeleteCurrentAutoSaveFile();
 
-   if (!wxRenameFile(fn + wxT(".tmp"), fn + wxT(".autosave")))
-   {
-      AudacityMessageBox(
-         wxString::Format( _("Could not create autosave file: %s"),
-            fn + wxT(".autosave") ),
-         _("Error"), wxICON_STOP, &window);
-      return;
+      if (!mAutoSaveFileName.empty())
+         return; // could not remove auto-save file
+
+      mAutoSaveFileName = pNewJournal->GetFileName();
+      std::lock_guard<std::mutex> lock{ mJournalMutex };
+      mJournal = std::move( pNewJournal );
    }
+   else
+      // The journal writes in the background; a failure is reported the next
+      // time
+      mJournal->AppendRecord( record );
 
-   mAutoSaveFileName += fn + wxT(".autosave");
+   mFragments.swap( mNewFragments );
+   mNewFragments.clear();
    // no-op cruft that's not #ifdefed for NoteTrack
    // See above for further comments.
    //   SonifyEndAutoSave();
 }
 
+void ProjectFileIO::AppendToAutoSave( const AutoSaveFile &data )
+{
+   std::lock_guard<std::mutex> lock{ mJournalMutex };
+   if (mJournal)
+      mJournal->AppendContinuation( data );
+}
+
 void ProjectFileIO::DeleteCurrentAutoSaveFile()
 {
    auto &project = mProject;
    auto &window = GetProjectFrame( project );
+
+   // Finish all writes to the file first
+   {
+      std::lock_guard<std::mutex> lock{ mJournalMutex };
+      mJournal.reset();
+   }
+   mFragments.clear();
+
    if (!mAutoSaveFileName.empty())
    {
       if (wxFileExists(mAutoSaveFileName))
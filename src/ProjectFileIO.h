@@ -11,11 +11,18 @@ Paul Licameli split from AudacityProject.h
 #ifndef __AUDACITY_PROJECT_FILE_IO__
 #define __AUDACITY_PROJECT_FILE_IO__
 
+#include <memory>
+#include <mutex>
+#include <vector>
+
 #include "ClientData.h" // to inherit
 #include "Prefs.h" // to inherit
 #include "xml/XMLTagHandler.h" // to inherit
 
 class AudacityProject;
+class AutoSaveFile;
+class AutoSaveJournal;
+class Track;
 
 ///\brief Object associated with a project that manages reading and writing
 /// of Audacity project file formats, and autosave
@@ -48,6 +55,9 @@ public:
    
    void AutoSave();
    void DeleteCurrentAutoSaveFile();
+   // Add data, such as recording logs, to the end of the autosave file, if
+   // there is one.  May be called from other threads.
+   void AppendToAutoSave( const AutoSaveFile &data );
 
    bool IsRecovered() const { return mIsRecovered; }
    void SetIsRecovered( bool value ) { mIsRecovered = value; }
@@ -69,6 +79,10 @@ private:
 
    void UpdatePrefs() override;
 
+   // While autosaving, writes a track into the journal record, or only a
+   // reference to what the last record wrote, if the track is unchanged
+   void WriteJournaledTrack( const Track &track, int ident );
+
    // non-static data members
    AudacityProject &mProject;
 
@@ -78,6 +92,29 @@ private:
    // Are we currently auto-saving or not?
    bool mAutoSaving{ false };
 
+   // Writes the records of the auto-save file; null if there is none
+   std::unique_ptr<AutoSaveJournal> mJournal;
+   // Guards mJournal from other threads that append to it
+   std::mutex mJournalMutex;
+
+   // A track, written to the journal as a fragment that later records may
+   // refer to, as long as its copy in the undo history stays the current
+   // state of the track
+   struct JournalFragment {
+      std::weak_ptr<const Track> copy;
+      int key;
+      int ident;
+   };
+   // The fragments that the last record used
+   std::vector<JournalFragment> mFragments;
+   int mNextFragmentKey{ 0 };
+
+   // Non-null only while auto-saving a journal record
+   AutoSaveFile *mpJournalRecord{ nullptr };
+   std::vector<std::shared_ptr<const Track>> mUndoCopies;
+   std::vector<JournalFragment> mNewFragments;
+   size_t mJournalPosition{ 0 };
+
    // Has this project been recovered from an auto-saved version
    bool mIsRecovered{ false };
 
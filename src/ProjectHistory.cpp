@@ -138,15 +138,28 @@ void ProjectHistory::PopState(const UndoState &state)
    // Restore tags
    Tags::Set( project, state.tags );
 
-   TrackList *const tracks = state.tracks.get();
+   // Keep the project's tracks that already agree with the state, which
+   // are likely in the same positions, and duplicate the others
+   std::vector< std::shared_ptr< Track > > current;
+   for (auto t : dstTracks)
+      current.push_back( t->SharedPointer() );
+
+   ListOfTracks restored;
+   for (const auto &t : state.tracks) {
+      const auto ii = restored.size();
+      if ( ii < current.size() && current[ii]->SameStateAs( *t ) )
+         restored.push_back( current[ii] );
+      else
+         restored.push_back( t->Duplicate() );
+   }
 
    dstTracks.Clear();
    bool odUsed = false;
    std::unique_ptr<ODComputeSummaryTask> computeTask;
 
-   for (auto t : tracks->Any())
+   for (const auto &t : restored)
    {
-      auto copyTrack = dstTracks.Add(t->Duplicate());
+      auto copyTrack = dstTracks.Add(t);
 
       //add the track to OD if the manager exists.  later we might do a more rigorous check...
       copyTrack->TypeSwitch( [&](WaveTrack *wt) {
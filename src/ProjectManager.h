@@ -39,7 +39,8 @@ public:
    ~ProjectManager() override;
 
    // This is the factory for projects:
-   static AudacityProject *New();
+   // The window is not shown for unattended batch processing
+   static AudacityProject *New( bool show = true );
 
    // The function that imports files can act as a factory too, and for that
    // reason remains in this class, not in ProjectFileManager
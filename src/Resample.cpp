@@ -16,9 +16,11 @@
 
       libsoxr, written by Rob Sykes. LGPL.
 
-   Since Audacity always does resampling on mono streams that are
-   contiguous in memory, this class doesn't support multiple channels
-   or some of the other optional features of some of these resamplers.
+   Channels are in separate buffers that are contiguous in memory.  One
+   instance may resample several channels together, which costs less than
+   an instance for each, but this class doesn't support interleaved
+   channels or some of the other optional features of some of these
+   resamplers.
 
 *//*******************************************************************/
 
@@ -28,9 +30,14 @@
 #include "Internat.h"
 #include "../include/audacity/ComponentInterface.h"
 
+#include <algorithm>
+
 #include <soxr.h>
 
-Resample::Resample(const bool useBestMethod, const double dMinFactor, const double dMaxFactor)
+Resample::Resample(const bool useBestMethod, const double dMinFactor, const double dMaxFactor,
+                   const unsigned numChannels)
+   : mNumChannels{ std::max(1u, numChannels) }
+   , mLastFactor{ 0 }
 {
    this->SetMethod(useBestMethod);
    soxr_quality_spec_t q_spec;
@@ -44,7 +51,9 @@ Resample::Resample(const bool useBestMethod, const double dMinFactor, const doub
       mbWantConstRateResampling = false; // variable rate resampling
       q_spec = soxr_quality_spec(SOXR_HQ, SOXR_VR);
    }
-   mHandle.reset(soxr_create(1, dMinFactor, 1, 0, 0, &q_spec, 0));
+   // Separate buffers for the channels, even when there is only one
+   soxr_io_spec_t io_spec = soxr_io_spec(SOXR_FLOAT32_S, SOXR_FLOAT32_S);
+   mHandle.reset(soxr_create(1, dMinFactor, mNumChannels, 0, &io_spec, &q_spec, 0));
 }
 
 Resample::~Resample()
@@ -110,21 +119,42 @@ std::pair<size_t, size_t>
                         float  *outBuffer,
                         size_t  outBufferLen)
 {
+   wxASSERT(mNumChannels == 1);
+   return Process(factor, &inBuffer, inBufferLen, lastFlag,
+                  &outBuffer, outBufferLen);
+}
+
+std::pair<size_t, size_t>
+      Resample::Process(double  factor,
+                        float  *const *inBuffers,
+                        size_t  inBufferLen,
+                        bool    lastFlag,
+                        float  *const *outBuffers,
+                        size_t  outBufferLen)
+{
+   // soxr takes the array of buffers as non-const, but does not change it
+   const auto outs = const_cast<float **>(outBuffers);
    size_t idone, odone;
    if (mbWantConstRateResampling)
    {
       soxr_process(mHandle.get(),
-            inBuffer , (lastFlag? ~inBufferLen : inBufferLen), &idone,
-            outBuffer,                           outBufferLen, &odone);
+            inBuffers , (lastFlag? ~inBufferLen : inBufferLen), &idone,
+            outs,                                 outBufferLen, &odone);
    }
    else
    {
-      soxr_set_io_ratio(mHandle.get(), 1/factor, 0);
+      // The ratio is often the same for many calls, as when there is a
+      // time track without changes of speed
+      if (factor != mLastFactor)
+      {
+         soxr_set_io_ratio(mHandle.get(), 1/factor, 0);
+         mLastFactor = factor;
+      }
 
       inBufferLen = lastFlag? ~inBufferLen : inBufferLen;
       soxr_process(mHandle.get(),
-            inBuffer , inBufferLen , &idone,
-            outBuffer, outBufferLen, &odone);
+            inBuffers , inBufferLen , &idone,
+            outs      , outBufferLen, &odone);
    }
    return { idone, odone };
 }
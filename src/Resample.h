@@ -38,7 +38,10 @@ class Resample final
    /// the fast method.
    // dMinFactor and dMaxFactor specify the range of factors for variable-rate resampling.
    // For constant-rate, pass the same value for both.
-   Resample(const bool useBestMethod, const double dMinFactor, const double dMaxFactor);
+   // numChannels is the number of channels resampled together by each call
+   // of Process; they are in separate buffers.
+   Resample(const bool useBestMethod, const double dMinFactor, const double dMaxFactor,
+            const unsigned numChannels = 1);
    ~Resample();
 
    static EnumSetting FastMethodSetting;
@@ -74,6 +77,26 @@ class Resample final
                         float  *outBuffer,
                         size_t  outBufferLen);
 
+   /** @brief As above, for all channels at once, which is cheaper than
+    * one Resample for each.
+    *
+    @param inBuffers One buffer of input samples for each channel, all of
+    length inBufferLen
+    @param outBuffers One buffer for output samples for each channel, all of
+    length outBufferLen
+    @return Number of input samples consumed, and number of output samples
+    created by this call, for each channel
+   */
+   std::pair<size_t, size_t>
+                Process(double  factor,
+                        float  *const *inBuffers,
+                        size_t  inBufferLen,
+                        bool    lastFlag,
+                        float  *const *outBuffers,
+                        size_t  outBufferLen);
+
+   unsigned GetNumChannels() const { return mNumChannels; }
+
  protected:
    void SetMethod(const bool useBestMethod);
 
@@ -81,6 +104,8 @@ class Resample final
    int   mMethod; // resampler-specific enum for resampling method
    soxrHandle mHandle; // constant-rate or variable-rate resampler (XOR per instance)
    bool mbWantConstRateResampling;
+   unsigned mNumChannels;
+   double mLastFactor; // of variable-rate resampling, to set it only on change
 };
 
 #endif // __AUDACITY_RESAMPLE_H__
@@ -22,6 +22,18 @@
   AvailForPut and AvailForGet may underestimate but will never
   overestimate.
 
+*//****************************************************************//**
+
+\class PlanarRingBuffer
+\brief Holds streamed audio samples of several channels that advance
+  together.
+
+  The same single reader, single writer protocol as RingBuffer, but with one
+  start and one end position for all channels.  The writer may fill a
+  region of all the channels, directly or by copying, before committing it
+  at once; likewise the reader may consume a region in place before
+  releasing it.
+
 *//*******************************************************************/
 
 
@@ -194,3 +206,131 @@ size_t RingBuffer::Discard(size_t samplesToDiscard)
 
    return samplesToDiscard;
 }
+
+PlanarRingBuffer::PlanarRingBuffer(
+   sampleFormat format, size_t size, size_t nChannels)
+   : mBufferSize{ std::max<size_t>(size, 64) }
+   , mChannels{ nChannels }
+   , mStride{
+      ( ( mBufferSize * SAMPLE_SIZE(format) + CacheLine - 1 )
+         / CacheLine * CacheLine ) / SAMPLE_SIZE(format) }
+   , mFormat{ format }
+   , mBuffer{ mStride * std::max<size_t>(nChannels, 1), mFormat }
+{
+}
+
+PlanarRingBuffer::~PlanarRingBuffer()
+{
+}
+
+size_t PlanarRingBuffer::Filled( size_t start, size_t end )
+{
+   return (end + mBufferSize - start) % mBufferSize;
+}
+
+size_t PlanarRingBuffer::Free( size_t start, size_t end )
+{
+   return std::max<size_t>(mBufferSize - Filled( start, end ), 4) - 4;
+}
+
+auto PlanarRingBuffer::MakeRegion( size_t start, size_t samples ) -> Region
+{
+   const auto first = std::min( samples, mBufferSize - start );
+   return { start, first, samples - first };
+}
+
+//
+// For the writer only:
+// Memory ordering is as for RingBuffer
+//
+
+size_t PlanarRingBuffer::AvailForPut()
+{
+   auto start = mStart.load( std::memory_order_relaxed );
+   auto end = mEnd.load( std::memory_order_relaxed );
+   return Free( start, end );
+}
+
+auto PlanarRingBuffer::GetWriteRegion(size_t samples) -> Region
+{
+   auto start = mStart.load( std::memory_order_acquire );
+   auto end = mEnd.load( std::memory_order_relaxed );
+   return MakeRegion( end, std::min( samples, Free( start, end ) ) );
+}
+
+void PlanarRingBuffer::WriteChannel(size_t channel, const Region &region,
+   samplePtr buffer, sampleFormat format, size_t samples)
+{
+   const auto dest = GetChannel( channel );
+   const auto size = SAMPLE_SIZE(mFormat);
+   samples = std::min( samples, region.Length() );
+
+   auto block = std::min( samples, region.first );
+   CopySamples( buffer, format, dest + region.start * size, mFormat, block );
+   ClearSamples( dest, mFormat, region.start + block, region.first - block );
+
+   buffer += block * SAMPLE_SIZE(format);
+   block = samples - block;
+   CopySamples( buffer, format, dest, mFormat, block );
+   ClearSamples( dest, mFormat, block, region.second - block );
+}
+
+void PlanarRingBuffer::CommitWrite(size_t samples)
+{
+   auto end = mEnd.load( std::memory_order_relaxed );
+
+   // Atomically update the end pointer with release, so the nonatomic writes
+   // just done to all channels of the buffer don't get reordered after
+   mEnd.store( (end + samples) % mBufferSize, std::memory_order_release );
+}
+
+//
+// For the reader only:
+//
+
+size_t PlanarRingBuffer::AvailForGet()
+{
+   auto end = mEnd.load( std::memory_order_relaxed ); // get away with it here
+   auto start = mStart.load( std::memory_order_relaxed );
+   return Filled( start, end );
+}
+
+auto PlanarRingBuffer::GetReadRegion(size_t samples) -> Region
+{
+   // Must match the writer's release with acquire for well defined reads of
+   // the buffer
+   auto end = mEnd.load( std::memory_order_acquire );
+   auto start = mStart.load( std::memory_order_relaxed );
+   return MakeRegion( start, std::min( samples, Filled( start, end ) ) );
+}
+
+void PlanarRingBuffer::ReadChannel(size_t channel, const Region &region,
+   samplePtr buffer, sampleFormat format)
+{
+   const auto src = GetChannel( channel );
+   CopySamples( src + region.start * SAMPLE_SIZE(mFormat), mFormat,
+      buffer, format, region.first );
+   CopySamples( src, mFormat,
+      buffer + region.first * SAMPLE_SIZE(format), format, region.second );
+}
+
+void PlanarRingBuffer::Release(size_t samples)
+{
+   auto start = mStart.load( std::memory_order_relaxed );
+
+   // Communicate to writer that we have consumed some data,
+   // with nonrelaxed ordering
+   mStart.store( (start + samples) % mBufferSize, std::memory_order_release );
+}
+
+size_t PlanarRingBuffer::Discard(size_t samplesToDiscard)
+{
+   auto end = mEnd.load( std::memory_order_relaxed ); // get away with it here
+   auto start = mStart.load( std::memory_order_relaxed );
+   samplesToDiscard = std::min( samplesToDiscard, Filled( start, end ) );
+
+   mStart.store((start + samplesToDiscard) % mBufferSize,
+                std::memory_order_relaxed);
+
+   return samplesToDiscard;
+}
@@ -58,4 +58,84 @@ class RingBuffer {
    SampleBuffer  mBuffer;
 };
 
+// A ring buffer for a group of channels that always advance together, such
+// as all the playback tracks, or all the recorded channels.  Samples of each
+// channel are contiguous, but one pair of indices serves all the channels,
+// so a whole frame group is published to the reader with one atomic update.
+// Besides copying Put and Get, it allows the writer to fill the storage in
+// place, and the reader to consume it in place, without conversion of
+// format.
+class PlanarRingBuffer {
+ public:
+   PlanarRingBuffer(sampleFormat format, size_t size, size_t nChannels);
+   ~PlanarRingBuffer();
+
+   // A span of positions in every channel, which may wrap around the end of
+   // the storage
+   struct Region {
+      size_t start;  // Position of the first segment
+      size_t first;  // Length of the first segment
+      size_t second; // Length of the second segment, which starts at zero
+
+      size_t Length() const { return first + second; }
+   };
+
+   sampleFormat GetFormat() const { return mFormat; }
+   size_t GetChannels() const { return mChannels; }
+
+   // Start of storage for one channel; the regions index into it
+   samplePtr GetChannel(size_t channel) const
+   { return mBuffer.ptr() + channel * mStride * SAMPLE_SIZE(mFormat); }
+
+   //
+   // For the writer only:
+   //
+
+   size_t AvailForPut();
+
+   // Free space for at most the given number of samples, to be filled in
+   // all channels and then made visible to the reader by CommitWrite()
+   Region GetWriteRegion(size_t samples);
+   // Copy samples into one channel of a region not yet committed,
+   // and zeroes after them to fill the region
+   void WriteChannel(size_t channel, const Region &region,
+                     samplePtr buffer, sampleFormat format, size_t samples);
+   void CommitWrite(size_t samples);
+
+   //
+   // For the reader only:
+   //
+
+   size_t AvailForGet();
+
+   // Filled space for at most the given number of samples, that remains
+   // valid until Release()
+   Region GetReadRegion(size_t samples);
+   // Copy all samples of one channel of a region
+   void ReadChannel(size_t channel, const Region &region,
+                    samplePtr buffer, sampleFormat format);
+   void Release(size_t samples);
+
+   size_t Discard(size_t samples);
+
+ private:
+   size_t Filled( size_t start, size_t end );
+   size_t Free( size_t start, size_t end );
+   Region MakeRegion( size_t start, size_t samples );
+
+   enum : size_t { CacheLine = 64 };
+
+   alignas(CacheLine) std::atomic<size_t> mStart { 0 };
+   alignas(CacheLine) std::atomic<size_t> mEnd{ 0 };
+
+   const size_t  mBufferSize;
+   const size_t  mChannels;
+   // Samples between the starts of channels, so that no two channels share
+   // a cache line
+   const size_t  mStride;
+
+   sampleFormat  mFormat;
+   SampleBuffer  mBuffer;
+};
+
 #endif /*  __AUDACITY_RING_BUFFER__ */
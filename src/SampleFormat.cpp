@@ -48,7 +48,8 @@
 
 static DitherType gLowQualityDither = DitherType::none;
 static DitherType gHighQualityDither = DitherType::none;
-static Dither gDitherAlgorithm;
+// Each thread dithers with its own state
+static thread_local Dither gDitherAlgorithm;
 
 void InitDitherers()
 {
@@ -121,3 +122,34 @@ void CopySamplesNoDither(samplePtr src, sampleFormat srcFormat,
       DitherType::none,
       src, srcFormat, dst, dstFormat, len, srcStride, dstStride);
 }
+
+void SampleStatistics::Accumulate(const float *buffer, size_t len)
+{
+   float lo = min, hi = max;
+   double s = 0, sq = 0;
+   size_t nClipped = 0;
+   for (size_t i = 0; i < len; i++) {
+      const float value = buffer[i];
+      lo = std::min(lo, value);
+      hi = std::max(hi, value);
+      s += value;
+      sq += double(value) * value;
+      if (fabs(value) >= MAX_AUDIO)
+         ++nClipped;
+   }
+   min = lo, max = hi;
+   sum += s;
+   sumOfSquares += sq;
+   count += len;
+   clipped += nClipped;
+}
+
+void SampleStatistics::Merge(const SampleStatistics &other)
+{
+   min = std::min(min, other.min);
+   max = std::max(max, other.max);
+   sum += other.sum;
+   sumOfSquares += other.sumOfSquares;
+   count += other.count;
+   clipped += other.clipped;
+}
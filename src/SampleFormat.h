@@ -15,6 +15,9 @@
 
 #include "MemoryX.h"
 #include <wx/defs.h>
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
 
 #include "audacity/Types.h"
 
@@ -142,6 +145,35 @@ void      ClearSamples(samplePtr buffer, sampleFormat format,
 void      ReverseSamples(samplePtr buffer, sampleFormat format,
                          int start, int len);
 
+//
+// Statistics of samples
+//
+
+/// \brief Extremes, sums and clipping of some samples, which combine
+/// without looking at the samples again.
+///
+/// A sample clips when its magnitude is at least MAX_AUDIO.
+struct SampleStatistics
+{
+   float min{ FLT_MAX };
+   float max{ -FLT_MAX };
+   double sum{ 0 };
+   double sumOfSquares{ 0 };
+   sampleCount count{ 0 };
+   sampleCount clipped{ 0 };
+
+   void Accumulate(const float *buffer, size_t len);
+   void Merge(const SampleStatistics &other);
+
+   // These give 0 for no samples
+   float GetPeak() const
+   { return count > 0 ? std::max(-min, max) : 0.f; }
+   double GetRMS() const
+   { return count > 0 ? std::sqrt(sumOfSquares / count.as_double()) : 0.0; }
+   double GetDCOffset() const
+   { return count > 0 ? sum / count.as_double() : 0.0; }
+};
+
 //
 // This must be called on startup and everytime NEW ditherers
 // are set in preferences.
@@ -0,0 +1,575 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  SampleFormatKernels.cpp
+
+*******************************************************************//**
+
+\file SampleFormatKernels.cpp
+\brief SSE2 and AVX2 loops for converting and dithering samples, chosen
+at run time.
+
+  The loops agree with the macros in Dither.cpp: float is clipped to
+  [-1, 1] before it is promoted, values are rounded to nearest, as lrintf()
+  does, and clipped to the range of the destination.  Conversions that need
+  no dither give exactly the same results.
+
+  Compilers build the AVX2 loops without any special option, by a target
+  attribute on each function, and they are used only when the processor
+  and the operating system support them.
+
+*//*******************************************************************/
+
+#include "Audacity.h"
+#include "SampleFormatKernels.h"
+
+#include <algorithm>
+#include <atomic>
+
+#include "Dither.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+   #define SAMPLE_FORMAT_KERNELS_X86
+   #include <immintrin.h>
+   #if defined(_MSC_VER)
+      #include <intrin.h>
+      #define TARGET_SSE2
+      #define TARGET_AVX2
+   #else
+      #define TARGET_SSE2 __attribute__((target("sse2")))
+      #define TARGET_AVX2 __attribute__((target("avx2")))
+   #endif
+#endif
+
+namespace SampleFormatKernels {
+
+NoiseState::NoiseState()
+   : triangle{ 0 }
+{
+   // Any seeds will do, but none may be zero
+   for ( size_t ii = 0; ii < nLanes; ++ii )
+      lanes[ii] = 0x9E3779B9u * ( ii + 1 );
+}
+
+namespace {
+
+InstructionSet Detect()
+{
+#ifdef SAMPLE_FORMAT_KERNELS_X86
+   bool sse2 = false, avx2 = false;
+#if defined(_MSC_VER)
+   int info[4];
+   __cpuid( info, 0 );
+   const int nIds = info[0];
+   __cpuid( info, 1 );
+   sse2 = ( info[3] & ( 1 << 26 ) ) != 0;
+   const bool osxsave = ( info[2] & ( 1 << 27 ) ) != 0;
+   const bool avx = ( info[2] & ( 1 << 28 ) ) != 0;
+   // The operating system must also save the ymm registers
+   if ( nIds >= 7 && osxsave && avx && ( _xgetbv( 0 ) & 6 ) == 6 ) {
+      __cpuidex( info, 7, 0 );
+      avx2 = ( info[1] & ( 1 << 5 ) ) != 0;
+   }
+#else
+   __builtin_cpu_init();
+   sse2 = __builtin_cpu_supports( "sse2" );
+   avx2 = __builtin_cpu_supports( "avx2" );
+#endif
+   if ( avx2 )
+      return InstructionSet::AVX2;
+   if ( sse2 )
+      return InstructionSet::SSE2;
+#endif
+   return InstructionSet::Scalar;
+}
+
+std::atomic< InstructionSet > &Current()
+{
+   static std::atomic< InstructionSet > current{ GetBest() };
+   return current;
+}
+
+#ifdef SAMPLE_FORMAT_KERNELS_X86
+
+////////////////////////////////////////////////////////////////////////
+// SSE2, four samples to a vector
+
+namespace SSE2 {
+
+// Uniform noise in [-0.5, 0.5) from the xorshift generators of four lanes
+TARGET_SSE2 inline __m128 Noise( __m128i &s )
+{
+   s = _mm_xor_si128( s, _mm_slli_epi32( s, 13 ) );
+   s = _mm_xor_si128( s, _mm_srli_epi32( s, 17 ) );
+   s = _mm_xor_si128( s, _mm_slli_epi32( s, 5 ) );
+   const auto bits = _mm_or_si128(
+      _mm_srli_epi32( s, 9 ), _mm_set1_epi32( 0x3f800000 ) );
+   return _mm_sub_ps( _mm_castsi128_ps( bits ), _mm_set1_ps( 1.5f ) );
+}
+
+// Does for vectors what Dither's methods do for single samples
+template< DitherType type > struct Ditherer {
+   __m128i s;
+   __m128 last;
+
+   TARGET_SSE2 explicit Ditherer( const NoiseState &state )
+      : s{ _mm_loadu_si128( reinterpret_cast< const __m128i* >( state.lanes ) ) }
+      , last{ _mm_set1_ps( state.triangle ) }
+   {}
+
+   TARGET_SSE2 void Save( NoiseState &state ) const
+   {
+      _mm_storeu_si128( reinterpret_cast< __m128i* >( state.lanes ), s );
+      state.triangle = _mm_cvtss_f32( last );
+   }
+
+   TARGET_SSE2 __m128 operator () ( __m128 x )
+   {
+      switch ( type ) {
+      case DitherType::rectangle:
+         return _mm_sub_ps( x, Noise( s ) );
+      case DitherType::triangle: {
+         // High pass: subtract from each noise value the one before it
+         const auto r = Noise( s );
+         const auto prev = _mm_move_ss( _mm_castsi128_ps(
+            _mm_slli_si128( _mm_castps_si128( r ), 4 ) ), last );
+         last = _mm_shuffle_ps( r, r, _MM_SHUFFLE( 3, 3, 3, 3 ) );
+         return _mm_sub_ps( _mm_add_ps( x, r ), prev );
+      }
+      default:
+         return x;
+      }
+   }
+};
+
+struct FromFloat {
+   using Sample = float;
+   TARGET_SSE2 static __m128 Load( const float *p )
+   {
+      // Clip; the order of operands makes NaN into -1, as lrintf() makes
+      // it the least integer
+      const auto x = _mm_min_ps( _mm_set1_ps( 1.0f ), _mm_loadu_ps( p ) );
+      return _mm_max_ps( x, _mm_set1_ps( -1.0f ) );
+   }
+};
+
+struct FromInt24 {
+   using Sample = int;
+   TARGET_SSE2 static __m128 Load( const int *p )
+   {
+      const auto x =
+         _mm_cvtepi32_ps( _mm_loadu_si128( reinterpret_cast< const __m128i* >( p ) ) );
+      return _mm_mul_ps( x, _mm_set1_ps( 1.0f / ( 1 << 23 ) ) );
+   }
+};
+
+struct ToInt16 {
+   using Sample = short;
+   static float Scale() { return float( 1 << 15 ); }
+   TARGET_SSE2 static void Store( short *p, __m128 a, __m128 b )
+   {
+      // Packing saturates
+      _mm_storeu_si128( reinterpret_cast< __m128i* >( p ),
+         _mm_packs_epi32( _mm_cvtps_epi32( a ), _mm_cvtps_epi32( b ) ) );
+   }
+};
+
+struct ToInt24 {
+   using Sample = int;
+   static float Scale() { return float( 1 << 23 ); }
+   TARGET_SSE2 static __m128i Round( __m128 x )
+   {
+      // Clipping before rounding gives the same as clipping after
+      x = _mm_min_ps( x, _mm_set1_ps( 8388607.0f ) );
+      x = _mm_max_ps( x, _mm_set1_ps( -8388608.0f ) );
+      return _mm_cvtps_epi32( x );
+   }
+   TARGET_SSE2 static void Store( int *p, __m128 a, __m128 b )
+   {
+      _mm_storeu_si128( reinterpret_cast< __m128i* >( p ), Round( a ) );
+      _mm_storeu_si128( reinterpret_cast< __m128i* >( p + 4 ), Round( b ) );
+   }
+};
+
+template< typename From, typename To, DitherType type >
+TARGET_SSE2 size_t Narrow( const typename From::Sample *src,
+   typename To::Sample *dst, size_t len, NoiseState &state )
+{
+   Ditherer< type > dither{ state };
+   const auto scale = _mm_set1_ps( To::Scale() );
+   size_t ii = 0;
+   for ( ; ii + 8 <= len; ii += 8 ) {
+      const auto a = dither( _mm_mul_ps( From::Load( src + ii ), scale ) );
+      const auto b = dither( _mm_mul_ps( From::Load( src + ii + 4 ), scale ) );
+      To::Store( dst + ii, a, b );
+   }
+   dither.Save( state );
+   return ii;
+}
+
+template< typename From, typename To >
+size_t Narrow( const typename From::Sample *src,
+   typename To::Sample *dst, size_t len, DitherType type, NoiseState &state )
+{
+   switch ( type ) {
+   case DitherType::none:
+      return Narrow< From, To, DitherType::none >( src, dst, len, state );
+   case DitherType::rectangle:
+      return Narrow< From, To, DitherType::rectangle >( src, dst, len, state );
+   case DitherType::triangle:
+      return Narrow< From, To, DitherType::triangle >( src, dst, len, state );
+   default:
+      return 0;
+   }
+}
+
+TARGET_SSE2 size_t Noise( float *dst, size_t len, NoiseState &state )
+{
+   auto s = _mm_loadu_si128( reinterpret_cast< const __m128i* >( state.lanes ) );
+   size_t ii = 0;
+   for ( ; ii + 4 <= len; ii += 4 )
+      _mm_storeu_ps( dst + ii, Noise( s ) );
+   _mm_storeu_si128( reinterpret_cast< __m128i* >( state.lanes ), s );
+   return ii;
+}
+
+// Sign extend eight shorts to two vectors of ints
+TARGET_SSE2 inline void Widen( const short *p, __m128i &lo, __m128i &hi )
+{
+   const auto s = _mm_loadu_si128( reinterpret_cast< const __m128i* >( p ) );
+   lo = _mm_srai_epi32( _mm_unpacklo_epi16( s, s ), 16 );
+   hi = _mm_srai_epi32( _mm_unpackhi_epi16( s, s ), 16 );
+}
+
+TARGET_SSE2 size_t Int16ToFloat( const short *src, float *dst, size_t len )
+{
+   const auto scale = _mm_set1_ps( 1.0f / ( 1 << 15 ) );
+   size_t ii = 0;
+   for ( ; ii + 8 <= len; ii += 8 ) {
+      __m128i lo, hi;
+      Widen( src + ii, lo, hi );
+      _mm_storeu_ps( dst + ii, _mm_mul_ps( _mm_cvtepi32_ps( lo ), scale ) );
+      _mm_storeu_ps( dst + ii + 4, _mm_mul_ps( _mm_cvtepi32_ps( hi ), scale ) );
+   }
+   return ii;
+}
+
+TARGET_SSE2 size_t Int24ToFloat( const int *src, float *dst, size_t len )
+{
+   size_t ii = 0;
+   for ( ; ii + 4 <= len; ii += 4 )
+      _mm_storeu_ps( dst + ii, FromInt24::Load( src + ii ) );
+   return ii;
+}
+
+TARGET_SSE2 size_t Int16ToInt24( const short *src, int *dst, size_t len )
+{
+   size_t ii = 0;
+   for ( ; ii + 8 <= len; ii += 8 ) {
+      __m128i lo, hi;
+      Widen( src + ii, lo, hi );
+      _mm_storeu_si128( reinterpret_cast< __m128i* >( dst + ii ),
+         _mm_slli_epi32( lo, 8 ) );
+      _mm_storeu_si128( reinterpret_cast< __m128i* >( dst + ii + 4 ),
+         _mm_slli_epi32( hi, 8 ) );
+   }
+   return ii;
+}
+
+size_t FloatToInt16( const float *src, short *dst, size_t len,
+   DitherType type, NoiseState &state )
+{
+   return Narrow< FromFloat, ToInt16 >( src, dst, len, type, state );
+}
+
+size_t FloatToInt24( const float *src, int *dst, size_t len,
+   DitherType type, NoiseState &state )
+{
+   return Narrow< FromFloat, ToInt24 >( src, dst, len, type, state );
+}
+
+size_t Int24ToInt16( const int *src, short *dst, size_t len,
+   DitherType type, NoiseState &state )
+{
+   return Narrow< FromInt24, ToInt16 >( src, dst, len, type, state );
+}
+
+} // namespace SSE2
+
+////////////////////////////////////////////////////////////////////////
+// AVX2, eight samples to a vector
+
+namespace AVX2 {
+
+TARGET_AVX2 inline __m256 Noise( __m256i &s )
+{
+   s = _mm256_xor_si256( s, _mm256_slli_epi32( s, 13 ) );
+   s = _mm256_xor_si256( s, _mm256_srli_epi32( s, 17 ) );
+   s = _mm256_xor_si256( s, _mm256_slli_epi32( s, 5 ) );
+   const auto bits = _mm256_or_si256(
+      _mm256_srli_epi32( s, 9 ), _mm256_set1_epi32( 0x3f800000 ) );
+   return _mm256_sub_ps( _mm256_castsi256_ps( bits ), _mm256_set1_ps( 1.5f ) );
+}
+
+template< DitherType type > struct Ditherer {
+   __m256i s;
+   __m256 last;
+
+   TARGET_AVX2 explicit Ditherer( const NoiseState &state )
+      : s{ _mm256_loadu_si256( reinterpret_cast< const __m256i* >( state.lanes ) ) }
+      , last{ _mm256_set1_ps( state.triangle ) }
+   {}
+
+   TARGET_AVX2 void Save( NoiseState &state ) const
+   {
+      _mm256_storeu_si256( reinterpret_cast< __m256i* >( state.lanes ), s );
+      state.triangle = _mm256_cvtss_f32( last );
+   }
+
+   TARGET_AVX2 __m256 operator () ( __m256 x )
+   {
+      switch ( type ) {
+      case DitherType::rectangle:
+         return _mm256_sub_ps( x, Noise( s ) );
+      case DitherType::triangle: {
+         const auto r = Noise( s );
+         const auto prev = _mm256_blend_ps( _mm256_permutevar8x32_ps(
+            r, _mm256_set_epi32( 6, 5, 4, 3, 2, 1, 0, 7 ) ), last, 1 );
+         last = _mm256_permutevar8x32_ps( r, _mm256_set1_epi32( 7 ) );
+         return _mm256_sub_ps( _mm256_add_ps( x, r ), prev );
+      }
+      default:
+         return x;
+      }
+   }
+};
+
+struct FromFloat {
+   using Sample = float;
+   TARGET_AVX2 static __m256 Load( const float *p )
+   {
+      const auto x =
+         _mm256_min_ps( _mm256_set1_ps( 1.0f ), _mm256_loadu_ps( p ) );
+      return _mm256_max_ps( x, _mm256_set1_ps( -1.0f ) );
+   }
+};
+
+struct FromInt24 {
+   using Sample = int;
+   TARGET_AVX2 static __m256 Load( const int *p )
+   {
+      const auto x = _mm256_cvtepi32_ps(
+         _mm256_loadu_si256( reinterpret_cast< const __m256i* >( p ) ) );
+      return _mm256_mul_ps( x, _mm256_set1_ps( 1.0f / ( 1 << 23 ) ) );
+   }
+};
+
+struct ToInt16 {
+   using Sample = short;
+   static float Scale() { return float( 1 << 15 ); }
+   TARGET_AVX2 static void Store( short *p, __m256 x )
+   {
+      // Packing works within halves, so pack the halves together
+      const auto v = _mm256_cvtps_epi32( x );
+      _mm_storeu_si128( reinterpret_cast< __m128i* >( p ), _mm_packs_epi32(
+         _mm256_castsi256_si128( v ), _mm256_extracti128_si256( v, 1 ) ) );
+   }
+};
+
+struct ToInt24 {
+   using Sample = int;
+   static float Scale() { return float( 1 << 23 ); }
+   TARGET_AVX2 static void Store( int *p, __m256 x )
+   {
+      x = _mm256_min_ps( x, _mm256_set1_ps( 8388607.0f ) );
+      x = _mm256_max_ps( x, _mm256_set1_ps( -8388608.0f ) );
+      _mm256_storeu_si256(
+         reinterpret_cast< __m256i* >( p ), _mm256_cvtps_epi32( x ) );
+   }
+};
+
+template< typename From, typename To, DitherType type >
+TARGET_AVX2 size_t Narrow( const typename From::Sample *src,
+   typename To::Sample *dst, size_t len, NoiseState &state )
+{
+   Ditherer< type > dither{ state };
+   const auto scale = _mm256_set1_ps( To::Scale() );
+   size_t ii = 0;
+   for ( ; ii + 8 <= len; ii += 8 )
+      To::Store( dst + ii,
+         dither( _mm256_mul_ps( From::Load( src + ii ), scale ) ) );
+   dither.Save( state );
+   return ii;
+}
+
+template< typename From, typename To >
+size_t Narrow( const typename From::Sample *src,
+   typename To::Sample *dst, size_t len, DitherType type, NoiseState &state )
+{
+   switch ( type ) {
+   case DitherType::none:
+      return Narrow< From, To, DitherType::none >( src, dst, len, state );
+   case DitherType::rectangle:
+      return Narrow< From, To, DitherType::rectangle >( src, dst, len, state );
+   case DitherType::triangle:
+      return Narrow< From, To, DitherType::triangle >( src, dst, len, state );
+   default:
+      return 0;
+   }
+}
+
+TARGET_AVX2 size_t Noise( float *dst, size_t len, NoiseState &state )
+{
+   auto s =
+      _mm256_loadu_si256( reinterpret_cast< const __m256i* >( state.lanes ) );
+   size_t ii = 0;
+   for ( ; ii + 8 <= len; ii += 8 )
+      _mm256_storeu_ps( dst + ii, Noise( s ) );
+   _mm256_storeu_si256( reinterpret_cast< __m256i* >( state.lanes ), s );
+   return ii;
+}
+
+TARGET_AVX2 inline __m256i Widen( const short *p )
+{
+   return _mm256_cvtepi16_epi32(
+      _mm_loadu_si128( reinterpret_cast< const __m128i* >( p ) ) );
+}
+
+TARGET_AVX2 size_t Int16ToFloat( const short *src, float *dst, size_t len )
+{
+   const auto scale = _mm256_set1_ps( 1.0f / ( 1 << 15 ) );
+   size_t ii = 0;
+   for ( ; ii + 8 <= len; ii += 8 )
+      _mm256_storeu_ps( dst + ii,
+         _mm256_mul_ps( _mm256_cvtepi32_ps( Widen( src + ii ) ), scale ) );
+   return ii;
+}
+
+TARGET_AVX2 size_t Int24ToFloat( const int *src, float *dst, size_t len )
+{
+   size_t ii = 0;
+   for ( ; ii + 8 <= len; ii += 8 )
+      _mm256_storeu_ps( dst + ii, FromInt24::Load( src + ii ) );
+   return ii;
+}
+
+TARGET_AVX2 size_t Int16ToInt24( const short *src, int *dst, size_t len )
+{
+   size_t ii = 0;
+   for ( ; ii + 8 <= len; ii += 8 )
+      _mm256_storeu_si256( reinterpret_cast< __m256i* >( dst + ii ),
+         _mm256_slli_epi32( Widen( src + ii ), 8 ) );
+   return ii;
+}
+
+size_t FloatToInt16( const float *src, short *dst, size_t len,
+   DitherType type, NoiseState &state )
+{
+   return Narrow< FromFloat, ToInt16 >( src, dst, len, type, state );
+}
+
+size_t FloatToInt24( const float *src, int *dst, size_t len,
+   DitherType type, NoiseState &state )
+{
+   return Narrow< FromFloat, ToInt24 >( src, dst, len, type, state );
+}
+
+size_t Int24ToInt16( const int *src, short *dst, size_t len,
+   DitherType type, NoiseState &state )
+{
+   return Narrow< FromInt24, ToInt16 >( src, dst, len, type, state );
+}
+
+} // namespace AVX2
+
+#endif // SAMPLE_FORMAT_KERNELS_X86
+
+} // namespace
+
+InstructionSet GetBest()
+{
+   static const InstructionSet best = Detect();
+   return best;
+}
+
+InstructionSet Get()
+{
+   return Current().load( std::memory_order_relaxed );
+}
+
+void Set( InstructionSet set )
+{
+   Current().store( std::min( set, GetBest() ), std::memory_order_relaxed );
+}
+
+const char *GetName( InstructionSet set )
+{
+   switch ( set ) {
+   case InstructionSet::SSE2:
+      return "SSE2";
+   case InstructionSet::AVX2:
+      return "AVX2";
+   default:
+      return "scalar";
+   }
+}
+
+#ifdef SAMPLE_FORMAT_KERNELS_X86
+   #define DISPATCH( call ) \
+      switch ( Get() ) { \
+      case InstructionSet::AVX2: return AVX2::call; \
+      case InstructionSet::SSE2: return SSE2::call; \
+      default: return 0; \
+      }
+#else
+   #define DISPATCH( call ) return 0;
+#endif
+
+namespace {
+size_t VectorNoise( float *dst, size_t len, NoiseState &state )
+{
+   DISPATCH( Noise( dst, len, state ) )
+}
+}
+
+void Noise( float *dst, size_t len, NoiseState &state )
+{
+   for ( auto ii = VectorNoise( dst, len, state ); ii < len; ++ii )
+      dst[ii] = NextNoise( state );
+}
+
+size_t Int16ToFloat( const short *src, float *dst, size_t len )
+{
+   DISPATCH( Int16ToFloat( src, dst, len ) )
+}
+
+size_t Int24ToFloat( const int *src, float *dst, size_t len )
+{
+   DISPATCH( Int24ToFloat( src, dst, len ) )
+}
+
+size_t Int16ToInt24( const short *src, int *dst, size_t len )
+{
+   DISPATCH( Int16ToInt24( src, dst, len ) )
+}
+
+size_t FloatToInt16( const float *src, short *dst, size_t len,
+   DitherType type, NoiseState &state )
+{
+   DISPATCH( FloatToInt16( src, dst, len, type, state ) )
+}
+
+size_t FloatToInt24( const float *src, int *dst, size_t len,
+   DitherType type, NoiseState &state )
+{
+   DISPATCH( FloatToInt24( src, dst, len, type, state ) )
+}
+
+size_t Int24ToInt16( const int *src, short *dst, size_t len,
+   DitherType type, NoiseState &state )
+{
+   DISPATCH( Int24ToInt16( src, dst, len, type, state ) )
+}
+
+}
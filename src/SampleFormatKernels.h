@@ -0,0 +1,79 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  SampleFormatKernels.h
+
+**********************************************************************/
+
+#ifndef __AUDACITY_SAMPLE_FORMAT_KERNELS__
+#define __AUDACITY_SAMPLE_FORMAT_KERNELS__
+
+#include <stddef.h>
+
+enum DitherType : unsigned;
+
+/// \brief Vectorized inner loops of Dither::Apply, for samples that are not
+/// interleaved.
+///
+/// The instruction set is chosen once, the best that the processor supports.
+/// Each conversion does the longest prefix of the samples that is a whole
+/// number of vectors, and returns its length; the caller does the rest with
+/// the scalar loops, which continue from the same noise state.
+namespace SampleFormatKernels {
+
+   enum class InstructionSet { Scalar, SSE2, AVX2 };
+
+   /// The best the processor supports
+   InstructionSet GetBest();
+   /// The one in use
+   InstructionSet Get();
+   /// For benchmarks; limited to what the processor supports.  Thread-safe.
+   void Set( InstructionSet set );
+   const char *GetName( InstructionSet set );
+
+   /// State of the dither noise: a xorshift generator for each lane of the
+   /// widest vector, which is much cheaper than rand(), and is not shared
+   /// between threads.  Scalar code uses the first lane only.
+   struct NoiseState {
+      enum : size_t { nLanes = 8 };
+      unsigned lanes[nLanes];
+      /// The last noise value, for the high pass of triangle dither
+      float triangle;
+
+      NoiseState();
+   };
+
+   /// Uniform noise in [-0.5, 0.5)
+   inline float NextNoise( NoiseState &state )
+   {
+      auto &x = state.lanes[0];
+      x ^= x << 13;
+      x ^= x >> 17;
+      x ^= x << 5;
+      // 23 random bits make the mantissa of a float in [1, 2)
+      union { unsigned i; float f; } u;
+      u.i = ( x >> 9 ) | 0x3f800000u;
+      return u.f - 1.5f;
+   }
+
+   /// Fill with uniform noise in [-0.5, 0.5), all of it
+   void Noise( float *dst, size_t len, NoiseState &state );
+
+   // These need no dither, and their results are exactly those of the
+   // scalar loops
+   size_t Int16ToFloat( const short *src, float *dst, size_t len );
+   size_t Int24ToFloat( const int *src, float *dst, size_t len );
+   size_t Int16ToInt24( const short *src, int *dst, size_t len );
+
+   // These do none, rectangle, or triangle dither, and return 0 for shaped
+   // dither, whose noise shaping filter is recursive
+   size_t FloatToInt16( const float *src, short *dst, size_t len,
+      DitherType type, NoiseState &state );
+   size_t FloatToInt24( const float *src, int *dst, size_t len,
+      DitherType type, NoiseState &state );
+   size_t Int24ToInt16( const int *src, short *dst, size_t len,
+      DitherType type, NoiseState &state );
+}
+
+#endif
@@ -40,7 +40,9 @@
 #include <wx/ffile.h>
 #include <wx/log.h>
 
+#include "BlockFileCache.h"
 #include "DirManager.h"
+#include "SummaryPyramid.h"
 
 #include "blockfile/SilentBlockFile.h"
 #include "blockfile/SimpleBlockFile.h"
@@ -57,6 +59,7 @@ Sequence::Sequence(const std::shared_ptr<DirManager> &projDirManager, sampleForm
    , mSampleFormat(format)
    , mMinSamples(sMaxDiskBlockSize / SAMPLE_SIZE(mSampleFormat) / 2)
    , mMaxSamples(mMinSamples * 2)
+   , mSummaryPyramid(std::make_unique<SummaryPyramid>())
 {
 }
 
@@ -68,6 +71,7 @@ Sequence::Sequence(const Sequence &orig, const std::shared_ptr<DirManager> &proj
    , mSampleFormat(orig.mSampleFormat)
    , mMinSamples(orig.mMinSamples)
    , mMaxSamples(orig.mMaxSamples)
+   , mSummaryPyramid(std::make_unique<SummaryPyramid>())
 {
    Paste(0, &orig);
 }
@@ -76,6 +80,16 @@ Sequence::~Sequence()
 {
 }
 
+bool Sequence::SameBlocksAs(const Sequence &other) const
+{
+   return mSampleFormat == other.mSampleFormat &&
+      mNumSamples == other.mNumSamples &&
+      mBlock.size() == other.mBlock.size() &&
+      std::equal(mBlock.begin(), mBlock.end(), other.mBlock.begin(),
+         [](const SeqBlock &a, const SeqBlock &b){
+            return a.f == b.f && a.start == b.start; });
+}
+
 size_t Sequence::GetMaxBlockSize() const
 {
    return mMaxSamples;
@@ -234,6 +248,43 @@ bool Sequence::ConvertToSampleFormat(sampleFormat format)
    return true;
 }
 
+void Sequence::CompressDeferredBlocks()
+// STRONG-GUARANTEE
+{
+   auto &factory = DirManager::GetSampleBlockFileFactory();
+   if (!factory)
+      return;
+
+   BlockArray newBlockArray{ mBlock };
+   bool changed = false;
+
+   SampleBuffer buffer(mMaxSamples, mSampleFormat);
+   for (auto &block : newBlockArray)
+   {
+      auto &file = block.f;
+      if (!file->GetNeedWriteCacheToDisk())
+         continue;
+
+      // Read from the cache, not the disk
+      const auto len = file->GetLength();
+      Read(buffer.ptr(), mSampleFormat, block, 0, len, true);
+
+      auto newFile = mDirManager->NewBlockFile(
+         [&]( wxFileNameWrapper filePath ) {
+            return factory( filePath, buffer.ptr(), len, mSampleFormat );
+         } );
+      if (newFile) {
+         // The old file is destroyed without its cache ever being written
+         file = newFile;
+         changed = true;
+      }
+   }
+
+   if (changed)
+      CommitChangesIfConsistent
+         (newBlockArray, mNumSamples, wxT("Sequence::CompressDeferredBlocks()"));
+}
+
 std::pair<float, float> Sequence::GetMinMax(
    sampleCount start, sampleCount len, bool mayThrow) const
 {
@@ -383,6 +434,35 @@ float Sequence::GetRMS(sampleCount start, sampleCount len, bool mayThrow) const
    return sqrt(sumsq / length.as_double() );
 }
 
+SampleStatistics Sequence::GetStatistics(
+   sampleCount start, sampleCount len, bool mayThrow) const
+{
+   SampleStatistics result;
+   if (len <= 0 || mBlock.size() == 0)
+      return result;
+
+   const auto end = start + len;
+   unsigned int block0 = FindBlock(start);
+   unsigned int block1 = FindBlock(end - 1);
+
+   for (auto b = block0; b <= block1; ++b) {
+      const SeqBlock &theBlock = mBlock[b];
+      const auto &theFile = theBlock.f;
+      const auto blockEnd = theBlock.start + theFile->GetLength();
+      const auto s0 = std::max(start, theBlock.start);
+      const auto s1 = std::min(end, blockEnd);
+
+      if (s0 == theBlock.start && s1 == blockEnd)
+         result.Merge(theFile->GetStatistics(mayThrow));
+      else
+         result.Merge(theFile->GetStatistics(
+            (s0 - theBlock.start).as_size_t(), (s1 - s0).as_size_t(),
+            mayThrow));
+   }
+
+   return result;
+}
+
 std::unique_ptr<Sequence> Sequence::Copy(sampleCount s0, sampleCount s1) const
 {
    auto dest = std::make_unique<Sequence>(mDirManager, mSampleFormat);
@@ -463,7 +543,16 @@ namespace {
                                     sampleFormat format,
                                     bool allowDeferredWrite = false)
    {
-      return dm.NewBlockFile( [&]( wxFileNameWrapper filePath ) {
+      return dm.NewBlockFile( [&]( wxFileNameWrapper filePath )
+      -> BlockFilePtr {
+         // Deferred writes are for recording, which should not wait on
+         // any other format
+         auto &factory = DirManager::GetSampleBlockFileFactory();
+         if ( factory && !allowDeferredWrite ) {
+            if ( auto result =
+                  factory( filePath, sampleData, sampleLen, format ) )
+               return result;
+         }
          return make_blockfile<SimpleBlockFile>(
             std::move(filePath), sampleData, sampleLen, format, allowDeferredWrite);
       } );
@@ -1096,7 +1185,8 @@ bool Sequence::Read(samplePtr buffer, sampleFormat format,
    wxASSERT(blockRelativeStart + len <= f->GetLength());
 
    // Either throws, or of !mayThrow, tells how many were really read
-   auto result = f->ReadData(buffer, format, blockRelativeStart, len, mayThrow);
+   auto result = BlockFileCache::Get().ReadData(
+      *f, buffer, format, blockRelativeStart, len, mayThrow);
 
    if (result != len)
    {
@@ -1126,6 +1216,39 @@ bool Sequence::Get(samplePtr buffer, sampleFormat format,
    return Get(b, buffer, format, start, len, mayThrow);
 }
 
+//static
+bool Sequence::GetFromBlocks(const BlockArray &blocks,
+   samplePtr buffer, sampleFormat format,
+   sampleCount start, size_t len, bool mayThrow)
+{
+   // Find the last block that starts at or before start
+   auto iter = std::upper_bound(blocks.begin(), blocks.end(), start,
+      [](sampleCount pos, const SeqBlock &block){ return pos < block.start; });
+
+   bool result = true;
+   while (len) {
+      if (iter == blocks.begin() ||
+          start >= (iter - 1)->start + (iter - 1)->f->GetLength()) {
+         if (mayThrow)
+            THROW_INCONSISTENCY_EXCEPTION;
+         ClearSamples( buffer, format, 0, len );
+         return false;
+      }
+      const SeqBlock &block = *(iter - 1);
+      const auto bstart = (start - block.start).as_size_t();
+      const auto blen = std::min(len, block.f->GetLength() - bstart);
+
+      if (! Read(buffer, format, block, bstart, blen, mayThrow) )
+         result = false;
+
+      len -= blen;
+      buffer += (blen * SAMPLE_SIZE(format));
+      ++iter;
+      start += blen;
+   }
+   return result;
+}
+
 bool Sequence::Get(int b, samplePtr buffer, sampleFormat format,
    sampleCount start, size_t len, bool mayThrow) const
 {
@@ -1314,6 +1437,14 @@ bool Sequence::GetWaveDisplay(float *min, float *max, float *rms, int* bl,
    // ... unless the mNumSamples ceiling applies, and then there are other defenses
    const auto s1 =
       std::min(mNumSamples, std::max(1 + where[len - 1], where[len]));
+
+   // When zoomed out so far that block summaries would be read for many
+   // blocks, use the summary pyramid instead
+   if ((s1 - s0).as_double() / len >= 65536) {
+      GetWaveDisplayFromPyramid(min, max, rms, bl, len, where, s1);
+      return true;
+   }
+
    Floats temp{ mMaxSamples };
 
    decltype(len) pixel = 0;
@@ -1507,6 +1638,46 @@ bool Sequence::GetWaveDisplay(float *min, float *max, float *rms, int* bl,
    return true;
 }
 
+void Sequence::GetWaveDisplayFromPyramid(float *min, float *max, float *rms,
+   int* bl, size_t len, const sampleCount *where, sampleCount s1) const
+{
+   auto &pyramid = *mSummaryPyramid;
+   std::lock_guard<std::mutex> lock{ pyramid.GetMutex() };
+   pyramid.Update(mBlock);
+
+   for (size_t pixel = 0; pixel < len; ++pixel) {
+      // Every column gets at least one sample, as in GetWaveDisplay
+      const auto from =
+         std::max(sampleCount(0), std::min(s1 - 1, where[pixel]));
+      const auto to = std::max(from + 1, std::min(s1, where[pixel + 1]));
+
+      // Whole blocks come from the pyramid, and the ends from block summaries
+      const int b0 = FindBlock(from);
+      const int b1 = FindBlock(to - 1);
+      const SeqBlock &block0 = mBlock[b0];
+      const auto start0 = (from - block0.start).as_size_t();
+      SummaryPyramid::Values values;
+      if (b0 == b1)
+         values = pyramid.GetPartial(mBlock, b0,
+            start0, (to - block0.start).as_size_t());
+      else {
+         values = pyramid.GetPartial(mBlock, b0,
+            start0, block0.f->GetLength());
+         values.Add(pyramid.GetBlocks(b0 + 1, b1));
+         values.Add(pyramid.GetPartial(mBlock, b1,
+            0, (to - mBlock[b1].start).as_size_t()));
+      }
+
+      if (values.min > values.max)
+         // Nothing available
+         min[pixel] = max[pixel] = 0;
+      else
+         min[pixel] = values.min, max[pixel] = values.max;
+      rms[pixel] = values.count > 0 ? sqrt(values.sumsq / values.count) : 0;
+      bl[pixel] = values.available ? b0 : -1 - b0;
+   }
+}
+
 size_t Sequence::GetIdealAppendLen() const
 {
    int numBlocks = mBlock.size();
@@ -23,6 +23,7 @@ class BlockFile;
 using BlockFilePtr = std::shared_ptr<BlockFile>;
 
 class DirManager;
+class SummaryPyramid;
 class wxFileNameWrapper;
 
 // This is an internal data structure!  For advanced use only.
@@ -85,6 +86,13 @@ class PROFILE_DLL_API Sequence final : public XMLTagHandler{
    bool Get(samplePtr buffer, sampleFormat format,
             sampleCount start, size_t len, bool mayThrow) const;
 
+   // Read from a copy of the block array of a sequence, which shares its
+   // block files.  Block files never change, so this may be done on another
+   // thread while the sequence is edited.
+   static bool GetFromBlocks(const BlockArray &blocks,
+      samplePtr buffer, sampleFormat format,
+      sampleCount start, size_t len, bool mayThrow);
+
    // Note that len is not size_t, because nullptr may be passed for buffer, in
    // which case, silence is inserted, possibly a large amount.
    void SetSamples(samplePtr buffer, sampleFormat format,
@@ -102,6 +110,10 @@ class PROFILE_DLL_API Sequence final : public XMLTagHandler{
 
    // Return non-null, or else throw!
    std::unique_ptr<Sequence> Copy(sampleCount s0, sampleCount s1) const;
+
+   // Whether the other has the same format and the very same block files,
+   // as a copy made by the copy constructor does until either changes
+   bool SameBlocksAs(const Sequence &other) const;
    void Paste(sampleCount s0, const Sequence *src);
 
    size_t GetIdealAppendLen() const;
@@ -161,6 +173,11 @@ class PROFILE_DLL_API Sequence final : public XMLTagHandler{
    // Return true iff there is a change
    bool ConvertToSampleFormat(sampleFormat format);
 
+   // Replace the blocks whose writing was deferred, during recording, with
+   // blocks from DirManager's sample block file factory, where it accepts
+   // them; the others are left for DirManager::WriteCacheToDisk()
+   void CompressDeferredBlocks();
+
    //
    // Retrieving summary info
    //
@@ -168,6 +185,10 @@ class PROFILE_DLL_API Sequence final : public XMLTagHandler{
    std::pair<float, float> GetMinMax(
       sampleCount start, sampleCount len, bool mayThrow) const;
    float GetRMS(sampleCount start, sampleCount len, bool mayThrow) const;
+   // Uses the statistics of whole blocks, and reads only the partial blocks
+   // at the ends
+   SampleStatistics GetStatistics(
+      sampleCount start, sampleCount len, bool mayThrow) const;
 
    //
    // Getting block size and alignment information
@@ -236,12 +257,19 @@ class PROFILE_DLL_API Sequence final : public XMLTagHandler{
    ///To block the Delete() method against the ODCalcSummaryTask::Update() method
    ODLock   mDeleteUpdateMutex;
 
+   // Summarizes whole blocks for GetWaveDisplay, updated when it is called
+   std::unique_ptr<SummaryPyramid> mSummaryPyramid;
+
    //
    // Private methods
    //
 
    int FindBlock(sampleCount pos) const;
 
+   void GetWaveDisplayFromPyramid(float *min, float *max, float *rms, int* bl,
+                                  size_t len, const sampleCount *where,
+                                  sampleCount s1) const;
+
    static void AppendBlock
       (DirManager &dirManager,
        BlockArray &blocks, sampleCount &numSamples, const SeqBlock &b);
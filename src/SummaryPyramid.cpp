@@ -0,0 +1,210 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  SummaryPyramid.cpp
+
+*******************************************************************//**
+
+\class SummaryPyramid
+\brief Summaries of ranges of whole blocks of a Sequence, for drawing
+far zoomed out.
+
+  Each BlockFile keeps its own minimum, maximum, and RMS in memory, so the
+  lowest level costs nothing to compute.  Each level above combines pairs of
+  entries below, and a range of blocks is covered by at most two entries of
+  each level.
+
+  Entries are matched to blocks by their files, which never change their
+  data.  After an edit, only the entries from the first changed block on
+  are recomputed, which for the usual appends at the end is only a few.
+
+*//*******************************************************************/
+
+#include "Audacity.h"
+#include "SummaryPyramid.h"
+
+#include <algorithm>
+#include <float.h>
+
+#include "BlockFile.h"
+#include "Sequence.h"
+
+namespace {
+   // Whether the weak pointer was made from the shared pointer, even if
+   // it has since expired
+   bool SameFile(
+      const std::weak_ptr< BlockFile > &w, const BlockFilePtr &s )
+   {
+      return !w.owner_before( s ) && !s.owner_before( w );
+   }
+
+   const size_t SummaryFrame = 65536;
+}
+
+SummaryPyramid::Values::Values()
+   : min{ FLT_MAX }, max{ -FLT_MAX }, sumsq{ 0 }, count{ 0 }, available{ true }
+{
+}
+
+void SummaryPyramid::Values::Add( const Values &other )
+{
+   min = std::min( min, other.min );
+   max = std::max( max, other.max );
+   sumsq += other.sumsq;
+   count += other.count;
+   available = available && other.available;
+}
+
+SummaryPyramid::SummaryPyramid()
+{
+}
+
+SummaryPyramid::~SummaryPyramid()
+{
+}
+
+void SummaryPyramid::Update( const BlockArray &blocks )
+{
+   const auto nBlocks = blocks.size();
+   const auto nKept = std::min( nBlocks, mLeaves.size() );
+   size_t first = 0;
+   while ( first < nKept && SameFile( mLeaves[first].file, blocks[first].f ) )
+      ++first;
+
+   if ( first < nBlocks || nBlocks < mLeaves.size() ) {
+      if ( mLevels.empty() )
+         mLevels.resize( 1 );
+
+      // Replace the lowest level from the first difference
+      auto &level0 = mLevels[0];
+      for ( auto ii = first; ii < level0.size(); ++ii )
+         if ( !level0[ii].available )
+            --mUnavailable;
+      mLeaves.resize( first );
+      level0.resize( first );
+      for ( auto ii = first; ii < nBlocks; ++ii ) {
+         const auto &file = blocks[ii].f;
+         mLeaves.push_back( { file, {} } );
+         level0.push_back( file ? Summarize( *file ) : Values{} );
+         if ( !file )
+            level0.back().available = false;
+         if ( !level0.back().available )
+            ++mUnavailable;
+      }
+
+      // Recompute the entries above that cover any changed block
+      size_t level = 1;
+      for ( ; mLevels[level - 1].size() > 1; ++level ) {
+         if ( mLevels.size() == level )
+            mLevels.resize( level + 1 );
+         const auto size = ( mLevels[level - 1].size() + 1 ) / 2;
+         auto &entries = mLevels[level];
+         entries.resize( std::min( entries.size(), first >> level ) );
+         entries.resize( size );
+         for ( auto ii = first >> level; ii < size; ++ii )
+            Recompute( level, ii );
+      }
+      mLevels.resize( level );
+   }
+
+   if ( mUnavailable > 0 )
+      Refresh( blocks );
+}
+
+void SummaryPyramid::Refresh( const BlockArray &blocks )
+{
+   // On-demand loading may have finished some summaries since last time
+   auto &level0 = mLevels[0];
+   for ( size_t ii = 0, nn = level0.size(); ii < nn; ++ii ) {
+      if ( level0[ii].available )
+         continue;
+      const auto &file = blocks[ii].f;
+      if ( !file || !file->IsSummaryAvailable() )
+         continue;
+      level0[ii] = Summarize( *file );
+      --mUnavailable;
+      for ( size_t level = 1; level < mLevels.size(); ++level )
+         Recompute( level, ii >> level );
+   }
+}
+
+auto SummaryPyramid::Summarize( const BlockFile &file ) const -> Values
+{
+   Values result;
+   const auto len = file.GetLength();
+   result.count = len;
+   if ( !file.IsSummaryAvailable() ) {
+      result.available = false;
+      return result;
+   }
+   const auto values = file.GetMinMaxRMS( false );
+   result.min = values.min;
+   result.max = values.max;
+   result.sumsq = double( values.RMS ) * values.RMS * len;
+   return result;
+}
+
+void SummaryPyramid::Recompute( size_t level, size_t index )
+{
+   const auto &below = mLevels[level - 1];
+   auto &entry = mLevels[level][index];
+   entry = below[2 * index];
+   if ( 2 * index + 1 < below.size() )
+      entry.Add( below[2 * index + 1] );
+}
+
+auto SummaryPyramid::GetPartial( const BlockArray &blocks,
+   size_t b, size_t start, size_t end ) -> Values
+{
+   const auto &file = blocks[b].f;
+   const auto len = file->GetLength();
+   end = std::min( end, len );
+   if ( start == 0 && end == len )
+      return mLevels[0][b];
+
+   Values result;
+   if ( start >= end )
+      return result;
+   if ( !mLevels[0][b].available ) {
+      result.count = end - start;
+      result.available = false;
+      return result;
+   }
+
+   auto &summary = mLeaves[b].summary64K;
+   const auto nFrames = ( len + SummaryFrame - 1 ) / SummaryFrame;
+   if ( summary.empty() ) {
+      summary.resize( 3 * nFrames );
+      // This fills with zeroes if the read fails
+      file->Read64K( summary.data(), 0, nFrames );
+   }
+
+   for ( auto frame = start / SummaryFrame, last = ( end - 1 ) / SummaryFrame;
+         frame <= last; ++frame ) {
+      const auto frameStart = frame * SummaryFrame;
+      const auto count = std::min( end, frameStart + SummaryFrame ) -
+         std::max( start, frameStart );
+      const float *triple = &summary[3 * frame];
+      result.min = std::min( result.min, triple[0] );
+      result.max = std::max( result.max, triple[1] );
+      result.sumsq += double( triple[2] ) * triple[2] * count;
+      result.count += count;
+   }
+   return result;
+}
+
+auto SummaryPyramid::GetBlocks( size_t b0, size_t b1 ) const -> Values
+{
+   Values result;
+   // Climb the levels, taking the entries at either end of the range that
+   // have no partner within it
+   for ( size_t level = 0; b0 < b1; ++level, b0 /= 2, b1 /= 2 ) {
+      const auto &entries = mLevels[level];
+      if ( b0 % 2 )
+         result.Add( entries[b0++] );
+      if ( b1 % 2 )
+         result.Add( entries[--b1] );
+   }
+   return result;
+}
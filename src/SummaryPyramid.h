@@ -0,0 +1,78 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  SummaryPyramid.h
+
+**********************************************************************/
+
+#ifndef __AUDACITY_SUMMARY_PYRAMID__
+#define __AUDACITY_SUMMARY_PYRAMID__
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+class BlockArray;
+class BlockFile;
+
+/// \brief Min, max, and RMS of all the blocks of a Sequence, at every power
+/// of two number of blocks, so that any range of whole blocks is summarized
+/// in logarithmic time, without reading their files.
+///
+/// The lowest level also keeps each block's 64K summary, read once, for the
+/// parts of blocks at the ends of a range.
+class SummaryPyramid final
+{
+public:
+   struct Values {
+      float min, max;
+      double sumsq; // sum of squares of all the samples
+      double count; // number of samples
+      bool available; // false if some summary is not yet computed
+
+      Values();
+      void Add( const Values &other );
+   };
+
+   SummaryPyramid();
+   SummaryPyramid( const SummaryPyramid& ) = delete;
+   SummaryPyramid &operator= ( const SummaryPyramid& ) = delete;
+   ~SummaryPyramid();
+
+   /// Make the pyramid agree with the given blocks.  Only entries from the
+   /// first block with a different file are recomputed.
+   void Update( const BlockArray &blocks );
+
+   /// Summarize samples [start, end) of block b, to the resolution of
+   /// its 64K summary, or exactly when that is all the block
+   Values GetPartial( const BlockArray &blocks,
+      size_t b, size_t start, size_t end );
+
+   /// Summarize whole blocks [b0, b1)
+   Values GetBlocks( size_t b0, size_t b1 ) const;
+
+   /// The lock to hold while calling the other methods, which may be called
+   /// from any thread
+   std::mutex &GetMutex() { return mMutex; }
+
+private:
+   struct Leaf {
+      std::weak_ptr< BlockFile > file;
+      // Triples of min, max, and rms, empty until needed
+      std::vector< float > summary64K;
+   };
+
+   void Refresh( const BlockArray &blocks );
+   Values Summarize( const BlockFile &file ) const;
+   void Recompute( size_t level, size_t index );
+
+   std::mutex mMutex;
+   std::vector< Leaf > mLeaves;
+   // mLevels[0] has an entry per block; each higher level combines pairs
+   // of the one below
+   std::vector< std::vector< Values > > mLevels;
+   size_t mUnavailable{ 0 };
+};
+
+#endif
@@ -0,0 +1,142 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  ThreadPool.cpp
+
+*******************************************************************//**
+
+\class ThreadPool
+\brief A fixed set of worker threads, fed from one queue of tasks.
+
+  The workers are started by the constructor and joined by the destructor,
+  which finishes any tasks still queued.
+
+*//*******************************************************************/
+
+#include "Audacity.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <memory>
+
+ThreadPool &ThreadPool::Get()
+{
+   static ThreadPool pool{
+      std::max( 2u, std::thread::hardware_concurrency() ) - 1 };
+   return pool;
+}
+
+ThreadPool::ThreadPool( size_t nWorkers )
+{
+   mThreads.reserve( nWorkers );
+   for ( size_t ii = 0; ii < nWorkers; ++ii )
+      mThreads.emplace_back( [this]{ Run(); } );
+}
+
+ThreadPool::~ThreadPool()
+{
+   {
+      std::lock_guard< std::mutex > lock{ mMutex };
+      mStopping = true;
+   }
+   mCondition.notify_all();
+   for ( auto &thread : mThreads )
+      thread.join();
+}
+
+void ThreadPool::Schedule( Task task )
+{
+   {
+      std::lock_guard< std::mutex > lock{ mMutex };
+      mTasks.push_back( std::move( task ) );
+   }
+   mCondition.notify_one();
+}
+
+void ThreadPool::Run()
+{
+   while ( true ) {
+      Task task;
+      {
+         std::unique_lock< std::mutex > lock{ mMutex };
+         mCondition.wait( lock, [this]{ return mStopping || !mTasks.empty(); } );
+         if ( mTasks.empty() )
+            return;
+         task = std::move( mTasks.front() );
+         mTasks.pop_front();
+      }
+      try {
+         task();
+      }
+      catch ( ... ) {
+      }
+   }
+}
+
+void ThreadPool::ParallelFor( size_t count,
+   const std::function< void( size_t ) > &fn, size_t maxConcurrency )
+{
+   if ( count == 0 )
+      return;
+
+   auto concurrency = GetConcurrency();
+   if ( maxConcurrency )
+      concurrency = std::min( concurrency, maxConcurrency );
+   concurrency = std::min( concurrency, count );
+
+   if ( concurrency <= 1 ) {
+      for ( size_t ii = 0; ii < count; ++ii )
+         fn( ii );
+      return;
+   }
+
+   // Helper tasks may start only after all the work is claimed, perhaps
+   // after this function has returned, so they share the state by pointer
+   // and never touch fn unless they claim an iteration.
+   struct State {
+      std::atomic< size_t > next{ 0 };
+      size_t busy{ 0 };
+      std::exception_ptr exception;
+      std::mutex mutex;
+      std::condition_variable condition;
+   };
+   auto pState = std::make_shared< State >();
+   const auto pFn = &fn;
+
+   auto work = [pState, pFn, count]{
+      auto &state = *pState;
+      {
+         std::lock_guard< std::mutex > lock{ state.mutex };
+         ++state.busy;
+      }
+      size_t ii;
+      while ( ( ii = state.next++ ) < count ) {
+         try {
+            ( *pFn )( ii );
+         }
+         catch ( ... ) {
+            std::lock_guard< std::mutex > lock{ state.mutex };
+            if ( !state.exception )
+               state.exception = std::current_exception();
+            state.next = count;
+         }
+      }
+      {
+         std::lock_guard< std::mutex > lock{ state.mutex };
+         --state.busy;
+      }
+      state.condition.notify_all();
+   };
+
+   for ( size_t ii = 1; ii < concurrency; ++ii )
+      Schedule( work );
+   work();
+
+   std::unique_lock< std::mutex > lock{ pState->mutex };
+   pState->condition.wait( lock, [&]{ return pState->busy == 0; } );
+   if ( pState->exception )
+      std::rethrow_exception( pState->exception );
+}
@@ -0,0 +1,62 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  ThreadPool.h
+
+**********************************************************************/
+
+#ifndef __AUDACITY_THREAD_POOL__
+#define __AUDACITY_THREAD_POOL__
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/// \brief A fixed set of worker threads, fed from one queue of tasks.
+///
+/// Tasks may be scheduled from any thread.  ParallelFor() lets the calling
+/// thread share a loop with the workers and returns only when all iterations
+/// are done, so callers may pass references to local state.
+class ThreadPool final
+{
+public:
+   using Task = std::function< void() >;
+
+   /// The application-wide pool, with one worker fewer than the number of
+   /// processors, because the thread that calls ParallelFor() also works
+   static ThreadPool &Get();
+
+   explicit ThreadPool( size_t nWorkers );
+   ThreadPool( const ThreadPool & ) = delete;
+   ThreadPool &operator= ( const ThreadPool & ) = delete;
+   ~ThreadPool();
+
+   /// Number of workers plus one for a thread calling ParallelFor()
+   size_t GetConcurrency() const { return mThreads.size() + 1; }
+
+   /// Run the task on some worker, some time later.  Exceptions escaping
+   /// the task are swallowed.
+   void Schedule( Task task );
+
+   /// Call fn(0), ..., fn(count - 1), in unspecified order and possibly
+   /// concurrently, on at most maxConcurrency threads (or all, if zero),
+   /// including the calling thread.  If any call throws, remaining
+   /// iterations are skipped and the first exception is rethrown here.
+   void ParallelFor( size_t count,
+      const std::function< void( size_t ) > &fn, size_t maxConcurrency = 0 );
+
+private:
+   void Run();
+
+   std::mutex mMutex;
+   std::condition_variable mCondition;
+   std::deque< Task > mTasks;
+   std::vector< std::thread > mThreads;
+   bool mStopping{ false };
+};
+
+#endif
@@ -125,6 +125,28 @@ Track::Holder Track::Duplicate() const
    return result;
 }
 
+bool Track::SameStateAs(const Track &) const
+{
+   return false;
+}
+
+bool Track::SameCommonStateAs(const Track &other) const
+{
+   // Ids are not compared, because TrackList::Add assigns new ones anyway
+   if (!(mDefaultName == other.mDefaultName &&
+         mName == other.mName &&
+         mDirManager == other.mDirManager &&
+         mSelected == other.mSelected &&
+         mLinked == other.mLinked &&
+         mChannel == other.mChannel))
+      return false;
+
+   // View state is copied too
+   if (!mpView || !other.mpView)
+      return !mpView && !other.mpView;
+   return mpView->SameStateAs(other);
+}
+
 Track::~Track()
 {
 }
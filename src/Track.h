@@ -330,6 +330,11 @@ private:
    // public nonvirtual duplication function that invokes Clone():
    virtual Holder Duplicate() const;
 
+   // Whether a Duplicate() of this track would be interchangeable with the
+   // other, so that undo history may keep one copy of an unchanged track.
+   // The default returns false.
+   virtual bool SameStateAs(const Track &other) const;
+
    // Called when this track is merged to stereo with another, and should
    // take on some paramaters of its partner.
    virtual void Merge(const Track &orig);
@@ -715,6 +720,10 @@ public:
    bool HandleCommonXMLAttribute(const wxChar *attr, const wxChar *value);
 
 protected:
+   // Compares what Init() and Duplicate() copy, but for the id, for
+   // overrides of SameStateAs
+   bool SameCommonStateAs(const Track &other) const;
+
    std::shared_ptr<CommonTrackCell> mpView;
    std::shared_ptr<CommonTrackCell> mpControls;
 };
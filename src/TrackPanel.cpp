@@ -74,6 +74,7 @@ is time to refresh some aspect of the screen.
 #include "TrackArtist.h"
 #include "TrackPanelAx.h"
 #include "TrackPanelResizerCell.h"
+#include "WaveClip.h"
 #include "WaveTrack.h"
 
 #include "ondemand/ODManager.h"
@@ -466,6 +467,17 @@ void TrackPanel::OnTimer(wxTimerEvent& )
          }
       }
    }
+
+   // Draw the spectrogram columns computed in the background since the
+   // last tick
+   {
+      const auto progress = WaveClip::GetSpectrogramProgress();
+      if (progress != mSpectrogramProgress) {
+         mSpectrogramProgress = progress;
+         mRefreshBacking = true;
+         Refresh( false );
+      }
+   }
    if(mTimeCount > 1000)
       mTimeCount = 0;
 }
@@ -211,6 +211,9 @@ protected:
 
    bool mRedrawAfterStop;
 
+   // Last seen value of WaveClip::GetSpectrogramProgress()
+   unsigned mSpectrogramProgress{ 0 };
+
    friend class TrackPanelAx;
 
 protected:
@@ -37,6 +37,7 @@ UndoManager
 #include "Tags.h"
 
 
+#include <map>
 #include <unordered_set>
 
 wxDEFINE_EVENT(EVT_UNDO_PUSHED, wxCommandEvent);
@@ -49,7 +50,7 @@ using Set = std::unordered_set<ConstBlockFilePtr>;
 
 struct UndoStackElem {
 
-   UndoStackElem(std::shared_ptr<TrackList> &&tracks_,
+   UndoStackElem(UndoTracks &&tracks_,
       const wxString &description_,
       const wxString &shortDescription_,
       const SelectedRegion &selectedRegion_,
@@ -95,12 +96,12 @@ UndoManager::~UndoManager()
 
 namespace {
    SpaceArray::value_type
-   CalculateUsage(const TrackList &tracks, Set *seen)
+   CalculateUsage(const Track &track, Set *seen)
    {
       SpaceArray::value_type result = 0;
 
       //TIMER_START( "CalculateSpaceUsage", space_calc );
-      for (auto wt : tracks.Any< const WaveTrack >())
+      if (auto wt = track_cast< const WaveTrack* >( &track ))
       {
          // Scan all clips within current track
          for(const auto &clip : wt->GetAllClips())
@@ -128,6 +129,37 @@ namespace {
 
       return result;
    }
+
+   // Copy the tracks, except pending added ones, reusing the copies in the
+   // previous state of those that did not change
+   UndoTracks CopyTracks(const TrackList &tracks, const UndoTracks *pPrevious)
+   {
+      const UndoTracks empty;
+      const auto &previous = pPrevious ? *pPrevious : empty;
+      std::map< TrackId, std::shared_ptr< const Track > > previousById;
+      for (const auto &pTrack : previous)
+         previousById[ pTrack->GetId() ] = pTrack;
+
+      UndoTracks result;
+      for (auto t : tracks) {
+         if ( t->GetId() == TrackId{} )
+            // Don't copy a pending added track
+            continue;
+         // Copies keep the id, but tracks restored by undo get new ones, and
+         // then the copy in the same position is the likely match
+         auto iter = previousById.find( t->GetId() );
+         const auto pCopy = iter != previousById.end()
+            ? iter->second
+            : result.size() < previous.size()
+               ? previous[ result.size() ]
+               : nullptr;
+         if ( pCopy && t->SameStateAs( *pCopy ) )
+            result.push_back( pCopy );
+         else
+            result.push_back( t->Duplicate() );
+      }
+      return result;
+   }
 }
 
 void UndoManager::CalculateSpaceUsage()
@@ -151,15 +183,22 @@ void UndoManager::CalculateSpaceUsage()
    // DELETE all states containing the block file.  So the block file's
    // contribution to space usage should be counted only in that latest state.
 
+   // A track copy shared with a later state contributes nothing more, so
+   // visit each copy once only, and the work is proportional to the changes
+   // in the history, not to its length times the number of tracks.
+   std::unordered_set<const Track*> visited;
+
    for (size_t nn = stack.size(); nn--;)
    {
       // Scan all tracks at current level
-      auto &tracks = *stack[nn]->state.tracks;
-      space[nn] = CalculateUsage(tracks, &seen);
+      for (const auto &pTrack : stack[nn]->state.tracks)
+         if (visited.insert( pTrack.get() ).second)
+            space[nn] += CalculateUsage(*pTrack, &seen);
    }
 
-   mClipboardSpaceUsage = CalculateUsage(
-      Clipboard::Get().GetTracks(), nullptr);
+   mClipboardSpaceUsage = 0;
+   for (auto pTrack : Clipboard::Get().GetTracks())
+      mClipboardSpaceUsage += CalculateUsage(*pTrack, nullptr);
 
    //TIMER_STOP( space_calc );
 }
@@ -240,6 +279,13 @@ bool UndoManager::RedoAvailable()
    return (current < (int)stack.size() - 1);
 }
 
+const UndoTracks *UndoManager::GetCurrentTracks() const
+{
+   if (current < 0 || current >= (int)stack.size())
+      return nullptr;
+   return &stack[current]->state.tracks;
+}
+
 void UndoManager::ModifyState(const TrackList * l,
                               const SelectedRegion &selectedRegion,
                               const std::shared_ptr<Tags> &tags)
@@ -249,17 +295,8 @@ void UndoManager::ModifyState(const TrackList * l,
    }
 
    SonifyBeginModifyState();
-   // Delete current -- not necessary, but let's reclaim space early
-   stack[current]->state.tracks.reset();
-
-   // Duplicate
-   auto tracksCopy = TrackList::Create();
-   for (auto t : *l) {
-      if ( t->GetId() == TrackId{} )
-         // Don't copy a pending added track
-         continue;
-      tracksCopy->Add(t->Duplicate());
-   }
+   // Duplicate what changed
+   auto tracksCopy = CopyTracks(*l, &stack[current]->state.tracks);
 
    // Replace
    stack[current]->state.tracks = std::move(tracksCopy);
@@ -293,13 +330,9 @@ void UndoManager::PushState(const TrackList * l,
       return;
    }
 
-   auto tracksCopy = TrackList::Create();
-   for (auto t : *l) {
-      if ( t->GetId() == TrackId{} )
-         // Don't copy a pending added track
-         continue;
-      tracksCopy->Add(t->Duplicate());
-   }
+   // Duplicate only what differs from the current state
+   auto tracksCopy = CopyTracks(
+      *l, current >= 0 ? &stack[current]->state.tracks : nullptr);
 
    mayConsolidate = true;
 
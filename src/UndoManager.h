@@ -8,9 +8,11 @@
 
   After each operation, call UndoManager's PushState, pass it
   the entire track hierarchy.  The UndoManager makes a duplicate
-  of every single track using its Duplicate method, which should
-  increment reference counts.  If we were not at the top of
-  the stack when this is called, DELETE above first.
+  of every track that changed since the current state, using its
+  Duplicate method, which should increment reference counts; the
+  copies of unchanged tracks are shared with the current state.
+  If we were not at the top of the stack when this is called,
+  DELETE above first.
 
   If a minor change is made, for example changing the visual
   display of a track or changing the selection, you can call
@@ -77,15 +79,19 @@ class Tags;
 class Track;
 class TrackList;
 
+// Copies of the tracks of a project, in order, which are never modified.
+// States may share the copies of tracks that did not change between them.
+using UndoTracks = std::vector< std::shared_ptr< const Track > >;
+
 struct UndoStackElem;
 struct UndoState {
-   UndoState(std::shared_ptr<TrackList> &&tracks_,
+   UndoState(UndoTracks &&tracks_,
       const std::shared_ptr<Tags> &tags_,
       const SelectedRegion &selectedRegion_)
       : tracks(std::move(tracks_)), tags(tags_), selectedRegion(selectedRegion_)
    {}
 
-   std::shared_ptr<TrackList> tracks;
+   UndoTracks tracks;
    std::shared_ptr<Tags> tags;
    SelectedRegion selectedRegion; // by value
 };
@@ -153,6 +159,10 @@ class AUDACITY_DLL_API UndoManager final
    bool UndoAvailable();
    bool RedoAvailable();
 
+   // The copies of the tracks of the current state, or null if there is no
+   // state yet
+   const UndoTracks *GetCurrentTracks() const;
+
    bool UnsavedChanges() const;
    void StateSaved();
 
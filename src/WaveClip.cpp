@@ -24,7 +24,10 @@
 #include "Experimental.h"
 
 #include <math.h>
+#include <algorithm>
+#include <atomic>
 #include <functional>
+#include <mutex>
 #include <vector>
 #include <wx/log.h>
 
@@ -35,16 +38,13 @@
 #include "Resample.h"
 #include "WaveTrack.h"
 #include "Profiler.h"
+#include "ThreadPool.h"
 #include "InconsistencyException.h"
 #include "UserException.h"
 
 #include "prefs/SpectrogramSettings.h"
 #include "widgets/ProgressDialog.h"
 
-#ifdef _OPENMP
-#include <omp.h>
-#endif
-
 class WaveCache {
 public:
    WaveCache()
@@ -334,6 +334,26 @@ WaveClip::WaveClip(const WaveClip& orig,
    mIsPlaceholder = orig.GetIsPlaceholder();
 }
 
+bool WaveClip::SameStateAs(const WaveClip &other) const
+{
+   if (!(mOffset == other.mOffset &&
+         mRate == other.mRate &&
+         mColourIndex == other.mColourIndex &&
+         mIsPlaceholder == other.mIsPlaceholder &&
+         // Samples not yet flushed are not copied
+         mAppendBufferLen == 0 && other.mAppendBufferLen == 0 &&
+         mEnvelope->SameStateAs(*other.mEnvelope) &&
+         mSequence->SameBlocksAs(*other.mSequence) &&
+         mCutLines.size() == other.mCutLines.size()))
+      return false;
+
+   for (size_t ii = 0, nn = mCutLines.size(); ii < nn; ++ii)
+      if (!mCutLines[ii]->SameStateAs(*other.mCutLines[ii]))
+         return false;
+
+   return true;
+}
+
 WaveClip::WaveClip(const WaveClip& orig,
                    const std::shared_ptr<DirManager> &projDirManager,
                    bool copyCutlines,
@@ -821,12 +841,13 @@ bool SpecCache::Matches
 
 bool SpecCache::CalculateOneSpectrum
    (const SpectrogramSettings &settings,
-    WaveTrackCache &waveTrackCache,
+    SampleSource &source,
     const int xx, const sampleCount numSamples,
     double offset, double rate, double pixelsPerSecond,
     int lowerBoundX, int upperBoundX,
     const std::vector<float> &gainFactors,
-    float* __restrict scratch, float* __restrict out) const
+    float* __restrict scratch, float* __restrict out,
+    Deferred *pDeferred) const
 {
    bool result = false;
    const bool reassignment =
@@ -897,13 +918,11 @@ bool SpecCache::CalculateOneSpectrum
          }
 
          if (myLen > 0) {
-            useBuffer = (float*)(waveTrackCache.Get(
-               floatSample, sampleCount(
+            useBuffer = const_cast<float*>(source.Get(
+               sampleCount(
                   floor(0.5 + from.as_double() + offset * rate)
                ),
-               myLen,
-               // Don't throw in this drawing operation
-               false)
+               myLen)
             );
 
             if (copy) {
@@ -1008,13 +1027,11 @@ bool SpecCache::CalculateOneSpectrum
 
                   // This is non-negative, because bin and correctedX are
                   auto ind = (int)nBins * correctedX + bin;
-#ifdef _OPENMP
-                  // This assignment can race if index reaches into another thread's bins.
-                  // The probability of a race very low, so this carries little overhead,
-                  // about 5% slower vs allowing it to race.
-                  #pragma omp atomic update
-#endif
-                  out[ind] += power;
+                  if (pDeferred && (correctedX < pDeferred->beginX ||
+                                    correctedX >= pDeferred->endX))
+                     pDeferred->contributions.emplace_back(ind, power);
+                  else
+                     out[ind] += power;
                }
             }
          }
@@ -1056,6 +1073,8 @@ void SpecCache::Grow(size_t len_, const SpectrogramSettings& settings,
    // Sample counts corresponding to the columns, and to one past the end.
    where.resize(len_ + 1);
 
+   status.resize(len_, ColumnMissing);
+
    len = len_;
    algorithm = settings.algorithm;
    pps = pixelsPerSecond;
@@ -1066,11 +1085,110 @@ void SpecCache::Grow(size_t len_, const SpectrogramSettings& settings,
    frequencyGain = settings.frequencyGain;
 }
 
+namespace {
+   // Columns of the spectrogram that one task of Populate computes
+   const int ColumnsPerTask = 32;
+
+   // Reassigned power that lands farther than this many columns from those
+   // of the task is deferred
+   const int MaxReassignmentMargin = 64;
+
+   std::atomic<size_t> sMaxConcurrency{ 0 };
+
+   // Reads the track, in the same thread
+   class TrackSampleSource final : public SpecCache::SampleSource {
+   public:
+      explicit TrackSampleSource(WaveTrackCache &cache)
+         : mCache{ cache }
+      {}
+      explicit TrackSampleSource(const std::shared_ptr<const WaveTrack> &pTrack)
+         : mOwned{ std::make_unique<WaveTrackCache>(pTrack) }
+         , mCache{ *mOwned }
+      {}
+
+      std::unique_ptr<SampleSource> Clone() const override
+      {
+         return std::make_unique<TrackSampleSource>(mCache.GetTrack());
+      }
+
+      const float *Get(sampleCount start, size_t len) override
+      {
+         // Don't throw in this drawing operation
+         return (const float*)mCache.Get(floatSample, start, len, false);
+      }
+
+   private:
+      std::unique_ptr<WaveTrackCache> mOwned;
+      WaveTrackCache &mCache;
+   };
+
+   // Reads a copy of the block array of a clip, which is safe in any thread
+   // because block files never change
+   class BlocksSampleSource final : public SpecCache::SampleSource {
+   public:
+      BlocksSampleSource(std::shared_ptr<const BlockArray> pBlocks,
+         sampleCount numSamples, sampleCount clipStart)
+         : mpBlocks{ std::move(pBlocks) }
+         , mNumSamples{ numSamples }
+         , mClipStart{ clipStart }
+      {}
+
+      std::unique_ptr<SampleSource> Clone() const override
+      {
+         return std::make_unique<BlocksSampleSource>(
+            mpBlocks, mNumSamples, mClipStart);
+      }
+
+      const float *Get(sampleCount start, size_t len) override
+      {
+         mBuffer.assign(len, 0.0f);
+         // Positions in the clip
+         const auto begin = std::max<sampleCount>(0, start - mClipStart);
+         const auto end = std::min(mNumSamples, start - mClipStart + len);
+         if (begin < end)
+            Sequence::GetFromBlocks(*mpBlocks,
+               (samplePtr)&mBuffer[(begin - (start - mClipStart)).as_size_t()],
+               floatSample, begin, (end - begin).as_size_t(), false);
+         return mBuffer.data();
+      }
+
+   private:
+      const std::shared_ptr<const BlockArray> mpBlocks;
+      const sampleCount mNumSamples;
+      const sampleCount mClipStart;
+      std::vector<float> mBuffer;
+   };
+}
+
+SpecCache::SampleSource::~SampleSource() = default;
+
+SpecCache::~SpecCache()
+{
+   if (job)
+      job->Cancel();
+}
+
+void SpecCache::SetMaxConcurrency(size_t count)
+{
+   sMaxConcurrency = count;
+}
+
 void SpecCache::Populate
    (const SpectrogramSettings &settings, WaveTrackCache &waveTrackCache,
     int copyBegin, int copyEnd, size_t numPixels,
     sampleCount numSamples,
     double offset, double rate, double pixelsPerSecond)
+{
+   TrackSampleSource source{ waveTrackCache };
+   Populate(settings, source, copyBegin, copyEnd, numPixels,
+      numSamples, offset, rate, pixelsPerSecond);
+}
+
+void SpecCache::Populate
+   (const SpectrogramSettings &settings, SampleSource &source,
+    int copyBegin, int copyEnd, size_t numPixels,
+    sampleCount numSamples,
+    double offset, double rate, double pixelsPerSecond)
 {
    const int &frequencyGainSetting = settings.frequencyGain;
    const size_t windowSizeSetting = settings.WindowSize();
@@ -1097,109 +1215,390 @@ void SpecCache::Populate
    if (!autocorrelation)
       ComputeSpectrogramGainFactors(fftLen, rate, frequencyGainSetting, gainFactors);
 
+   auto &pool = ThreadPool::Get();
+   size_t concurrency = pool.GetConcurrency();
+   if (const size_t maxConcurrency = sMaxConcurrency)
+      concurrency = std::min(concurrency, maxConcurrency);
+
+   // Storage for mutable per-thread data
+   struct Worker {
+      void init(SampleSource &original, size_t scratchSize) {
+         if (!source) {
+            source = original.Clone();
+            scratch.resize(scratchSize);
+         }
+      }
+      std::unique_ptr<SampleSource> source;
+      std::vector<float> scratch;
+      Deferred deferred;
+   };
+   std::vector<Worker> workers;
+
+   const auto addDeferred = [&](Deferred &deferred) {
+      for (const auto &contribution : deferred.contributions)
+         freq[contribution.first] += contribution.second;
+      deferred.contributions.clear();
+   };
+
+   const double pixelsPerSample = pixelsPerSecond / rate;
+
+   // Time reassignment moves power at most about half a window from its
+   // column.  Tasks for chunks of columns at least twice that wide, taking
+   // turns with their neighbors, never add to the same bins at once.
+   const int margin = !reassignment ? 0 :
+      std::min(MaxReassignmentMargin,
+         (int)(0.5 + fftLen * pixelsPerSample / 2) + 1);
+   const int chunkSize = std::max(ColumnsPerTask, 2 * margin);
+
    // Loop over the ranges before and after the copied portion and compute anew.
    // One of the ranges may be empty.
    for (int jj = 0; jj < 2; ++jj) {
       const int lowerBoundX = jj == 0 ? 0 : copyEnd;
       const int upperBoundX = jj == 0 ? copyBegin : numPixels;
-
-#ifdef _OPENMP
-      // Storage for mutable per-thread data.
-      // private clause ensures one copy per thread
-      struct ThreadLocalStorage {
-         ThreadLocalStorage()  { }
-         ~ThreadLocalStorage() { }
-
-         void init(WaveTrackCache &waveTrackCache, size_t scratchSize) {
-            if (!cache) {
-               cache = std::make_unique<WaveTrackCache>(waveTrackCache.GetTrack());
-               scratch.resize(scratchSize);
-            }
+      if (lowerBoundX >= upperBoundX)
+         continue;
+
+      const int nChunks = (upperBoundX - lowerBoundX + chunkSize - 1) / chunkSize;
+      const size_t nWorkers = std::min(concurrency, (size_t)nChunks);
+      if (workers.size() < nWorkers)
+         workers.resize(nWorkers);
+
+      if (nWorkers <= 1) {
+         for (auto xx = lowerBoundX; xx < upperBoundX; ++xx)
+            CalculateOneSpectrum(
+               settings, source, xx, numSamples,
+               offset, rate, pixelsPerSecond,
+               lowerBoundX, upperBoundX,
+               gainFactors, &scratch[0], &freq[0]);
+      }
+      else {
+         // With reassignment, do even chunks, then odd ones
+         const int nPhases = reassignment ? 2 : 1;
+         for (int phase = 0; phase < nPhases; ++phase) {
+            std::atomic<int> next{ phase };
+            pool.ParallelFor(nWorkers, [&](size_t iWorker) {
+               auto &worker = workers[iWorker];
+               worker.init(source, scratchSize);
+               int chunk;
+               while ((chunk = next.fetch_add(nPhases)) < nChunks) {
+                  const int beginX = lowerBoundX + chunk * chunkSize;
+                  const int endX = std::min(upperBoundX, beginX + chunkSize);
+                  worker.deferred.beginX = beginX - margin;
+                  worker.deferred.endX = endX + margin;
+                  for (auto xx = beginX; xx < endX; ++xx)
+                     CalculateOneSpectrum(
+                        settings, *worker.source, xx, numSamples,
+                        offset, rate, pixelsPerSecond,
+                        lowerBoundX, upperBoundX,
+                        gainFactors, &worker.scratch[0], &freq[0],
+                        reassignment ? &worker.deferred : nullptr);
+               }
+            });
          }
-         std::unique_ptr<WaveTrackCache> cache;
-         std::vector<float> scratch;
-      } tls;
-
-      #pragma omp parallel for private(tls)
-#endif
-      for (auto xx = lowerBoundX; xx < upperBoundX; ++xx)
-      {
-#ifdef _OPENMP
-         tls.init(waveTrackCache, scratchSize);
-         WaveTrackCache& cache = *tls.cache;
-         float* buffer = &tls.scratch[0];
-#else
-         WaveTrackCache& cache = waveTrackCache;
-         float* buffer = &scratch[0];
-#endif
-         CalculateOneSpectrum(
-            settings, cache, xx, numSamples,
-            offset, rate, pixelsPerSecond,
-            lowerBoundX, upperBoundX,
-            gainFactors, buffer, &freq[0]);
+         for (auto &worker : workers)
+            addDeferred(worker.deferred);
       }
 
       if (reassignment) {
          // Need to look beyond the edges of the range to accumulate more
          // time reassignments.
          // I'm not sure what's a good stopping criterion?
-         auto xx = lowerBoundX;
-         const double pixelsPerSample = pixelsPerSecond / rate;
          const int limit = std::min((int)(0.5 + fftLen * pixelsPerSample), 100);
-         for (int ii = 0; ii < limit; ++ii)
-         {
-            const bool result =
-               CalculateOneSpectrum(
-                  settings, waveTrackCache, --xx, numSamples,
-                  offset, rate, pixelsPerSecond,
-                  lowerBoundX, upperBoundX,
-                  gainFactors, &scratch[0], &freq[0]);
-            if (!result)
-               break;
-         }
+         if (nWorkers <= 1) {
+            auto xx = lowerBoundX;
+            for (int ii = 0; ii < limit; ++ii)
+            {
+               const bool result =
+                  CalculateOneSpectrum(
+                     settings, source, --xx, numSamples,
+                     offset, rate, pixelsPerSecond,
+                     lowerBoundX, upperBoundX,
+                     gainFactors, &scratch[0], &freq[0]);
+               if (!result)
+                  break;
+            }
 
-         xx = upperBoundX;
-         for (int ii = 0; ii < limit; ++ii)
-         {
-            const bool result =
-               CalculateOneSpectrum(
-                  settings, waveTrackCache, xx++, numSamples,
-                  offset, rate, pixelsPerSecond,
-                  lowerBoundX, upperBoundX,
-                  gainFactors, &scratch[0], &freq[0]);
-            if (!result)
-               break;
+            xx = upperBoundX;
+            for (int ii = 0; ii < limit; ++ii)
+            {
+               const bool result =
+                  CalculateOneSpectrum(
+                     settings, source, xx++, numSamples,
+                     offset, rate, pixelsPerSecond,
+                     lowerBoundX, upperBoundX,
+                     gainFactors, &scratch[0], &freq[0]);
+               if (!result)
+                  break;
+            }
+         }
+         else {
+            // Compute a batch of columns at once, each deferring all it
+            // contributes; then add those, in order, up to the first column
+            // that contributes nothing, as the loops above would stop there
+            for (int side = 0; side < 2; ++side) {
+               int done = 0;
+               bool stop = false;
+               while (!stop && done < limit) {
+                  const int batch = std::min((int)nWorkers, limit - done);
+                  std::vector<char> results(batch);
+                  pool.ParallelFor(batch, [&](size_t ii) {
+                     auto &worker = workers[ii];
+                     worker.init(source, scratchSize);
+                     const int xx = side == 0
+                        ? lowerBoundX - 1 - (done + (int)ii)
+                        : upperBoundX + done + (int)ii;
+                     worker.deferred.beginX = worker.deferred.endX = xx;
+                     results[ii] = CalculateOneSpectrum(
+                        settings, *worker.source, xx, numSamples,
+                        offset, rate, pixelsPerSecond,
+                        lowerBoundX, upperBoundX,
+                        gainFactors, &worker.scratch[0], &freq[0],
+                        &worker.deferred);
+                  });
+                  for (int ii = 0; ii < batch; ++ii) {
+                     if (!results[ii])
+                        stop = true;
+                     if (stop)
+                        workers[ii].deferred.contributions.clear();
+                     else
+                        addDeferred(workers[ii].deferred);
+                  }
+                  done += batch;
+               }
+            }
          }
 
          // Now Convert to dB terms.  Do this only after accumulating
          // power values, which may cross columns with the time correction.
-#ifdef _OPENMP
-         #pragma omp parallel for
-#endif
-         for (xx = lowerBoundX; xx < upperBoundX; ++xx) {
-            float *const results = &freq[nBins * xx];
-            for (size_t ii = 0; ii < nBins; ++ii) {
-               float &power = results[ii];
-               if (power <= 0)
-                  power = -160.0;
-               else
-                  power = 10.0*log10f(power);
-            }
-            if (!gainFactors.empty()) {
-               // Apply a frequency-dependant gain factor
-               for (size_t ii = 0; ii < nBins; ++ii)
-                  results[ii] += gainFactors[ii];
+         const auto toDB = [&](size_t chunk) {
+            const int beginX = lowerBoundX + (int)chunk * chunkSize;
+            const int endX = std::min(upperBoundX, beginX + chunkSize);
+            for (auto xx = beginX; xx < endX; ++xx) {
+               float *const results = &freq[nBins * xx];
+               for (size_t ii = 0; ii < nBins; ++ii) {
+                  float &power = results[ii];
+                  if (power <= 0)
+                     power = -160.0;
+                  else
+                     power = 10.0*log10f(power);
+               }
+               if (!gainFactors.empty()) {
+                  // Apply a frequency-dependant gain factor
+                  for (size_t ii = 0; ii < nBins; ++ii)
+                     results[ii] += gainFactors[ii];
+               }
             }
-         }
+         };
+         pool.ParallelFor(nChunks, toDB, nWorkers);
+      }
+   }
+}
+
+namespace {
+   // The coarse image computes one column of so many
+   const size_t CoarseHop = 8;
+
+   // Compute a coarse image first only if at least so many columns are
+   // missing
+   const size_t MinCoarseColumns = 64;
+
+   // Columns that a job computes between checks for cancellation
+   const int ColumnsPerPiece = 256;
+
+   std::atomic<unsigned> sSpectrogramProgress{ 0 };
+}
+
+/// Computes the columns of a SpecCache that are not ready, on the
+/// application's thread pool, into caches of its own, from which the main
+/// thread merges them.
+class SpecJob final : public std::enable_shared_from_this<SpecJob>
+{
+public:
+   SpecJob(const SpectrogramSettings &settings, const SpecCache &cache,
+      std::shared_ptr<const BlockArray> pBlocks,
+      sampleCount numSamples, sampleCount clipStart,
+      double offset, double rate);
+
+   bool Idle() const { return mRuns.empty(); }
+   void Start();
+   void Cancel() { mCancelled = true; }
+   bool Finished() const;
+
+   // Copy into the cache the columns computed better than it has them;
+   // returns whether there were any
+   bool Merge(SpecCache &cache);
+
+private:
+   void Run();
+   void Publish(int begin, int end, SpecCache::ColumnStatus status);
+
+   const SpectrogramSettings mSettings;
+   BlocksSampleSource mSource;
+   const sampleCount mNumSamples;
+   const double mOffset;
+   const double mRate;
+   const double mPps;
+   const size_t mNBins;
+
+   SpecCache mFine;
+   SpecCache mCoarse;
+   // Columns not ready, as [begin, end)
+   std::vector<std::pair<int, int>> mRuns;
+   bool mDoCoarse{ false };
+
+   std::atomic<bool> mCancelled{ false };
+
+   mutable std::mutex mMutex;
+   // Guarded by mMutex
+   std::vector<unsigned char> mPublished;
+   bool mFinished{ false };
+};
+
+SpecJob::SpecJob(const SpectrogramSettings &settings, const SpecCache &cache,
+   std::shared_ptr<const BlockArray> pBlocks,
+   sampleCount numSamples, sampleCount clipStart,
+   double offset, double rate)
+   : mSettings{ settings }
+   , mSource{ std::move(pBlocks), numSamples, clipStart }
+   , mNumSamples{ numSamples }
+   , mOffset{ offset }
+   , mRate{ rate }
+   , mPps{ cache.pps }
+   , mNBins{ settings.NBins() }
+   , mPublished{ cache.status }
+{
+   // Grow caches the windows, in this thread
+   const auto len = cache.len;
+   mFine.Grow(len, mSettings, cache.pps, cache.start);
+   mFine.where = cache.where;
+
+   size_t nMissing = 0;
+   for (size_t xx = 0; xx < len;) {
+      if (cache.status[xx] == SpecCache::ColumnReady) {
+         ++xx;
+         continue;
+      }
+      auto end = xx;
+      for (; end < len && cache.status[end] != SpecCache::ColumnReady; ++end)
+         if (cache.status[end] == SpecCache::ColumnMissing)
+            ++nMissing;
+      mRuns.emplace_back(xx, end);
+      xx = end;
+   }
+
+   // Time reassignment of a coarse column would scatter its power thinly
+   mDoCoarse = nMissing >= MinCoarseColumns &&
+      settings.algorithm != SpectrogramSettings::algReassignment;
+   if (mDoCoarse) {
+      const auto coarseLen = (len + CoarseHop - 1) / CoarseHop;
+      mCoarse.Grow(coarseLen, mSettings, cache.pps / CoarseHop, cache.start);
+      // Each coarse column stands for the middle of its fine columns
+      for (size_t kk = 0; kk <= coarseLen; ++kk)
+         mCoarse.where[kk] =
+            cache.where[std::min(kk * CoarseHop + CoarseHop / 2, len)];
+   }
+}
+
+void SpecJob::Start()
+{
+   auto self = shared_from_this();
+   ThreadPool::Get().Schedule([self]{ self->Run(); });
+}
+
+bool SpecJob::Finished() const
+{
+   std::lock_guard<std::mutex> lock{ mMutex };
+   return mFinished;
+}
+
+bool SpecJob::Merge(SpecCache &cache)
+{
+   std::lock_guard<std::mutex> lock{ mMutex };
+   bool result = false;
+   for (size_t xx = 0; xx < mPublished.size(); ++xx) {
+      const auto status = mPublished[xx];
+      if (status <= cache.status[xx])
+         continue;
+      const float *const column = status == SpecCache::ColumnReady
+         ? &mFine.freq[mNBins * xx]
+         : &mCoarse.freq[mNBins * std::min(xx / CoarseHop, mCoarse.len - 1)];
+      std::copy(column, column + mNBins, &cache.freq[mNBins * xx]);
+      cache.status[xx] = status;
+      result = true;
+   }
+   return result;
+}
+
+void SpecJob::Publish(int begin, int end, SpecCache::ColumnStatus status)
+{
+   {
+      std::lock_guard<std::mutex> lock{ mMutex };
+      for (auto xx = begin; xx < end; ++xx)
+         mPublished[xx] = std::max<unsigned char>(mPublished[xx], status);
+   }
+   ++sSpectrogramProgress;
+}
+
+void SpecJob::Run()
+{
+   // Finish even if cancelled or failed, so that the main thread lets go.
+   // Only success counts as progress; the columns a failure leaves stay
+   // silent until the cache is invalidated
+   bool completed = false;
+   auto cleanup = finally([this, &completed]{
+      {
+         std::lock_guard<std::mutex> lock{ mMutex };
+         mFinished = true;
+      }
+      if (completed)
+         ++sSpectrogramProgress;
+   });
+
+   if (mDoCoarse) {
+      for (const auto &run : mRuns) {
+         if (mCancelled)
+            return;
+         // Compute coarse columns [begin, end) only
+         mCoarse.Populate(mSettings, mSource,
+            0, run.first / CoarseHop, (run.second + CoarseHop - 1) / CoarseHop,
+            mNumSamples, mOffset, mRate, mPps / CoarseHop);
       }
+      for (const auto &run : mRuns)
+         Publish(run.first, run.second, SpecCache::ColumnCoarse);
    }
+
+   // Time reassignment crosses columns, so compute each run at once, as
+   // GetSpectrogram would
+   const bool reassignment =
+      mSettings.algorithm == SpectrogramSettings::algReassignment;
+   for (const auto &run : mRuns) {
+      for (auto begin = run.first; begin < run.second;) {
+         if (mCancelled)
+            return;
+         const auto end = reassignment
+            ? run.second
+            : std::min(run.second, begin + ColumnsPerPiece);
+         mFine.Populate(mSettings, mSource,
+            0, begin, end,
+            mNumSamples, mOffset, mRate, mPps);
+         Publish(begin, end, SpecCache::ColumnReady);
+         begin = end;
+      }
+   }
+   completed = true;
+}
+
+unsigned WaveClip::GetSpectrogramProgress()
+{
+   return sSpectrogramProgress;
 }
 
 bool WaveClip::GetSpectrogram(WaveTrackCache &waveTrackCache,
                               const float *& spectrogram,
                               const sampleCount *& where,
                               size_t numPixels,
-                              double t0, double pixelsPerSecond) const
+                              double t0, double pixelsPerSecond,
+                              bool inBackground) const
 {
    const WaveTrack *const track = waveTrackCache.GetTrack().get();
    const SpectrogramSettings &settings = track->GetSpectrogramSettings();
@@ -1210,13 +1609,32 @@ bool WaveClip::GetSpectrogram(WaveTrackCache &waveTrackCache,
       mSpecCache->Matches
       (mDirty, pixelsPerSecond, settings, mRate);
 
+   // Take what was computed in the background, before the columns move
+   bool merged = false;
+   if (match && mSpecCache->job) {
+      auto &job = mSpecCache->job;
+      const bool finished = job->Finished();
+      merged = job->Merge(*mSpecCache);
+      if (finished)
+         job.reset();
+   }
+
    if (match &&
        mSpecCache->start == t0 &&
        mSpecCache->len >= numPixels) {
-      spectrogram = &mSpecCache->freq[0];
-      where = &mSpecCache->where[0];
-
-      return false;  //hit cache completely
+      const auto &status = mSpecCache->status;
+      const bool ready = std::all_of(status.begin(), status.end(),
+         [](unsigned char value){ return value == SpecCache::ColumnReady; });
+      // After a failed job, no other starts until an edit, a zoom or new
+      // settings invalidate the cache, below
+      if (ready)
+         mSpecCache->job.reset();
+      if (ready || inBackground) {
+         spectrogram = &mSpecCache->freq[0];
+         where = &mSpecCache->where[0];
+
+         return merged;  //hit cache completely
+      }
    }
 
    // Caching is not implemented for reassignment, unless for
@@ -1254,11 +1672,28 @@ bool WaveClip::GetSpectrogram(WaveTrackCache &waveTrackCache,
       copyEnd = std::min((int)numPixels, std::max(0,
          (int)mSpecCache->len - oldX0
       ));
+
+      // Computing in this thread, copy only what is ready
+      const auto &status = mSpecCache->status;
+      if (!inBackground && copyEnd > copyBegin &&
+          !std::all_of(
+             status.begin() + (copyBegin + oldX0),
+             status.begin() + (copyEnd + oldX0),
+             [](unsigned char value){
+                return value == SpecCache::ColumnReady; }))
+         copyBegin = copyEnd = 0;
+   }
+
+   // The job computes columns that are about to move
+   if (mSpecCache->job) {
+      mSpecCache->job->Cancel();
+      mSpecCache->job.reset();
    }
 
    // Resize the cache, keep the contents unchanged.
    mSpecCache->Grow(numPixels, settings, pixelsPerSecond, t0);
    auto nBins = settings.NBins();
+   auto &status = mSpecCache->status;
 
    // Optimization: if the old cache is good and overlaps
    // with the current one, re-use as much of the cache as
@@ -1269,7 +1704,13 @@ bool WaveClip::GetSpectrogram(WaveTrackCache &waveTrackCache,
       memmove(&mSpecCache->freq[nBins * copyBegin],
                &mSpecCache->freq[nBins * (copyBegin + oldX0)],
                nBins * (copyEnd - copyBegin) * sizeof(float));
+      memmove(&status[copyBegin], &status[copyBegin + oldX0],
+               (copyEnd - copyBegin) * sizeof(status[0]));
    }
+   std::fill(status.begin(), status.begin() + std::max(0, copyBegin),
+      SpecCache::ColumnMissing);
+   std::fill(status.begin() + std::max(copyBegin, copyEnd), status.end(),
+      SpecCache::ColumnMissing);
 
    // Reassignment accumulates, so it needs a zeroed buffer
    if (settings.algorithm == SpectrogramSettings::algReassignment)
@@ -1294,10 +1735,31 @@ bool WaveClip::GetSpectrogram(WaveTrackCache &waveTrackCache,
    fillWhere(mSpecCache->where, numPixels, 0.5, correction,
       t0, mRate, samplesPerPixel);
 
-   mSpecCache->Populate
-      (settings, waveTrackCache, copyBegin, copyEnd, numPixels,
-       mSequence->GetNumSamples(),
-       mOffset, mRate, pixelsPerSecond);
+   if (!inBackground) {
+      mSpecCache->Populate
+         (settings, waveTrackCache, copyBegin, copyEnd, numPixels,
+          mSequence->GetNumSamples(),
+          mOffset, mRate, pixelsPerSecond);
+      std::fill(status.begin(), status.end(), SpecCache::ColumnReady);
+   }
+   else {
+      // Show silence where there is nothing yet, not stale data
+      for (size_t xx = 0; xx < numPixels; ++xx)
+         if (status[xx] == SpecCache::ColumnMissing)
+            std::fill(&mSpecCache->freq[nBins * xx],
+               &mSpecCache->freq[nBins * (xx + 1)], -160.0f);
+
+      // Compute the columns that are not ready on other threads.
+      // The block files never change, so a copy of the block array can be
+      // read in other threads while this clip is edited
+      auto job = std::make_shared<SpecJob>(settings, *mSpecCache,
+         std::make_shared<const BlockArray>(mSequence->GetBlockArray()),
+         mSequence->GetNumSamples(), GetStartSample(), mOffset, mRate);
+      if (!job->Idle()) {
+         job->Start();
+         mSpecCache->job = std::move(job);
+      }
+   }
 
    mSpecCache->dirty = mDirty;
    spectrogram = &mSpecCache->freq[0];
@@ -1348,6 +1810,26 @@ float WaveClip::GetRMS(double t0, double t1, bool mayThrow) const
    return mSequence->GetRMS(s0, s1-s0, mayThrow);
 }
 
+SampleStatistics WaveClip::GetStatistics(
+   double t0, double t1, bool mayThrow) const
+{
+   if (t0 > t1) {
+      if (mayThrow)
+         THROW_INCONSISTENCY_EXCEPTION;
+      return {};
+   }
+
+   if (t0 == t1)
+      return {};
+
+   sampleCount s0, s1;
+
+   TimeToSamplesClip(t0, &s0);
+   TimeToSamplesClip(t1, &s1);
+
+   return mSequence->GetStatistics(s0, s1-s0, mayThrow);
+}
+
 void WaveClip::ConvertToSampleFormat(sampleFormat format)
 {
    // Note:  it is not necessary to do this recursively to cutlines.
@@ -22,6 +22,7 @@
 
 #include <wx/longlong.h>
 
+#include <utility>
 #include <vector>
 
 class BlockArray;
@@ -32,6 +33,7 @@ class Envelope;
 class ProgressDialog;
 class Sequence;
 class SpectrogramSettings;
+class SpecJob;
 class WaveCache;
 class WaveTrackCache;
 class wxFileNameWrapper;
@@ -39,6 +41,26 @@ class wxFileNameWrapper;
 class SpecCache {
 public:
 
+   // Where Populate reads the samples of the track, at positions in the
+   // track
+   class SampleSource {
+   public:
+      virtual ~SampleSource();
+      // Another source of the same samples, for use on another thread
+      virtual std::unique_ptr<SampleSource> Clone() const = 0;
+      // The samples, or null if they cannot be read; valid until the next
+      // call
+      virtual const float *Get(sampleCount start, size_t len) = 0;
+   };
+
+   // How far a column is computed, when the cache is populated in the
+   // background
+   enum ColumnStatus : unsigned char {
+      ColumnMissing,
+      ColumnCoarse,
+      ColumnReady,
+   };
+
    // Make invalid cache
    SpecCache()
       : algorithm(-1)
@@ -50,34 +72,52 @@ public:
    {
    }
 
-   ~SpecCache()
-   {
-   }
+   // Cancels the job populating this cache in the background, if any
+   ~SpecCache();
 
    bool Matches(int dirty_, double pixelsPerSecond,
       const SpectrogramSettings &settings, double rate) const;
 
+   // Reassigned power that a column contributes outside of [beginX, endX),
+   // as pairs of index into freq and power, to be added later, so that
+   // threads computing columns far apart never add to the same bins
+   struct Deferred {
+      int beginX{ 0 }, endX{ 0 };
+      std::vector< std::pair< size_t, float > > contributions;
+   };
+
    // Calculate one column of the spectrum
    bool CalculateOneSpectrum
       (const SpectrogramSettings &settings,
-       WaveTrackCache &waveTrackCache,
+       SampleSource &source,
        const int xx, sampleCount numSamples,
        double offset, double rate, double pixelsPerSecond,
        int lowerBoundX, int upperBoundX,
        const std::vector<float> &gainFactors,
        float* __restrict scratch,
-       float* __restrict out) const;
+       float* __restrict out,
+       Deferred *pDeferred = nullptr) const;
 
    // Grow the cache while preserving the (possibly now invalid!) contents
    void Grow(size_t len_, const SpectrogramSettings& settings,
                double pixelsPerSecond, double start_);
 
-   // Calculate the dirty columns at the begin and end of the cache
+   // For benchmarks: the most threads that Populate may use, or 0 for all
+   // that the application's thread pool has.  Thread-safe.
+   static void SetMaxConcurrency(size_t count);
+
+   // Calculate the dirty columns at the begin and end of the cache, on the
+   // threads of the application's thread pool
    void Populate
       (const SpectrogramSettings &settings, WaveTrackCache &waveTrackCache,
        int copyBegin, int copyEnd, size_t numPixels,
        sampleCount numSamples,
        double offset, double rate, double pixelsPerSecond);
+   void Populate
+      (const SpectrogramSettings &settings, SampleSource &source,
+       int copyBegin, int copyEnd, size_t numPixels,
+       sampleCount numSamples,
+       double offset, double rate, double pixelsPerSecond);
 
    size_t       len { 0 }; // counts pixels, not samples
    int          algorithm;
@@ -89,8 +129,13 @@ public:
    int          frequencyGain;
    std::vector<float> freq;
    std::vector<sampleCount> where;
+   // ColumnStatus of each column
+   std::vector<unsigned char> status;
 
    int          dirty;
+
+   // Computes the columns that are not ready, if not null
+   std::shared_ptr<SpecJob> job;
 };
 
 class SpecPxCache {
@@ -198,6 +243,10 @@ public:
 
    virtual ~WaveClip();
 
+   // Whether the other is interchangeable with a copy of this, including
+   // cut lines, sharing the same block files
+   bool SameStateAs(const WaveClip &other) const;
+
    void ConvertToSampleFormat(sampleFormat format);
 
    // Always gives non-negative answer, not more than sample sequence length
@@ -258,14 +307,23 @@ public:
     * calculations and Contrast */
    bool GetWaveDisplay(WaveDisplay &display,
                        double t0, double pixelsPerSecond, bool &isLoadingOD) const;
+   /** If inBackground, columns that are not cached are computed in the
+    * background, first coarsely; columns not yet computed are silent.  Call
+    * again to take what has been computed since, when
+    * GetSpectrogramProgress() changes. */
    bool GetSpectrogram(WaveTrackCache &cache,
                        const float *& spectrogram,
                        const sampleCount *& where,
                        size_t numPixels,
-                       double t0, double pixelsPerSecond) const;
+                       double t0, double pixelsPerSecond,
+                       bool inBackground = false) const;
+   /** Changes whenever spectrograms computed in the background progress */
+   static unsigned GetSpectrogramProgress();
    std::pair<float, float> GetMinMax(
       double t0, double t1, bool mayThrow = true) const;
    float GetRMS(double t0, double t1, bool mayThrow = true) const;
+   SampleStatistics GetStatistics(
+      double t0, double t1, bool mayThrow = true) const;
 
    // Set/clear/get rectangle that this WaveClip fills on screen. This is
    // called by TrackArtist while actually drawing the tracks and clips.
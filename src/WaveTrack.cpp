@@ -326,6 +326,48 @@ Track::Holder WaveTrack::Clone() const
    return std::make_shared<WaveTrack>( *this );
 }
 
+bool WaveTrack::SameStateAs(const Track &other) const
+{
+   const auto pOther = dynamic_cast<const WaveTrack*>(&other);
+   if (!pOther || !SameCommonStateAs(other))
+      return false;
+   const auto &wt = *pOther;
+
+   // What Init() copies
+   if (!(GetMute() == wt.GetMute() &&
+         GetSolo() == wt.GetSolo() &&
+         mFormat == wt.mFormat &&
+         mWaveColorIndex == wt.mWaveColorIndex &&
+         mRate == wt.mRate &&
+         mGain == wt.mGain &&
+         mPan == wt.mPan &&
+         mDisplayMin == wt.mDisplayMin &&
+         mDisplayMax == wt.mDisplayMax &&
+         mSpectrumMin == wt.mSpectrumMin &&
+         mSpectrumMax == wt.mSpectrumMax))
+      return false;
+
+   // Independent display settings; spectrogram settings are not worth
+   // comparing field by field
+   if (mpSpectrumSettings || wt.mpSpectrumSettings)
+      return false;
+   if (!mpWaveformSettings || !wt.mpWaveformSettings) {
+      if (mpWaveformSettings || wt.mpWaveformSettings)
+         return false;
+   }
+   else if (mpWaveformSettings->scaleType != wt.mpWaveformSettings->scaleType ||
+            mpWaveformSettings->dBRange != wt.mpWaveformSettings->dBRange)
+      return false;
+
+   if (mClips.size() != wt.mClips.size())
+      return false;
+   for (size_t ii = 0, nn = mClips.size(); ii < nn; ++ii)
+      if (!mClips[ii]->SameStateAs(*wt.mClips[ii]))
+         return false;
+
+   return true;
+}
+
 double WaveTrack::GetRate() const
 {
    return mRate;
@@ -1854,6 +1896,53 @@ float WaveTrack::GetRMS(double t0, double t1, bool mayThrow) const
    return length > 0 ? sqrt(sumsq / length.as_double()) : 0.0;
 }
 
+SampleStatistics WaveTrack::GetStatistics(
+   double t0, double t1, bool mayThrow) const
+{
+   if (t0 > t1) {
+      if (mayThrow)
+         THROW_INCONSISTENCY_EXCEPTION;
+      return {};
+   }
+
+   SampleStatistics results;
+   if (t0 == t1)
+      return results;
+
+   for (const auto &clip: mClips)
+   {
+      // As in GetRMS
+      if (t1 >= clip->GetStartTime() && t0 <= clip->GetEndTime())
+         results.Merge(clip->GetStatistics(t0, t1, mayThrow));
+   }
+
+   return results;
+}
+
+SampleStatistics WaveTrack::GetStatistics(
+   sampleCount start, sampleCount len, bool mayThrow) const
+{
+   SampleStatistics results;
+   const auto end = start + len;
+
+   for (const auto &clip: mClips)
+   {
+      auto clipStart = clip->GetStartSample();
+      auto clipEnd = clip->GetEndSample();
+
+      if (clipEnd > start && clipStart < end)
+      {
+         // Clip sample region and requested region overlap
+         auto s0 = std::max(start, clipStart);
+         auto s1 = std::min(end, clipEnd);
+         results.Merge(clip->GetSequence()->GetStatistics(
+            s0 - clipStart, s1 - s0, mayThrow));
+      }
+   }
+
+   return results;
+}
+
 bool WaveTrack::Get(samplePtr buffer, sampleFormat format,
                     sampleCount start, size_t len, fillFormat fill,
                     bool mayThrow, sampleCount * pNumCopied) const
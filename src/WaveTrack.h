@@ -91,6 +91,8 @@ private:
 
    virtual ~WaveTrack();
 
+   bool SameStateAs(const Track &other) const override;
+
    double GetOffset() const override;
    void SetOffset(double o) override;
    virtual ChannelType GetChannelIgnoringPan() const;
@@ -251,6 +253,14 @@ private:
       double t0, double t1, bool mayThrow = true) const;
    // May assume precondition: t0 <= t1
    float GetRMS(double t0, double t1, bool mayThrow = true) const;
+   // Peak, RMS, DC offset and clipping of the clips between the times, or
+   // of the samples from start, found from block statistics wherever a
+   // range covers whole blocks.  Gaps between clips are not counted.
+   // May assume precondition: t0 <= t1
+   SampleStatistics GetStatistics(
+      double t0, double t1, bool mayThrow = true) const;
+   SampleStatistics GetStatistics(
+      sampleCount start, sampleCount len, bool mayThrow = true) const;
 
    //
    // MM: We now have more than one sequence and envelope per track, so
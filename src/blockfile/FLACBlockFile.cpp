@@ -0,0 +1,621 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  FLACBlockFile.cpp
+
+*******************************************************************//**
+
+\class FLACBlockFile
+\brief A BlockFile that stores samples losslessly compressed with libFLAC
+
+  The disk file is an ordinary FLAC stream of one channel.  An application
+  metadata block holds the summary data, and a seek table allows reading
+  parts of the block without decoding all of it.
+
+  FLAC stores integers of up to 24 bits, so only blocks of 16 or 24 bit
+  samples, or of float samples that are exactly such integers, can be
+  stored this way.  That covers recordings and imports that have not yet
+  been processed.  Other blocks remain SimpleBlockFiles.
+
+  Projects using these blocks cannot be opened by versions of Audacity
+  that do not know them, so they are made only if the preference
+  "/Directories/CompressBlockFiles" is set.
+
+*//*******************************************************************/
+
+#include "../Audacity.h" // for USE_* macros
+
+#ifdef USE_LIBFLAC
+#include "FLACBlockFile.h"
+
+#include <float.h>
+#include <math.h>
+#include <string.h>
+#include <vector>
+
+#include <wx/ffile.h>
+#include <wx/log.h>
+
+#include "FLAC++/decoder.h"
+#include "FLAC++/encoder.h"
+
+#include "../DirManager.h"
+#include "../FileException.h"
+#include "../Internat.h"
+#include "../Prefs.h"
+#include "../xml/XMLTagHandler.h"
+#include "../xml/XMLWriter.h"
+
+namespace {
+
+const wxChar *CompressBlockFilesKey = wxT("/Directories/CompressBlockFiles");
+
+// Identifies the metadata block holding the summary
+const FLAC__byte SummaryId[] = { 'A', 'u', 'd', 's' };
+
+// A middle setting; decoding speed hardly depends on it
+const unsigned CompressionLevel = 5;
+
+// The seek table has a point for each this many samples
+const unsigned SeekPointSpacing = 16384;
+
+// The sample rate is not meaningful, but FLAC requires one
+const unsigned SampleRate = 44100;
+
+// Collects the encoded stream in memory, so the file is written at once
+class MemoryEncoder final : public FLAC::Encoder::Stream
+{
+public:
+   std::vector< FLAC__byte > mBytes;
+
+protected:
+   ::FLAC__StreamEncoderWriteStatus write_callback(
+      const FLAC__byte buffer[], size_t bytes, unsigned, unsigned ) override
+   {
+      if ( mPosition + bytes > mBytes.size() )
+         mBytes.resize( mPosition + bytes );
+      memcpy( mBytes.data() + mPosition, buffer, bytes );
+      mPosition += bytes;
+      return FLAC__STREAM_ENCODER_WRITE_STATUS_OK;
+   }
+
+   // Seeking lets the encoder complete the stream info and seek table
+   ::FLAC__StreamEncoderSeekStatus seek_callback(
+      FLAC__uint64 absolute_byte_offset ) override
+   {
+      if ( absolute_byte_offset > mBytes.size() )
+         return FLAC__STREAM_ENCODER_SEEK_STATUS_ERROR;
+      mPosition = absolute_byte_offset;
+      return FLAC__STREAM_ENCODER_SEEK_STATUS_OK;
+   }
+
+   ::FLAC__StreamEncoderTellStatus tell_callback(
+      FLAC__uint64 *absolute_byte_offset ) override
+   {
+      *absolute_byte_offset = mPosition;
+      return FLAC__STREAM_ENCODER_TELL_STATUS_OK;
+   }
+
+private:
+   size_t mPosition{ 0 };
+};
+
+// Decodes a range of samples from a stream in memory
+class MemoryDecoder final : public FLAC::Decoder::Stream
+{
+public:
+   MemoryDecoder( const char *bytes, size_t size,
+      samplePtr data, sampleFormat format, size_t start, size_t len )
+      : mBytes{ bytes }, mSize{ size }
+      , mData{ data }, mFormat{ format }, mStart{ start }, mLen{ len }
+   {}
+
+   size_t GetDone() const { return mDone; }
+   bool IsDone() const { return mDone == mLen || mFailed; }
+
+protected:
+   ::FLAC__StreamDecoderReadStatus read_callback(
+      FLAC__byte buffer[], size_t *bytes ) override
+   {
+      const auto count = std::min( *bytes, mSize - mPosition );
+      memcpy( buffer, mBytes + mPosition, count );
+      mPosition += count;
+      *bytes = count;
+      return count
+         ? FLAC__STREAM_DECODER_READ_STATUS_CONTINUE
+         : FLAC__STREAM_DECODER_READ_STATUS_END_OF_STREAM;
+   }
+
+   ::FLAC__StreamDecoderSeekStatus seek_callback(
+      FLAC__uint64 absolute_byte_offset ) override
+   {
+      if ( absolute_byte_offset > mSize )
+         return FLAC__STREAM_DECODER_SEEK_STATUS_ERROR;
+      mPosition = absolute_byte_offset;
+      return FLAC__STREAM_DECODER_SEEK_STATUS_OK;
+   }
+
+   ::FLAC__StreamDecoderTellStatus tell_callback(
+      FLAC__uint64 *absolute_byte_offset ) override
+   {
+      *absolute_byte_offset = mPosition;
+      return FLAC__STREAM_DECODER_TELL_STATUS_OK;
+   }
+
+   ::FLAC__StreamDecoderLengthStatus length_callback(
+      FLAC__uint64 *stream_length ) override
+   {
+      *stream_length = mSize;
+      return FLAC__STREAM_DECODER_LENGTH_STATUS_OK;
+   }
+
+   bool eof_callback() override
+   {
+      return mPosition >= mSize;
+   }
+
+   ::FLAC__StreamDecoderWriteStatus write_callback(
+      const ::FLAC__Frame *frame, const FLAC__int32 * const buffer[] ) override
+   {
+      // The decoder gives sample numbers, not frame numbers, to this callback
+      const auto first = frame->header.number.sample_number;
+      const auto next = mStart + mDone;
+      const auto end = first + frame->header.blocksize;
+      if ( next < first || next >= end )
+         return FLAC__STREAM_DECODER_WRITE_STATUS_CONTINUE;
+
+      const auto src = buffer[0] + ( next - first );
+      const auto count =
+         std::min< FLAC__uint64 >( end - next, mLen - mDone );
+      const auto bits = frame->header.bits_per_sample;
+      switch ( mFormat ) {
+         case floatSample: {
+            const auto dst = reinterpret_cast< float* >( mData ) + mDone;
+            const float scale = 1.0f / ( 1 << ( bits - 1 ) );
+            for ( size_t ii = 0; ii < count; ++ii )
+               dst[ii] = src[ii] * scale;
+            break;
+         }
+         case int24Sample: {
+            const auto dst = reinterpret_cast< int* >( mData ) + mDone;
+            const auto shift = 24 - bits;
+            for ( size_t ii = 0; ii < count; ++ii )
+               dst[ii] = src[ii] << shift;
+            break;
+         }
+         case int16Sample:
+         default: {
+            // Truncates 24 bits, as libsndfile does for SimpleBlockFile
+            const auto dst = reinterpret_cast< short* >( mData ) + mDone;
+            const auto shift = bits - 16;
+            for ( size_t ii = 0; ii < count; ++ii )
+               dst[ii] = src[ii] >> shift;
+            break;
+         }
+      }
+      mDone += count;
+      return FLAC__STREAM_DECODER_WRITE_STATUS_CONTINUE;
+   }
+
+   void error_callback( ::FLAC__StreamDecoderErrorStatus ) override
+   {
+      mFailed = true;
+   }
+
+private:
+   const char *const mBytes;
+   const size_t mSize;
+   size_t mPosition{ 0 };
+
+   const samplePtr mData;
+   const sampleFormat mFormat;
+   const size_t mStart;
+   const size_t mLen;
+   size_t mDone{ 0 };
+   bool mFailed{ false };
+};
+
+// Finds the summary in the metadata blocks that follow the stream marker
+bool FindSummary( wxFFile &file, size_t summaryBytes )
+{
+   char marker[4];
+   if ( file.Read( marker, 4 ) != 4 || memcmp( marker, "fLaC", 4 ) )
+      return false;
+   while ( true ) {
+      FLAC__byte header[4];
+      if ( file.Read( header, 4 ) != 4 )
+         return false;
+      const bool last = header[0] & 0x80;
+      const auto type = header[0] & 0x7f;
+      const wxFileOffset length =
+         ( header[1] << 16 ) | ( header[2] << 8 ) | header[3];
+      if ( type == FLAC__METADATA_TYPE_APPLICATION &&
+           length == wxFileOffset( sizeof(SummaryId) + summaryBytes ) ) {
+         FLAC__byte id[ sizeof(SummaryId) ];
+         if ( file.Read( id, sizeof(id) ) != sizeof(id) )
+            return false;
+         if ( !memcmp( id, SummaryId, sizeof(id) ) )
+            return true;
+         if ( !file.Seek( length - sizeof(id), wxFromCurrent ) )
+            return false;
+      }
+      else if ( !file.Seek( length, wxFromCurrent ) )
+         return false;
+      if ( last )
+         return false;
+   }
+}
+
+}
+
+/// Constructs a FLACBlockFile based on sample data and writes
+/// it to disk.
+///
+/// @param baseFileName  The filename to use, but without an extension.
+///                      This constructor will add the .flac extension.
+/// @param sampleData    The sample data to be written to this block.
+/// @param sampleLen     The number of samples to be written to this block.
+/// @param format        The format of the given samples.
+/// @param bitsPerSample 16 or 24, as found by GetLosslessBits()
+FLACBlockFile::FLACBlockFile(wxFileNameWrapper &&baseFileName,
+                             samplePtr sampleData, size_t sampleLen,
+                             sampleFormat format, unsigned bitsPerSample):
+   BlockFile {
+      (baseFileName.SetExt(wxT("flac")), std::move(baseFileName)),
+      sampleLen
+   },
+   mBitsPerSample{ bitsPerSample }
+{
+   ArrayOf<char> cleanup;
+   auto summaryData = CalcSummary(sampleData, sampleLen, format, cleanup);
+   if (!WriteFLACBlockFile(sampleData, sampleLen, format, summaryData))
+      throw FileException{
+         FileException::Cause::Write, mFileName };
+}
+
+/// Construct a FLACBlockFile memory structure that will point to an
+/// existing block file.  This file must exist and be a valid block file.
+///
+/// @param existingFile The disk file this FLACBlockFile should use.
+FLACBlockFile::FLACBlockFile(wxFileNameWrapper &&existingFile, size_t len,
+                             float min, float max, float rms,
+                             unsigned bitsPerSample):
+   BlockFile{ std::move(existingFile), len },
+   mBitsPerSample{ bitsPerSample }
+{
+   mMin = min;
+   mMax = max;
+   mRMS = rms;
+}
+
+FLACBlockFile::~FLACBlockFile()
+{
+}
+
+bool FLACBlockFile::IsEnabled()
+{
+   bool compress = false;
+   gPrefs->Read(CompressBlockFilesKey, &compress, false);
+   return compress;
+}
+
+unsigned FLACBlockFile::GetLosslessBits(samplePtr sampleData,
+                                        size_t sampleLen, sampleFormat format)
+{
+   switch (format) {
+      case int16Sample:
+         return 16;
+      case int24Sample: {
+         auto samples = reinterpret_cast<const int *>(sampleData);
+         for (size_t ii = 0; ii < sampleLen; ++ii)
+            if (samples[ii] < -(1 << 23) || samples[ii] >= (1 << 23))
+               return 0;
+         return 24;
+      }
+      case floatSample: {
+         // Each sample must be a whole number of 24 bit steps in [-1, 1)
+         auto samples = reinterpret_cast<const float *>(sampleData);
+         bool fits16 = true;
+         for (size_t ii = 0; ii < sampleLen; ++ii) {
+            const float value = samples[ii] * float(1 << 23);
+            if (!(value >= -float(1 << 23) && value < float(1 << 23)) ||
+                value != floorf(value))
+               return 0;
+            fits16 = fits16 && fmodf(value, 256.0f) == 0;
+         }
+         return fits16 ? 16 : 24;
+      }
+      default:
+         return 0;
+   }
+}
+
+bool FLACBlockFile::WriteFLACBlockFile(
+    samplePtr sampleData,
+    size_t sampleLen,
+    sampleFormat format,
+    const void* summaryData)
+{
+   // The metadata blocks, which the encoder does not take ownership of
+   struct MetadataDeleter { void operator () (FLAC__StreamMetadata *p) const
+      { if (p) ::FLAC__metadata_object_delete(p); } };
+   using Metadata = std::unique_ptr<FLAC__StreamMetadata, MetadataDeleter>;
+
+   Metadata summary{
+      ::FLAC__metadata_object_new(FLAC__METADATA_TYPE_APPLICATION) };
+   Metadata seekTable{
+      ::FLAC__metadata_object_new(FLAC__METADATA_TYPE_SEEKTABLE) };
+   if (!summary || !seekTable)
+      return false;
+   memcpy(summary->data.application.id, SummaryId, sizeof(SummaryId));
+   if (!::FLAC__metadata_object_application_set_data(summary.get(),
+         (FLAC__byte *)summaryData, mSummaryInfo.totalSummaryBytes, true) ||
+       !::FLAC__metadata_object_seektable_template_append_spaced_points_by_samples(
+         seekTable.get(), SeekPointSpacing, sampleLen) ||
+       !::FLAC__metadata_object_seektable_template_sort(seekTable.get(), true))
+      return false;
+   FLAC__StreamMetadata *metadata[] = { summary.get(), seekTable.get() };
+
+   MemoryEncoder encoder;
+   // Compression is usually to somewhat more than half
+   encoder.mBytes.reserve(sampleLen * mBitsPerSample / 16 + 65536);
+   encoder.set_channels(1);
+   encoder.set_bits_per_sample(mBitsPerSample);
+   encoder.set_sample_rate(SampleRate);
+   encoder.set_compression_level(CompressionLevel);
+   encoder.set_total_samples_estimate(sampleLen);
+   encoder.set_metadata(metadata, 2);
+   if (encoder.init() != FLAC__STREAM_ENCODER_INIT_STATUS_OK)
+      return false;
+
+   const size_t bufferSize = 4096;
+   ArrayOf<FLAC__int32> buffer{ bufferSize };
+   for (size_t done = 0; done < sampleLen;) {
+      const auto count = std::min(bufferSize, sampleLen - done);
+      switch (format) {
+         case int16Sample: {
+            auto samples = reinterpret_cast<const short *>(sampleData) + done;
+            for (size_t ii = 0; ii < count; ++ii)
+               buffer[ii] = samples[ii];
+            break;
+         }
+         case int24Sample: {
+            auto samples = reinterpret_cast<const int *>(sampleData) + done;
+            for (size_t ii = 0; ii < count; ++ii)
+               buffer[ii] = samples[ii];
+            break;
+         }
+         case floatSample:
+         default: {
+            // Exact, as GetLosslessBits() checked
+            auto samples = reinterpret_cast<const float *>(sampleData) + done;
+            const float scale = float(1 << (mBitsPerSample - 1));
+            for (size_t ii = 0; ii < count; ++ii)
+               buffer[ii] = FLAC__int32(samples[ii] * scale);
+            break;
+         }
+      }
+      if (!encoder.process_interleaved(buffer.get(), count)) {
+         encoder.finish();
+         return false;
+      }
+      done += count;
+   }
+   if (!encoder.finish())
+      return false;
+
+   wxFFile file(mFileName.GetFullPath(), wxT("wb"));
+   if (!file.IsOpened())
+      return false;
+   const auto &bytes = encoder.mBytes;
+   return file.Write(bytes.data(), bytes.size()) == bytes.size() &&
+      file.Close();
+}
+
+/// Read the summary section of the disk file.
+///
+/// @param *data The buffer to write the data to.  It must be at least
+/// mSummaryinfo.totalSummaryBytes long.
+bool FLACBlockFile::ReadSummary(ArrayOf<char> &data)
+{
+   data.reinit( mSummaryInfo.totalSummaryBytes );
+
+   wxFFile file(mFileName.GetFullPath(), wxT("rb"));
+   {
+      Maybe<wxLogNull> silence{};
+      if (mSilentLog)
+         silence.create();
+      if (!file.IsOpened()){
+         memset(data.get(), 0, mSummaryInfo.totalSummaryBytes);
+         mSilentLog = TRUE;
+         return false;
+      }
+   }
+   mSilentLog = FALSE;
+
+   if( !FindSummary(file, mSummaryInfo.totalSummaryBytes) ||
+       file.Read(data.get(), mSummaryInfo.totalSummaryBytes) !=
+          mSummaryInfo.totalSummaryBytes ) {
+      memset(data.get(), 0, mSummaryInfo.totalSummaryBytes);
+      return false;
+   }
+
+   FixSummary(data.get());
+
+   return true;
+}
+
+/// Read the compressed file and decode the data portion of it.
+/// Convert it to the given format if it is not already.
+///
+/// @param data   The buffer where the data will be stored
+/// @param format The format the data will be stored in
+/// @param start  The offset in this block file
+/// @param len    The number of samples to read
+size_t FLACBlockFile::ReadData(samplePtr data, sampleFormat format,
+                        size_t start, size_t len, bool mayThrow) const
+{
+   size_t framesRead = 0;
+
+   // One read of the file, which is smaller than the samples
+   wxFFile file;
+   ArrayOf<char> bytes;
+   size_t size = 0;
+   {
+      Maybe<wxLogNull> silence{};
+      if (mSilentLog)
+         silence.create();
+      const auto fullPath = mFileName.GetFullPath();
+      if (wxFile::Exists(fullPath) && file.Open(fullPath, wxT("rb"))) {
+         size = file.Length();
+         bytes.reinit(size);
+         if (file.Read(bytes.get(), size) != size)
+            size = 0;
+      }
+   }
+   mSilentLog = (size == 0);
+
+   if (size > 0 && start < mLen) {
+      MemoryDecoder decoder{ bytes.get(), size, data, format, start,
+         std::min(len, mLen - start) };
+      if (decoder.init() == FLAC__STREAM_DECODER_INIT_STATUS_OK &&
+          (start == 0
+            ? decoder.process_until_end_of_metadata()
+            : decoder.seek_absolute(start))) {
+         while (!decoder.IsDone() && decoder.process_single() &&
+                decoder.get_state() != FLAC__STREAM_DECODER_END_OF_STREAM)
+            ;
+         framesRead = decoder.GetDone();
+      }
+      decoder.finish();
+   }
+
+   if ( framesRead < len ) {
+      if (mayThrow)
+         throw FileException{ FileException::Cause::Read, mFileName };
+      ClearSamples(data, format, framesRead, len - framesRead);
+   }
+
+   return framesRead;
+}
+
+void FLACBlockFile::SaveXML(XMLWriter &xmlFile)
+// may throw
+{
+   xmlFile.StartTag(wxT("flacblockfile"));
+
+   xmlFile.WriteAttr(wxT("filename"), mFileName.GetFullName());
+   xmlFile.WriteAttr(wxT("len"), mLen);
+   xmlFile.WriteAttr(wxT("bits"), mBitsPerSample);
+   xmlFile.WriteAttr(wxT("min"), mMin);
+   xmlFile.WriteAttr(wxT("max"), mMax);
+   xmlFile.WriteAttr(wxT("rms"), mRMS);
+
+   xmlFile.EndTag(wxT("flacblockfile"));
+}
+
+// BuildFromXML methods should always return a BlockFile, not NULL,
+// even if the result is flawed (e.g., refers to nonexistent file),
+// as testing will be done in ProjectFSCK().
+/// static
+BlockFilePtr FLACBlockFile::BuildFromXML(DirManager &dm, const wxChar **attrs)
+{
+   wxFileNameWrapper fileName;
+   float min = 0.0f, max = 0.0f, rms = 0.0f;
+   size_t len = 0;
+   unsigned bits = 16;
+   double dblValue;
+   long nValue;
+
+   while(*attrs)
+   {
+      const wxChar *attr =  *attrs++;
+      const wxChar *value = *attrs++;
+      if (!value)
+         break;
+
+      const wxString strValue = value;
+      if (!wxStricmp(attr, wxT("filename")) &&
+            // Can't use XMLValueChecker::IsGoodFileName here, but do part of its test.
+            XMLValueChecker::IsGoodFileString(strValue) &&
+            (strValue.length() + 1 + dm.GetProjectDataDir().length() <= PLATFORM_MAX_PATH))
+      {
+         if (!dm.AssignFile(fileName, strValue, false))
+            // Make sure fileName is back to uninitialized state so we can detect problem later.
+            fileName.Clear();
+      }
+      else if (!wxStrcmp(attr, wxT("len")) &&
+               XMLValueChecker::IsGoodInt(strValue) && strValue.ToLong(&nValue) &&
+               nValue > 0)
+         len = nValue;
+      else if (!wxStrcmp(attr, wxT("bits")) &&
+               XMLValueChecker::IsGoodInt(strValue) && strValue.ToLong(&nValue) &&
+               (nValue == 16 || nValue == 24))
+         bits = nValue;
+      else if (XMLValueChecker::IsGoodString(strValue) && Internat::CompatibleToDouble(strValue, &dblValue))
+      {  // double parameters
+         if (!wxStricmp(attr, wxT("min")))
+            min = dblValue;
+         else if (!wxStricmp(attr, wxT("max")))
+            max = dblValue;
+         else if (!wxStricmp(attr, wxT("rms")) && (dblValue >= 0.0))
+            rms = dblValue;
+      }
+   }
+
+   return make_blockfile<FLACBlockFile>
+      (std::move(fileName), len, min, max, rms, bits);
+}
+
+/// Create a copy of this BlockFile, but using a different disk file.
+///
+/// @param newFileName The name of the NEW file to use.
+BlockFilePtr FLACBlockFile::Copy(wxFileNameWrapper &&newFileName)
+{
+   auto newBlockFile = make_blockfile<FLACBlockFile>
+      (std::move(newFileName), mLen, mMin, mMax, mRMS, mBitsPerSample);
+
+   return newBlockFile;
+}
+
+auto FLACBlockFile::GetSpaceUsage() const -> DiskByteCount
+{
+   wxFFile file(mFileName.GetFullPath());
+   return file.IsOpened() ? file.Length() : 0;
+}
+
+/// Write silence in place of the missing file
+void FLACBlockFile::Recover()
+{
+   SampleBuffer silence(mLen, int16Sample);
+   ClearSamples(silence.ptr(), int16Sample, 0, mLen);
+   ArrayOf<char> cleanup;
+   auto summaryData = CalcSummary(silence.ptr(), mLen, int16Sample, cleanup);
+   mBitsPerSample = 16;
+   WriteFLACBlockFile(silence.ptr(), mLen, int16Sample, summaryData);
+}
+
+static DirManager::RegisteredBlockFileDeserializer sRegistration {
+   "flacblockfile",
+   []( DirManager &dm, const wxChar **attrs ){
+      return FLACBlockFile::BuildFromXML( dm, attrs );
+   }
+};
+
+static DirManager::RegisteredSampleBlockFileFactory sFactoryRegistration {
+   []( wxFileNameWrapper &fileName,
+      samplePtr sampleData, size_t sampleLen, sampleFormat format )
+   -> BlockFilePtr {
+      if (!FLACBlockFile::IsEnabled())
+         return {};
+      const auto bits =
+         FLACBlockFile::GetLosslessBits(sampleData, sampleLen, format);
+      if (!bits)
+         return {};
+      return make_blockfile<FLACBlockFile>(
+         std::move(fileName), sampleData, sampleLen, format, bits);
+   }
+};
+
+#endif // USE_LIBFLAC
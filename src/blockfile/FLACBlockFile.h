@@ -0,0 +1,68 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  FLACBlockFile.h
+
+**********************************************************************/
+
+#ifndef __AUDACITY_FLAC_BLOCKFILE__
+#define __AUDACITY_FLAC_BLOCKFILE__
+
+#include "../BlockFile.h"
+
+class DirManager;
+
+/// A BlockFile that stores integer samples losslessly compressed, in a
+/// FLAC file that also holds the summary data.
+class FLACBlockFile final : public BlockFile {
+ public:
+
+   // Constructor / Destructor
+
+   /// Create a disk file and write summary and compressed sample data to
+   /// it.  The samples must be representable with the given bits, as
+   /// GetLosslessBits() found.
+   FLACBlockFile(wxFileNameWrapper &&baseFileName,
+                 samplePtr sampleData, size_t sampleLen,
+                 sampleFormat format, unsigned bitsPerSample);
+   /// Create the memory structure to refer to the given block file
+   FLACBlockFile(wxFileNameWrapper &&existingFile, size_t len,
+                 float min, float max, float rms, unsigned bitsPerSample);
+
+   virtual ~FLACBlockFile();
+
+   /// Whether NEW blocks should be compressed, as set in preferences
+   static bool IsEnabled();
+   /// Returns 16 or 24 if all the samples can be stored exactly with that
+   /// many bits, else 0
+   static unsigned GetLosslessBits(samplePtr sampleData, size_t sampleLen,
+                                   sampleFormat format);
+
+   // Reading
+
+   /// Read the summary from the application block of the FLAC file
+   bool ReadSummary(ArrayOf<char> &data) override;
+   /// Decode the samples
+   size_t ReadData(samplePtr data, sampleFormat format,
+                        size_t start, size_t len, bool mayThrow) const override;
+
+   /// Create a NEW block file identical to this one
+   BlockFilePtr Copy(wxFileNameWrapper &&newFileName) override;
+   /// Write an XML representation of this file
+   void SaveXML(XMLWriter &xmlFile) override;
+
+   DiskByteCount GetSpaceUsage() const override;
+   void Recover() override;
+
+   static BlockFilePtr BuildFromXML(DirManager &dm, const wxChar **attrs);
+
+ private:
+
+   bool WriteFLACBlockFile(samplePtr sampleData, size_t sampleLen,
+                           sampleFormat format, const void *summaryData);
+
+   unsigned mBitsPerSample;
+};
+
+#endif
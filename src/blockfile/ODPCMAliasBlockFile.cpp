@@ -30,6 +30,7 @@ The summary is eventually computed and written to a file in a background thread.
 
 #include "../DirManager.h"
 #include "../FileFormats.h"
+#include "../MappedSampleFile.h"
 
 #include "../ondemand/ODManager.h"
 
@@ -501,6 +502,10 @@ size_t ODPCMAliasBlockFile::ReadData(samplePtr data, sampleFormat format,
       return len;
    }
 
+   if (MappedSampleFileCache::Get().ReadData(*this, mAliasedFileName, true,
+         mAliasChannel, mAliasStart, data, format, start, len) == len)
+      return len;
+
    return CommonReadData( mayThrow,
       mAliasedFileName, mSilentAliasLog, this, mAliasStart, mAliasChannel,
       data, format, start, len);
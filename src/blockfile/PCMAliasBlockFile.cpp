@@ -19,6 +19,7 @@
 #include <sndfile.h>
 
 #include "../FileFormats.h"
+#include "../MappedSampleFile.h"
 
 #include "../DirManager.h"
 
@@ -76,6 +77,10 @@ size_t PCMAliasBlockFile::ReadData(samplePtr data, sampleFormat format,
       return len;
    }
 
+   if (MappedSampleFileCache::Get().ReadData(*this, mAliasedFileName, true,
+         mAliasChannel, mAliasStart, data, format, start, len) == len)
+      return len;
+
    return CommonReadData( mayThrow,
       mAliasedFileName, mSilentAliasLog, this, mAliasStart, mAliasChannel,
       data, format, start, len);
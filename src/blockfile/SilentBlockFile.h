@@ -35,6 +35,8 @@ class SilentBlockFile final : public BlockFile {
    /// Read the data section of the disk file
    size_t ReadData(samplePtr data, sampleFormat format,
                         size_t start, size_t len, bool mayThrow) const override;
+   /// Reading is as cheap as the cache
+   bool IsDataCacheable() const override { return false; }
 
    /// Create a NEW block file identical to this one
    BlockFilePtr Copy(wxFileNameWrapper &&newFileName) override;
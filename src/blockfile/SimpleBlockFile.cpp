@@ -70,6 +70,7 @@ to get its definition, rather than rolling our own.
 #include "../Prefs.h"
 
 #include "../FileFormats.h"
+#include "../MappedSampleFile.h"
 
 #include "sndfile.h"
 
@@ -412,9 +413,14 @@ size_t SimpleBlockFile::ReadData(samplePtr data, sampleFormat format,
 
       return framesRead;
    }
-   else
+   else {
+      if (MappedSampleFileCache::Get().ReadData(*this, mFileName, false,
+            0, 0, data, format, start, len) == len)
+         return len;
+
       return CommonReadData( mayThrow,
          mFileName, mSilentLog, nullptr, 0, 0, data, format, start, len);
+   }
 }
 
 void SimpleBlockFile::SaveXML(XMLWriter &xmlFile)
@@ -549,6 +555,7 @@ auto SimpleBlockFile::GetSpaceUsage() const -> DiskByteCount
 }
 
 void SimpleBlockFile::Recover(){
+   MappedSampleFileCache::Get().Invalidate(this);
    wxFFile file(mFileName.GetFullPath(), wxT("wb"));
 
    if( !file.IsOpened() ){
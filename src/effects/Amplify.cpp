@@ -178,6 +178,18 @@ bool EffectAmplify::LoadFactoryDefaults()
 
 // Effect implementation
 
+bool EffectAmplify::SupportsParallelProcessing()
+{
+   return true;
+}
+
+size_t EffectAmplify::ParallelProcessBlock(size_t WXUNUSED(instance),
+   float **inBlock, float **outBlock, size_t blockLen)
+{
+   // Stateless
+   return ProcessBlock(inBlock, outBlock, blockLen);
+}
+
 bool EffectAmplify::Init()
 {
    mPeak = 0.0;
@@ -52,6 +52,9 @@ public:
 
    // Effect implementation
 
+   bool SupportsParallelProcessing() override;
+   size_t ParallelProcessBlock(size_t instance,
+      float **inBlock, float **outBlock, size_t blockLen) override;
    bool Init() override;
    void Preview(bool dryOnly) override;
    void PopulateOrExchange(ShuttleGui & S) override;
@@ -0,0 +1,143 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  AnalysisCache.cpp
+
+*******************************************************************//**
+
+\class AnalysisCache
+\brief Remembers what the first pass of a two pass effect read from its
+tracks, so that the second pass need not read and convert them again.
+
+*//*******************************************************************/
+
+#include "../Audacity.h"
+#include "AnalysisCache.h"
+
+#include <algorithm>
+#include <new>
+
+#include "../WaveTrack.h"
+
+AnalysisCache::AnalysisCache( size_t maxSamples )
+   : mMaxSamples{ maxSamples }
+{
+}
+
+void AnalysisCache::Clear()
+{
+   mRecords.clear();
+   mUsed = 0;
+}
+
+bool AnalysisCache::Begin(
+   const WaveTrack &track, sampleCount start, sampleCount end )
+{
+   Release( track );
+
+   auto &record = mRecords[ &track ];
+   record.start = record.added = start;
+   record.end = std::max( start, end );
+
+   const auto len = record.end - start;
+   if ( len <= mMaxSamples - mUsed ) {
+      const auto size = len.as_size_t();
+      try {
+         record.samples.reinit( size );
+         record.size = size;
+         mUsed += size;
+      }
+      catch ( const std::bad_alloc& ) {
+         // Do without; the second pass will read the track
+      }
+   }
+
+   return record.size > 0;
+}
+
+void AnalysisCache::Add( const WaveTrack &track,
+   const float *buffer, size_t len, sampleCount numWithinClips )
+{
+   auto iter = mRecords.find( &track );
+   if ( iter == mRecords.end() || len == 0 )
+      return;
+   auto &record = iter->second;
+
+   // Ignore samples past the end that was given to Begin()
+   len = limitSampleBufferSize( len, record.end - record.added );
+   if ( len == 0 )
+      return;
+
+   if ( record.size > 0 )
+      std::copy( buffer, buffer + len,
+         record.samples.get() + ( record.added - record.start ).as_size_t() );
+
+   record.total.Accumulate( buffer, len );
+   record.total.withinClips =
+      record.total.withinClips && ( numWithinClips >= len );
+   record.added += len;
+}
+
+bool AnalysisCache::Contains(
+   const WaveTrack &track, sampleCount start, size_t len ) const
+{
+   auto iter = mRecords.find( &track );
+   if ( iter == mRecords.end() )
+      return false;
+   const auto &record = iter->second;
+   return record.size > 0 &&
+      start >= record.start && start + len <= record.added;
+}
+
+void AnalysisCache::Get( const WaveTrack &track,
+   float *buffer, sampleCount start, size_t len ) const
+{
+   if ( Contains( track, start, len ) ) {
+      const auto &record = mRecords.find( &track )->second;
+      const auto src =
+         record.samples.get() + ( start - record.start ).as_size_t();
+      std::copy( src, src + len, buffer );
+   }
+   else
+      track.Get( (samplePtr)buffer, floatSample, start, len );
+}
+
+void AnalysisCache::Put( WaveTrack &track ) const
+{
+   auto iter = mRecords.find( &track );
+   if ( iter == mRecords.end() )
+      return;
+   const auto &record = iter->second;
+   if ( record.size == 0 )
+      return;
+
+   // Set in pieces as the track would have them, so that no block is
+   // rewritten more than once
+   auto s = record.start;
+   while ( s < record.added ) {
+      const auto len = limitSampleBufferSize(
+         track.GetBestBlockSize( s ), record.added - s );
+      track.Set( (samplePtr)( record.samples.get() +
+            ( s - record.start ).as_size_t() ),
+         floatSample, s, len );
+      s += len;
+   }
+}
+
+auto AnalysisCache::GetStats( const WaveTrack &track ) const -> const Stats *
+{
+   auto iter = mRecords.find( &track );
+   if ( iter == mRecords.end() )
+      return nullptr;
+   return &iter->second.total;
+}
+
+void AnalysisCache::Release( const WaveTrack &track )
+{
+   auto iter = mRecords.find( &track );
+   if ( iter == mRecords.end() )
+      return;
+   mUsed -= iter->second.size;
+   mRecords.erase( iter );
+}
@@ -0,0 +1,89 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  AnalysisCache.h
+
+**********************************************************************/
+
+#ifndef __AUDACITY_EFFECT_ANALYSIS_CACHE__
+#define __AUDACITY_EFFECT_ANALYSIS_CACHE__
+
+#include <unordered_map>
+
+#include "../MemoryX.h"
+#include "../SampleFormat.h"
+
+class WaveTrack;
+
+/// \brief Remembers what the first pass of a two pass effect read from its
+/// tracks, so that the second pass need not read and convert them again.
+///
+/// Samples are kept in memory while they fit within a limit shared by all
+/// tracks; beyond it only the statistics are kept, and the second pass reads
+/// the track as before.
+class AnalysisCache final
+{
+public:
+   /// 128 MB of float samples
+   static const size_t DefaultMaxSamples = 32 * 1024 * 1024;
+
+   struct Stats : SampleStatistics {
+      /// Whether all samples were within clips, so that min and max do not
+      /// count the zeroes that fill the gaps
+      bool withinClips{ true };
+   };
+
+   explicit AnalysisCache( size_t maxSamples = DefaultMaxSamples );
+   AnalysisCache( const AnalysisCache& ) = delete;
+   AnalysisCache &operator= ( const AnalysisCache& ) = delete;
+
+   /// Forget all tracks and free the memory
+   void Clear();
+
+   /// Begin to record the samples of the track from start to end, forgetting
+   /// what was recorded for it before; returns whether the samples will be
+   /// kept in memory
+   bool Begin( const WaveTrack &track, sampleCount start, sampleCount end );
+   /// Record the next samples of the track; numWithinClips is as returned
+   /// by WaveTrack::Get()
+   void Add( const WaveTrack &track, const float *buffer, size_t len,
+      sampleCount numWithinClips );
+   void Add( const WaveTrack &track, const float *buffer, size_t len )
+   { Add( track, buffer, len, len ); }
+
+   /// Whether Add() was called for all samples from start to end, and they
+   /// are in memory
+   bool Contains( const WaveTrack &track, sampleCount start, size_t len ) const;
+
+   /// Copy samples from memory, or else read them from the track; may throw
+   void Get( const WaveTrack &track,
+      float *buffer, sampleCount start, size_t len ) const;
+
+   /// Set the samples kept in memory onto the track, for a first pass whose
+   /// output was kept only here; may throw
+   void Put( WaveTrack &track ) const;
+
+   /// Statistics of all that was added for the track, or null
+   const Stats *GetStats( const WaveTrack &track ) const;
+
+   /// Forget the track, when its second pass is done
+   void Release( const WaveTrack &track );
+
+private:
+   struct Record {
+      sampleCount start{ 0 };
+      sampleCount end{ 0 };
+      sampleCount added{ 0 };
+      // Empty if the samples did not fit
+      Floats samples;
+      size_t size{ 0 };
+      Stats total;
+   };
+
+   const size_t mMaxSamples;
+   size_t mUsed{ 0 };
+   std::unordered_map< const WaveTrack*, Record > mRecords;
+};
+
+#endif
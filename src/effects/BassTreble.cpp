@@ -215,6 +215,38 @@ bool EffectBassTreble::CheckWhetherSkipEffect()
 
 // Effect implementation
 
+bool EffectBassTreble::SupportsParallelProcessing()
+{
+   return true;
+}
+
+bool EffectBassTreble::ParallelInitialize(size_t numInstances)
+{
+   mInstances.resize(numInstances);
+
+   return true;
+}
+
+bool EffectBassTreble::ParallelProcessInitialize(size_t instance, float sampleRate,
+   sampleCount WXUNUSED(totalLen), ChannelNames WXUNUSED(chanMap))
+{
+   InstanceInit(mInstances[instance], sampleRate);
+   return true;
+}
+
+size_t EffectBassTreble::ParallelProcessBlock(size_t instance,
+   float **inBlock, float **outBlock, size_t blockLen)
+{
+   return InstanceProcess(mInstances[instance], inBlock, outBlock, blockLen);
+}
+
+bool EffectBassTreble::ParallelFinalize()
+{
+   mInstances.clear();
+
+   return true;
+}
+
 void EffectBassTreble::PopulateOrExchange(ShuttleGui & S)
 {
    S.SetBorder(5);
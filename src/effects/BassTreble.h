@@ -72,6 +72,14 @@ public:
 
    // Effect Implementation
 
+   bool SupportsParallelProcessing() override;
+   bool ParallelInitialize(size_t numInstances) override;
+   bool ParallelProcessInitialize(size_t instance, float sampleRate,
+      sampleCount totalLen, ChannelNames chanMap) override;
+   size_t ParallelProcessBlock(size_t instance,
+      float **inBlock, float **outBlock, size_t blockLen) override;
+   bool ParallelFinalize() override;
+
    void PopulateOrExchange(ShuttleGui & S) override;
    bool TransferDataToWindow() override;
    bool TransferDataFromWindow() override;
@@ -102,6 +110,7 @@ private:
 private:
    EffectBassTrebleState mMaster;
    std::vector<EffectBassTrebleState> mSlaves;
+   std::vector<EffectBassTrebleState> mInstances;
 
    double      mBass;
    double      mTreble;
@@ -365,6 +365,38 @@ bool EffectDistortion::LoadFactoryPreset(int id)
 
 // Effect implementation
 
+bool EffectDistortion::SupportsParallelProcessing()
+{
+   return true;
+}
+
+bool EffectDistortion::ParallelInitialize(size_t numInstances)
+{
+   mInstances.resize(numInstances);
+
+   return true;
+}
+
+bool EffectDistortion::ParallelProcessInitialize(size_t instance, float sampleRate,
+   sampleCount WXUNUSED(totalLen), ChannelNames WXUNUSED(chanMap))
+{
+   InstanceInit(mInstances[instance], sampleRate);
+   return true;
+}
+
+size_t EffectDistortion::ParallelProcessBlock(size_t instance,
+   float **inBlock, float **outBlock, size_t blockLen)
+{
+   return InstanceProcess(mInstances[instance], inBlock, outBlock, blockLen);
+}
+
+bool EffectDistortion::ParallelFinalize()
+{
+   mInstances.clear();
+
+   return true;
+}
+
 void EffectDistortion::PopulateOrExchange(ShuttleGui & S)
 {
    S.AddSpace(0, 5);
@@ -61,6 +61,7 @@ greater use in future.
 #include "../ProjectSettings.h"
 #include "../ShuttleGui.h"
 #include "../Shuttle.h"
+#include "../ThreadPool.h"
 #include "../ViewInfo.h"
 #include "../WaveTrack.h"
 #include "../commands/Command.h"
@@ -1351,6 +1352,9 @@ bool Effect::Process()
 
 bool Effect::ProcessPass()
 {
+   if (CanProcessPassInParallel())
+      return ProcessPassInParallel();
+
    bool bGoodResult = true;
    bool isGenerator = GetType() == EffectTypeGenerate;
 
@@ -1505,6 +1509,214 @@ bool Effect::ProcessPass()
    return bGoodResult;
 }
 
+bool Effect::CanProcessPassInParallel()
+{
+   if (GetType() != EffectTypeProcess || !SupportsParallelProcessing())
+      return false;
+
+   if (ThreadPool::Get().GetConcurrency() < 2)
+      return false;
+
+   bool parallel;
+   gPrefs->Read(wxT("/Effects/ProcessTracksInParallel"), &parallel, true);
+   if (!parallel)
+      return false;
+
+   // Not worth the trouble for a single track group
+   const bool multichannel = mNumAudioIn > 1;
+   auto range = multichannel
+      ? mOutputTracks->Selected< const WaveTrack >() + &Track::IsLeader
+      : mOutputTracks->Selected< const WaveTrack >();
+   return range.size() > 1;
+}
+
+// Like the serial loop in ProcessPass() and ProcessTrack(), but the client
+// processes up to one track group per available thread at once, each with its
+// own instance and buffers.  Reading and writing the tracks, and progress
+// reporting, stay on the main thread.  Blocks are cut at the same positions
+// as in the serial loop, so the results are identical.
+bool Effect::ProcessPassInParallel()
+{
+   struct Group {
+      WaveTrack *left{};
+      WaveTrack *right{};
+      ChannelName map[3];
+      unsigned numChannels{};
+      sampleCount leftStart{};
+      sampleCount rightStart{};
+      sampleCount len{};
+      double rate{};
+      size_t blockSize{};
+      size_t bufferSize{};
+      sampleCount pos{};
+      size_t count{};
+   };
+   std::vector<Group> groups;
+
+   const bool multichannel = mNumAudioIn > 1;
+   auto range = multichannel
+      ? mOutputTracks->Leaders()
+      : mOutputTracks->Any();
+   range.Visit(
+      [&](WaveTrack *left, const Track::Fallthrough &fallthrough) {
+         if (!left->GetSelected())
+            return fallthrough();
+
+         groups.emplace_back();
+         auto &group = groups.back();
+         group.left = left;
+         group.rate = left->GetRate();
+         GetSamples(left, &group.leftStart, &group.len);
+
+         for (auto channel :
+              TrackList::Channels(left).StartingWith(left)) {
+            auto &map = group.map;
+            if (channel->GetChannel() == Track::LeftChannel)
+               map[group.numChannels] = ChannelNameFrontLeft;
+            else if (channel->GetChannel() == Track::RightChannel)
+               map[group.numChannels] = ChannelNameFrontRight;
+            else
+               map[group.numChannels] = ChannelNameMono;
+
+            ++ group.numChannels;
+            map[group.numChannels] = ChannelNameEOL;
+
+            if (! multichannel)
+               break;
+
+            if (group.numChannels == 2) {
+               // TODO: more-than-two-channels
+               group.right = channel;
+               GetSamples(channel, &group.rightStart, &group.len);
+               break;
+            }
+         }
+      },
+      [&](Track *t) {
+         if (t->IsSyncLockSelected())
+            t->SyncLockAdjust(mT1, mT0 + mDuration);
+      }
+   );
+
+   sampleCount total = 0;
+   for (const auto &group : groups)
+      total += group.len;
+   sampleCount done = 0;
+
+   // Not members of Group, because FloatBuffers can't be moved
+   ArrayOf<FloatBuffers> inBuffers{ groups.size() };
+   ArrayOf<FloatBuffers> outBuffers{ groups.size() };
+
+   if (!ParallelInitialize(groups.size()))
+      return false;
+   auto cleanup = finally( [&] { ParallelFinalize(); } );
+
+   auto &pool = ThreadPool::Get();
+   const auto nSlots = pool.GetConcurrency();
+
+   // Take the groups a few at a time, to bound the memory for buffers
+   for (size_t first = 0; first < groups.size(); first += nSlots) {
+      const auto last = std::min(groups.size(), first + nSlots);
+
+      for (auto ii = first; ii < last; ++ii) {
+         auto &group = groups[ii];
+
+         SetSampleRate(group.rate);
+         auto max = group.left->GetMaxBlockSize() * 2;
+         group.blockSize = SetBlockSize(max);
+         group.bufferSize =
+            ((max + (group.blockSize - 1)) / group.blockSize) *
+               group.blockSize;
+
+         // Always create the number of buffers the client expects, with
+         // the ones we won't fill cleared
+         inBuffers[ii].reinit(mNumAudioIn, group.bufferSize, true);
+         outBuffers[ii].reinit(mNumAudioOut, group.bufferSize);
+
+         if (!ParallelProcessInitialize(
+               ii, group.rate, group.len, group.map))
+            return false;
+      }
+
+      while (true) {
+         bool more = false;
+         for (auto ii = first; ii < last; ++ii) {
+            auto &group = groups[ii];
+            group.count =
+               limitSampleBufferSize(group.bufferSize, group.len - group.pos);
+            if (group.count == 0)
+               continue;
+            more = true;
+            group.left->Get((samplePtr) inBuffers[ii][0].get(), floatSample,
+               group.leftStart + group.pos, group.count);
+            if (group.right)
+               group.right->Get(
+                  (samplePtr) inBuffers[ii][1].get(), floatSample,
+                  group.rightStart + group.pos, group.count);
+         }
+         if (!more)
+            break;
+
+         pool.ParallelFor(last - first, [&](size_t jj){
+            const auto ii = first + jj;
+            auto &group = groups[ii];
+            auto &inBuffer = inBuffers[ii];
+            auto &outBuffer = outBuffers[ii];
+            ArrayOf<float *> inBufPos{ mNumAudioIn };
+            ArrayOf<float *> outBufPos{ mNumAudioOut };
+            for (size_t offset = 0; offset < group.count;
+                 offset += group.blockSize) {
+               auto curBlockSize =
+                  std::min(group.blockSize, group.count - offset);
+               for (size_t i = 0; i < mNumAudioIn; i++)
+                  inBufPos[i] = inBuffer[i].get() + offset;
+               for (size_t i = 0; i < mNumAudioOut; i++)
+                  outBufPos[i] = outBuffer[i].get() + offset;
+
+               // The last block is passed whole, padded with zeroes,
+               // and only the first curBlockSize samples are kept
+               if (curBlockSize < group.blockSize) {
+                  for (size_t i = 0; i < group.numChannels; i++)
+                     std::fill(inBufPos[i] + curBlockSize,
+                        inBufPos[i] + group.blockSize, 0.0f);
+               }
+
+               auto processed = ParallelProcessBlock(
+                  ii, inBufPos.get(), outBufPos.get(), curBlockSize);
+               wxASSERT(processed == curBlockSize);
+               wxUnusedVar(processed);
+            }
+         });
+
+         for (auto ii = first; ii < last; ++ii) {
+            auto &group = groups[ii];
+            if (group.count == 0)
+               continue;
+            auto chans = std::min<unsigned>(mNumAudioOut, group.numChannels);
+            group.left->Set((samplePtr) outBuffers[ii][0].get(), floatSample,
+               group.leftStart + group.pos, group.count);
+            if (group.right)
+               group.right->Set(
+                  (samplePtr) outBuffers[ii][chans >= 2 ? 1 : 0].get(),
+                  floatSample, group.rightStart + group.pos, group.count);
+            group.pos += group.count;
+            done += group.count;
+         }
+
+         if (TotalProgress(done.as_double() / total.as_double()))
+            return false;
+      }
+
+      // Release the buffers of the finished groups
+      for (auto ii = first; ii < last; ++ii) {
+         inBuffers[ii].reset();
+         outBuffers[ii].reset();
+      }
+   }
+
+   return true;
+}
+
 bool Effect::ProcessTrack(int count,
                           ChannelNames map,
                           WaveTrack *left,
@@ -1980,6 +2192,35 @@ void Effect::EnableDebug(bool enable)
    mUIDebug = enable;
 }
 
+bool Effect::SupportsParallelProcessing()
+{
+   return false;
+}
+
+bool Effect::ParallelInitialize(size_t WXUNUSED(numInstances))
+{
+   return true;
+}
+
+bool Effect::ParallelProcessInitialize(size_t WXUNUSED(instance),
+   float WXUNUSED(sampleRate), sampleCount WXUNUSED(totalLen),
+   ChannelNames WXUNUSED(chanMap))
+{
+   return true;
+}
+
+size_t Effect::ParallelProcessBlock(size_t WXUNUSED(instance),
+   float **WXUNUSED(inBlock), float **WXUNUSED(outBlock),
+   size_t WXUNUSED(blockLen))
+{
+   return 0;
+}
+
+bool Effect::ParallelFinalize()
+{
+   return true;
+}
+
 void Effect::SetLinearEffectFlag(bool linearEffectFlag)
 {
    mIsLinearEffect = linearEffectFlag;
@@ -328,6 +328,21 @@ protected:
    virtual bool EnablePreview(bool enable = true);
    virtual void EnableDebug(bool enable = true);
 
+   // Effects that keep all of their processing state in separate instances,
+   // as the realtime capable ones do, may let ProcessPass() work on several
+   // track groups at once.  ParallelInitialize() and
+   // ParallelProcessInitialize() are called on the main thread before any
+   // processing; ParallelProcessBlock() may then be called on worker threads,
+   // but never concurrently for the same instance.  Such effects must not
+   // report latency.
+   virtual bool SupportsParallelProcessing();
+   virtual bool ParallelInitialize(size_t numInstances);
+   virtual bool ParallelProcessInitialize(size_t instance, float sampleRate,
+      sampleCount totalLen, ChannelNames chanMap);
+   virtual size_t ParallelProcessBlock(size_t instance,
+      float **inBlock, float **outBlock, size_t blockLen);
+   virtual bool ParallelFinalize();
+
    // No more virtuals!
 
    // The Progress methods all return true if the user has cancelled;
@@ -500,6 +515,10 @@ protected:
                      ArrayOf< float * > &inBufPos,
                      ArrayOf< float *> &outBufPos);
 
+   // Driver for client effects that support parallel processing
+   bool CanProcessPassInParallel();
+   bool ProcessPassInParallel();
+
  //
  // private data
  //
@@ -95,6 +95,7 @@ EffectRack::EffectRack()
    mBypassing = false;
    mNumEffects = 0;
    mLastLatency = 0;
+   mLastLoad = 0;
    mTimer.SetOwner(this);
 
    mPowerPushed = CreateBitmap(power_on_16x16_xpm, false, false);
@@ -129,6 +130,11 @@ EffectRack::EffectRack()
          mLatency = safenew wxStaticText(mPanel, wxID_ANY, _("Latency: 0"));
          hs->Add(mLatency, 0, wxALIGN_CENTER);
          hs->AddStretchSpacer();
+         /* i18n-hint: Percentage of the available time that the busiest
+            track took for realtime effects */
+         mLoad = safenew wxStaticText(mPanel, wxID_ANY, _("Load: 0%"));
+         hs->Add(mLoad, 0, wxALIGN_CENTER);
+         hs->AddStretchSpacer();
          hs->Add(safenew wxToggleButton(mPanel, wxID_CLEAR, _("&Bypass")), 0, wxALIGN_RIGHT | wxALIGN_CENTER_VERTICAL);
          bs->Add(hs.release(), 0, wxEXPAND);
       }
@@ -292,6 +298,14 @@ void EffectRack::OnTimer(wxTimerEvent & WXUNUSED(evt))
       mLatency->Refresh();
       mLastLatency = latency;
    }
+
+   int load = (int) (RealtimeEffectManager::Get().GetRealtimeLoad() * 100 + 0.5);
+   if (load != mLastLoad)
+   {
+      mLoad->SetLabel(wxString::Format(_("Load: %3d%%"), load));
+      mLoad->Refresh();
+      mLastLoad = load;
+   }
 }
 
 void EffectRack::OnApply(wxCommandEvent & WXUNUSED(evt))
@@ -61,6 +61,8 @@ private:
 private:
    wxStaticText *mLatency;
    int mLastLatency;
+   wxStaticText *mLoad;
+   int mLastLoad;
 
    wxBitmap mPowerPushed;
    wxBitmap mPowerRaised;
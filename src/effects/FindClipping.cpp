@@ -180,6 +180,8 @@ bool EffectFindClipping::ProcessOne(LabelTrack * lt,
    decltype(len) s = 0, startrun = 0, stoprun = 0, samps = 0;
    decltype(blockSize) block = 0;
    double startTime = -1.0;
+   // Samples before this are known to include some that clip
+   decltype(len) checkedEnd = 0;
 
    while (s < len) {
       if (block == 0) {
@@ -190,6 +192,39 @@ bool EffectFindClipping::ProcessOne(LabelTrack * lt,
             break;
          }
 
+         if (s >= checkedEnd) {
+            // Block statistics can tell that a whole block has no clipping,
+            // without reading it.  Then do at once what the loop below
+            // would do for so many samples that don't clip.
+            const auto n = limitSampleBufferSize(
+               wt->GetBestBlockSize(start + s), len - s );
+            if (wt->GetStatistics(start + s, n).clipped == 0) {
+               if (startrun >= mStart) {
+                  const auto needed = mStop - stoprun;
+                  if (needed <= n) {
+                     samps += needed;
+                     lt->AddLabel(SelectedRegion(startTime,
+                                                wt->LongSamplesToTime(start + s + needed - 1 - mStop)),
+                                 wxString::Format(wxT("%lld of %lld"), startrun.as_long_long(), (samps - mStop).as_long_long()));
+                     startrun = 0;
+                     stoprun = 0;
+                     samps = 0;
+                  }
+                  else {
+                     stoprun += n;
+                     samps += n;
+                  }
+               }
+               else {
+                  startrun = 0;
+               }
+
+               s += n;
+               continue;
+            }
+            checkedEnd = s + n;
+         }
+
          block = limitSampleBufferSize( blockSize, len - s );
 
          wt->Get((samplePtr)buffer.get(), floatSample, start + s, block);
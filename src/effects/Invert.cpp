@@ -75,3 +75,17 @@ size_t EffectInvert::ProcessBlock(float **inBlock, float **outBlock, size_t bloc
 
    return blockLen;
 }
+
+// Effect implementation
+
+bool EffectInvert::SupportsParallelProcessing()
+{
+   return true;
+}
+
+size_t EffectInvert::ParallelProcessBlock(size_t WXUNUSED(instance),
+   float **inBlock, float **outBlock, size_t blockLen)
+{
+   // Stateless
+   return ProcessBlock(inBlock, outBlock, blockLen);
+}
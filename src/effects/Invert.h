@@ -38,6 +38,12 @@ public:
    unsigned GetAudioInCount() override;
    unsigned GetAudioOutCount() override;
    size_t ProcessBlock(float **inBlock, float **outBlock, size_t blockLen) override;
+
+   // Effect implementation
+
+   bool SupportsParallelProcessing() override;
+   size_t ParallelProcessBlock(size_t instance,
+      float **inBlock, float **outBlock, size_t blockLen) override;
 };
 
 #endif
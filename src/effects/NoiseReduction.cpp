@@ -47,6 +47,7 @@
 #include "../widgets/HelpSystem.h"
 #include "../Prefs.h"
 #include "../RealFFTf.h"
+#include "../ThreadPool.h"
 
 #include "../WaveTrack.h"
 #include "../widgets/AudacityMessageBox.h"
@@ -158,6 +159,16 @@ enum  NoiseReductionChoice {
    NRC_LEAVE_RESIDUE,
 };
 
+// Tracks longer than two of these are processed in segments about this
+// long, one for each thread
+const size_t SegmentSamples = 1 << 18;
+
+// Most spectrum values that one thread computes at once in profiling
+const size_t TaskSpectrumFloats = 1 << 20;
+
+// With a longer release, process serially
+const size_t MaxReleaseSteps = 1 << 12;
+
 } // namespace
 
 //----------------------------------------------------------------------------
@@ -276,6 +287,26 @@ private:
                    int count, WaveTrack *track,
                    sampleCount start, sampleCount len);
 
+   // Parallel processing, in segments of the track, with results the same
+   // as ProcessOne's loop
+   bool GetWarmUpSteps(size_t &steps) const;
+   bool ProfileSegments(EffectNoiseReduction &effect,
+                        Statistics &statistics,
+                        int count, const WaveTrack &track,
+                        sampleCount start, sampleCount len);
+   bool ReduceSegments(EffectNoiseReduction &effect,
+                       Statistics &statistics,
+                       int count, const WaveTrack &track,
+                       sampleCount start, sampleCount len, size_t warmUpSteps,
+                       WaveTrack &outputTrack);
+   // These are done by helpers, in other threads
+   void ComputeSpectrums(const WaveTrack &track,
+      sampleCount start, size_t nWindows, float *spectrums);
+   void ReduceSegment(Statistics &statistics, const WaveTrack &track,
+      sampleCount start, sampleCount len,
+      sampleCount first, sampleCount end, size_t warmUpSteps);
+   void MakeHelpers(size_t count);
+
    void StartNewTrack();
    void ProcessSamples(Statistics &statistics,
       WaveTrack *outputTrack, size_t len, float *buffer);
@@ -290,6 +321,11 @@ private:
 
 private:
 
+   const Settings &mSettings;
+#ifdef EXPERIMENTAL_SPECTRAL_EDITING
+   const double mF0, mF1;
+#endif
+
    const bool mDoProfile;
 
    const double mSampleRate;
@@ -347,6 +383,14 @@ private:
       FloatVector mImagFFTs;
    };
    std::vector<std::unique_ptr<Record>> mQueue;
+
+   // Workers for other threads
+   std::vector<std::unique_ptr<Worker>> mHelpers;
+
+   // When processing a segment without an output track, output of steps
+   // from mSegmentSkip on goes here
+   FloatVector mSegmentOutput;
+   sampleCount mSegmentSkip;
 };
 
 /****************************************************************//**
@@ -729,7 +773,12 @@ EffectNoiseReduction::Worker::Worker
 , double f0, double f1
 #endif
 )
-: mDoProfile(settings.mDoProfile)
+: mSettings(settings)
+#ifdef EXPERIMENTAL_SPECTRAL_EDITING
+, mF0(f0), mF1(f1)
+#endif
+
+, mDoProfile(settings.mDoProfile)
 
 , mSampleRate(sampleRate)
 
@@ -758,6 +807,8 @@ EffectNoiseReduction::Worker::Worker
 , mInSampleCount(0)
 , mOutStepCount(0)
 , mInWavePos(0)
+
+, mSegmentSkip(0)
 {
 #ifdef EXPERIMENTAL_SPECTRAL_EDITING
    {
@@ -1276,7 +1327,11 @@ void EffectNoiseReduction::Worker::ReduceNoise
       float *buffer = &mOutOverlapBuffer[0];
       if (mOutStepCount >= 0) {
          // Output the first portion of the overlap buffer, they're done
-         outputTrack->Append((samplePtr)buffer, floatSample, mStepSize);
+         if (outputTrack)
+            outputTrack->Append((samplePtr)buffer, floatSample, mStepSize);
+         else if (mOutStepCount >= mSegmentSkip)
+            mSegmentOutput.insert(mSegmentOutput.end(),
+               buffer, buffer + mStepSize);
       }
 
       // Shift the remainder over.
@@ -1298,39 +1353,51 @@ bool EffectNoiseReduction::Worker::ProcessOne
    if(!mDoProfile)
       outputTrack = factory.NewWaveTrack(track->GetSampleFormat(), track->GetRate());
 
-   auto bufferSize = track->GetMaxBlockSize();
-   FloatVector buffer(bufferSize);
-
    bool bLoopSuccess = true;
-   auto samplePos = start;
-   while (bLoopSuccess && samplePos < start + len) {
-      //Get a blockSize of samples (smaller than the size of the buffer)
-      const auto blockSize = limitSampleBufferSize(
-         track->GetBestBlockSize(samplePos),
-         start + len - samplePos
-      );
-
-      //Get the samples from the track and put them in the buffer
-      track->Get((samplePtr)&buffer[0], floatSample, samplePos, blockSize);
-      samplePos += blockSize;
-
-      mInSampleCount += blockSize;
-      ProcessSamples(statistics, outputTrack.get(), blockSize, &buffer[0]);
-
-      // Update the Progress meter, let user cancel
-      bLoopSuccess = 
-         !effect.TrackProgress(count,
-                               ( samplePos - start ).as_double() /
-                               len.as_double() );
-   }
-
-   if (bLoopSuccess) {
+   size_t warmUpSteps = 0;
+   if (ThreadPool::Get().GetConcurrency() > 1 &&
+       len > 2 * SegmentSamples &&
+       (mDoProfile || GetWarmUpSteps(warmUpSteps))) {
       if (mDoProfile)
-         FinishTrackStatistics(statistics);
+         bLoopSuccess =
+            ProfileSegments(effect, statistics, count, *track, start, len);
       else
+         bLoopSuccess = ReduceSegments(effect, statistics, count, *track,
+            start, len, warmUpSteps, *outputTrack);
+   }
+   else {
+      auto bufferSize = track->GetMaxBlockSize();
+      FloatVector buffer(bufferSize);
+
+      auto samplePos = start;
+      while (bLoopSuccess && samplePos < start + len) {
+         //Get a blockSize of samples (smaller than the size of the buffer)
+         const auto blockSize = limitSampleBufferSize(
+            track->GetBestBlockSize(samplePos),
+            start + len - samplePos
+         );
+
+         //Get the samples from the track and put them in the buffer
+         track->Get((samplePtr)&buffer[0], floatSample, samplePos, blockSize);
+         samplePos += blockSize;
+
+         mInSampleCount += blockSize;
+         ProcessSamples(statistics, outputTrack.get(), blockSize, &buffer[0]);
+
+         // Update the Progress meter, let user cancel
+         bLoopSuccess = 
+            !effect.TrackProgress(count,
+                                  ( samplePos - start ).as_double() /
+                                  len.as_double() );
+      }
+
+      if (bLoopSuccess && !mDoProfile)
          FinishTrack(statistics, &*outputTrack);
    }
 
+   if (bLoopSuccess && mDoProfile)
+      FinishTrackStatistics(statistics);
+
    if (bLoopSuccess && !mDoProfile) {
       // Flush the output WaveTrack (since it's buffered)
       outputTrack->Flush();
@@ -1347,6 +1414,185 @@ bool EffectNoiseReduction::Worker::ProcessOne
    return bLoopSuccess;
 }
 
+// In profiling, the spectrums of windows can be computed apart, then
+// gathered in order.  In noise reduction, the gains of a window depend on
+// those before it only through the release, which decays to the floor in a
+// bounded number of steps.  So a segment of the output is the same as from
+// processing the whole track, if processing begins a little before it.
+bool EffectNoiseReduction::Worker::GetWarmUpSteps(size_t &steps) const
+{
+   // Follow the highest possible gain down as ReduceNoise does
+   size_t releaseSteps = 0;
+   for (float gain = 1.0f; gain > mNoiseAttenFactor; ++releaseSteps) {
+      if (releaseSteps > MaxReleaseSteps)
+         // Too slow, or no decay at all
+         return false;
+      gain = std::max(mNoiseAttenFactor, gain * mOneBlockRelease);
+   }
+
+   // Windows padded before the segment; then windows whose classification
+   // looks at padded windows; then the release; then the history, with
+   // room to spare
+   steps = mStepsPerWindow + mNWindowsToExamine + releaseSteps +
+      mHistoryLen + 1;
+   return true;
+}
+
+void EffectNoiseReduction::Worker::MakeHelpers(size_t count)
+{
+   while (mHelpers.size() < count)
+      mHelpers.push_back(std::make_unique<Worker>(mSettings, mSampleRate
+#ifdef EXPERIMENTAL_SPECTRAL_EDITING
+         , mF0, mF1
+#endif
+      ));
+}
+
+bool EffectNoiseReduction::Worker::ProfileSegments
+(EffectNoiseReduction &effect, Statistics &statistics,
+ int count, const WaveTrack &track, sampleCount start, sampleCount len)
+{
+   // Windows that fit in the selection, without padding
+   if (len < (sampleCount)mWindowSize)
+      return true;
+   const auto nWindows =
+      ((len - mWindowSize) / mStepSize).as_long_long() + 1;
+
+   auto &pool = ThreadPool::Get();
+   const auto nHelpers = pool.GetConcurrency();
+   MakeHelpers(nHelpers);
+
+   const size_t windowsPerTask = std::max<size_t>(1, std::min(
+      SegmentSamples / mStepSize, TaskSpectrumFloats / mSpectrumSize));
+   const auto windowsPerRound = nHelpers * windowsPerTask;
+   FloatVector spectrums(windowsPerRound * mSpectrumSize);
+
+   for (long long first = 0; first < nWindows; first += windowsPerRound) {
+      const auto nn = (size_t)std::min<long long>(
+         windowsPerRound, nWindows - first);
+      const auto nTasks = (nn + windowsPerTask - 1) / windowsPerTask;
+      pool.ParallelFor(nTasks, [&](size_t iTask) {
+         const auto offset = iTask * windowsPerTask;
+         mHelpers[iTask]->ComputeSpectrums(track,
+            start + (first + offset) * mStepSize,
+            std::min(windowsPerTask, nn - offset),
+            &spectrums[offset * mSpectrumSize]);
+      });
+
+      // Gather in the same order as ProcessSamples, through the queue,
+      // which the old statistics examine
+      for (size_t ii = 0; ii < nn; ++ii) {
+         const float *const pPower = &spectrums[ii * mSpectrumSize];
+         std::copy(pPower, pPower + mSpectrumSize,
+            mQueue[0]->mSpectrums.begin());
+         GatherStatistics(statistics);
+         RotateHistoryWindows();
+      }
+
+      // Update the Progress meter, let user cancel
+      if (effect.TrackProgress(count,
+            double(first + nn) / double(nWindows)))
+         return false;
+   }
+
+   return true;
+}
+
+void EffectNoiseReduction::Worker::ComputeSpectrums
+(const WaveTrack &track, sampleCount start, size_t nWindows, float *spectrums)
+{
+   const auto nSamples = (nWindows - 1) * mStepSize + mWindowSize;
+   FloatVector buffer(nSamples);
+   track.Get((samplePtr)&buffer[0], floatSample, start, nSamples);
+
+   for (size_t ii = 0; ii < nWindows; ++ii) {
+      memmove(&mInWaveBuffer[0], &buffer[ii * mStepSize],
+         mWindowSize * sizeof(float));
+      FillFirstHistoryWindow();
+      const float *const pPower = &mQueue[0]->mSpectrums[0];
+      std::copy(pPower, pPower + mSpectrumSize, spectrums + ii * mSpectrumSize);
+   }
+}
+
+bool EffectNoiseReduction::Worker::ReduceSegments
+(EffectNoiseReduction &effect, Statistics &statistics,
+ int count, const WaveTrack &track, sampleCount start, sampleCount len,
+ size_t warmUpSteps, WaveTrack &outputTrack)
+{
+   // Steps of output, as many as FinishTrack makes; the last may pass the
+   // end of the selection
+   const auto nSteps = ((len + mStepSize - 1) / mStepSize).as_long_long();
+
+   auto &pool = ThreadPool::Get();
+   const auto nHelpers = pool.GetConcurrency();
+   MakeHelpers(nHelpers);
+
+   const size_t stepsPerTask = std::max<size_t>(1, SegmentSamples / mStepSize);
+   const auto stepsPerRound = nHelpers * stepsPerTask;
+
+   for (long long first = 0; first < nSteps; first += stepsPerRound) {
+      const auto nn = (size_t)std::min<long long>(
+         stepsPerRound, nSteps - first);
+      const auto nTasks = (nn + stepsPerTask - 1) / stepsPerTask;
+      pool.ParallelFor(nTasks, [&](size_t iTask) {
+         const auto offset = iTask * stepsPerTask;
+         const sampleCount begin = first + offset;
+         mHelpers[iTask]->ReduceSegment(statistics, track, start, len,
+            begin, begin + std::min(stepsPerTask, nn - offset), warmUpSteps);
+      });
+
+      // Append in order
+      for (size_t iTask = 0; iTask < nTasks; ++iTask) {
+         auto &output = mHelpers[iTask]->mSegmentOutput;
+         outputTrack.Append((samplePtr)&output[0], floatSample, output.size());
+         output.clear();
+      }
+
+      // Update the Progress meter, let user cancel
+      if (effect.TrackProgress(count,
+            double(first + nn) / double(nSteps)))
+         return false;
+   }
+
+   return true;
+}
+
+void EffectNoiseReduction::Worker::ReduceSegment
+(Statistics &statistics, const WaveTrack &track,
+ sampleCount start, sampleCount len,
+ sampleCount first, sampleCount end, size_t warmUpSteps)
+{
+   // Begin early enough that the steps from first on are as if processing
+   // began at the start; or begin at the start
+   const auto begin = std::max<sampleCount>(0, first - warmUpSteps);
+   StartNewTrack();
+   mSegmentOutput.clear();
+   mSegmentSkip = first - begin;
+   const auto stop = end - begin;
+
+   const auto bufferSize =
+      std::max<size_t>(1, track.GetMaxBlockSize() / mStepSize) * mStepSize;
+   FloatVector buffer(bufferSize);
+   auto samplePos = begin * mStepSize;
+   while (mOutStepCount < stop) {
+      // Past the end of the selection, feed silence, as FinishTrack does
+      const auto avail = limitSampleBufferSize(bufferSize, len - samplePos);
+      if (avail > 0)
+         track.Get((samplePtr)&buffer[0], floatSample,
+            start + samplePos, avail);
+      std::fill(buffer.begin() + avail, buffer.end(), 0.0f);
+      samplePos += bufferSize;
+
+      // One step at a time, so as not to go far past the stop
+      for (size_t offset = 0;
+           offset < bufferSize && mOutStepCount < stop;
+           offset += mStepSize) {
+         mInSampleCount += mStepSize;
+         ProcessSamples(statistics, nullptr, mStepSize, &buffer[offset]);
+      }
+   }
+}
+
 //----------------------------------------------------------------------------
 // EffectNoiseReduction::Dialog
 //----------------------------------------------------------------------------
@@ -224,6 +224,7 @@ bool EffectNormalize::Process()
 
    //Iterate over each track
    this->CopyInputTracks(); // Set up mOutputTracks.
+   auto cleanup = finally( [&] { mCache.Clear(); } );
    bool bGoodResult = true;
    double progress = 0;
    wxString topMsg;
@@ -472,24 +473,43 @@ bool EffectNormalize::AnalyseTrack(const WaveTrack * track, const wxString &msg,
       else
       {
 #endif
-         // Since we need complete summary data, we need to block until the OD tasks are done for this track
-         // This is needed for track->GetMinMax
-         // TODO: should we restrict the flags to just the relevant block files (for selections)
-         while (ProjectFileManager::GetODFlags( *track )) {
-            // update the gui
-            if (ProgressResult::Cancelled == mProgress->Update(
-               0, _("Waiting for waveform to finish computing...")) )
+         bool haveMinMax = false;
+         if(mDC)
+         {
+            result = AnalyseTrackData(track, msg, progress, ANALYSE_DC, offset);
+            if(!result)
                return false;
-            wxMilliSleep(100);
+
+            // The analysis found the extremes too, unless it read gaps
+            // between clips, whose zeroes GetMinMax would not count
+            auto pStats = mCache.GetStats(*track);
+            if(pStats && pStats->withinClips && pStats->count > 0)
+            {
+               min = pStats->min, max = pStats->max;
+               haveMinMax = true;
+            }
          }
 
-         // set mMin, mMax.  No progress bar here as it's fast.
-         auto pair = track->GetMinMax(mCurT0, mCurT1); // may throw
-         min = pair.first, max = pair.second;
+         if(!haveMinMax)
+         {
+            // Since we need complete summary data, we need to block until the OD tasks are done for this track
+            // This is needed for track->GetMinMax
+            // TODO: should we restrict the flags to just the relevant block files (for selections)
+            while (ProjectFileManager::GetODFlags( *track )) {
+               // update the gui
+               if (ProgressResult::Cancelled == mProgress->Update(
+                  0, _("Waiting for waveform to finish computing...")) )
+                  return false;
+               wxMilliSleep(100);
+            }
+
+            // set mMin, mMax.  No progress bar here as it's fast.
+            auto pair = track->GetMinMax(mCurT0, mCurT1); // may throw
+            min = pair.first, max = pair.second;
+         }
 
          if(mDC)
          {
-            result = AnalyseTrackData(track, msg, progress, ANALYSE_DC, offset);
             min += offset;
             max += offset;
          }
@@ -538,6 +558,9 @@ bool EffectNormalize::AnalyseTrackData(const WaveTrack * track, const wxString &
    //be shorter than the length of the track being processed.
    Floats buffer{ track->GetMaxBlockSize() };
 
+   // Remember the samples for ProcessOne, and their statistics
+   mCache.Begin(*track, start, end);
+
    mSum   = 0.0; // dc offset inits
    mCount = 0;
 #ifdef EXPERIMENTAL_R128_NORM
@@ -561,6 +584,8 @@ bool EffectNormalize::AnalyseTrackData(const WaveTrack * track, const wxString &
       //Get the samples from the track and put them in the buffer
       track->Get((samplePtr) buffer.get(), floatSample, s, block, fillZero, true, &blockSamples);
       totalSamples += blockSamples;
+      // Before the loudness analysis, which filters the buffer in place
+      mCache.Add(*track, buffer.get(), block, blockSamples);
 
       //Process the buffer.
       if(op == ANALYSE_DC)
@@ -625,8 +650,9 @@ bool EffectNormalize::ProcessOne(
          end - s
       );
 
-      //Get the samples from the track and put them in the buffer
-      track->Get((samplePtr) buffer.get(), floatSample, s, block);
+      //Get the samples from the analysis, if it kept them, or else from
+      //the track, and put them in the buffer
+      mCache.Get(*track, buffer.get(), s, block);
 
       //Process the buffer.
       ProcessData(buffer.get(), block, offset);
@@ -645,6 +671,7 @@ bool EffectNormalize::ProcessOne(
       }
    }
    progress += 1.0/double(2*GetNumWaveTracks());
+   mCache.Release(*track);
 
    //Return true because the effect processing succeeded ... unless cancelled
    return rc;
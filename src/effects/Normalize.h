@@ -16,6 +16,7 @@
 #include "../Experimental.h"
 
 #include "Effect.h"
+#include "AnalysisCache.h"
 #include "Biquad.h"
 
 class wxCheckBox;
@@ -105,6 +106,9 @@ private:
 #endif
    sampleCount    mCount;
 
+   // Samples that the analysis read, for the processing
+   AnalysisCache mCache;
+
    wxCheckBox *mGainCheckBox;
    wxCheckBox *mDCCheckBox;
    wxTextCtrl *mLevelTextCtrl;
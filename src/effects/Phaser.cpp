@@ -247,6 +247,43 @@ bool EffectPhaser::SetAutomationParameters(CommandParameters & parms)
 
 // Effect implementation
 
+bool EffectPhaser::SupportsParallelProcessing()
+{
+   return true;
+}
+
+bool EffectPhaser::ParallelInitialize(size_t numInstances)
+{
+   mInstances.resize(numInstances);
+
+   return true;
+}
+
+bool EffectPhaser::ParallelProcessInitialize(size_t instance, float sampleRate,
+   sampleCount WXUNUSED(totalLen), ChannelNames chanMap)
+{
+   InstanceInit(mInstances[instance], sampleRate);
+   if (chanMap[0] == ChannelNameFrontRight)
+   {
+      mInstances[instance].phase += M_PI;
+   }
+
+   return true;
+}
+
+size_t EffectPhaser::ParallelProcessBlock(size_t instance,
+   float **inBlock, float **outBlock, size_t blockLen)
+{
+   return InstanceProcess(mInstances[instance], inBlock, outBlock, blockLen);
+}
+
+bool EffectPhaser::ParallelFinalize()
+{
+   mInstances.clear();
+
+   return true;
+}
+
 void EffectPhaser::PopulateOrExchange(ShuttleGui & S)
 {
    S.SetBorder(5);
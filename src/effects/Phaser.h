@@ -77,6 +77,14 @@ public:
 
    // Effect implementation
 
+   bool SupportsParallelProcessing() override;
+   bool ParallelInitialize(size_t numInstances) override;
+   bool ParallelProcessInitialize(size_t instance, float sampleRate,
+      sampleCount totalLen, ChannelNames chanMap) override;
+   size_t ParallelProcessBlock(size_t instance,
+      float **inBlock, float **outBlock, size_t blockLen) override;
+   bool ParallelFinalize() override;
+
    void PopulateOrExchange(ShuttleGui & S) override;
    bool TransferDataToWindow() override;
    bool TransferDataFromWindow() override;
@@ -117,6 +125,7 @@ private:
 private:
    EffectPhaserState mMaster;
    std::vector<EffectPhaserState> mSlaves;
+   std::vector<EffectPhaserState> mInstances;
 
    // parameters
    int mStages;
@@ -15,9 +15,17 @@
 
 #include "audacity/EffectInterface.h"
 #include "MemoryX.h"
+#include "../ThreadPool.h"
 
+#include <algorithm>
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
 #include <wx/time.h>
+#include <wx/utils.h>
 
 class RealtimeEffectState
 {
@@ -42,6 +50,85 @@ private:
    std::atomic<int> mRealtimeSuspendCount{ 1 };    // Effects are initially suspended
 };
 
+struct RealtimeEffectManager::Chain
+{
+   std::vector< std::shared_ptr<RealtimeEffectState> > states;
+};
+
+// Held by the audio thread while it uses the published chain, so that the
+// main thread does not destroy that chain, or finalize or suspend its
+// effects, meanwhile.  Entering and leaving never wait.
+class RealtimeEffectManager::ReadGuard
+{
+public:
+   explicit ReadGuard( RealtimeEffectManager &manager )
+      : mReaders{ manager.mReaders[ manager.mEpoch.load() & 1 ] }
+   {
+      // Count ourselves in before looking at the chain
+      ++mReaders;
+      mChain = manager.mPublished.load();
+   }
+
+   ~ReadGuard()
+   {
+      --mReaders;
+   }
+
+   const Chain &GetChain() const { return *mChain; }
+
+private:
+   std::atomic<unsigned> &mReaders;
+   const Chain *mChain;
+};
+
+// Threads that share the processing of the groups of one buffer with the
+// audio thread.  They wait for each buffer by spinning a while, then on a
+// condition that the audio thread signals without blocking.  Groups are
+// claimed one at a time by compare and swap, so that a worker late for a
+// buffer finds no group left, and the audio thread does the work instead.
+class RealtimeEffectManager::Workers
+{
+public:
+   // Most groups in one batch
+   static const size_t MaxGroups = 0xFFFF;
+
+   explicit Workers( RealtimeEffectManager &manager );
+   ~Workers();
+
+   size_t Count() const { return mThreads.size(); }
+   void Add();
+
+   // Called by the audio thread
+   void Run( const Chain &chain, Group *groups, size_t nGroups );
+
+private:
+   // Generation of the batch, number of its groups, and the next group to
+   // claim, in one word
+   static uint64_t Pack( uint32_t generation, size_t count, size_t next )
+   {
+      return ( uint64_t( generation ) << 32 ) | ( count << 16 ) | next;
+   }
+
+   void Work();
+   // Process a group of the batch; false if none was left
+   bool ProcessOne( uint32_t generation );
+
+   RealtimeEffectManager &mManager;
+   std::vector< std::thread > mThreads;
+
+   std::atomic< uint64_t > mClaim{ 0 };
+   std::atomic< size_t > mDone{ 0 };
+   std::atomic< bool > mStop{ false };
+
+   // Written by the audio thread only, before it publishes a batch
+   uint32_t mGeneration{ 0 };
+   const Chain *mChain{};
+   Group *mGroups{};
+
+   std::mutex mMutex;
+   std::condition_variable mCondition;
+};
+
 RealtimeEffectManager & RealtimeEffectManager::Get()
 {
    static RealtimeEffectManager rem;
@@ -49,62 +136,189 @@ RealtimeEffectManager & RealtimeEffectManager::Get()
 }
 
 RealtimeEffectManager::RealtimeEffectManager()
+   : mChain{ std::make_unique< Chain >() }
 {
-   mRealtimeLock.Enter();
+   mReaders[0] = mReaders[1] = 0;
+   mPublished = mChain.get();
    mRealtimeActive = false;
    mRealtimeSuspended = true;
    mRealtimeLatency = 0;
-   mRealtimeLock.Leave();
 }
 
 RealtimeEffectManager::~RealtimeEffectManager()
 {
 }
 
+void RealtimeEffectManager::Publish(std::unique_ptr<Chain> chain)
+{
+   mPublished = chain.get();
+
+   // The old chain may still be in use by the audio thread
+   Synchronize();
+   mChain = std::move(chain);
+}
+
+void RealtimeEffectManager::Synchronize()
+{
+   // Switch new readers to the other counter, and wait for the old one to
+   // drain.  Do it for both counters, because a reader may have chosen its
+   // counter just before the switch but counted itself in just after.
+   for (int i = 0; i < 2; i++)
+   {
+      auto &readers = mReaders[ mEpoch++ & 1 ];
+      while (readers.load() != 0)
+         wxMilliSleep(1);
+   }
+}
+
+RealtimeEffectManager::Workers::Workers( RealtimeEffectManager &manager )
+   : mManager{ manager }
+{
+}
+
+RealtimeEffectManager::Workers::~Workers()
+{
+   {
+      std::lock_guard< std::mutex > lock{ mMutex };
+      mStop = true;
+   }
+   mCondition.notify_all();
+   for ( auto &thread : mThreads )
+      thread.join();
+}
+
+void RealtimeEffectManager::Workers::Add()
+{
+   mThreads.emplace_back( [this]{ Work(); } );
+}
+
+void RealtimeEffectManager::Workers::Run(
+   const Chain &chain, Group *groups, size_t nGroups )
+{
+   mChain = &chain;
+   mGroups = groups;
+   mDone = 0;
+   const auto generation = ++mGeneration;
+   mClaim = Pack( generation, nGroups, 0 );
+
+   // Wake the workers that sleep.  Don't wait for the mutex to do it; a
+   // worker that misses the signal only leaves more groups to this thread.
+   if ( mMutex.try_lock() ) {
+      mCondition.notify_all();
+      mMutex.unlock();
+   }
+   else
+      mCondition.notify_all();
+
+   while ( ProcessOne( generation ) )
+      ;
+
+   // Wait only for workers still busy with groups they claimed
+   while ( mDone < nGroups )
+      std::this_thread::yield();
+}
+
+void RealtimeEffectManager::Workers::Work()
+{
+   // Times to yield while waiting for a batch, before sleeping
+   const int SpinCount = 200;
+
+   uint32_t seen = 0;
+   int spins = 0;
+   while ( !mStop ) {
+      const auto generation = uint32_t( mClaim >> 32 );
+      if ( generation == seen ) {
+         // The next buffer is likely soon; so spin a while before sleeping
+         // until signalled.  The timeout only bounds the sleep after a
+         // signal that the audio thread sent without taking the mutex.
+         if ( ++spins < SpinCount ) {
+            std::this_thread::yield();
+            continue;
+         }
+         std::unique_lock< std::mutex > lock{ mMutex };
+         mCondition.wait_for( lock, std::chrono::milliseconds( 100 ), [&]{
+            return mStop || uint32_t( mClaim >> 32 ) != seen;
+         } );
+         continue;
+      }
+
+      seen = generation;
+      spins = 0;
+      while ( ProcessOne( generation ) )
+         ;
+   }
+}
+
+bool RealtimeEffectManager::Workers::ProcessOne( uint32_t generation )
+{
+   auto claim = mClaim.load();
+   while ( true ) {
+      const size_t count = ( claim >> 16 ) & MaxGroups;
+      const size_t next = claim & MaxGroups;
+      if ( uint32_t( claim >> 32 ) != generation || next >= count )
+         return false;
+      if ( mClaim.compare_exchange_weak( claim, claim + 1 ) ) {
+         // The batch can't change until this group is done
+         auto &group = mGroups[ next ];
+         group.processed = mManager.ProcessGroup( *mChain,
+            group.group, group.chans, group.buffers, group.numSamples );
+         ++mDone;
+         return true;
+      }
+   }
+}
+
 #if defined(EXPERIMENTAL_EFFECTS_RACK)
 void RealtimeEffectManager::RealtimeSetEffects(const EffectArray & effects)
 {
-   // Block RealtimeProcess()
-   RealtimeSuspend();
-
-   decltype( mStates ) newStates;
-   auto begin = mStates.begin(), end = mStates.end();
+   auto &states = mChain->states;
+   auto newChain = std::make_unique< Chain >();
+   auto begin = states.begin(), end = states.end();
    for ( auto pEffect : effects ) {
       auto found = std::find_if( begin, end,
-         [=]( const decltype( mStates )::value_type &state ){
-            return state && &state->GetEffect() == pEffect;
+         [=]( const std::shared_ptr< RealtimeEffectState > &state ){
+            return &state->GetEffect() == pEffect;
          }
       );
       if ( found == end ) {
          // Tell New effect to get ready
          pEffect->RealtimeInitialize();
-         newStates.emplace_back(
-            std::make_unique< RealtimeEffectState >( *pEffect ) );
+         auto state = std::make_shared< RealtimeEffectState >( *pEffect );
+         if (mRealtimeActive)
+         {
+            for (size_t i = 0, cnt = mRealtimeChans.size(); i < cnt; i++)
+               state->RealtimeAddProcessor(
+                  i, mRealtimeChans[i], mRealtimeRates[i]);
+         }
+         if (!mRealtimeSuspended)
+            state->RealtimeResume();
+         newChain->states.push_back( std::move( state ) );
       }
       else {
          // Preserve state for effect that remains in the chain
-         newStates.emplace_back( std::move( *found ) );
+         newChain->states.push_back( *found );
       }
    }
 
-   // Remaining states that were not moved need to clean up
-   for ( auto &state : mStates ) {
-      if ( state )
-         state->GetEffect().RealtimeFinalize();
-   }
+   // Remember the states that were not kept
+   auto removed = states;
+   for ( auto &state : newChain->states )
+      removed.erase( std::remove( removed.begin(), removed.end(), state ),
+         removed.end() );
 
-   // Get rid of the old chain
-   // And install the NEW one
-   mStates.swap( newStates );
+   // Install the NEW chain, without interrupting RealtimeProcess()
+   Publish( std::move( newChain ) );
 
-   // Allow RealtimeProcess() to, well, process 
-   RealtimeResume();
+   // Remaining states that were not moved need to clean up, now that the
+   // audio thread no longer uses them
+   for ( auto &state : removed )
+      state->GetEffect().RealtimeFinalize();
 }
 #endif
 
 bool RealtimeEffectManager::RealtimeIsActive()
 {
-   return mStates.size() != 0;
+   return mChain->states.size() != 0;
 }
 
 bool RealtimeEffectManager::RealtimeIsSuspended()
@@ -114,12 +328,8 @@ bool RealtimeEffectManager::RealtimeIsSuspended()
 
 void RealtimeEffectManager::RealtimeAddEffect(EffectClientInterface *effect)
 {
-   // Block RealtimeProcess()
-   RealtimeSuspend();
-
-   // Add to list of active effects
-   mStates.emplace_back( std::make_unique< RealtimeEffectState >( *effect ) );
-   auto &state = mStates.back();
+   // Prepare the new state before the audio thread can see it
+   auto state = std::make_shared< RealtimeEffectState >( *effect );
 
    // Initialize effect if realtime is already active
    if (mRealtimeActive)
@@ -133,35 +343,38 @@ void RealtimeEffectManager::RealtimeAddEffect(EffectClientInterface *effect)
          state->RealtimeAddProcessor(i, mRealtimeChans[i], mRealtimeRates[i]);
       }
    }
-   
 
-   // Allow RealtimeProcess() to, well, process 
-   RealtimeResume();
+   // Let it process at once if the others do
+   if (!mRealtimeSuspended)
+      state->RealtimeResume();
+
+   // Add to list of active effects
+   auto newChain = std::make_unique< Chain >( *mChain );
+   newChain->states.push_back( std::move( state ) );
+   Publish( std::move( newChain ) );
 }
 
 void RealtimeEffectManager::RealtimeRemoveEffect(EffectClientInterface *effect)
 {
-   // Block RealtimeProcess()
-   RealtimeSuspend();
-
-   if (mRealtimeActive)
-   {
-      // Cleanup realtime processing
-      effect->RealtimeFinalize();
-   }
-      
    // Remove from list of active effects
-   auto end = mStates.end();
-   auto found = std::find_if( mStates.begin(), end,
-      [&](const decltype(mStates)::value_type &state){
+   auto newChain = std::make_unique< Chain >( *mChain );
+   auto &states = newChain->states;
+   auto end = states.end();
+   auto found = std::find_if( states.begin(), end,
+      [&](const std::shared_ptr< RealtimeEffectState > &state){
          return &state->GetEffect() == effect;
       }
    );
    if (found != end)
-      mStates.erase(found);
+      states.erase(found);
+   Publish( std::move( newChain ) );
 
-   // Allow RealtimeProcess() to, well, process 
-   RealtimeResume();
+   // The audio thread no longer uses the effect
+   if (mRealtimeActive)
+   {
+      // Cleanup realtime processing
+      effect->RealtimeFinalize();
+   }
 }
 
 void RealtimeEffectManager::RealtimeInitialize(double rate)
@@ -172,13 +385,14 @@ void RealtimeEffectManager::RealtimeInitialize(double rate)
    // (Re)Set processor parameters
    mRealtimeChans.clear();
    mRealtimeRates.clear();
+   mRealtimeLoads.clear();
 
    // RealtimeAdd/RemoveEffect() needs to know when we're active so it can
    // initialize newly added effects
    mRealtimeActive = true;
 
    // Tell each effect to get ready for action
-   for (auto &state : mStates) {
+   for (auto &state : mChain->states) {
       state->GetEffect().SetSampleRate(rate);
       state->GetEffect().RealtimeInitialize();
    }
@@ -189,11 +403,24 @@ void RealtimeEffectManager::RealtimeInitialize(double rate)
 
 void RealtimeEffectManager::RealtimeAddProcessor(int group, unsigned chans, float rate)
 {
-   for (auto &state : mStates)
+   // The audio thread is not running yet
+   for (auto &state : mChain->states)
       state->RealtimeAddProcessor(group, chans, rate);
 
    mRealtimeChans.push_back(chans);
    mRealtimeRates.push_back(rate);
+   mRealtimeLoads.emplace_back(0.0f);
+
+   // Start another thread for each further group, up to the number of
+   // processors, counting the audio thread; none with only one processor
+   const auto maxWorkers = ThreadPool::Get().GetConcurrency() - 1;
+   if (group > 0 && maxWorkers > 0 && (!mWorkers ||
+       mWorkers->Count() < std::min<size_t>(group, maxWorkers)))
+   {
+      if (!mWorkers)
+         mWorkers = std::make_unique<Workers>(*this);
+      mWorkers->Add();
+   }
 }
 
 void RealtimeEffectManager::RealtimeFinalize()
@@ -205,12 +432,16 @@ void RealtimeEffectManager::RealtimeFinalize()
    mRealtimeLatency = 0;
 
    // Tell each effect to clean up as well
-   for (auto &state : mStates)
+   for (auto &state : mChain->states)
       state->GetEffect().RealtimeFinalize();
 
    // Reset processor parameters
    mRealtimeChans.clear();
    mRealtimeRates.clear();
+   mRealtimeLoads.clear();
+
+   // Stop the threads
+   mWorkers.reset();
 
    // No longer active
    mRealtimeActive = false;
@@ -218,44 +449,33 @@ void RealtimeEffectManager::RealtimeFinalize()
 
 void RealtimeEffectManager::RealtimeSuspend()
 {
-   mRealtimeLock.Enter();
-
    // Already suspended...bail
    if (mRealtimeSuspended)
-   {
-      mRealtimeLock.Leave();
       return;
-   }
 
    // Show that we aren't going to be doing anything
    mRealtimeSuspended = true;
 
+   // Let the audio thread finish what it was doing
+   Synchronize();
+
    // And make sure the effects don't either
-   for (auto &state : mStates)
+   for (auto &state : mChain->states)
       state->RealtimeSuspend();
-
-   mRealtimeLock.Leave();
 }
 
 void RealtimeEffectManager::RealtimeResume()
 {
-   mRealtimeLock.Enter();
-
    // Already running...bail
    if (!mRealtimeSuspended)
-   {
-      mRealtimeLock.Leave();
       return;
-   }
 
    // Tell the effects to get ready for more action
-   for (auto &state : mStates)
+   for (auto &state : mChain->states)
       state->RealtimeResume();
 
    // And we should too
    mRealtimeSuspended = false;
-
-   mRealtimeLock.Leave();
 }
 
 //
@@ -263,21 +483,19 @@ void RealtimeEffectManager::RealtimeResume()
 //
 void RealtimeEffectManager::RealtimeProcessStart()
 {
-   // Protect ourselves from the main thread
-   mRealtimeLock.Enter();
+   // Keep the main thread from destroying the chain while we use it
+   ReadGuard guard{ *this };
 
    // Can be suspended because of the audio stream being paused or because effects
    // have been suspended.
    if (!mRealtimeSuspended)
    {
-      for (auto &state : mStates)
+      for (auto &state : guard.GetChain().states)
       {
          if (state->IsRealtimeActive())
             state->GetEffect().RealtimeProcessStart();
       }
    }
-
-   mRealtimeLock.Leave();
 }
 
 //
@@ -285,21 +503,70 @@ void RealtimeEffectManager::RealtimeProcessStart()
 //
 size_t RealtimeEffectManager::RealtimeProcess(int group, unsigned chans, float **buffers, size_t numSamples)
 {
-   // Protect ourselves from the main thread
-   mRealtimeLock.Enter();
+   // Keep the main thread from destroying the chain while we use it
+   ReadGuard guard{ *this };
+   auto &chain = guard.GetChain();
 
    // Can be suspended because of the audio stream being paused or because effects
    // have been suspended, so allow the samples to pass as-is.
-   if (mRealtimeSuspended || mStates.empty())
-   {
-      mRealtimeLock.Leave();
+   if (mRealtimeSuspended || chain.states.empty())
       return numSamples;
-   }
 
    // Remember when we started so we can calculate the amount of latency we
    // are introducing
    wxMilliClock_t start = wxGetUTCTimeMillis();
 
+   auto result = ProcessGroup(chain, group, chans, buffers, numSamples);
+
+   // Remember the latency
+   mRealtimeLatency = (int) (wxGetUTCTimeMillis() - start).GetValue();
+
+   return result;
+}
+
+//
+// This will be called in a different thread than the main GUI thread.
+//
+void RealtimeEffectManager::RealtimeProcess(Group *groups, size_t nGroups)
+{
+   // Keep the main thread from destroying the chain while we, and the
+   // workers, use it
+   ReadGuard guard{ *this };
+   auto &chain = guard.GetChain();
+
+   if (mRealtimeSuspended || chain.states.empty())
+   {
+      for (size_t i = 0; i < nGroups; i++)
+         groups[i].processed = groups[i].numSamples;
+      return;
+   }
+
+   wxMilliClock_t start = wxGetUTCTimeMillis();
+
+   if (mWorkers && nGroups > 1 && nGroups <= Workers::MaxGroups)
+      mWorkers->Run(chain, groups, nGroups);
+   else
+   {
+      for (size_t i = 0; i < nGroups; i++)
+      {
+         auto &group = groups[i];
+         group.processed = ProcessGroup(chain,
+            group.group, group.chans, group.buffers, group.numSamples);
+      }
+   }
+
+   mRealtimeLatency = (int) (wxGetUTCTimeMillis() - start).GetValue();
+}
+
+//
+// This will be called by the audio thread or a worker.
+//
+size_t RealtimeEffectManager::ProcessGroup(const Chain &chain,
+   int group, unsigned chans, float **buffers, size_t numSamples)
+{
+   auto &states = chain.states;
+   const auto begin = std::chrono::steady_clock::now();
+
    // Allocate the in/out buffer arrays
    float **ibuf = (float **) alloca(chans * sizeof(float *));
    float **obuf = (float **) alloca(chans * sizeof(float *));
@@ -315,7 +582,7 @@ size_t RealtimeEffectManager::RealtimeProcess(int group, unsigned chans, float *
    // Now call each effect in the chain while swapping buffer pointers to feed the
    // output of one effect as the input to the next effect
    size_t called = 0;
-   for (auto &state : mStates)
+   for (auto &state : states)
    {
       if (state->IsRealtimeActive())
       {
@@ -344,10 +611,14 @@ size_t RealtimeEffectManager::RealtimeProcess(int group, unsigned chans, float *
       }
    }
 
-   // Remember the latency
-   mRealtimeLatency = (int) (wxGetUTCTimeMillis() - start).GetValue();
-
-   mRealtimeLock.Leave();
+   // Remember the fraction of real time that this took
+   if (numSamples > 0 && group >= 0 && (size_t)group < mRealtimeLoads.size())
+   {
+      const std::chrono::duration<double> elapsed =
+         std::chrono::steady_clock::now() - begin;
+      mRealtimeLoads[group] =
+         elapsed.count() * mRealtimeRates[group] / numSamples;
+   }
 
    //
    // This is wrong...needs to handle tails
@@ -360,21 +631,19 @@ size_t RealtimeEffectManager::RealtimeProcess(int group, unsigned chans, float *
 //
 void RealtimeEffectManager::RealtimeProcessEnd()
 {
-   // Protect ourselves from the main thread
-   mRealtimeLock.Enter();
+   // Keep the main thread from destroying the chain while we use it
+   ReadGuard guard{ *this };
 
    // Can be suspended because of the audio stream being paused or because effects
    // have been suspended.
    if (!mRealtimeSuspended)
    {
-      for (auto &state : mStates)
+      for (auto &state : guard.GetChain().states)
       {
          if (state->IsRealtimeActive())
             state->GetEffect().RealtimeProcessEnd();
       }
    }
-
-   mRealtimeLock.Leave();
 }
 
 int RealtimeEffectManager::GetRealtimeLatency()
@@ -382,6 +651,21 @@ int RealtimeEffectManager::GetRealtimeLatency()
    return mRealtimeLatency;
 }
 
+float RealtimeEffectManager::GetRealtimeLoad(int group)
+{
+   if (group < 0 || (size_t)group >= mRealtimeLoads.size())
+      return 0;
+   return mRealtimeLoads[group];
+}
+
+float RealtimeEffectManager::GetRealtimeLoad()
+{
+   float result = 0;
+   for (auto &load : mRealtimeLoads)
+      result = std::max<float>(result, load);
+   return result;
+}
+
 RealtimeEffectState::RealtimeEffectState( EffectClientInterface &effect )
    : mEffect{ effect }
 {
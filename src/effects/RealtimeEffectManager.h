@@ -11,9 +11,10 @@
 #ifndef __AUDACITY_REALTIME_EFFECT_MANAGER__
 #define __AUDACITY_REALTIME_EFFECT_MANAGER__
 
+#include <atomic>
+#include <deque>
 #include <memory>
 #include <vector>
-#include <wx/thread.h>
 
 class EffectClientInterface;
 class RealtimeEffectState;
@@ -42,14 +43,64 @@ public:
    void RealtimeProcessEnd();
    int GetRealtimeLatency();
 
+   // One group's buffers, for processing several groups at once
+   struct Group
+   {
+      int group;
+      unsigned chans;
+      float **buffers;
+      size_t numSamples;
+      // Set by RealtimeProcess, as the single group version returns it
+      size_t processed;
+   };
+   // Process each group as the single group version does, but concurrently
+   // on worker threads too, when there is more than one group.  Does not
+   // allocate, and waits only for workers that are processing some of the
+   // groups.
+   void RealtimeProcess(Group *groups, size_t nGroups);
+
+   // Fraction of the real time of its last buffer that processing of the
+   // group took, or of the busiest group
+   float GetRealtimeLoad(int group);
+   float GetRealtimeLoad();
+
 private:
    RealtimeEffectManager();
    ~RealtimeEffectManager();
 
-   wxCriticalSection mRealtimeLock;
-   std::vector< std::unique_ptr<RealtimeEffectState> > mStates;
-   int mRealtimeLatency;
-   bool mRealtimeSuspended;
+   // The effects in order, as the audio thread sees them.  A chain is never
+   // changed once published; edits publish a new one instead, so that the
+   // audio thread need not wait for them.
+   struct Chain;
+   class ReadGuard;
+   class Workers;
+
+   // Make chain the one that the audio thread sees, and destroy the old one
+   // once no audio thread still uses it
+   void Publish(std::unique_ptr<Chain> chain);
+   // Wait until the audio thread has left any RealtimeProcess...() call that
+   // it entered before this
+   void Synchronize();
+
+   size_t ProcessGroup(const Chain &chain,
+      int group, unsigned chans, float **buffers, size_t numSamples);
+
+   // These are changed by the main thread only
+   std::unique_ptr<Chain> mChain;
+   std::atomic<const Chain*> mPublished{ nullptr };
+
+   // Audio threads count themselves in one of the two readers, chosen by the
+   // parity of the epoch
+   std::atomic<unsigned> mEpoch{ 0 };
+   std::atomic<unsigned> mReaders[2];
+
+   // Threads that RealtimeProcess() for several groups shares them with,
+   // started as groups are added
+   std::unique_ptr<Workers> mWorkers;
+
+   std::atomic<int> mRealtimeLatency;
+   std::deque< std::atomic<float> > mRealtimeLoads;
+   std::atomic<bool> mRealtimeSuspended;
    bool mRealtimeActive;
    std::vector<unsigned> mRealtimeChans;
    std::vector<double> mRealtimeRates;
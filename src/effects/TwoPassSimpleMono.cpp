@@ -30,15 +30,24 @@ bool EffectTwoPassSimpleMono::Process()
 
     InitPass1();
     this->CopyInputTracks(); // Set up mOutputTracks.
+    auto cleanup = finally( [&] { mCache.Clear(); } );
     bool bGoodResult = ProcessPass();
 
+    bool secondPass = false;
     if (bGoodResult && !mSecondPassDisabled)
     {
         mPass = 1;
-        if (InitPass2())
+        secondPass = InitPass2();
+        if (secondPass)
             bGoodResult = ProcessPass();
     }
 
+    if (bGoodResult && !secondPass)
+        // The first pass left in the cache what it did not set onto
+        // the tracks
+        for( auto track : mOutputTracks->Selected< WaveTrack >() )
+            mCache.Put(*track);
+
     this->ReplaceProcessedTracks(bGoodResult);
     return bGoodResult;
 }
@@ -109,8 +118,15 @@ bool EffectTwoPassSimpleMono::ProcessOne(WaveTrack * track,
    auto samples1 =  limitSampleBufferSize(
       std::min( maxblock, track->GetBestBlockSize(start) ), end - start );
 
-   //Get the samples from the track and put them in the buffer
-   track->Get((samplePtr) buffer1.get(), floatSample, start, samples1);
+   // The first pass keeps its output in memory, if it fits, for the second
+   // pass, which sets it onto the track; so the first pass need not
+   bool deferred = false;
+   if (mPass == 0 && !mSecondPassDisabled)
+      deferred = mCache.Begin(*track, start, end);
+
+   //Get the samples from the first pass, if it kept them, or else from the
+   //track, and put them in the buffer
+   mCache.Get(*track, buffer1.get(), start, samples1);
 
    // Process the first buffer with a NULL previous buffer
    if (mPass == 0)
@@ -131,8 +147,8 @@ bool EffectTwoPassSimpleMono::ProcessOne(WaveTrack * track,
          std::min( track->GetBestBlockSize(s), maxblock ), end - s
       );
 
-      //Get the samples from the track and put them in the buffer
-      track->Get((samplePtr)buffer2.get(), floatSample, s, samples2);
+      //Get the samples and put them in the buffer
+      mCache.Get(*track, buffer2.get(), s, samples2);
 
       //Process the buffer.  If it fails, clean up and exit.
       if (mPass == 0)
@@ -145,7 +161,7 @@ bool EffectTwoPassSimpleMono::ProcessOne(WaveTrack * track,
 
       //Processing succeeded. copy the newly-changed samples back
       //onto the track.
-      track->Set((samplePtr)buffer1.get(), floatSample, s - samples1, samples1);
+      Store(track, buffer1.get(), s - samples1, samples1, deferred);
 
       //Increment s one blockfull of samples
       s += samples2;
@@ -181,12 +197,24 @@ bool EffectTwoPassSimpleMono::ProcessOne(WaveTrack * track,
 
    //Processing succeeded. copy the newly-changed samples back
    //onto the track.
-   track->Set((samplePtr)buffer1.get(), floatSample, s - samples1, samples1);
+   Store(track, buffer1.get(), s - samples1, samples1, deferred);
+
+   if (mPass == 1)
+      mCache.Release(*track);
 
    //Return true because the effect processing succeeded.
    return true;
 }
 
+void EffectTwoPassSimpleMono::Store(WaveTrack * track,
+   float *buffer, sampleCount start, size_t len, bool deferred)
+{
+   if (mPass == 0)
+      mCache.Add(*track, buffer, len);
+   if (!deferred)
+      track->Set((samplePtr)buffer, floatSample, start, len);
+}
+
 bool EffectTwoPassSimpleMono::NewTrackPass1()
 {
    return true;
@@ -13,6 +13,7 @@
 #define __AUDACITY_EFFECT_TWOPASSSIMPLEMONO__
 
 #include "SimpleMono.h"
+#include "AnalysisCache.h"
 
 
 class WaveTrack;
@@ -79,6 +80,11 @@ private:
    bool ProcessOne(WaveTrack * t,
                    sampleCount start, sampleCount end);
    bool ProcessPass() override;
+   void Store(WaveTrack * t,
+              float *buffer, sampleCount start, size_t len, bool deferred);
+
+   // Output of the first pass, for the second
+   AnalysisCache mCache;
 };
 
 #endif
@@ -1493,6 +1493,9 @@ bool VSTEffect::RealtimeAddProcessor(unsigned numChannels, float sampleRate)
       callDispatcher(effEndSetProgram, 0, 0, NULL, 0.0);
    }
 
+   mGroupIn.reinit(mSlaves.size() * mAudioIns, mBlockSize, true);
+   mGroupSamples.resize(mSlaves.size());
+
    return slave->ProcessInitialize(0, NULL);
 }
 
@@ -1506,6 +1509,9 @@ bool VSTEffect::RealtimeFinalize()
 
    mMasterOut.reset();
 
+   mGroupIn.reset();
+   mGroupSamples.clear();
+
    return ProcessFinalize();
 }
 
@@ -1535,6 +1541,7 @@ bool VSTEffect::RealtimeProcessStart()
       memset(mMasterIn[i].get(), 0, mBlockSize * sizeof(float));
 
    mNumSamples = 0;
+   std::fill(mGroupSamples.begin(), mGroupSamples.end(), 0);
 
    return true;
 }
@@ -1543,20 +1550,34 @@ size_t VSTEffect::RealtimeProcess(int group, float **inbuf, float **outbuf, size
 {
    wxASSERT(numSamples <= mBlockSize);
 
+   // This may run on several threads at once, for different groups, so
+   // the master's input is summed later, in RealtimeProcessEnd()
    for (unsigned int c = 0; c < mAudioIns; c++)
    {
-      for (decltype(numSamples) s = 0; s < numSamples; s++)
-      {
-         mMasterIn[c][s] += inbuf[c][s];
-      }
+      memcpy(mGroupIn[group * mAudioIns + c].get(), inbuf[c],
+         numSamples * sizeof(float));
    }
-   mNumSamples = std::max(numSamples, mNumSamples);
+   mGroupSamples[group] = numSamples;
 
    return mSlaves[group]->ProcessBlock(inbuf, outbuf, numSamples);
 }
 
 bool VSTEffect::RealtimeProcessEnd()
 {
+   for (size_t group = 0, cnt = mGroupSamples.size(); group < cnt; group++)
+   {
+      const auto numSamples = mGroupSamples[group];
+      for (unsigned int c = 0; c < mAudioIns; c++)
+      {
+         const float *const groupIn = mGroupIn[group * mAudioIns + c].get();
+         for (decltype(mNumSamples) s = 0; s < numSamples; s++)
+         {
+            mMasterIn[c][s] += groupIn[s];
+         }
+      }
+      mNumSamples = std::max(numSamples, mNumSamples);
+   }
+
    // These casts to float** should be safe...
    ProcessBlock(
       reinterpret_cast <float**> (mMasterIn.get()),
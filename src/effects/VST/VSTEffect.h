@@ -366,6 +366,11 @@ private:
    unsigned mNumChannels;
    FloatBuffers mMasterIn, mMasterOut;
    size_t mNumSamples;
+   // The input of each group, for the master, apart from the others
+   // because groups may be processed on several threads at once:
+   // mAudioIns buffers for each group, and how many samples each had
+   FloatBuffers mGroupIn;
+   std::vector<size_t> mGroupSamples;
 
    // UI
    wxDialog *mDialog;
@@ -231,6 +231,43 @@ bool EffectWahwah::SetAutomationParameters(CommandParameters & parms)
 
 // Effect implementation
 
+bool EffectWahwah::SupportsParallelProcessing()
+{
+   return true;
+}
+
+bool EffectWahwah::ParallelInitialize(size_t numInstances)
+{
+   mInstances.resize(numInstances);
+
+   return true;
+}
+
+bool EffectWahwah::ParallelProcessInitialize(size_t instance, float sampleRate,
+   sampleCount WXUNUSED(totalLen), ChannelNames chanMap)
+{
+   InstanceInit(mInstances[instance], sampleRate);
+   if (chanMap[0] == ChannelNameFrontRight)
+   {
+      mInstances[instance].phase += M_PI;
+   }
+
+   return true;
+}
+
+size_t EffectWahwah::ParallelProcessBlock(size_t instance,
+   float **inBlock, float **outBlock, size_t blockLen)
+{
+   return InstanceProcess(mInstances[instance], inBlock, outBlock, blockLen);
+}
+
+bool EffectWahwah::ParallelFinalize()
+{
+   mInstances.clear();
+
+   return true;
+}
+
 void EffectWahwah::PopulateOrExchange(ShuttleGui & S)
 {
    S.SetBorder(5);
@@ -74,6 +74,14 @@ public:
 
    // Effect implementation
 
+   bool SupportsParallelProcessing() override;
+   bool ParallelInitialize(size_t numInstances) override;
+   bool ParallelProcessInitialize(size_t instance, float sampleRate,
+      sampleCount totalLen, ChannelNames chanMap) override;
+   size_t ParallelProcessBlock(size_t instance,
+      float **inBlock, float **outBlock, size_t blockLen) override;
+   bool ParallelFinalize() override;
+
    void PopulateOrExchange(ShuttleGui & S) override;
    bool TransferDataToWindow() override;
    bool TransferDataFromWindow() override;
@@ -101,6 +109,7 @@ private:
 private:
    EffectWahwahState mMaster;
    std::vector<EffectWahwahState> mSlaves;
+   std::vector<EffectWahwahState> mInstances;
 
    /* Parameters:
    mFreq - LFO frequency
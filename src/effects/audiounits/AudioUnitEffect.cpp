@@ -1356,6 +1356,9 @@ bool AudioUnitEffect::RealtimeAddProcessor(unsigned numChannels, float sampleRat
    auto pSlave = slave.get();
    mSlaves.push_back(std::move(slave));
 
+   mGroupIn.reinit(mSlaves.size() * mAudioIns, mBlockSize, true);
+   mGroupSamples.resize(mSlaves.size());
+
    return pSlave->ProcessInitialize(0);
 }
 
@@ -1368,6 +1371,9 @@ bool AudioUnitEffect::RealtimeFinalize()
    mMasterIn.reset();
    mMasterOut.reset();
 
+   mGroupIn.reset();
+   mGroupSamples.clear();
+
    return ProcessFinalize();
 }
 
@@ -1395,6 +1401,7 @@ bool AudioUnitEffect::RealtimeProcessStart()
       memset(mMasterIn[i].get(), 0, mBlockSize * sizeof(float));
 
    mNumSamples = 0;
+   std::fill(mGroupSamples.begin(), mGroupSamples.end(), 0);
 
    return true;
 }
@@ -1406,20 +1413,34 @@ size_t AudioUnitEffect::RealtimeProcess(int group,
 {
    wxASSERT(numSamples <= mBlockSize);
 
+   // This may run on several threads at once, for different groups, so
+   // the master's input is summed later, in RealtimeProcessEnd()
    for (size_t c = 0; c < mAudioIns; c++)
    {
-      for (decltype(numSamples) s = 0; s < numSamples; s++)
-      {
-         mMasterIn[c][s] += inbuf[c][s];
-      }
+      memcpy(mGroupIn[group * mAudioIns + c].get(), inbuf[c],
+         numSamples * sizeof(float));
    }
-   mNumSamples = wxMax(numSamples, mNumSamples);
+   mGroupSamples[group] = numSamples;
 
    return mSlaves[group]->ProcessBlock(inbuf, outbuf, numSamples);
 }
 
 bool AudioUnitEffect::RealtimeProcessEnd()
 {
+   for (size_t group = 0, cnt = mGroupSamples.size(); group < cnt; group++)
+   {
+      const auto numSamples = mGroupSamples[group];
+      for (size_t c = 0; c < mAudioIns; c++)
+      {
+         const float *const groupIn = mGroupIn[group * mAudioIns + c].get();
+         for (decltype(mNumSamples) s = 0; s < numSamples; s++)
+         {
+            mMasterIn[c][s] += groupIn[s];
+         }
+      }
+      mNumSamples = wxMax(numSamples, mNumSamples);
+   }
+
    ProcessBlock(
       reinterpret_cast<float**>(mMasterIn.get()),
       reinterpret_cast<float**>(mMasterOut.get()),
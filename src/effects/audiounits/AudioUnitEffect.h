@@ -208,6 +208,11 @@ private:
    unsigned mNumChannels;
    ArraysOf<float> mMasterIn, mMasterOut;
    size_t mNumSamples;
+   // The input of each group, for the master, apart from the others
+   // because groups may be processed on several threads at once:
+   // mAudioIns buffers for each group, and how many samples each had
+   ArraysOf<float> mGroupIn;
+   std::vector<size_t> mGroupSamples;
 
    AUEventListenerRef mEventListenerRef;
 
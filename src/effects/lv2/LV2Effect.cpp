@@ -831,6 +831,9 @@ bool LV2Effect::RealtimeFinalize()
 
    mMasterOut.reset();
 
+   mGroupIn.reset();
+   mGroupSamples.clear();
+
    return true;
 }
 
@@ -850,6 +853,7 @@ bool LV2Effect::RealtimeProcessStart()
       memset(mMasterIn[p].get(), 0, mBlockSize * sizeof(float));
 
    mNumSamples = 0;
+   std::fill(mGroupSamples.begin(), mGroupSamples.end(), 0);
 
    return true;
 }
@@ -867,14 +871,15 @@ size_t LV2Effect::RealtimeProcess(int group,
       return 0;
    }
 
-   for (size_t p = 0, cnt = mAudioInputs.size(); p < cnt; p++)
+   // This may run on several threads at once, for different groups, so
+   // the master's input is summed later, in RealtimeProcessEnd()
+   const auto nInputs = mAudioInputs.size();
+   for (size_t p = 0; p < nInputs; p++)
    {
-      for (decltype(numSamples) s = 0; s < numSamples; s++)
-      {
-         mMasterIn[p][s] += inbuf[p][s];
-      }
+      memcpy(mGroupIn[group * nInputs + p].get(), inbuf[p],
+         numSamples * sizeof(float));
    }
-   mNumSamples = wxMax(numSamples, mNumSamples);
+   mGroupSamples[group] = numSamples;
 
    LilvInstance *slave = mSlaves[group];
 
@@ -905,11 +910,29 @@ bool LV2Effect::RealtimeAddProcessor(unsigned WXUNUSED(numChannels), float sampl
 
    mSlaves.push_back(slave);
 
+   mGroupIn.reinit(mSlaves.size() * mAudioInputs.size(), mBlockSize, true);
+   mGroupSamples.resize(mSlaves.size());
+
    return true;
 }
 
 bool LV2Effect::RealtimeProcessEnd()
 {
+   const auto nInputs = mAudioInputs.size();
+   for (size_t group = 0, cnt = mGroupSamples.size(); group < cnt; group++)
+   {
+      const auto numSamples = mGroupSamples[group];
+      for (size_t p = 0; p < nInputs; p++)
+      {
+         const float *const groupIn = mGroupIn[group * nInputs + p].get();
+         for (decltype(mNumSamples) s = 0; s < numSamples; s++)
+         {
+            mMasterIn[p][s] += groupIn[s];
+         }
+      }
+      mNumSamples = wxMax(numSamples, mNumSamples);
+   }
+
    lilv_instance_run(mMaster, mNumSamples);
 
    return true;
@@ -284,6 +284,11 @@ private:
 
    FloatBuffers mMasterIn, mMasterOut;
    size_t mNumSamples;
+   // The input of each group, for the master, apart from the others
+   // because groups may be processed on several threads at once:
+   // a buffer for each audio input for each group, and how many samples each had
+   FloatBuffers mGroupIn;
+   std::vector<size_t> mGroupSamples;
 
    double mLength;
 
@@ -62,6 +62,7 @@
 #include "../DirManager.h"
 #include "../FileFormats.h"
 #include "../Mix.h"
+#include "../MixerPipeline.h"
 #include "../Prefs.h"
 #include "../Project.h"
 #include "../ProjectHistory.h"
@@ -97,6 +98,11 @@ bool ExportPlugin::CheckFileName(wxFileName & WXUNUSED(filename), int WXUNUSED(f
   return true;
 }
 
+bool ExportPlugin::CanExportConcurrently(int WXUNUSED(format))
+{
+   return false;
+}
+
 /** \brief Add a NEW entry to the list of formats this plug-in can export
  *
  * To configure the format use SetFormat, SetCanMetaData etc with the index of
@@ -242,7 +248,7 @@ wxWindow *ExportPlugin::OptionsCreate(wxWindow *parent, int WXUNUSED(format))
 }
 
 //Create a mixer by computing the time warp factor
-std::unique_ptr<Mixer> ExportPlugin::CreateMixer(const TrackList &tracks,
+std::unique_ptr<MixerPipeline> ExportPlugin::CreateMixer(const TrackList &tracks,
          bool selectionOnly,
          double startTime, double stopTime,
          unsigned numOutChannels, size_t outBufferSize, bool outInterleaved,
@@ -250,16 +256,21 @@ std::unique_ptr<Mixer> ExportPlugin::CreateMixer(const TrackList &tracks,
          bool highQuality, MixerSpec *mixerSpec)
 {
    WaveTrackConstArray inputTracks;
-   auto range = tracks.Any< const WaveTrack >()
-      + (selectionOnly ? &Track::IsSelected : &Track::Any )
-      - &WaveTrack::GetMute;
-   for (auto pTrack: range)
-      inputTracks.push_back(
-         pTrack->SharedPointer< const WaveTrack >() );
+   const auto pJob = ExportJob::Current();
+   if (pJob && !pJob->GetTracks().empty())
+      inputTracks = pJob->GetTracks();
+   else {
+      auto range = tracks.Any< const WaveTrack >()
+         + (selectionOnly ? &Track::IsSelected : &Track::Any )
+         - &WaveTrack::GetMute;
+      for (auto pTrack: range)
+         inputTracks.push_back(
+            pTrack->SharedPointer< const WaveTrack >() );
+   }
    const auto timeTrack = *tracks.Any<const TimeTrack>().begin();
    auto envelope = timeTrack ? timeTrack->GetEnvelope() : nullptr;
    // MB: the stop time should not be warped, this was a bug.
-   return std::make_unique<Mixer>(inputTracks,
+   auto pMixer = std::make_unique<Mixer>(inputTracks,
                   // Throw, to stop exporting, if read fails:
                   true,
                   Mixer::WarpOptions(envelope),
@@ -267,12 +278,16 @@ std::unique_ptr<Mixer> ExportPlugin::CreateMixer(const TrackList &tracks,
                   numOutChannels, outBufferSize, outInterleaved,
                   outRate, outFormat,
                   highQuality, mixerSpec);
+   return std::make_unique<MixerPipeline>(std::move(pMixer),
+      outBufferSize, numOutChannels, outInterleaved, outFormat);
 }
 
 void ExportPlugin::InitProgress(std::unique_ptr<ProgressDialog> &pDialog,
    const wxString &title, const wxString &message)
 {
-   if (!pDialog)
+   if (const auto pJob = ExportJob::Current())
+      pJob->SetStarted();
+   else if (!pDialog)
       pDialog = std::make_unique<ProgressDialog>( title, message );
    else {
       pDialog->SetTitle( title );
@@ -281,6 +296,108 @@ void ExportPlugin::InitProgress(std::unique_ptr<ProgressDialog> &pDialog,
    }
 }
 
+ProgressResult ExportPlugin::UpdateProgress(
+   std::unique_ptr<ProgressDialog> &pDialog, double current, double total)
+{
+   if (const auto pJob = ExportJob::Current()) {
+      pJob->SetFraction(total > 0 ? current / total : 0.0);
+      return pJob->GetRequest();
+   }
+   return pDialog->Update(current, total);
+}
+
+void ExportPlugin::ShowExportError(const wxString &message)
+{
+   if (const auto pJob = ExportJob::Current())
+      pJob->AddError(message);
+   else
+      AudacityMessageBox(message);
+}
+
+//----------------------------------------------------------------------------
+// ExportJob
+//----------------------------------------------------------------------------
+
+namespace {
+thread_local ExportJob *sCurrentJob = nullptr;
+}
+
+ExportJob::Scope::Scope( ExportJob &job )
+   : mPrevious{ sCurrentJob }
+{
+   sCurrentJob = &job;
+}
+
+ExportJob::Scope::~Scope()
+{
+   sCurrentJob = mPrevious;
+}
+
+ExportJob *ExportJob::Current()
+{
+   return sCurrentJob;
+}
+
+ExportJob::ExportJob( WaveTrackConstArray tracks )
+   : mTracks{ std::move( tracks ) }
+   , mRequest{ static_cast<unsigned>( ProgressResult::Success ) }
+   , mResult{ ProgressResult::Cancelled }
+{
+}
+
+void ExportJob::SetStarted()
+{
+   {
+      std::lock_guard< std::mutex > lock{ mMutex };
+      mStarted = true;
+   }
+   mCondition.notify_all();
+}
+
+void ExportJob::AddError( const wxString &message )
+{
+   std::lock_guard< std::mutex > lock{ mMutex };
+   mErrors.push_back( message );
+}
+
+void ExportJob::Finish( ProgressResult result )
+{
+   {
+      std::lock_guard< std::mutex > lock{ mMutex };
+      mResult = result;
+      mStarted = mFinished = true;
+   }
+   mCondition.notify_all();
+}
+
+void ExportJob::WaitUntilStarted()
+{
+   std::unique_lock< std::mutex > lock{ mMutex };
+   mCondition.wait( lock, [this]{ return mStarted; } );
+}
+
+bool ExportJob::IsFinished() const
+{
+   std::lock_guard< std::mutex > lock{ mMutex };
+   return mFinished;
+}
+
+void ExportJob::Request( ProgressResult request )
+{
+   mRequest.store( static_cast<unsigned>( request ) );
+}
+
+ProgressResult ExportJob::GetRequest() const
+{
+   return static_cast<ProgressResult>( mRequest.load() );
+}
+
+ProgressResult ExportJob::GetResult() const
+{
+   std::lock_guard< std::mutex > lock{ mMutex };
+   return mResult;
+}
+
 //----------------------------------------------------------------------------
 // Export
 //----------------------------------------------------------------------------
@@ -11,6 +11,9 @@
 #ifndef __AUDACITY_EXPORT__
 #define __AUDACITY_EXPORT__
 
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
 #include <vector>
 #include <wx/filename.h> // member variable
 #include "../SampleFormat.h"
@@ -30,6 +33,7 @@ class TrackList;
 class MixerSpec;
 class ProgressDialog;
 class Mixer;
+class MixerPipeline;
 using WaveTrackConstArray = std::vector < std::shared_ptr < const WaveTrack > >;
 enum class ProgressResult : unsigned;
 
@@ -92,6 +96,11 @@ public:
    virtual wxWindow *OptionsCreate(wxWindow *parent, int format) = 0;
 
    virtual bool CheckFileName(wxFileName &filename, int format = 0);
+   /** @brief Whether Export() of the sub-format may run on a worker thread,
+    * at the same time as other exports, for an ExportJob.  Such a plug-in
+    * must use InitProgress(), UpdateProgress() and ShowExportError(), and
+    * must read preferences only before it calls InitProgress(). */
+   virtual bool CanExportConcurrently(int format = 0);
    /** @brief Exporter plug-ins may override this to specify the number
     * of channels in exported file. -1 for unspecified */
    virtual int SetNumExportChannels() { return -1; }
@@ -129,23 +138,104 @@ public:
                        int subformat = 0) = 0;
 
 protected:
-   std::unique_ptr<Mixer> CreateMixer(const TrackList &tracks,
+   // The mixer runs on a thread of its own, ahead of the encoder
+   std::unique_ptr<MixerPipeline> CreateMixer(const TrackList &tracks,
          bool selectionOnly,
          double startTime, double stopTime,
          unsigned numOutChannels, size_t outBufferSize, bool outInterleaved,
          double outRate, sampleFormat outFormat,
          bool highQuality = true, MixerSpec *mixerSpec = NULL);
 
-   // Create or recycle a dialog.
+   // Create or recycle a dialog.  For an ExportJob, make none, and let
+   // the main thread know that the job is past its setup.
    static void InitProgress(std::unique_ptr<ProgressDialog> &pDialog,
          const wxString &title, const wxString &message);
 
+   // Update the dialog made by InitProgress(), or the ExportJob
+   static ProgressResult UpdateProgress(
+         std::unique_ptr<ProgressDialog> &pDialog,
+         double current, double total);
+
+   // Show an error, or keep it for the main thread to show after an
+   // ExportJob
+   static void ShowExportError(const wxString &message);
+
 private:
    std::vector<FormatInfo> mFormatInfos;
 };
 
 using ExportPluginArray = std::vector < std::unique_ptr< ExportPlugin > > ;
 
+//----------------------------------------------------------------------------
+// ExportJob
+//----------------------------------------------------------------------------
+
+/// \brief What an ExportPlugin::Export() running on a worker thread shares
+/// with the main thread that waits for it.
+///
+/// While a Scope installs the job for its thread, the plug-in shows no dialogs:
+/// progress and errors are kept here for the main thread, which may ask the
+/// export to stop or cancel.  If the job has tracks, CreateMixer() mixes them
+/// instead of the selected ones, so that jobs need not change the selection.
+class AUDACITY_DLL_API ExportJob final
+{
+public:
+   /// Installs the job for the current thread, for the lifetime of the Scope
+   class AUDACITY_DLL_API Scope final
+   {
+   public:
+      explicit Scope( ExportJob &job );
+      Scope( const Scope& ) = delete;
+      Scope &operator= ( const Scope& ) = delete;
+      ~Scope();
+   private:
+      ExportJob *mPrevious;
+   };
+
+   /// The job installed for the current thread, or null
+   static ExportJob *Current();
+
+   explicit ExportJob( WaveTrackConstArray tracks = {} );
+   ExportJob( const ExportJob& ) = delete;
+   ExportJob &operator= ( const ExportJob& ) = delete;
+
+   const WaveTrackConstArray &GetTracks() const { return mTracks; }
+
+   // Called on the worker thread
+
+   /// The plug-in is done with its setup and is now exporting
+   void SetStarted();
+   void SetFraction( double fraction ) { mFraction.store( fraction ); }
+   void AddError( const wxString &message );
+   void Finish( ProgressResult result );
+
+   // Called on the main thread
+
+   /// Block until the job calls SetStarted() or Finish()
+   void WaitUntilStarted();
+   bool IsFinished() const;
+   double GetFraction() const { return mFraction.load(); }
+   /// Ask the export to stop or cancel, as if from its progress dialog
+   void Request( ProgressResult request );
+   ProgressResult GetRequest() const;
+   ProgressResult GetResult() const;
+   /// The errors kept, once the job is finished
+   const wxArrayStringEx &GetErrors() const { return mErrors; }
+
+private:
+   const WaveTrackConstArray mTracks;
+   std::atomic< double > mFraction{ 0.0 };
+   std::atomic< unsigned > mRequest;
+
+   mutable std::mutex mMutex;
+   std::condition_variable mCondition;
+   // Guarded by mMutex
+   bool mStarted{ false };
+   bool mFinished{ false };
+   ProgressResult mResult;
+   wxArrayStringEx mErrors;
+};
+
 //----------------------------------------------------------------------------
 // Exporter
 //----------------------------------------------------------------------------
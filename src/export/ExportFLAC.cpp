@@ -40,7 +40,6 @@ and libvorbis examples, Monty <monty@xiph.org>
 #include "../Tags.h"
 #include "../Track.h"
 
-#include "../widgets/AudacityMessageBox.h"
 #include "../widgets/ProgressDialog.h"
 
 //----------------------------------------------------------------------------
@@ -219,13 +218,14 @@ public:
                MixerSpec *mixerSpec = NULL,
                const Tags *metadata = NULL,
                int subformat = 0) override;
+   // optional
+   bool CanExportConcurrently(int format) override;
 
 private:
 
-   bool GetMetadata(AudacityProject *project, const Tags *tags);
-
-   // Should this be a stack variable instead in Export?
-   FLAC__StreamMetadataHandle mMetadata;
+   // Null on failure.  Not a member, because exports may run concurrently
+   FLAC__StreamMetadataHandle GetMetadata(
+      AudacityProject *project, const Tags *tags);
 };
 
 //----------------------------------------------------------------------------
@@ -241,6 +241,11 @@ ExportFLAC::ExportFLAC()
    SetDescription(_("FLAC Files"),0);
 }
 
+bool ExportFLAC::CanExportConcurrently(int WXUNUSED(format))
+{
+   return true;
+}
+
 ProgressResult ExportFLAC::Export(AudacityProject *project,
                         std::unique_ptr<ProgressDialog> &pDialog,
                         unsigned numChannels,
@@ -276,23 +281,20 @@ ProgressResult ExportFLAC::Export(AudacityProject *project,
    encoder.set_sample_rate(lrint(rate));
 
    // See note in GetMetadata() about a bug in libflac++ 1.1.2
-   if (success && !GetMetadata(project, metadata)) {
+   FLAC__StreamMetadataHandle pMetadata;
+   if (success && !(pMetadata = GetMetadata(project, metadata))) {
       // TODO: more precise message
-      AudacityMessageBox(_("Unable to export"));
+      ShowExportError(_("Unable to export"));
       return ProgressResult::Cancelled;
    }
 
-   if (success && mMetadata) {
+   if (success && pMetadata) {
       // set_metadata expects an array of pointers to metadata and a size.
       // The size is 1.
-      FLAC__StreamMetadata *p = mMetadata.get();
+      FLAC__StreamMetadata *p = pMetadata.get();
       success = encoder.set_metadata(&p, 1);
    }
 
-   auto cleanup1 = finally( [&] {
-      mMetadata.reset(); // need this?
-   } );
-
    sampleFormat format;
    if (bitDepthPref == wxT("24")) {
       format = int24Sample;
@@ -331,7 +333,7 @@ ProgressResult ExportFLAC::Export(AudacityProject *project,
 
    if (!success) {
       // TODO: more precise message
-      AudacityMessageBox(_("Unable to export"));
+      ShowExportError(_("Unable to export"));
       return ProgressResult::Cancelled;
    }
 
@@ -340,7 +342,7 @@ ProgressResult ExportFLAC::Export(AudacityProject *project,
 #else
    wxFFile f;     // will be closed when it goes out of scope
    if (!f.Open(fName, wxT("w+b"))) {
-      AudacityMessageBox(wxString::Format(_("FLAC export couldn't open %s"), fName));
+      ShowExportError(wxString::Format(_("FLAC export couldn't open %s"), fName));
       return ProgressResult::Cancelled;
    }
 
@@ -349,12 +351,12 @@ ProgressResult ExportFLAC::Export(AudacityProject *project,
    // libflac can't (under Windows).
    int status = encoder.init(f.fp());
    if (status != FLAC__STREAM_ENCODER_INIT_STATUS_OK) {
-      AudacityMessageBox(wxString::Format(_("FLAC encoder failed to initialize\nStatus: %d"), status));
+      ShowExportError(wxString::Format(_("FLAC encoder failed to initialize\nStatus: %d"), status));
       return ProgressResult::Cancelled;
    }
 #endif
 
-   mMetadata.reset();
+   pMetadata.reset();
 
    auto cleanup2 = finally( [&] {
       if (!(updateResult == ProgressResult::Success ||
@@ -377,7 +379,6 @@ ProgressResult ExportFLAC::Export(AudacityProject *project,
       selectionOnly
          ? _("Exporting the selected audio as FLAC")
          : _("Exporting the audio as FLAC") );
-   auto &progress = *pDialog;
 
    while (updateResult == ProgressResult::Success) {
       auto samplesThisRun = mixer->Process(SAMPLES_PER_RUN);
@@ -402,13 +403,13 @@ ProgressResult ExportFLAC::Export(AudacityProject *project,
                reinterpret_cast<FLAC__int32**>( tmpsmplbuf.get() ),
                samplesThisRun) ) {
             // TODO: more precise message
-            AudacityMessageBox(_("Unable to export"));
+            ShowExportError(_("Unable to export"));
             updateResult = ProgressResult::Cancelled;
             break;
          }
          if (updateResult == ProgressResult::Success)
             updateResult =
-               progress.Update(mixer->MixGetCurrentTime() - t0, t1 - t0);
+               UpdateProgress(pDialog, mixer->MixGetCurrentTime() - t0, t1 - t0);
       }
    }
 
@@ -441,13 +442,17 @@ wxWindow *ExportFLAC::OptionsCreate(wxWindow *parent, int format)
 //      expects that array to be valid until the stream is initialized.
 //
 //      This has been fixed in 1.1.4.
-bool ExportFLAC::GetMetadata(AudacityProject *project, const Tags *tags)
+FLAC__StreamMetadataHandle ExportFLAC::GetMetadata(
+   AudacityProject *project, const Tags *tags)
 {
    // Retrieve tags if needed
    if (tags == NULL)
       tags = &Tags::Get( *project );
 
-   mMetadata.reset(::FLAC__metadata_object_new(FLAC__METADATA_TYPE_VORBIS_COMMENT));
+   FLAC__StreamMetadataHandle pMetadata{
+      ::FLAC__metadata_object_new(FLAC__METADATA_TYPE_VORBIS_COMMENT) };
+   if (!pMetadata)
+      return {};
 
    wxString n;
    for (const auto &pair : tags->GetRange()) {
@@ -458,13 +463,13 @@ bool ExportFLAC::GetMetadata(AudacityProject *project, const Tags *tags)
       }
       FLAC::Metadata::VorbisComment::Entry entry(n.mb_str(wxConvUTF8),
                                                  v.mb_str(wxConvUTF8));
-      if (! ::FLAC__metadata_object_vorbiscomment_append_comment(mMetadata.get(),
+      if (! ::FLAC__metadata_object_vorbiscomment_append_comment(pMetadata.get(),
                                                            entry.get_entry(),
                                                            true) )
-         return false;
+         return {};
    }
 
-   return true;
+   return pMetadata;
 }
 
 std::unique_ptr<ExportPlugin> New_ExportFLAC()
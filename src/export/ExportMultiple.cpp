@@ -18,6 +18,8 @@
 #include "../Audacity.h"
 #include "ExportMultiple.h"
 
+#include <exception>
+
 #include <wx/defs.h>
 #include <wx/button.h>
 #include <wx/checkbox.h>
@@ -37,6 +39,7 @@
 #include <wx/stattext.h>
 #include <wx/textctrl.h>
 #include <wx/textdlg.h>
+#include <wx/utils.h>
 
 #include "../DirManager.h"
 #include "../FileFormats.h"
@@ -49,6 +52,7 @@
 #include "../SelectionState.h"
 #include "../ShuttleGui.h"
 #include "../Tags.h"
+#include "../ThreadPool.h"
 #include "../WaveTrack.h"
 #include "../widgets/HelpSystem.h"
 #include "../widgets/AudacityMessageBox.h"
@@ -78,6 +82,34 @@ namespace {
     */
 }
 
+/// One file of a concurrent export
+struct ExportMultiple::Job
+{
+   Job(unsigned channels_, const wxFileName &inName_,
+       double t0_, double t1_, const Tags &tags_,
+       WaveTrackConstArray tracks = {})
+      : channels{ channels_ }
+      , inName{ inName_ }
+      , t0{ t0_ }
+      , t1{ t1_ }
+      , tags{ tags_ }
+      , state{ std::move( tracks ) }
+   {}
+
+   const unsigned channels;
+   const wxFileName inName;
+   const double t0;
+   const double t1;
+   const Tags tags;
+   ExportJob state;
+
+   bool started{ false };
+   wxString fullPath;
+   wxFileName backup;
+   // Written by the worker before it finishes the state
+   std::exception_ptr exception;
+};
+
 /* define our dynamic array of export settings */
 
 enum {
@@ -387,6 +419,8 @@ void ExportMultiple::PopulateOrExchange(ShuttleGui& S)
       mOverwrite = S.Id(OverwriteID).TieCheckBox(_("Overwrite existing files"),
                                                  wxT("/Export/OverwriteExisting"),
                                                  false);
+      S.TieSpinCtrl(_("Files exported at &once (0 = automatic):"),
+                    wxT("/Export/MultipleConcurrency"), 0, 64, 0);
    }
    S.EndHorizontalLay();
 
@@ -814,6 +848,17 @@ ProgressResult ExportMultiple::ExportMultipleByLabel(bool byName,
       l++;  // next label, count up one
    }
 
+   if (GetConcurrency() > 1) {
+      std::vector< std::unique_ptr< Job > > jobs;
+      for (const auto &kit : exportSettings) {
+         if( kit.destfile.GetName().empty() )
+            continue;
+         jobs.push_back( std::make_unique< Job >(
+            channels, kit.destfile, kit.t0, kit.t1, kit.filetags ) );
+      }
+      return DoConcurrentExports(jobs);
+   }
+
    auto ok = ProgressResult::Success;   // did it work?
    int count = 0; // count the number of sucessful runs
    ExportKit activeSetting;  // pointer to the settings in use for this export
@@ -937,6 +982,25 @@ ProgressResult ExportMultiple::ExportMultipleByTrack(bool byName,
    }
    // end of user-interactive data gathering loop, start of export processing
    // loop
+   if (GetConcurrency() > 1) {
+      // Each job mixes the channels of its track, so that the selection
+      // need not change
+      std::vector< std::unique_ptr< Job > > jobs;
+      size_t ii = 0;
+      for (auto tr : mTracks->Leaders<WaveTrack>() - &WaveTrack::GetMute) {
+         const auto &kit = exportSettings[ii++];
+         if( kit.destfile.GetName().empty() )
+            continue;
+         WaveTrackConstArray tracks;
+         for (auto channel : TrackList::Channels(tr))
+            tracks.push_back( channel->SharedPointer< const WaveTrack >() );
+         jobs.push_back( std::make_unique< Job >(
+            kit.channels, kit.destfile, kit.t0, kit.t1, kit.filetags,
+            std::move( tracks ) ) );
+      }
+      return DoConcurrentExports(jobs);
+   }
+
    int count = 0; // count the number of sucessful runs
    ExportKit activeSetting;  // pointer to the settings in use for this export
    std::unique_ptr<ProgressDialog> pDialog;
@@ -990,10 +1054,52 @@ ProgressResult ExportMultiple::DoExport(std::unique_ptr<ProgressDialog> &pDialog
       wxLogDebug(wxT("Whole Project"));
 
    wxFileName backup;
+   if (!ChooseFileName(inName, {}, name, backup))
+      return ProgressResult::Cancelled;
+
+   ProgressResult success = ProgressResult::Cancelled;
+   const wxString fullPath{name.GetFullPath()};
+
+   auto cleanup = finally( [&] {
+      FinishFile(success, fullPath, backup);
+   } );
+
+   // Call the format export routine
+   success = mPlugins[mPluginIndex]->Export(mProject,
+                                            pDialog,
+                                                channels,
+                                                fullPath,
+                                                selectedOnly,
+                                                t0,
+                                                t1,
+                                                NULL,
+                                                &tags,
+                                                mSubFormatIndex);
+
+   if (success == ProgressResult::Success || success == ProgressResult::Stopped) {
+      mExported.push_back(fullPath);
+   }
+
+   Refresh();
+   Update();
+
+   return success;
+}
+
+bool ExportMultiple::ChooseFileName(const wxFileName &inName,
+                                    const FilePaths &reserved,
+                                    wxFileName &name,
+                                    wxFileName &backup)
+{
+   auto exists = [&](const wxFileName &fn) {
+      return fn.FileExists() ||
+         make_iterator_range( reserved ).contains( fn.GetFullPath() );
+   };
+
    if (mOverwrite->GetValue()) {
       // Make sure we don't overwrite (corrupt) alias files
       if (!DirManager::Get( *mProject ).EnsureSafeFilename(inName)) {
-         return ProgressResult::Cancelled;
+         return false;
       }
       name = inName;
       backup.Assign(name);
@@ -1004,62 +1110,175 @@ ProgressResult ExportMultiple::DoExport(std::unique_ptr<ProgressDialog> &pDialog
                            wxString::Format(wxT("%d"), suffix));
          ++suffix;
       }
-      while (backup.FileExists());
+      while (exists(backup));
       ::wxRenameFile(inName.GetFullPath(), backup.GetFullPath());
    }
    else {
       name = inName;
       int i = 2;
       wxString base(name.GetName());
-      while (name.FileExists()) {
+      while (exists(name)) {
          name.SetName(wxString::Format(wxT("%s-%d"), base, i++));
       }
    }
 
-   ProgressResult success = ProgressResult::Cancelled;
-   const wxString fullPath{name.GetFullPath()};
+   return true;
+}
 
-   auto cleanup = finally( [&] {
-      bool ok =
-         success == ProgressResult::Stopped ||
-         success == ProgressResult::Success;
-      if (backup.IsOk()) {
-         if ( ok )
-            // Remove backup
-            ::wxRemoveFile(backup.GetFullPath());
+void ExportMultiple::FinishFile(ProgressResult result,
+                                const wxString &fullPath,
+                                const wxFileName &backup)
+{
+   bool ok =
+      result == ProgressResult::Stopped ||
+      result == ProgressResult::Success;
+   if (backup.IsOk()) {
+      if ( ok )
+         // Remove backup
+         ::wxRemoveFile(backup.GetFullPath());
+      else {
+         // Restore original
+         ::wxRemoveFile(fullPath);
+         ::wxRenameFile(backup.GetFullPath(), fullPath);
+      }
+   }
+   else {
+      if ( ! ok )
+         // Remove any new, and only partially written, file.
+         ::wxRemoveFile(fullPath);
+   }
+}
+
+size_t ExportMultiple::GetConcurrency()
+{
+   if (!mPlugins[mPluginIndex]->CanExportConcurrently(mSubFormatIndex))
+      return 1;
+
+   // The main thread only waits and shows progress
+   const auto workers = ThreadPool::Get().GetConcurrency() - 1;
+
+   int concurrency;
+   gPrefs->Read(wxT("/Export/MultipleConcurrency"), &concurrency, 0);
+   if (concurrency <= 0)
+      return workers;
+   return std::min<size_t>(concurrency, workers);
+}
+
+ProgressResult ExportMultiple::DoConcurrentExports(
+   std::vector< std::unique_ptr< Job > > &jobs)
+{
+   auto &pool = ThreadPool::Get();
+   const auto concurrency = GetConcurrency();
+   const auto pPlugin = mPlugins[mPluginIndex];
+   const auto project = mProject;
+   const auto subformat = mSubFormatIndex;
+
+   ProgressDialog progress( _("Export Multiple"),
+      wxString::Format(_("Exporting %lld files"), (long long) jobs.size()) );
+
+   FilePaths reserved;
+   size_t next = 0;
+   auto request = ProgressResult::Success;
+   bool userRequest = false;
+
+   while (true) {
+      size_t nRunning = 0;
+      double done = 0;
+      for (size_t ii = 0; ii < next; ++ii) {
+         const auto &state = jobs[ii]->state;
+         if (state.IsFinished()) {
+            done += 1.0;
+            // Like the serial loop, start no more after a failure
+            const auto result = state.GetResult();
+            if (request == ProgressResult::Success &&
+                result != ProgressResult::Success &&
+                result != ProgressResult::Stopped)
+               request = result;
+         }
          else {
-            // Restore original
-            ::wxRemoveFile(fullPath);
-            ::wxRenameFile(backup.GetFullPath(), fullPath);
+            ++nRunning;
+            done += state.GetFraction();
          }
       }
-      else {
-         if ( ! ok )
-            // Remove any new, and only partially written, file.
-            ::wxRemoveFile(fullPath);
+
+      // Start more in order, naming each one as the serial loop would
+      while (request == ProgressResult::Success &&
+             next < jobs.size() && nRunning < concurrency) {
+         auto &job = *jobs[next];
+         wxFileName name;
+         if (!ChooseFileName(job.inName, reserved, name, job.backup)) {
+            request = ProgressResult::Cancelled;
+            break;
+         }
+         job.fullPath = name.GetFullPath();
+         reserved.push_back(job.fullPath);
+         job.started = true;
+         ++next, ++nRunning;
+
+         const auto pJob = &job;
+         pool.Schedule( [=]{
+            ExportJob::Scope scope{ pJob->state };
+            auto result = ProgressResult::Failed;
+            try {
+               std::unique_ptr<ProgressDialog> pDialog;
+               result = pPlugin->Export(project, pDialog,
+                  pJob->channels, pJob->fullPath,
+                  !pJob->state.GetTracks().empty(),
+                  pJob->t0, pJob->t1, NULL, &pJob->tags, subformat);
+            }
+            catch ( ... ) {
+               pJob->exception = std::current_exception();
+            }
+            pJob->state.Finish( result );
+         } );
+
+         // Plug-ins read preferences, and some use members of the plug-in,
+         // before they start to export; let each do that alone
+         job.state.WaitUntilStarted();
       }
-   } );
 
-   // Call the format export routine
-   success = mPlugins[mPluginIndex]->Export(mProject,
-                                            pDialog,
-                                                channels,
-                                                fullPath,
-                                                selectedOnly,
-                                                t0,
-                                                t1,
-                                                NULL,
-                                                &tags,
-                                                mSubFormatIndex);
+      if (nRunning == 0 &&
+          (next == jobs.size() || request != ProgressResult::Success))
+         break;
 
-   if (success == ProgressResult::Success || success == ProgressResult::Stopped) {
-      mExported.push_back(fullPath);
+      auto result = progress.Update(done, (double) jobs.size());
+      if (result != ProgressResult::Success && !userRequest) {
+         userRequest = true;
+         request = result;
+         for (size_t ii = 0; ii < next; ++ii)
+            jobs[ii]->state.Request(result);
+      }
+
+      wxMilliSleep(10);
+   }
+
+   // Report in order, as the serial loop would
+   auto ok = request;
+   std::exception_ptr exception;
+   for (const auto &pJob : jobs) {
+      if (!pJob->started)
+         continue;
+      const auto result = pJob->state.GetResult();
+      FinishFile(result, pJob->fullPath, pJob->backup);
+      if (result == ProgressResult::Success ||
+          result == ProgressResult::Stopped)
+         mExported.push_back(pJob->fullPath);
+      else if (ok == ProgressResult::Success ||
+               ok == ProgressResult::Stopped)
+         ok = result;
+      for (const auto &error : pJob->state.GetErrors())
+         AudacityMessageBox(error);
+      if (pJob->exception && !exception)
+         exception = pJob->exception;
    }
 
    Refresh();
    Update();
 
-   return success;
+   if (exception)
+      std::rethrow_exception(exception);
+
+   return ok;
 }
 
 wxString ExportMultiple::MakeFileName(const wxString &input)
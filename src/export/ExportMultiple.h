@@ -79,6 +79,41 @@ private:
                  double t0,
                  double t1,
                  const Tags &tags);
+   /** \brief Choose the file to write for one file of an export multiple
+    * set, moving aside any existing file that it would overwrite
+    *
+    * @param inName The file name (and path) wanted
+    * @param reserved Names of files being exported that may not exist yet,
+    * which are taken as existing
+    * @param name Receives the file name to write
+    * @param backup Receives the name of the moved file, if any
+    * @return false if the file may not be overwritten
+    */
+   bool ChooseFileName(const wxFileName &inName,
+                 const FilePaths &reserved,
+                 wxFileName &name,
+                 wxFileName &backup);
+   /** Remove the backup if the export succeeded, else remove the new file
+    * and restore the backup */
+   static void FinishFile(ProgressResult result,
+                 const wxString &fullPath,
+                 const wxFileName &backup);
+
+   /** How many files to export at once: the number in preferences, or one
+    * fewer than the number of processors; but one if the chosen format
+    * cannot export concurrently */
+   size_t GetConcurrency();
+
+   struct Job;
+   /** \brief Export the files of the set on worker threads, several at once,
+    * with one progress dialog for all of them
+    *
+    * Files are named and started in order, so they get the same names as
+    * they would one after another.  Errors are shown when all are done.
+    */
+   ProgressResult DoConcurrentExports(
+                 std::vector< std::unique_ptr< Job > > &jobs);
+
    /** \brief Takes an arbitrary text string and converts it to a form that can
     * be used as a file name, if necessary prompting the user to edit the file
     * name produced */
@@ -35,7 +35,6 @@
 
 #include "../Tags.h"
 #include "../Track.h"
-#include "../widgets/AudacityMessageBox.h"
 #include "../widgets/ProgressDialog.h"
 
 //----------------------------------------------------------------------------
@@ -142,6 +141,8 @@ public:
                MixerSpec *mixerSpec = NULL,
                const Tags *metadata = NULL,
                int subformat = 0) override;
+   // optional
+   bool CanExportConcurrently(int format) override;
 
 private:
 
@@ -159,6 +160,11 @@ ExportOGG::ExportOGG()
    SetDescription(_("Ogg Vorbis Files"),0);
 }
 
+bool ExportOGG::CanExportConcurrently(int WXUNUSED(format))
+{
+   return true;
+}
+
 ProgressResult ExportOGG::Export(AudacityProject *project,
                        std::unique_ptr<ProgressDialog> &pDialog,
                        unsigned numChannels,
@@ -181,7 +187,7 @@ ProgressResult ExportOGG::Export(AudacityProject *project,
    FileIO outFile(fName, FileIO::Output);
 
    if (!outFile.IsOpened()) {
-      AudacityMessageBox(_("Unable to open target file for writing"));
+      ShowExportError(_("Unable to open target file for writing"));
       return ProgressResult::Cancelled;
    }
 
@@ -211,14 +217,14 @@ ProgressResult ExportOGG::Export(AudacityProject *project,
    vorbis_info_init(&info);
    if (vorbis_encode_init_vbr(&info, numChannels, (int)(rate + 0.5), quality)) {
       // TODO: more precise message
-      AudacityMessageBox(_("Unable to export"));
+      ShowExportError(_("Unable to export"));
       return ProgressResult::Cancelled;
    }
 
    // Retrieve tags
    if (!FillComment(project, &comment, metadata)) {
       // TODO: more precise message
-      AudacityMessageBox(_("Unable to export"));
+      ShowExportError(_("Unable to export"));
       return ProgressResult::Cancelled;
    }
 
@@ -226,7 +232,7 @@ ProgressResult ExportOGG::Export(AudacityProject *project,
    if (vorbis_analysis_init(&dsp, &info) ||
        vorbis_block_init(&dsp, &block)) {
       // TODO: more precise message
-      AudacityMessageBox(_("Unable to export"));
+      ShowExportError(_("Unable to export"));
       return ProgressResult::Cancelled;
    }
 
@@ -236,7 +242,7 @@ ProgressResult ExportOGG::Export(AudacityProject *project,
    srand(time(NULL));
    if (ogg_stream_init(&stream, rand())) {
       // TODO: more precise message
-      AudacityMessageBox(_("Unable to export"));
+      ShowExportError(_("Unable to export"));
       return ProgressResult::Cancelled;
    }
 
@@ -259,7 +265,7 @@ ProgressResult ExportOGG::Export(AudacityProject *project,
       ogg_stream_packetin(&stream, &comment_header) ||
       ogg_stream_packetin(&stream, &codebook_header)) {
       // TODO: more precise message
-      AudacityMessageBox(_("Unable to export"));
+      ShowExportError(_("Unable to export"));
       return ProgressResult::Cancelled;
    }
 
@@ -269,7 +275,7 @@ ProgressResult ExportOGG::Export(AudacityProject *project,
       if ( outFile.Write(page.header, page.header_len).GetLastError() ||
            outFile.Write(page.body, page.body_len).GetLastError()) {
          // TODO: more precise message
-         AudacityMessageBox(_("Unable to export"));
+         ShowExportError(_("Unable to export"));
          return ProgressResult::Cancelled;
       }
    }
@@ -284,7 +290,6 @@ ProgressResult ExportOGG::Export(AudacityProject *project,
          selectionOnly
             ? _("Exporting the selected audio as Ogg Vorbis")
             : _("Exporting the audio as Ogg Vorbis") );
-      auto &progress = *pDialog;
 
       while (updateResult == ProgressResult::Success && !eos) {
          float **vorbis_buffer = vorbis_analysis_buffer(&dsp, SAMPLES_PER_RUN);
@@ -337,7 +342,7 @@ ProgressResult ExportOGG::Export(AudacityProject *project,
                   if ( outFile.Write(page.header, page.header_len).GetLastError() ||
                        outFile.Write(page.body, page.body_len).GetLastError()) {
                      // TODO: more precise message
-                     AudacityMessageBox(_("Unable to export"));
+                     ShowExportError(_("Unable to export"));
                      return ProgressResult::Cancelled;
                   }
 
@@ -351,18 +356,18 @@ ProgressResult ExportOGG::Export(AudacityProject *project,
          if (err) {
             updateResult = ProgressResult::Cancelled;
             // TODO: more precise message
-            AudacityMessageBox(_("Unable to export"));
+            ShowExportError(_("Unable to export"));
             break;
          }
 
-         updateResult = progress.Update(mixer->MixGetCurrentTime() - t0, t1 - t0);
+         updateResult = UpdateProgress(pDialog, mixer->MixGetCurrentTime() - t0, t1 - t0);
       }
    }
 
    if ( !outFile.Close() ) {
       updateResult = ProgressResult::Cancelled;
       // TODO: more precise message
-      AudacityMessageBox(_("Unable to export"));
+      ShowExportError(_("Unable to export"));
    }
 
    return updateResult;
@@ -32,7 +32,6 @@
 #include "../ShuttleGui.h"
 #include "../Tags.h"
 #include "../Track.h"
-#include "../widgets/AudacityMessageBox.h"
 #include "../widgets/ErrorDialog.h"
 #include "../widgets/ProgressDialog.h"
 
@@ -341,6 +340,7 @@ public:
    // optional
    FileExtension GetExtension(int index) override;
    bool CheckFileName(wxFileName &filename, int format) override;
+   bool CanExportConcurrently(int format) override;
 
 private:
    void ReportTooBigError(wxWindow * pParent);
@@ -402,6 +402,11 @@ void ExportPCM::ReportTooBigError(wxWindow * pParent)
       _("You have attempted to Export a WAV or AIFF file which would be greater than 4GB.\n"
       "Audacity cannot do this, the Export was abandoned.");
 
+   if (ExportJob::Current()) {
+      ShowExportError(message);
+      return;
+   }
+
    ShowErrorDialog(pParent, _("Error Exporting"), message,
                   wxT("Size_limits_for_WAV_and_AIFF_files"));
 
@@ -415,6 +420,11 @@ void ExportPCM::ReportTooBigError(wxWindow * pParent)
 #endif
 }
 
+bool ExportPCM::CanExportConcurrently(int WXUNUSED(format))
+{
+   return true;
+}
+
 /**
  *
  * @param subformat Control whether we are doing a "preset" export to a popular
@@ -472,7 +482,7 @@ ProgressResult ExportPCM::Export(AudacityProject *project,
       if (!sf_format_check(&info))
          info.format = (info.format & SF_FORMAT_TYPEMASK);
       if (!sf_format_check(&info)) {
-         AudacityMessageBox(_("Cannot export audio in this format."));
+         ShowExportError(_("Cannot export audio in this format."));
          return ProgressResult::Cancelled;
       }
 
@@ -486,7 +496,7 @@ ProgressResult ExportPCM::Export(AudacityProject *project,
       }
 
       if (!sf) {
-         AudacityMessageBox(wxString::Format(_("Cannot export audio to %s"),
+         ShowExportError(wxString::Format(_("Cannot export audio to %s"),
                                        fName));
          return ProgressResult::Cancelled;
       }
@@ -533,7 +543,6 @@ ProgressResult ExportPCM::Export(AudacityProject *project,
                   formatStr)
                : wxString::Format(_("Exporting the audio as %s"),
                   formatStr) );
-         auto &progress = *pDialog;
 
          while (updateResult == ProgressResult::Success) {
             sf_count_t samplesWritten;
@@ -552,7 +561,7 @@ ProgressResult ExportPCM::Export(AudacityProject *project,
             if (static_cast<size_t>(samplesWritten) != numSamples) {
                char buffer2[1000];
                sf_error_str(sf.get(), buffer2, 1000);
-               AudacityMessageBox(wxString::Format(
+               ShowExportError(wxString::Format(
                                              /* i18n-hint: %s will be the error message from libsndfile, which
                                               * is usually something unhelpful (and untranslated) like "system
                                               * error" */
@@ -563,7 +572,7 @@ ProgressResult ExportPCM::Export(AudacityProject *project,
                break;
             }
             
-            updateResult = progress.Update(mixer->MixGetCurrentTime() - t0, t1 - t0);
+            updateResult = UpdateProgress(pDialog, mixer->MixGetCurrentTime() - t0, t1 - t0);
          }
       }
       
@@ -574,13 +583,13 @@ ProgressResult ExportPCM::Export(AudacityProject *project,
              (sf_format & SF_FORMAT_TYPEMASK) == SF_FORMAT_WAVEX) {
             if (!AddStrings(project, sf.get(), metadata, sf_format)) {
                // TODO: more precise message
-               AudacityMessageBox(_("Unable to export"));
+               ShowExportError(_("Unable to export"));
                return ProgressResult::Cancelled;
             }
          }
          if (0 != sf.close()) {
             // TODO: more precise message
-            AudacityMessageBox(_("Unable to export"));
+            ShowExportError(_("Unable to export"));
             return ProgressResult::Cancelled;
          }
       }
@@ -593,7 +602,7 @@ ProgressResult ExportPCM::Export(AudacityProject *project,
          // Note: file has closed, and gets reopened and closed again here:
          if (!AddID3Chunk(fName, metadata, sf_format) ) {
             // TODO: more precise message
-            AudacityMessageBox(_("Unable to export"));
+            ShowExportError(_("Unable to export"));
             return ProgressResult::Cancelled;
          }
 
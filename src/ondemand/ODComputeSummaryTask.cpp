@@ -23,15 +23,14 @@ updating the ODPCMAliasBlockFile and the GUI of the newly available data.
 #include "../Sequence.h"
 #include "../WaveClip.h"
 #include "../WaveTrack.h"
+#include <algorithm>
 #include <wx/wx.h>
 
-//36 blockfiles > 3 minutes stereo 44.1kHz per ODTask::DoSome
-#define nBlockFilesPerDoSome 36
-
 ///Creates a NEW task that computes summaries for a wavetrack that needs to be specified through SetWaveTrack()
 ODComputeSummaryTask::ODComputeSummaryTask()
 {
    mMaxBlockFiles = 0;
+   mBlockFilesInProgress = 0;
    mHasUpdateRan=false;
 }
 
@@ -47,7 +46,7 @@ std::unique_ptr<ODTask> ODComputeSummaryTask::Clone() const
 ///releases memory that the ODTask owns.  Subclasses should override.
 void ODComputeSummaryTask::Terminate()
 {
-   //The terminate block won't allow DoSomeInternal and this method to be run async, so this is thread-safe.
+   //TerminateAndBlock waits for running jobs, so DoSomeInternal and this method are not run async, so this is thread-safe.
    //Deref the block files since they are ref'ed when put into the array.
    mBlockFilesMutex.Lock();
    mBlockFiles.clear();
@@ -55,94 +54,59 @@ void ODComputeSummaryTask::Terminate()
 }
 
 ///Computes and writes the data for one BlockFile if it still has a refcount.
-void ODComputeSummaryTask::DoSomeInternal()
+bool ODComputeSummaryTask::DoSomeInternal()
 {
-   if(mBlockFiles.size()<=0)
-   {
-      mPercentCompleteMutex.Lock();
-      mPercentComplete = 1.0;
-      mPercentCompleteMutex.Unlock();
-      return;
-   }
-
-   mBlockFilesMutex.Lock();
-   for(size_t j=0; j < mWaveTracks.size() && mBlockFiles.size();j++)
+   std::shared_ptr< ODPCMAliasBlockFile > bf;
    {
-      bool success = false;
-      const auto bf = mBlockFiles[0].lock();
-
-      sampleCount blockStartSample = 0;
-      sampleCount blockEndSample = 0;
-
+      //take the foremost block out of the array, so that other jobs take the next ones.
+      ODLocker locker{ &mBlockFilesMutex };
+      if(mBlockFiles.empty())
+         return false;
+      bf = mBlockFiles[0].lock();
+      mBlockFiles.erase(mBlockFiles.begin());
       if(bf)
-      {
-         // WriteSummary might throw, but this is a worker thread, so stop
-         // the exceptions here!
-         success = GuardedCall<bool>( [&] {
-            bf->DoWriteSummary();
-            return true;
-         } );
-         blockStartSample = bf->GetStart();
-         blockEndSample = blockStartSample + bf->GetLength();
-      }
+         ++mBlockFilesInProgress;
       else
-      {
-         success = true;
          // The block file disappeared.
          //the waveform in the wavetrack now is shorter, so we need to update mMaxBlockFiles
          //because now there is less work to do.
          mMaxBlockFiles--;
-      }
-
-      if (success)
-      {
-         //take it out of the array - we are done with it.
-         mBlockFiles.erase(mBlockFiles.begin());
-      }
-      else
-         // The task does not make progress
-         ;
-
-      //This is a bit of a convenience in case someone tries to terminate the task by closing the trackpanel or window.
-      //ODComputeSummaryTask::Terminate() uses this lock to remove everything, and we don't want it to wait since the UI is being blocked.
-      mBlockFilesMutex.Unlock();
-      wxThread::This()->Yield();
-      mBlockFilesMutex.Lock();
-
-      //update the gui for all associated blocks.  It doesn't matter that we're hitting more wavetracks then we should
-      //because this loop runs a number of times equal to the number of tracks, they probably are getting processed in
-      //the next iteration at the same sample window.
-      if (success && bf) {
-         mWaveTrackMutex.Lock();
-         for(size_t i=0;i<mWaveTracks.size();i++)
-         {
-            auto waveTrack = mWaveTracks[i].lock();
-            if(success && waveTrack)
-               waveTrack->AddInvalidRegion(blockStartSample,blockEndSample);
-         }
-         mWaveTrackMutex.Unlock();
-      }
    }
 
-   mBlockFilesMutex.Unlock();
+   if(!bf)
+      return true;
 
-   //update percentage complete.
-   CalculatePercentComplete();
-}
+   // WriteSummary might throw, but this is a worker thread, so stop
+   // the exceptions here!
+   const bool success = GuardedCall<bool>( [&] {
+      bf->DoWriteSummary();
+      return true;
+   } );
 
-///compute the next time we should take a break in terms of overall percentage.
-///We want to do a constant number of blockfiles.
-float ODComputeSummaryTask::ComputeNextWorkUntilPercentageComplete()
-{
-   if(mMaxBlockFiles==0)
-     return 1.0;
+   {
+      ODLocker locker{ &mBlockFilesMutex };
+      --mBlockFilesInProgress;
+      if(!success)
+         // The task does not make progress; put the block back to try again
+         mBlockFiles.insert(mBlockFiles.begin(), bf);
+   }
 
-   float nextPercent;
-   mPercentCompleteMutex.Lock();
-   nextPercent=mPercentComplete + ((float)nBlockFilesPerDoSome/(mMaxBlockFiles+1));
-   mPercentCompleteMutex.Unlock();
+   //update the gui for all associated blocks.  It doesn't matter that we're hitting more wavetracks then we should
+   //because they probably share the same sample window.
+   if (success) {
+      const auto blockStartSample = bf->GetStart();
+      const auto blockEndSample = blockStartSample + bf->GetLength();
+      mWaveTrackMutex.Lock();
+      for(size_t i=0;i<mWaveTracks.size();i++)
+      {
+         auto waveTrack = mWaveTracks[i].lock();
+         if(waveTrack)
+            waveTrack->AddInvalidRegion(blockStartSample,blockEndSample);
+      }
+      mWaveTrackMutex.Unlock();
+   }
 
-   return nextPercent;
+   return true;
 }
 
 void ODComputeSummaryTask::MarkUpdateRan()
@@ -165,9 +129,13 @@ void ODComputeSummaryTask::CalculatePercentComplete()
 {
    bool hasUpdateRan;
    hasUpdateRan = HasUpdateRan();
+   mBlockFilesMutex.Lock();
+   const auto remaining = mBlockFiles.size() + mBlockFilesInProgress;
+   mBlockFilesMutex.Unlock();
    mPercentCompleteMutex.Lock();
    if(hasUpdateRan)
-      mPercentComplete = (float) 1.0 - ((float)mBlockFiles.size() / (mMaxBlockFiles+1));
+      //blocks being summarized may be listed again after a reorder, so don't go below zero
+      mPercentComplete = std::max(0.0f, (float) 1.0 - ((float)remaining / (mMaxBlockFiles+1)));
    else
       mPercentComplete =0.0;
    mPercentCompleteMutex.Unlock();
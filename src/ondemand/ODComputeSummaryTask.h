@@ -46,8 +46,8 @@ class ODComputeSummaryTask final : public ODTask
 
    const wxChar* GetTip() override { return _("Import complete. Calculating waveform"); }
 
-   bool UsesCustomWorkUntilPercentage() override { return true; }
-   float ComputeNextWorkUntilPercentageComplete() override;
+   ///Blocks are independent, so any number of threads may summarize them.
+   bool AllowsConcurrentJobs() override { return true; }
 
    ///releases memory that the ODTask owns.  Subclasses should override.
    void Terminate() override;
@@ -57,7 +57,7 @@ protected:
    void CalculatePercentComplete() override;
 
    ///Computes and writes the data for one BlockFile if it still has a refcount.
-   void DoSomeInternal() override;
+   bool DoSomeInternal() override;
 
    ///Readjusts the blockfile order in the default manner.  If we have had an ODRequest
    ///Then it updates in the OD manner.
@@ -75,6 +75,8 @@ protected:
    ODLock  mBlockFilesMutex;
    std::vector< std::weak_ptr< ODPCMAliasBlockFile > > mBlockFiles;
    int mMaxBlockFiles;
+   //block files taken out of mBlockFiles by jobs that have not finished them
+   int mBlockFilesInProgress;
    ODLock  mHasUpdateRanMutex;
    bool mHasUpdateRan;
 };
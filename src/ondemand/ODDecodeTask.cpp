@@ -33,85 +33,76 @@ ODDecodeTask::ODDecodeTask()
 
 
 ///Computes and writes the data for one BlockFile if it still has a refcount.
-void ODDecodeTask::DoSomeInternal()
+///Decoders read their files in sequence, so jobs of this task are never concurrent.
+bool ODDecodeTask::DoSomeInternal()
 {
    if(mBlockFiles.size()<=0)
-   {
-      mPercentCompleteMutex.Lock();
-      mPercentComplete = 1.0;
-      mPercentCompleteMutex.Unlock();
-      return;
-   }
+      return false;
 
    ODFileDecoder* decoder;
 
-   for(size_t j=0; j < mWaveTracks.size() && mBlockFiles.size();j++)
-   {
-      const auto bf = mBlockFiles[0].lock();
-      sampleCount blockStartSample = 0;
-      sampleCount blockEndSample = 0;
-      bool success =false;
+   const auto bf = mBlockFiles[0].lock();
+   sampleCount blockStartSample = 0;
+   sampleCount blockEndSample = 0;
+   bool success =false;
 
-      int ret = 1;
+   int ret = 1;
 
-      if(bf)
+   if(bf)
+   {
+      //OD TODO: somehow pass the bf a reference to the decoder that manages its file.
+      //we need to ensure that the filename won't change or be moved.  We do this by calling LockRead(),
+      //which the dirmanager::EnsureSafeFilename also does.
       {
-         //OD TODO: somehow pass the bf a reference to the decoder that manages its file.
-         //we need to ensure that the filename won't change or be moved.  We do this by calling LockRead(),
-         //which the dirmanager::EnsureSafeFilename also does.
-         {
-            auto locker = bf->LockForRead();
-            //Get the decoder.  If the file was moved, we need to create another one and init it.
-            decoder = GetOrCreateMatchingFileDecoder( &*bf );
-            if(!decoder->IsInitialized())
-               decoder->Init();
-            bf->SetODFileDecoder(decoder);
-            // Does not throw:
-            ret = bf->DoWriteBlockFile();
-         }
-
-         if(ret >= 0) {
-            success = true;
-            blockStartSample = bf->GetStart();
-            blockEndSample = blockStartSample + bf->GetLength();
-         }
+         auto locker = bf->LockForRead();
+         //Get the decoder.  If the file was moved, we need to create another one and init it.
+         decoder = GetOrCreateMatchingFileDecoder( &*bf );
+         if(!decoder->IsInitialized())
+            decoder->Init();
+         bf->SetODFileDecoder(decoder);
+         // Does not throw:
+         ret = bf->DoWriteBlockFile();
       }
-      else
-      {
+
+      if(ret >= 0) {
          success = true;
-         // The block file disappeared.
-         //the waveform in the wavetrack now is shorter, so we need to update mMaxBlockFiles
-         //because now there is less work to do.
-         mMaxBlockFiles--;
+         blockStartSample = bf->GetStart();
+         blockEndSample = blockStartSample + bf->GetLength();
       }
+   }
+   else
+   {
+      success = true;
+      // The block file disappeared.
+      //the waveform in the wavetrack now is shorter, so we need to update mMaxBlockFiles
+      //because now there is less work to do.
+      mMaxBlockFiles--;
+   }
 
-      if (success)
+   if (success)
+   {
+      //take it out of the array - we are done with it.
+      mBlockFiles.erase(mBlockFiles.begin());
+   }
+   else
+      // The task does not make progress
+      ;
+
+   //Release the refcount we placed on it if we are successful
+   if( bf && success ) {
+      //upddate the gui for all associated blocks.  It doesn't matter that we're hitting more wavetracks then we should
+      //because they probably share the same sample window.
+      mWaveTrackMutex.Lock();
+      for(size_t i=0;i<mWaveTracks.size();i++)
       {
-         //take it out of the array - we are done with it.
-         mBlockFiles.erase(mBlockFiles.begin());
-      }
-      else
-         // The task does not make progress
-         ;
-
-      //Release the refcount we placed on it if we are successful
-      if( bf && success ) {
-         //upddate the gui for all associated blocks.  It doesn't matter that we're hitting more wavetracks then we should
-         //because this loop runs a number of times equal to the number of tracks, they probably are getting processed in
-         //the next iteration at the same sample window.
-         mWaveTrackMutex.Lock();
-         for(size_t i=0;i<mWaveTracks.size();i++)
-         {
-            auto waveTrack = mWaveTracks[i].lock();
-            if(waveTrack)
-               waveTrack->AddInvalidRegion(blockStartSample,blockEndSample);
-         }
-         mWaveTrackMutex.Unlock();
+         auto waveTrack = mWaveTracks[i].lock();
+         if(waveTrack)
+            waveTrack->AddInvalidRegion(blockStartSample,blockEndSample);
       }
+      mWaveTrackMutex.Unlock();
    }
 
-   //update percentage complete.
-   CalculatePercentComplete();
+   return true;
 }
 
 void ODDecodeTask::CalculatePercentComplete()
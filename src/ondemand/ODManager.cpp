@@ -19,117 +19,12 @@ ODTask requests and internals.
 
 #include "ODTask.h"
 #include "ODWaveTrackTaskQueue.h"
+#include "ODWorkerPool.h"
 #include "../Project.h"
-#include <NonGuiThread.h>
-#include <wx/utils.h>
+#include <thread>
 #include <wx/wx.h>
-#include <wx/thread.h>
 #include <wx/event.h>
 
-#ifdef __WXMAC__
-
-// On Mac OS X, it's better not to use the wxThread class.
-// We use our own implementation based on pthreads instead.
-
-class ODTaskThread {
- public:
-   typedef int ExitCode;
-   ODTaskThread(ODTask* task);
-   /*ExitCode*/ void Entry();
-   void Create() {}
-   void Delete() {
-      mDestroy = true;
-      pthread_join(mThread, NULL);
-   }
-   bool TestDestroy() { return mDestroy; }
-   void Sleep(int ms) {
-      struct timespec spec;
-      spec.tv_sec = 0;
-      spec.tv_nsec = ms * 1000 * 1000;
-      nanosleep(&spec, NULL);
-   }
-   static void *callback(void *p) {
-      ODTaskThread *th = (ODTaskThread *)p;
-#if defined(__WXMAC__)
-      /*return (void *)*/ th->Entry();
-      return NULL;
-#else
-      return (void *) th->Entry();
-#endif
-   }
-   void Run() {
-      pthread_create(&mThread, NULL, callback, this);
-   }
-
-   ///Specifies the priority the thread will run at.  Currently doesn't work.
-   ///@param priority value from 0 (min priority) to 100 (max priority)
-   void SetPriority(int priority)
-   {
-      mPriority=priority;
-   }
-
- private:
-   int mPriority;
-   bool mDestroy;
-   pthread_t mThread;
-
-   ODTask* mTask;
-};
-
-#else
-
-class ODTaskThread final : public wxThread
-{
-public:
-   ///Constructs a ODTaskThread
-   ///@param task the task to be launched as an
-   ODTaskThread(ODTask* task);
-
-
-protected:
-   ///Executes a part of the task
-   void* Entry() override;
-   ODTask* mTask;
-
-};
-
-#endif
-
-ODTaskThread::ODTaskThread(ODTask* task)
-#ifndef __WXMAC__
-: wxThread()
-#endif
-{
-   mTask=task;
-#ifdef __WXMAC__
-   mDestroy = false;
-   mThread = NULL;
-#endif
-
-}
-
-#ifdef __WXMAC__
-
-void ODTaskThread::Entry()
-#else
-void *ODTaskThread::Entry()
-
-#endif
-{
-   //TODO: Figure out why this has no effect at all.
-   //wxThread::This()->SetPriority( 40);
-   //Do at least 5 percent of the task
-   mTask->DoSome(0.05f);
-
-   //release the thread count so that the ODManager knows how many active threads are alive.
-   ODManager::Instance()->DecrementCurrentThreads();
-
-
-#ifndef __WXMAC__
-   return NULL;
-#endif
-}
-
 static ODLock gODInitedMutex;
 static bool gManagerCreated=false;
 static bool gPause=false; //to be loaded in and used with Pause/Resume before ODMan init.
@@ -158,88 +53,35 @@ int CompareNoCaseFileName(const wxString& first, const wxString& second)
 //private constructor - Singleton.
 ODManager::ODManager()
 {
-   mTerminate = false;
-   mTerminated = false;
-   mPause = gPause;
-
-   //must set up the queue condition
-   mQueueNotEmptyCond = std::make_unique<ODCondition>(&mQueueNotEmptyCondLock);
 }
 
 //private destructor - DELETE with static method Quit()
 ODManager::~ODManager()
 {
-   mTerminateMutex.Lock();
-   mTerminate = true;
-   mTerminateMutex.Unlock();
-
-   //This while loop waits for ODTasks to finish and the DELETE removes all tasks from the Queue.
+   //This waits for running jobs to finish and drops the queued ones.
    //This function is called from the main audacity event thread, so there should not be more requests for pMan
-   mTerminatedMutex.Lock();
-   while (!mTerminated)
-   {
-      mTerminatedMutex.Unlock();
-      wxThread::Sleep(200);
-
-      //signal the queue not empty condition since the ODMan thread will wait on the queue condition
-      mQueueNotEmptyCondLock.Lock();
-      mQueueNotEmptyCond->Signal();
-      mQueueNotEmptyCondLock.Unlock();
-
-      mTerminatedMutex.Lock();
-   }
-   mTerminatedMutex.Unlock();
+   mPool->Stop();
 
    //get rid of all the queues.  The queues get rid of the tasks, so we don't worry abut them.
    //nothing else should be running on OD related threads at this point, so we don't lock.
    mQueues.clear();
 }
 
-///Adds a task to running queue.  Thread-safe.
+///Adds a job of a task to the worker pool.  Thread-safe.
 void ODManager::AddTask(ODTask* task)
 {
-   mTasksMutex.Lock();
-   mTasks.push_back(task);
-   mTasksMutex.Unlock();
-   //signal the queue not empty condition.
-   bool paused;
-
-   mPauseLock.Lock();
-   paused=mPause;
-   mPauseLock.Unlock();
-
-   //don't signal if we are paused since if we wake up the loop it will start processing other tasks while paused
-   if(!paused)
-      mQueueNotEmptyCond->Signal();
+   mPool->Add(task);
 }
 
 void ODManager::SignalTaskQueueLoop()
 {
-   bool paused;
-
-   mPauseLock.Lock();
-   paused=mPause;
-   mPauseLock.Unlock();
-   //don't signal if we are paused
-   if(!paused)
-      mQueueNotEmptyCond->Signal();
+   UpdateQueues();
 }
 
-///removes a task from the active task queue
+///removes a task's queued jobs from the worker pool
 void ODManager::RemoveTaskIfInQueue(ODTask* task)
 {
-   mTasksMutex.Lock();
-   //linear search okay for now, (probably only 1-5 tasks exist at a time.)
-   for(unsigned int i=0;i<mTasks.size();i++)
-   {
-      if(mTasks[i]==task)
-      {
-         mTasks.erase(mTasks.begin()+i);
-         break;
-      }
-   }
-   mTasksMutex.Unlock();
-
+   mPool->Remove(task);
 }
 
 ///Adds a NEW task to the queue.  Creates a queue if the tracks associated with the task is not in the list
@@ -315,143 +157,49 @@ bool ODManager::IsInstanceCreated()
    return ret;
 }
 
-///Launches a thread for the manager and starts accepting Tasks.
+///Launches the worker threads and starts accepting Tasks.
 void ODManager::Init()
 {
-   mCurrentThreads = 0;
-   mMaxThreads = 5;
-
-   //   wxLogDebug(wxT("Initializing ODManager...Creating manager thread"));
-   // This is a detached thread, so it deletes itself when it finishes
-   // ... except on Mac where we we don't use wxThread for reasons unexplained
-   ODManagerHelperThread* startThread = safenew ODManagerHelperThread;
-
-//   startThread->SetPriority(0);//default of 50.
-   startThread->Create();
-//   wxPrintf("starting thread from init\n");
-   startThread->Run();
-
-//   wxPrintf("started thread from init\n");
-   //destruction of thread is taken care of by thread library
+   //one worker for each processor
+   mPool = std::make_unique<ODWorkerPool>(
+      std::thread::hardware_concurrency(),
+      [this](bool outOfWork){ JobDone(outOfWork); } );
+   mPool->Pause(gPause);
 }
 
-void ODManager::DecrementCurrentThreads()
+///Called by the workers after each job.
+void ODManager::JobDone(bool outOfWork)
 {
-   mCurrentThreadsMutex.Lock();
-   mCurrentThreads--;
-   mCurrentThreadsMutex.Unlock();
-}
-
-///Main loop for managing threads and tasks.
-void ODManager::Start()
-{
-   bool tasksInArray;
-   bool paused;
-   int  numQueues=0;
-
-   mNeedsDraw=0;
-
-   //wxLog calls not threadsafe.  are printfs?  thread-messy for sure, but safe?
-//   wxPrintf("ODManager thread strating \n");
-   //TODO: Figure out why this has no effect at all.
-   //wxThread::This()->SetPriority(30);
-   mTerminateMutex.Lock();
-   while(!mTerminate)
-   {
-      mTerminateMutex.Unlock();
-//    wxPrintf("ODManager thread running \n");
-
-      //we should look at our WaveTrack queues to see if we can process a NEW task to the running queue.
+   //some task ran out of work: remove it if it is complete and schedule the next in its queue
+   if(outOfWork)
       UpdateQueues();
 
-      //start some threads if necessary
-
-      mTasksMutex.Lock();
-      tasksInArray = mTasks.size()>0;
-      mTasksMutex.Unlock();
-
-      mPauseLock.Lock();
-      paused=mPause;
-      mPauseLock.Unlock();
-
-      mCurrentThreadsMutex.Lock();
-      // keep adding tasks if there is work to do, up to the limit.
-      while(!paused && tasksInArray && (mCurrentThreads < mMaxThreads))
-      {
-         mCurrentThreads++;
-         mCurrentThreadsMutex.Unlock();
-
-         mTasksMutex.Lock();
-         //detach a NEW thread.
-         // This is a detached thread, so it deletes itself when it finishes
-         // ... except on Mac where we we don't use wxThread for reasons unexplained
-         auto thread = safenew ODTaskThread(mTasks[0]);//task);
-         //thread->SetPriority(10);//default is 50.
-         thread->Create();
-         thread->Run();
-
-         mTasks.erase(mTasks.begin());
-         tasksInArray = mTasks.size()>0;
-         mTasksMutex.Unlock();
-
-         mCurrentThreadsMutex.Lock();
-      }
-
-      mCurrentThreadsMutex.Unlock();
-      //use a conditon variable to block here instead of a sleep.
-
-      // JKC: If there are no tasks ready to run, or we're paused then
-      // we wait for there to be tasks in the queue.
-      {
-         ODLocker locker{ &mQueueNotEmptyCondLock };
-         if( (!tasksInArray) || paused)
-            mQueueNotEmptyCond->Wait();
-      }
-
-      //if there is some ODTask running, then there will be something in the queue.  If so then redraw to show progress
-      mQueuesMutex.Lock();
-      mNeedsDraw += mQueues.size()>0?1:0;
-      numQueues=mQueues.size();
-      mQueuesMutex.Unlock();
-
-      //redraw the current project only (ODTasks will send a redraw on complete even if the projects are in the background)
-      //we don't want to redraw at a faster rate when we have more queues because
-      //this means the CPU is already taxed.  This if statement normalizes the rate
-      if((mNeedsDraw>numQueues) && numQueues)
-      {
-         mNeedsDraw=0;
-         wxCommandEvent event( EVT_ODTASK_UPDATE );
-         ODLocker locker{ &AllProjects::Mutex() };
-         AudacityProject* proj = GetActiveProject();
-         if(proj)
-            proj->wxEvtHandler::AddPendingEvent(event);
-      }
-      mTerminateMutex.Lock();
+   //redraw the current project only (ODTasks will send a redraw on complete even if the projects are in the background)
+   //we don't want to redraw at a faster rate when we have more workers because
+   //this means the CPU is already taxed.  So limit the rate.
+   {
+      const auto now = std::chrono::steady_clock::now();
+      std::lock_guard<std::mutex> lock{ mLastDrawMutex };
+      if(now - mLastDraw < std::chrono::milliseconds(100))
+         return;
+      mLastDraw = now;
    }
-   mTerminateMutex.Unlock();
-
-   mTerminatedMutex.Lock();
-   mTerminated=true;
-   mTerminatedMutex.Unlock();
 
-   //wxLogDebug Not thread safe.
-   //wxPrintf("ODManager thread terminating\n");
+   wxCommandEvent event( EVT_ODTASK_UPDATE );
+   ODLocker locker{ &AllProjects::Mutex() };
+   AudacityProject* proj = GetActiveProject();
+   if(proj)
+      proj->wxEvtHandler::AddPendingEvent(event);
 }
 
 //static function that prevents ODTasks from being scheduled
-//does not stop currently running tasks from completing their immediate subtask,
+//does not stop currently running jobs from completing their block file,
 //but presumably they will finish within a second
 void ODManager::Pauser::Pause(bool pause)
 {
    if(IsInstanceCreated())
    {
-      pMan->mPauseLock.Lock();
-      pMan->mPause = pause;
-      pMan->mPauseLock.Unlock();
-
-      if(!pause)
-         //we should check the queue again.
-         pMan->mQueueNotEmptyCond->Signal();
+      pMan->mPool->Pause(pause);
    }
    else
    {
@@ -551,6 +299,9 @@ bool ODManager::MakeWaveTrackDependent(
    //finally remove the dependent track
    mQueues.erase(mQueues.begin()+dependentIndex);
    mQueuesMutex.Unlock();
+
+   //the master's front task may have finished its jobs, but has more to do now
+   UpdateQueues();
    return true;
 }
 
@@ -564,6 +315,12 @@ void ODManager::DemandTrackUpdate(WaveTrack* track, double seconds)
    for(unsigned int i=0;i<mQueues.size();i++)
    {
       mQueues[i]->DemandTrackUpdate(track,seconds);
+      //and do the track's work before that of other tracks
+      if(mQueues[i]->ContainsWaveTrack(track))
+      {
+         if(ODTask* task = mQueues[i]->GetFrontTask())
+            mPool->Add(task, true);
+      }
    }
    mQueuesMutex.Unlock();
 }
@@ -589,6 +346,12 @@ void ODManager::UpdateQueues()
             AddTask(queue->GetFrontTask());
          }
       }
+      else if(ODTask* task = mQueues[i]->GetFrontTask())
+      {
+         //there is a chance the task got more to do after its jobs ran out, (like when it is joined with a NEW track)
+         if(!task->IsRunning())
+            AddTask(task);
+      }
 
       //if the queue is empty DELETE it.
       if(mQueues[i]->IsEmpty())
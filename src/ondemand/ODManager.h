@@ -19,17 +19,12 @@ number of threads.
 #ifndef __AUDACITY_ODMANAGER__
 #define __AUDACITY_ODMANAGER__
 
+#include <chrono>
+#include <mutex>
 #include <vector>
 #include "ODTaskThread.h"
 #include <wx/event.h> // for DECLARE_EXPORTED_EVENT_TYPE
 
-#ifdef __WXMAC__
-// On Mac OS X, it's better not to use the wxThread class.
-// We use our own implementation based on pthreads instead.
-#include <pthread.h>
-#include <time.h>
-#endif //__WXMAC__
-
 wxDECLARE_EXPORTED_EVENT(AUDACITY_DLL_API,
                          EVT_ODTASK_UPDATE, wxCommandEvent);
 
@@ -40,6 +35,7 @@ int CompareNoCaseFileName(const wxString& first, const wxString& second);
 class Track;
 class WaveTrack;
 class ODWaveTrackTaskQueue;
+class ODWorkerPool;
 class ODManager final
 {
  public:
@@ -58,13 +54,10 @@ class ODManager final
    ///changes the tasks associated with this Waveform to process the task from a different point in the track
    void DemandTrackUpdate(WaveTrack* track, double seconds);
 
-   ///Reduces the count of current threads running.  Meant to be called when ODTaskThreads end in their own threads.  Thread-safe.
-   void DecrementCurrentThreads();
-
    ///Adds a wavetrack, creates a queue member.
    void AddNewTask(std::unique_ptr<ODTask> &&mtask, bool lockMutex=true);
 
-   ///Wakes the queue loop up by signalling its condition variable.
+   ///Removes completed tasks from the queues and schedules the next ones.
    void SignalTaskQueueLoop();
 
    ///if it shares a queue/task, creates a NEW queue/task for the track, and removes it from any previously existing tasks.
@@ -82,7 +75,7 @@ class ODManager final
    void ReplaceWaveTrack(Track *oldTrack,
       const std::shared_ptr< Track > &newTrack);
 
-   ///Adds a task to the running queue.  Threas-safe.
+   ///Adds a job of a task to the worker pool.  Thread-safe.
    void AddTask(ODTask* task);
 
    void RemoveTaskIfInQueue(ODTask* task);
@@ -129,11 +122,11 @@ class ODManager final
    //private constructor - DELETE with static method Quit()
    friend std::default_delete < ODManager > ;
    ~ODManager();
-   ///Launches a thread for the manager and starts accepting Tasks.
+   ///Launches the worker threads and starts accepting Tasks.
    void Init();
 
-   ///Start the main loop for the manager.
-   void Start();
+   ///Called by the workers after each job.  Thread-safe.
+   void JobDone(bool outOfWork);
 
    ///Remove references in our array to Tasks that have been completed/Schedule NEW ones
    void UpdateQueues();
@@ -145,99 +138,12 @@ class ODManager final
    std::vector<std::unique_ptr<ODWaveTrackTaskQueue>> mQueues;
    ODLock mQueuesMutex;
 
-   //List of current Task to do.
-   std::vector<ODTask*> mTasks;
-   //mutex for above variable
-   ODLock mTasksMutex;
-
-   //global pause switch for OD
-   volatile bool mPause;
-   ODLock mPauseLock;
-
-   volatile int mNeedsDraw;
-
-   ///Number of threads currently running.   Accessed thru multiple threads
-   volatile int mCurrentThreads;
-   //mutex for above variable
-   ODLock mCurrentThreadsMutex;
-
-   ///Maximum number of threads allowed out.
-   int mMaxThreads;
-
-   volatile bool mTerminate;
-   ODLock mTerminateMutex;
-
-   volatile bool mTerminated;
-   ODLock mTerminatedMutex;
-
-   //for the queue not empty comdition
-   ODLock         mQueueNotEmptyCondLock;
-   std::unique_ptr<ODCondition> mQueueNotEmptyCond;
+   //The threads that do the jobs of the tasks at the front of the queues.
+   std::unique_ptr<ODWorkerPool> mPool;
 
-#ifdef __WXMAC__
-
-// On Mac OS X, it's better not to use the wxThread class.
-// We use our own implementation based on pthreads instead.
-
-class ODManagerHelperThread {
- public:
-   typedef int ExitCode;
-   ODManagerHelperThread() { mDestroy = false; mThread = NULL; }
-  /* ExitCode*/ void Entry(){
-         ODManager::Instance()->Start();
-   }
-
-   void Create() {}
-   void Delete() {
-      mDestroy = true;
-      pthread_join(mThread, NULL);
-   }
-   bool TestDestroy() { return mDestroy; }
-   void Sleep(int ms) {
-      struct timespec spec;
-      spec.tv_sec = 0;
-      spec.tv_nsec = ms * 1000 * 1000;
-      nanosleep(&spec, NULL);
-   }
-   static void *callback(void *p) {
-      ODManagerHelperThread *th = (ODManagerHelperThread *)p;
-      /* return (void *) */th->Entry();
-      return NULL;
-   }
-
-   ///Specifies the priority the thread will run at.  Currently doesn't work.
-   ///@param priority value from 0 (min priority) to 100 (max priority)
-   void SetPriority(int priority)
-   {
-      mPriority=priority;
-   }
-
-   void Run() {
-      pthread_create(&mThread, NULL, callback, this);
-   }
- private:
-   bool mDestroy;
-   pthread_t mThread;
-   int mPriority;
-};
-#else
-   class ODManagerHelperThread final : public wxThread
-   {
-      public:
-      ///Constructs an ODManagerHelperThread
-      ///@param task the task to be launched as an
-      ODManagerHelperThread(): wxThread(){}
-
-      protected:
-      ///Executes a part of the task
-      void *Entry()
-      {
-         ODManager::Instance()->Start();
-         return NULL;
-      }
-
-   };
-#endif //__WXMAC__
+   //when the current project was last told to redraw
+   std::chrono::steady_clock::time_point mLastDraw;
+   std::mutex mLastDrawMutex;
 };
 
 #endif
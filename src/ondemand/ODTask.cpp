@@ -38,10 +38,11 @@ ODTask::ODTask()
 
    static int sTaskNumber=0;
    mPercentComplete=0;
-   mDoingTask=false;
    mTerminate = false;
    mNeedsODUpdate=false;
-   mIsRunning = false;
+   mJobSlots = 0;
+   mUpdated = false;
+   mCompleted = false;
 
    mTaskNumber=sTaskNumber++;
 }
@@ -52,81 +53,77 @@ void ODTask::TerminateAndBlock()
    //one mutex pair for the value of mTerminate
    mTerminateMutex.Lock();
    mTerminate=true;
-   //release all data the derived class may have allocated
    mTerminateMutex.Unlock();
 
-   //and one mutex pair for the exit of the function
-   mBlockUntilTerminateMutex.Lock();
-//TODO lock mTerminate?
-   mBlockUntilTerminateMutex.Unlock();
+   //queued jobs would never start while OD is paused, so take them back.
+   //There is no manager while it is being destroyed, but then it has dropped its jobs already.
+   if(ODManager::IsInstanceCreated())
+   {
+      if(auto pMan = ODManager::Instance())
+         pMan->RemoveTaskIfInQueue(this);
+   }
+
+   //wait till the running jobs are out of DoJob() to terminate.
+   {
+      std::unique_lock<std::mutex> lock{ mJobSlotsMutex };
+      mJobSlotsCondition.wait(lock, [this]{ return mJobSlots == 0; });
+   }
 
-   //wait till we are out of doSome() to terminate.
+   //release all data the derived class may have allocated
    Terminate();
 }
 
-///Do a modular part of the task.  For example, if the task is to load the entire file, load one BlockFile.
-///Relies on DoSomeInternal(), which is the subclasses must implement.
-///@param amountWork the percent amount of the total job to do.  1.0 represents the entire job.  the default of 0.0
-/// will do the smallest unit of work possible
-void ODTask::DoSome(float amountWork)
+bool ODTask::IsTerminating()
 {
-   SetIsRunning(true);
-   mBlockUntilTerminateMutex.Lock();
-
-//   wxPrintf("%s %i subtask starting on NEW thread with priority\n", GetTaskName(),GetTaskNumber());
-
-   mDoingTask=mTaskStarted=true;
-
-   float workUntil = amountWork+PercentComplete();
-
+   ODLocker locker{ &mTerminateMutex };
+   return mTerminate;
+}
 
+bool ODTask::AcquireJobSlot()
+{
+   std::lock_guard<std::mutex> lock{ mJobSlotsMutex };
+   if(IsTerminating() || (mJobSlots > 0 && !AllowsConcurrentJobs()))
+      return false;
+   ++mJobSlots;
+   return true;
+}
 
-   //check periodically to see if we should exit.
-   mTerminateMutex.Lock();
-   if(mTerminate)
+void ODTask::ReleaseJobSlot()
+{
    {
-      mTerminateMutex.Unlock();
-      SetIsRunning(false);
-      mBlockUntilTerminateMutex.Unlock();
-      return;
+      std::lock_guard<std::mutex> lock{ mJobSlotsMutex };
+      --mJobSlots;
    }
-   mTerminateMutex.Unlock();
-
-   Update();
-
-
-   if(UsesCustomWorkUntilPercentage())
-      workUntil = ComputeNextWorkUntilPercentageComplete();
-
-   if(workUntil<PercentComplete())
-      workUntil = PercentComplete();
+   mJobSlotsCondition.notify_all();
+}
 
-   //Do Some of the task.
+///Do the smallest unit of the task.  For example, if the task is to load the entire file, load one BlockFile.
+///Relies on DoSomeInternal(), which is the subclasses must implement.
+///@return false if there was no more work to start
+bool ODTask::DoJob()
+{
+   //check to see if we should exit.
+   if(IsTerminating())
+      return false;
 
-   mTerminateMutex.Lock();
-   while(PercentComplete() < workUntil && PercentComplete() < 1.0 && !mTerminate)
+   //order the work the first time, and again whenever ondemand has been called
+   if(!mUpdated || GetNeedsODUpdate())
    {
-      wxThread::This()->Yield();
-      //release within the loop so we can cut the number of iterations short
-
-      DoSomeInternal(); //keep the terminate mutex on so we don't remo
-      mTerminateMutex.Unlock();
-      //check to see if ondemand has been called
-      if(GetNeedsODUpdate() && PercentComplete() < 1.0)
+      std::lock_guard<std::mutex> lock{ mUpdateMutex };
+      if(!mUpdated || GetNeedsODUpdate())
+      {
          ODUpdate();
-
-
-      //But add the mutex lock back before we check the value again.
-      mTerminateMutex.Lock();
+         mUpdated = true;
+      }
    }
-   mTerminateMutex.Unlock();
-   mDoingTask=false;
 
-   mTerminateMutex.Lock();
-   //if it is not done, put it back onto the ODManager queue.
-   if(PercentComplete() < 1.0&& !mTerminate)
+   //Do Some of the task.
+   const bool claimed = DoSomeInternal();
+   CalculatePercentComplete();
+
+   if(claimed)
    {
-      ODManager::Instance()->AddTask(this);
+      mCompleted = false;
 
       //we did a bit of progress - we should allow a resave.
       ODLocker locker{ &AllProjects::Mutex() };
@@ -140,10 +137,11 @@ void ODTask::DoSome(float amountWork)
          }
       }
 
-
-//      wxPrintf("%s %i is %f done\n", GetTaskName(),GetTaskNumber(),PercentComplete());
+      return true;
    }
-   else
+
+   //Only one of the jobs that find nothing left reports completion
+   if(PercentComplete() >= 1.0 && !IsTerminating() && !mCompleted.exchange(true))
    {
       //for profiling, uncomment and look in audacity.app/exe's folder for AudacityProfile.txt
       //static int tempLog =0;
@@ -168,9 +166,8 @@ void ODTask::DoSome(float amountWork)
 
 //      wxPrintf("%s %i complete\n", GetTaskName(),GetTaskNumber());
    }
-   mTerminateMutex.Unlock();
-   SetIsRunning(false);
-   mBlockUntilTerminateMutex.Unlock();
+
+   return false;
 }
 
 bool ODTask::IsTaskAssociatedWithProject(AudacityProject* proj)
@@ -202,20 +199,11 @@ void ODTask::ODUpdate()
    ResetNeedsODUpdate();
 }
 
-void ODTask::SetIsRunning(bool value)
-{
-   mIsRunningMutex.Lock();
-   mIsRunning=value;
-   mIsRunningMutex.Unlock();
-}
-
+///returns whether any job is queued or running.
 bool ODTask::IsRunning()
 {
-   bool ret;
-   mIsRunningMutex.Lock();
-   ret= mIsRunning;
-   mIsRunningMutex.Unlock();
-   return ret;
+   std::lock_guard<std::mutex> lock{ mJobSlotsMutex };
+   return mJobSlots > 0;
 }
 
 sampleCount ODTask::GetDemandSample() const
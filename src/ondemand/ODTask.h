@@ -25,6 +25,9 @@ in a background thread.
 
 #include "../BlockFile.h"
 
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
 #include <vector>
 #include <wx/event.h> // to declare custom event type
 class AudacityProject;
@@ -61,19 +64,22 @@ class ODTask /* not final */
    virtual unsigned int GetODType(){return eODNone;}
 
 
-///Do a modular part of the task.  For example, if the task is to load the entire file, load one BlockFile.
+///Do the smallest unit of the task, such as loading one BlockFile, in the order the user demands.
 ///Relies on DoSomeInternal(), which is the subclasses must implement.
-///@param amountWork the percent amount of the total job to do.  1.0 represents the entire job.  the default of 0.0
-/// will do the smallest unit of work possible
-   void DoSome(float amountWork=0.0);
+///Several threads may do jobs of a task at once if AllowsConcurrentJobs() is true.
+///@return false if there was no more work to start
+   bool DoJob();
 
-   ///Call DoSome until PercentComplete >= 1.0
-   void DoAll();
+   ///Whether jobs of this task may run on several threads at once
+   virtual bool AllowsConcurrentJobs(){return false;}
 
-   virtual float PercentComplete();
+   ///Reserves a place for a job that a thread will do later.  Fails if the task is terminating
+   ///or, for tasks that do one job at a time, if another is reserved.  Thread-safe.
+   bool AcquireJobSlot();
+   ///Gives up a place reserved by AcquireJobSlot().  Thread-safe.
+   void ReleaseJobSlot();
 
-   virtual bool UsesCustomWorkUntilPercentage(){return false;}
-   virtual float ComputeNextWorkUntilPercentageComplete(){return 1.0;}
+   virtual float PercentComplete();
 
    ///returns whether or not this task and another task can merge together, as when we make two mono tracks stereo.
    ///for Loading/Summarizing, this is not an issue because the entire track is processed
@@ -97,7 +103,9 @@ class ODTask /* not final */
 
    bool IsComplete();
 
+   ///Stops jobs from starting and waits for running ones to finish.
    void TerminateAndBlock();
+   bool IsTerminating();
    ///releases memory that the ODTask owns.  Subclasses should override.
    virtual void Terminate(){}
 
@@ -132,30 +140,36 @@ class ODTask /* not final */
 
    ///pure virtual function that does some part of the task this object represents.
    ///this function is meant to be called repeatedly until the IsComplete is true.
-   ///Does the smallest unit of work for this task.
-   virtual void DoSomeInternal() = 0;
+   ///Claims and does the smallest unit of work for this task, which must be thread-safe
+   ///if AllowsConcurrentJobs() is true.
+   ///@return false if there was no unit left to claim
+   virtual bool DoSomeInternal() = 0;
 
-   ///virtual method called before DoSomeInternal is used from DoSome.
+   ///virtual method called before the first DoSomeInternal.
    virtual void Update(){}
 
-   ///virtual method called in DoSome everytime the user has demanded some OD function so that the
+   ///virtual method called in DoJob everytime the user has demanded some OD function so that the
    ///ODTask can readjust its computation order.  By default just calls Update(), but subclasses with
    ///special needs can override this
    virtual void ODUpdate();
 
-   void SetIsRunning(bool value);
-
 
 
    int   mTaskNumber;
    volatile float mPercentComplete;
    ODLock mPercentCompleteMutex;
-   volatile bool  mDoingTask;
-   volatile bool  mTaskStarted;
    volatile bool mTerminate;
    ODLock mTerminateMutex;
-   //for a function not a member var.
-   ODLock mBlockUntilTerminateMutex;
+
+   //jobs queued or running, and the condition TerminateAndBlock waits on for them
+   int mJobSlots;
+   std::mutex mJobSlotsMutex;
+   std::condition_variable mJobSlotsCondition;
+
+   //so that only one thread reorders the work at a time
+   std::mutex mUpdateMutex;
+   std::atomic<bool> mUpdated;
+   std::atomic<bool> mCompleted;
 
    std::vector< std::weak_ptr< WaveTrack > > mWaveTracks;
    ODLock     mWaveTrackMutex;
@@ -163,9 +177,6 @@ class ODTask /* not final */
    sampleCount mDemandSample;
    mutable ODLock      mDemandSampleMutex;
 
-   volatile bool mIsRunning;
-   ODLock mIsRunningMutex;
-
 
    private:
 
@@ -10,8 +10,8 @@
 
 ******************************************************************//**
 
-\class ODTaskThread
-\brief A thread that executes a part of the task specfied by an ODTask.
+\file ODTaskThread.cpp
+\brief Locks and conditions for the threads that do the jobs of ODTasks.
 
 *//*******************************************************************/
 
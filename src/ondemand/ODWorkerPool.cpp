@@ -0,0 +1,213 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  ODWorkerPool.cpp
+
+  Audacity(R) is copyright (c) 1999-2019 Audacity Team.
+  License: GPL v2.  See License.txt.
+
+******************************************************************//**
+
+\class ODWorkerPool
+\brief A work-stealing pool of threads, one per processor, that does the
+jobs of ODTasks.
+
+  Jobs are short, one block file each, so a mutex per queue is cheap
+  enough, and pausing or demanding another place takes effect within one
+  block.
+
+*//*******************************************************************/
+
+#include "../Audacity.h"
+#include "ODWorkerPool.h"
+
+#include <algorithm>
+
+#include "ODTask.h"
+
+ODWorkerPool::ODWorkerPool( size_t nWorkers, JobDoneCallback callback )
+   : mCallback{ std::move( callback ) }
+{
+   nWorkers = std::max< size_t >( 1, nWorkers );
+
+   // All the queues must exist before any worker looks for one to steal from
+   for ( size_t ii = 0; ii < nWorkers; ++ii )
+      mWorkers.push_back( std::make_unique< Worker >() );
+   for ( size_t ii = 0; ii < nWorkers; ++ii )
+      mWorkers[ii]->thread = std::thread( [this, ii]{ Run( ii ); } );
+}
+
+ODWorkerPool::~ODWorkerPool()
+{
+   Stop();
+}
+
+void ODWorkerPool::Stop()
+{
+   mStopping = true;
+
+   // Give back the slots of jobs that will never run, so that
+   // ODTask::TerminateAndBlock() does not wait for them
+   for ( auto &pWorker : mWorkers ) {
+      std::lock_guard< std::mutex > lock{ pWorker->mutex };
+      for ( auto task : pWorker->jobs ) {
+         --mQueued;
+         task->ReleaseJobSlot();
+      }
+      pWorker->jobs.clear();
+   }
+
+   {
+      std::lock_guard< std::mutex > lock{ mMutex };
+   }
+   mCondition.notify_all();
+
+   for ( auto &pWorker : mWorkers )
+      if ( pWorker->thread.joinable() )
+         pWorker->thread.join();
+}
+
+void ODWorkerPool::Add( ODTask *task, bool urgent )
+{
+   // An urgent task that already waits needs no more jobs, only to go first
+   if ( urgent && Promote( task ) )
+      return;
+   // Otherwise the task may already have all the jobs it may have
+   if ( task->AcquireJobSlot() )
+      Push( mNextWorker++ % mWorkers.size(), task, urgent );
+}
+
+bool ODWorkerPool::Promote( ODTask *task )
+{
+   bool found = false;
+   for ( auto &pWorker : mWorkers ) {
+      std::lock_guard< std::mutex > lock{ pWorker->mutex };
+      auto &jobs = pWorker->jobs;
+      auto iter = std::find( jobs.begin(), jobs.end(), task );
+      if ( iter != jobs.end() ) {
+         jobs.erase( iter );
+         jobs.push_front( task );
+         found = true;
+      }
+   }
+   return found;
+}
+
+void ODWorkerPool::Remove( ODTask *task )
+{
+   for ( auto &pWorker : mWorkers ) {
+      std::lock_guard< std::mutex > lock{ pWorker->mutex };
+      auto &jobs = pWorker->jobs;
+      auto end = jobs.end();
+      auto newEnd = std::remove( jobs.begin(), end, task );
+      for ( auto iter = newEnd; iter != end; ++iter ) {
+         --mQueued;
+         task->ReleaseJobSlot();
+      }
+      jobs.erase( newEnd, end );
+   }
+}
+
+void ODWorkerPool::Pause( bool pause )
+{
+   mPaused = pause;
+   if ( !pause )
+      Notify();
+}
+
+void ODWorkerPool::Push( size_t index, ODTask *task, bool front )
+{
+   {
+      auto &worker = *mWorkers[index];
+      std::lock_guard< std::mutex > lock{ worker.mutex };
+      if ( mStopping ) {
+         task->ReleaseJobSlot();
+         return;
+      }
+      if ( front )
+         worker.jobs.push_front( task );
+      else
+         worker.jobs.push_back( task );
+      ++mQueued;
+   }
+   Notify();
+}
+
+void ODWorkerPool::Notify()
+{
+   // Lock and unlock, so that a worker between testing for jobs and
+   // waiting does not miss the notification
+   {
+      std::lock_guard< std::mutex > lock{ mMutex };
+   }
+   mCondition.notify_all();
+}
+
+ODTask *ODWorkerPool::Take( size_t index )
+{
+   // Own jobs from the front, others' from the back
+   const auto nWorkers = mWorkers.size();
+   for ( size_t ii = 0; ii < nWorkers; ++ii ) {
+      auto &worker = *mWorkers[ ( index + ii ) % nWorkers ];
+      std::lock_guard< std::mutex > lock{ worker.mutex };
+      auto &jobs = worker.jobs;
+      if ( jobs.empty() )
+         continue;
+      ODTask *task;
+      if ( ii == 0 ) {
+         task = jobs.front();
+         jobs.pop_front();
+      }
+      else {
+         task = jobs.back();
+         jobs.pop_back();
+      }
+      --mQueued;
+      return task;
+   }
+   return nullptr;
+}
+
+void ODWorkerPool::Run( size_t index )
+{
+   auto &worker = *mWorkers[index];
+   while ( !mStopping ) {
+      ODTask *task = mPaused ? nullptr : Take( index );
+      if ( !task ) {
+         std::unique_lock< std::mutex > lock{ mMutex };
+         ++mIdle;
+         mCondition.wait( lock, [this]{
+            return mStopping || ( !mPaused && mQueued > 0 ); } );
+         --mIdle;
+         continue;
+      }
+
+      bool more = false;
+      try {
+         more = task->DoJob();
+      }
+      catch ( ... ) {
+      }
+
+      // Let an idle worker share the task, if it has nothing else to steal
+      if ( more && mIdle > 0 && mQueued <= 0 &&
+           task->AllowsConcurrentJobs() && task->AcquireJobSlot() )
+         Push( index, task, false );
+
+      {
+         // Keep the task first for this worker, unless it is done, or
+         // Remove() or Stop() may have already looked in this queue
+         std::lock_guard< std::mutex > lock{ worker.mutex };
+         if ( more && !mStopping && !task->IsTerminating() ) {
+            worker.jobs.push_front( task );
+            ++mQueued;
+         }
+         else
+            // The task may be destroyed after this
+            task->ReleaseJobSlot();
+      }
+
+      mCallback( !more );
+   }
+}
@@ -0,0 +1,96 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  ODWorkerPool.h
+
+  Audacity(R) is copyright (c) 1999-2019 Audacity Team.
+  License: GPL v2.  See License.txt.
+
+******************************************************************//**
+
+\class ODWorkerPool
+\brief A work-stealing pool of threads, one per processor, that does the
+jobs of ODTasks.
+
+*//*******************************************************************/
+
+#ifndef __AUDACITY_ODWORKERPOOL__
+#define __AUDACITY_ODWORKERPOOL__
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class ODTask;
+
+/// Each worker has its own queue of jobs, each job being the next smallest
+/// unit of some ODTask.  A worker takes jobs from the front of its own queue
+/// and, when that is empty, steals from the back of the others.
+///
+/// After a job, the worker keeps the task at the front of its queue until
+/// the task has no more to do.  If the task allows concurrent jobs and some
+/// worker is idle with nothing to steal, it also queues another job for it,
+/// so that one long task spreads over all the processors.
+///
+/// Each queued or running job holds a slot of its task, so that
+/// ODTask::TerminateAndBlock() can wait for them.
+class ODWorkerPool final
+{
+public:
+   /// Called after each job, with true if the job found no more to do
+   using JobDoneCallback = std::function< void( bool ) >;
+
+   ODWorkerPool( size_t nWorkers, JobDoneCallback callback );
+   ODWorkerPool( const ODWorkerPool & ) = delete;
+   ODWorkerPool &operator= ( const ODWorkerPool & ) = delete;
+   ~ODWorkerPool();
+
+   /// Drop queued jobs, then wait for running jobs to finish.  No more jobs
+   /// start after this.
+   void Stop();
+
+   /// Queue a job of the task, unless it can take no more.  Urgent jobs are
+   /// done before others.  Thread-safe.
+   void Add( ODTask *task, bool urgent = false );
+   /// Move queued jobs of the task ahead of all others, returning whether
+   /// there were any.  Thread-safe.
+   bool Promote( ODTask *task );
+   /// Drop queued jobs of the task.  Thread-safe.
+   void Remove( ODTask *task );
+
+   /// Stop or resume starting jobs.  Running jobs finish.
+   void Pause( bool pause );
+
+private:
+   struct Worker {
+      std::mutex mutex;
+      std::deque< ODTask * > jobs;
+      std::thread thread;
+   };
+
+   void Run( size_t index );
+   ODTask *Take( size_t index );
+   /// Queue a job for which the task's slot was already acquired
+   void Push( size_t index, ODTask *task, bool front );
+   void Notify();
+
+   JobDoneCallback mCallback;
+   std::vector< std::unique_ptr< Worker > > mWorkers;
+
+   // For sleeping while there is nothing to do
+   std::mutex mMutex;
+   std::condition_variable mCondition;
+   std::atomic< long > mQueued{ 0 };
+   std::atomic< size_t > mIdle{ 0 };
+   std::atomic< size_t > mNextWorker{ 0 };
+   std::atomic< bool > mPaused{ false };
+   std::atomic< bool > mStopping{ false };
+};
+
+#endif
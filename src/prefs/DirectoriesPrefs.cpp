@@ -32,7 +32,9 @@
 #include <wx/filename.h>
 #include <wx/utils.h>
 
+#include "../BlockFileCache.h"
 #include "../FileNames.h"
+#include "../MappedSampleFile.h"
 #include "../Prefs.h"
 #include "../ShuttleGui.h"
 #include "../widgets/AudacityMessageBox.h"
@@ -120,6 +122,34 @@ void DirectoriesPrefs::PopulateOrExchange(ShuttleGui & S)
    }
    S.EndStatic();
 
+   S.StartStatic(_("Read cache"));
+   {
+      S.StartTwoColumn();
+      {
+         S.TieNumericTextBox(_("Memory for recently read &audio (MB):"),
+                             wxT("/Directories/SampleCacheSize"),
+                             256,
+                             9);
+      }
+      S.EndTwoColumn();
+      S.TieCheckBox(_("Read audio through &memory mapped files"),
+                    wxT("/Directories/MapBlockFiles"),
+                    true);
+   }
+   S.EndStatic();
+
+#ifdef USE_LIBFLAC
+   S.StartStatic(_("Project storage"));
+   {
+      S.TieCheckBox(_("&Compress unedited audio losslessly"),
+                    wxT("/Directories/CompressBlockFiles"),
+                    false);
+      S.AddVariableText(_("Only audio that is exactly 16 or 24 bit is compressed, such as audio imported from CD, or recorded from most devices; recordings are compressed when they stop. Audio changed by effects in 32-bit float projects is stored uncompressed as before."))->Wrap(600);
+      S.AddVariableText(_("Projects saved this way can be opened only by versions of Audacity that offer this option, not by Audacity 2.3.3 or earlier releases."))->Wrap(600);
+   }
+   S.EndStatic();
+#endif
+
 #ifdef DEPRECATED_AUDIO_CACHE
    // See http://bugzilla.audacityteam.org/show_bug.cgi?id=545.
    S.StartStatic(_("Audio cache"));
@@ -284,6 +314,9 @@ bool DirectoriesPrefs::Commit()
    ShuttleGui S(this, eIsSavingToPrefs);
    PopulateOrExchange(S);
 
+   BlockFileCache::Get().UpdatePrefs();
+   MappedSampleFileCache::Get().UpdatePrefs();
+
    return true;
 }
 
@@ -162,6 +162,10 @@ void EffectsPrefs::PopulateOrExchange(ShuttleGui & S)
                              5);
       }
       S.EndMultiColumn();
+
+      S.TieCheckBox(_("Process &tracks in parallel"),
+                    wxT("/Effects/ProcessTracksInParallel"),
+                    true);
    }
    S.EndStatic();
 
@@ -174,6 +178,9 @@ void EffectsPrefs::PopulateOrExchange(ShuttleGui & S)
       S.TieCheckBox(_("Rescan plugins next time Audacity is started"),
                      wxT("/Plugins/Rescan"),
                      false);
+      S.TieCheckBox(_("Check new plugins in separate processes"),
+                     wxT("/Plugins/ScanInProcesses"),
+                     true);
    }
    S.EndStatic();
 #endif
@@ -153,6 +153,13 @@ void PlaybackPrefs::PopulateOrExchange(ShuttleGui & S)
             UnpinnedScrubbingPreferenceDefault());
       }
       S.EndVerticalLay();
+
+      S.StartTwoColumn();
+      {
+         S.TieSpinCtrl(_("Buffer filling &threads (0 = automatic):"),
+            wxT("/AudioIO/FillBuffersThreads"), 0, 64, 0);
+      }
+      S.EndTwoColumn();
    }
    S.EndStatic();
 
@@ -250,9 +250,11 @@ void DrawClipSpectrum(TrackPanelDrawingContext &context,
    bool updated;
    {
       const double pps = averagePixelsPerSample * rate;
+      // Columns not yet computed are drawn again when TrackPanel sees the
+      // background computation progress
       updated = clip->GetSpectrogram(waveTrackCache, freq, where,
                                      (size_t)hiddenMid.width,
-         t0, pps);
+         t0, pps, true);
    }
    auto nBins = settings.NBins();
 
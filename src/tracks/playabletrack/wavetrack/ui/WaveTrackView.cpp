@@ -12,6 +12,7 @@ Paul Licameli split from TrackPanel.cpp
 
 #include "../../../../Experimental.h"
 
+#include <algorithm>
 #include <wx/graphics.h>
 
 #include "../../../../WaveClip.h"
@@ -86,6 +87,22 @@ void WaveTrackView::CopyTo( Track &track ) const
    }
 }
 
+bool WaveTrackView::SameStateAs( const Track &track ) const
+{
+   if ( !TrackView::SameStateAs( track ) )
+      return false;
+   const auto pOther =
+      dynamic_cast< const WaveTrackView* >( &TrackView::Get( track ) );
+   if ( !pOther )
+      return false;
+   const auto &placements = pOther->SavePlacements();
+   return placements.size() == mPlacements.size() &&
+      std::equal( placements.begin(), placements.end(), mPlacements.begin(),
+         []( const WaveTrackSubViewPlacement &a,
+            const WaveTrackSubViewPlacement &b ){
+            return a.index == b.index && a.fraction == b.fraction; } );
+}
+
 std::vector<UIHandlePtr> WaveTrackView::DetailedHitTest
 (const TrackPanelMouseState &st,
  const AudacityProject *pProject, int currentTool, bool bMultiTool)
@@ -61,6 +61,7 @@ public:
 
    // Preserve some view state too for undo/redo purposes
    void CopyTo( Track &track ) const override;
+   bool SameStateAs( const Track &track ) const override;
 
    std::shared_ptr<TrackVRulerControls> DoGetVRulerControls() override;
 
@@ -61,6 +61,11 @@ void CommonTrackCell::CopyTo( Track& ) const
 {
 }
 
+bool CommonTrackCell::SameStateAs( const Track& ) const
+{
+   return true;
+}
+
 void CommonTrackCell::Reparent( const std::shared_ptr<Track> &parent )
 {
    mwTrack = parent;
@@ -66,6 +66,10 @@ public:
    // The default does nothing
    virtual void CopyTo( Track &track ) const;
 
+   // Whether CopyTo would change nothing in the given track
+   // The default returns true
+   virtual bool SameStateAs( const Track &track ) const;
+
    std::shared_ptr<Track> DoFindTrack() override;
 
    virtual void Reparent( const std::shared_ptr<Track> &parent );
@@ -60,6 +60,12 @@ void TrackView::CopyTo( Track &track ) const
    other.mHeight = mHeight;
 }
 
+bool TrackView::SameStateAs( const Track &track ) const
+{
+   auto &other = Get( track );
+   return other.mMinimized == mMinimized && other.mHeight == mHeight;
+}
+
 TrackView &TrackView::Get( Track &track )
 {
    auto pView = std::static_pointer_cast<TrackView>( track.GetTrackView() );
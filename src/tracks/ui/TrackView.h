@@ -42,6 +42,7 @@ public:
 
    // Copy view state, for undo/redo purposes
    void CopyTo( Track &track ) const override;
+   bool SameStateAs( const Track &track ) const override;
 
    static TrackView &Get( Track & );
    static const TrackView &Get( const Track & );
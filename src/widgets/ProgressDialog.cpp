@@ -990,6 +990,13 @@ BEGIN_EVENT_TABLE(ProgressDialog, wxDialogWrapper)
    EVT_CLOSE(ProgressDialog::OnCloseWindow)
 END_EVENT_TABLE()
 
+bool ProgressDialog::sHeadless = false;
+
+void ProgressDialog::SetHeadless(bool headless)
+{
+   sHeadless = headless;
+}
+
 //
 // Constructor
 //
@@ -1080,6 +1087,9 @@ void ProgressDialog::Reinit()
    mCancel = false;
    mStop = false;
 
+   if (sHeadless)
+      return;
+
    // Because wxGTK is very sensitive about maintaining focus when
    // this window is not shown, we always show it.  But, since we
    // want a 500ms delay before it's actually visible for those
@@ -1139,7 +1149,7 @@ bool ProgressDialog::Create(const wxString & title,
    columns.back().push_back(message);
    auto result = Create(title, columns, flags, sRemainingLabelText);
 
-   if (result) {
+   if (result && !sHeadless) {
       // Record some values used in case of change of message
       // TODO: make the following work in case of message tables
       wxClientDC dc(this);
@@ -1154,15 +1164,22 @@ bool ProgressDialog::Create(const wxString & title,
                             int flags /* = pdlgDefaultFlags */,
                             const wxString & sRemainingLabelText /* = {} */)
 {
-   Init();
-
-   wxWindow *parent = GetParentForModalDialog(NULL, 0);
-
    // Set this boolean to indicate if we are using the "Elapsed" labels
    m_bShowElapsedTime = !(flags & pdlgHideElapsedTime);
    // Set this boolean to indicate if we confirm the Cancel/Stop actions
    m_bConfirmAction = (flags & pdlgConfirmStopCancel)!=0;
 
+   if (sHeadless)
+   {
+      // Keep the times, but leave the window uncreated
+      Reinit();
+      return true;
+   }
+
+   Init();
+
+   wxWindow *parent = GetParentForModalDialog(NULL, 0);
+
    bool success = wxDialogWrapper::Create(parent,
                                    wxID_ANY,
                                    title,
@@ -1328,7 +1345,7 @@ ProgressResult ProgressDialog::Update(int value, const wxString & message)
    wxLongLong_t now = wxGetUTCTimeMillis().GetValue();
    wxLongLong_t elapsed = now - mStartTime;
 
-   if (elapsed < 500)
+   if (elapsed < 500 || sHeadless)
    {
       return ProgressResult::Success;
    }
@@ -1491,7 +1508,7 @@ ProgressResult ProgressDialog::Update(double current, double total, const wxStri
 //
 void ProgressDialog::SetMessage(const wxString & message)
 {
-   if (!message.empty())
+   if (!message.empty() && !sHeadless)
    {
       mMessage->SetLabel(message);
 
@@ -1658,7 +1675,7 @@ ProgressResult TimerProgressDialog::UpdateProgress()
    wxLongLong_t now = wxGetUTCTimeMillis().GetValue();
    wxLongLong_t elapsed = now - mStartTime;
 
-   if (elapsed < 500)
+   if (elapsed < 500 || sHeadless)
    {
       return ProgressResult::Success;
    }
@@ -103,6 +103,10 @@ public:
    ProgressResult Update(int current, int total, const wxString & message = {});
    void SetMessage(const wxString & message);
 
+   // For unattended processing: dialogs created after this still track
+   // progress, but create no windows, and are never cancelled
+   static void SetHeadless(bool headless);
+
 protected:
    wxWindowRef mHadFocus;
 
@@ -124,6 +128,8 @@ protected:
    bool m_bShowElapsedTime = true;
    bool m_bConfirmAction = false;
 
+   static bool sHeadless;
+
 private:
    void Init();
    bool SearchForWindow(const wxWindowList & list, const wxWindow *searchfor) const;